@@ -6,7 +6,17 @@
 namespace Halley
 {
 	class ResourceLoader;
-	class VorbisData;
+	class AudioClipStream;
+	struct AudioPCMData;
+
+	// Reads a clip for a single voice, for clips which need to keep track of where each voice is reading from
+	class IAudioClipReader
+	{
+	public:
+		virtual ~IAudioClipReader() = default;
+
+		virtual size_t copyChannelData(size_t channelN, size_t pos, size_t len, gsl::span<AudioConfig::SampleFormat> dst) = 0;
+	};
 
 	class IAudioClip
 	{
@@ -14,10 +24,13 @@ namespace Halley
 		virtual ~IAudioClip() = default;
 
 		virtual size_t copyChannelData(size_t channelN, size_t pos, size_t len, gsl::span<AudioConfig::SampleFormat> dst) const = 0;
+		virtual std::shared_ptr<IAudioClipReader> makeReader() const { return {}; } // If this returns a reader, voices must read through it instead
 		virtual uint8_t getNumberOfChannels() const = 0;
 		virtual size_t getLength() const = 0; // in samples
 		virtual size_t getLoopPoint() const { return 0; } // in samples
 		virtual bool isLoaded() const { return true; }
+		virtual bool isThreadSafe() const { return true; } // Can different voices read this clip concurrently?
+		virtual bool isSeekable() const { return true; } // Can playback jump to any position without reading what's in between?
 	};
 
 	class AudioClip final : public AsyncResource, public IAudioClip
@@ -28,15 +41,19 @@ namespace Halley
 
 		AudioClip& operator=(AudioClip&& other) noexcept;
 
-		void loadFromStatic(std::shared_ptr<ResourceDataStatic> data, Metadata meta);
+		void loadFromStatic(std::shared_ptr<ResourceDataStatic> data, Metadata meta, const String& assetId);
 		void loadFromStream(std::shared_ptr<ResourceDataStream> data, Metadata meta);
 
 		size_t copyChannelData(size_t channelN, size_t pos, size_t len, gsl::span<AudioConfig::SampleFormat> dst) const override;
+		std::shared_ptr<IAudioClipReader> makeReader() const override; // Streaming clips decode separately for each voice
 		uint8_t getNumberOfChannels() const override;
 		size_t getLength() const override; // in samples
 		size_t getLoopPoint() const override; // in samples
 		bool isLoaded() const override;
 
+		// Number of times the mixer asked a streaming clip for samples which hadn't been decoded yet, across all of its voices
+		size_t getStreamUnderruns() const;
+
 		static std::shared_ptr<AudioClip> loadResource(ResourceLoader& loader);
 		constexpr static AssetType getAssetType() { return AssetType::AudioClip; }
 		void reload(Resource&& resource) override;
@@ -44,15 +61,11 @@ namespace Halley
 	private:
 		size_t sampleLength = 0;
 		size_t loopPoint = 0;
-		mutable size_t streamPos = 0;
 		uint8_t numChannels = 0;
 		bool streaming = false;
 
-		// TODO: sort this mess?
-		mutable std::vector<std::vector<AudioConfig::SampleFormat>> temp0;
-		mutable std::vector<std::vector<AudioConfig::SampleFormat>> temp1;
-		mutable std::vector<std::vector<AudioConfig::SampleFormat>> samples;
-		mutable std::unique_ptr<VorbisData> vorbisData;
+		std::shared_ptr<const AudioPCMData> pcm;
+		std::shared_ptr<const AudioClipStream> stream;
 	};
 
 	class StreamingAudioClip final : public IAudioClip
@@ -65,6 +78,7 @@ namespace Halley
 		size_t copyChannelData(size_t channelN, size_t pos, size_t len, gsl::span<AudioConfig::SampleFormat> dst) const override;
 		uint8_t getNumberOfChannels() const override;
 		size_t getLength() const override;
+		bool isSeekable() const override;
 		size_t getSamplesLeft() const;
 
 	private:
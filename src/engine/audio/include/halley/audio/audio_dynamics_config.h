@@ -21,6 +21,7 @@ namespace Halley {
 			float getValue(float variable) const;
 
 			String name;
+			int id = -1; // Interned name, to read the variable without looking the string up
 		};
 
 		AudioDynamicsConfig();
@@ -16,6 +16,27 @@ namespace Halley
 	class Resources;
 	class AudioDynamicsConfig;
 
+	// What to do when playing an event would exceed one of its instance limits
+	enum class AudioVoiceStealPolicy
+	{
+		None, // Don't play the new voice
+		Oldest,
+		Quietest,
+		LowestPriority // Only if its priority isn't higher than the new voice's
+	};
+
+	template <>
+	struct EnumNames<AudioVoiceStealPolicy> {
+		constexpr std::array<const char*, 4> operator()() const {
+			return{{
+				"none",
+				"oldest",
+				"quietest",
+				"lowestPriority"
+			}};
+		}
+	};
+
 	class AudioEvent final : public Resource
 	{
 	public:
@@ -24,6 +45,17 @@ namespace Halley
 
 		size_t run(AudioEngine& engine, uint32_t id, const AudioPosition& position) const;
 
+		// Unique to each event object, so voices can be matched to the event which started them without holding on to it
+		uint32_t getEventId() const;
+
+		// Higher priority voices are the last to be virtualised or stolen
+		int getPriority() const;
+
+		// Maximum number of concurrent voices started by this event, and on the groups it plays on. Zero means unlimited.
+		int getMaxInstances() const;
+		int getMaxGroupInstances() const;
+		AudioVoiceStealPolicy getStealPolicy() const;
+
 		void serialize(Serializer& s) const;
 		void deserialize(Deserializer& s);
 
@@ -32,7 +64,13 @@ namespace Halley
 		constexpr static AssetType getAssetType() { return AssetType::AudioEvent; }
 
 	private:
+		uint32_t eventId;
 		std::vector<std::unique_ptr<IAudioEventAction>> actions;
+		int priority = 0;
+		int maxInstances = 0;
+		int maxGroupInstances = 0;
+		AudioVoiceStealPolicy stealPolicy = AudioVoiceStealPolicy::Oldest;
+
 		void loadDependencies(Resources& resources) const;
 	};
 
@@ -54,7 +92,7 @@ namespace Halley
 	{
 	public:
 		virtual ~IAudioEventAction() {}
-		virtual bool run(AudioEngine& engine, uint32_t id, const AudioPosition& position) const = 0;
+		virtual bool run(AudioEngine& engine, uint32_t id, const AudioPosition& position, const AudioEvent& sourceEvent) const = 0;
 		virtual AudioEventActionType getType() const = 0;
 
 		virtual void serialize(Serializer& s) const = 0;
@@ -68,7 +106,7 @@ namespace Halley
 		explicit AudioEventActionPlay(AudioEvent& event);
 		AudioEventActionPlay(AudioEvent& event, const ConfigNode& config);
 
-		bool run(AudioEngine& engine, uint32_t id, const AudioPosition& position) const override;
+		bool run(AudioEngine& engine, uint32_t id, const AudioPosition& position, const AudioEvent& sourceEvent) const override;
 		AudioEventActionType getType() const override;
 
 		void serialize(Serializer& s) const override;
@@ -4,6 +4,7 @@
 #include <vector>
 #include "halley/core/api/halley_api_internal.h"
 #include <map>
+#include <unordered_map>
 
 #include "halley/data_structures/ring_buffer.h"
 
@@ -11,7 +12,11 @@ namespace Halley {
 	class AudioPosition;
 	class AudioEngine;
 	class AudioHandleImpl;
+	class AudioHandlePool;
+	class AudioCommandQueue;
+	class AudioEvent;
 	class IAudioClip;
+	struct AudioCommand;
 
     class AudioFacade final : public AudioAPIInternal
     {
@@ -44,11 +49,14 @@ namespace Halley {
 
 		void setMasterVolume(float volume = 1.0f) override;
 		void setGroupVolume(const String& groupName, float volume = 1.0f) override;
+		void setGroupBus(const String& groupName, AudioBusConfig config) override;
 
 	    void setOutputChannels(std::vector<AudioChannelData> audioChannelData) override;
 	    void setListener(AudioListenerData listener) override;
 
 		void setGlobalVariable(const String& variable, float value) override;
+		void setGlobalVariable(int variableId, float value) override;
+		int getGlobalVariableId(const String& variable) override;
 
 		void onAudioException(std::exception& e);
 
@@ -70,11 +78,19 @@ namespace Halley {
 	    AudioSpec audioSpec;
 		int lastDeviceNumber = 0;
 
-		RingBuffer<std::function<void()>> commandQueue;
-		std::vector<std::function<void()>> inbox;
-    	
+		std::unique_ptr<AudioCommandQueue> commandQueue;
+		std::unordered_map<String, std::shared_ptr<const AudioEvent>> events; // Keeps events alive while any of their sounds are playing, so commands can refer to them by pointer
+		std::shared_ptr<AudioHandlePool> handlePool;
+
+		struct PlayingSound {
+			uint32_t id;
+			const AudioEvent* event; // Null for clips played directly
+
+			bool operator<(uint32_t other) const { return id < other; }
+		};
+
 		RingBuffer<String> exceptions;
-		std::vector<uint32_t> playingSounds;
+		std::vector<PlayingSound> playingSounds; // Sorted by id
 		RingBuffer<std::vector<uint32_t>> finishedSoundsQueue;
 
 		std::map<int, AudioHandle> musicTracks;
@@ -85,7 +101,11 @@ namespace Halley {
 		void doStartPlayback(int deviceNumber, bool createEngine);
 	    void run();
 	    void stepAudio();
+	    bool enqueue(AudioCommand command);
 	    void enqueue(std::function<void()> action);
+		const AudioEvent* getEvent(const String& name);
+		void releaseFinishedEvents();
+		AudioHandle makeHandle(uint32_t id);
 		
 		void stopMusic(AudioHandle& handle, float fade);
 
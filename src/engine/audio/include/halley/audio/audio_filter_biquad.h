@@ -3,16 +3,48 @@
 #include "audio_source.h"
 
 namespace Halley {
+	// Second order IIR filter, one set of coefficients shared by every channel
+	// y[n] = a0 x[n] + a1 x[n-1] + a2 x[n-2] - b1 y[n-1] - b2 y[n-2]
+	class AudioBiquad {
+	public:
+		AudioBiquad();
+
+		static AudioBiquad makeLowPass(float cutoffHz, float q = 0.7071f, float sampleRate = float(AudioConfig::sampleRate));
+		static AudioBiquad makeHighPass(float cutoffHz, float q = 0.7071f, float sampleRate = float(AudioConfig::sampleRate));
+
+		void setParameters(float a0, float a1, float a2, float b1, float b2);
+		void reset();
+
+		void process(size_t channel, gsl::span<AudioConfig::SampleFormat> samples);
+
+	private:
+		float a0 = 1.0f;
+		float a1 = 0.0f;
+		float a2 = 0.0f;
+		float b1 = 0.0f;
+		float b2 = 0.0f;
+
+		struct State {
+			float z1 = 0.0f;
+			float z2 = 0.0f;
+		};
+		std::array<State, AudioConfig::maxChannels> state;
+	};
+
     class AudioFilterBiquad final : public AudioSource {
     public:
 		AudioFilterBiquad(std::shared_ptr<AudioSource> src);
 		void setParameters(float a0, float a1, float a2, float b1, float b2);
-    	
+
 	    uint8_t getNumberOfChannels() const override;
 	    bool isReady() const override;
+	    bool isThreadSafe() const override;
 	    bool getAudioData(size_t numSamples, AudioSourceData& dst) override;
+	    bool canSkip() const override;
+	    bool skipAudioData(size_t numSamples) override;
 
     private:
 		std::shared_ptr<AudioSource> src;
+		AudioBiquad biquad;
     };
 }
@@ -0,0 +1,88 @@
+#pragma once
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "halley/text/halleystring.h"
+#include "halley/core/api/audio_api.h"
+
+namespace Halley
+{
+	// Decoded samples of a clip, one vector per channel
+	// Shared read-only between every clip (and so every voice) playing the same asset
+	struct AudioPCMData
+	{
+		std::vector<std::vector<AudioConfig::SampleFormat>> samples;
+
+		size_t getSizeBytes() const;
+	};
+
+	// Keeps the decoded samples of small clips around, so an asset is only decoded once even if it's loaded several times,
+	// unloaded and loaded again, or loaded concurrently
+	// Entries still in use by a clip are never evicted; the rest are dropped least recently used first, once over budget.
+	class AudioPCMCache
+	{
+	public:
+		struct Key
+		{
+			String assetId;
+			uint64_t version = 0; // Hash of the encoded data, so a changed asset won't hit the old entry
+
+			bool operator==(const Key& other) const;
+		};
+
+		using Decoder = std::function<AudioPCMData()>;
+
+		AudioPCMCache(size_t budgetBytes = 32 * 1024 * 1024, size_t maxClipBytes = 1024 * 1024);
+
+		static AudioPCMCache& get();
+
+		void setBudget(size_t bytes);
+		size_t getBudget() const;
+		void setMaxClipSize(size_t bytes);
+		size_t getMaxClipSize() const;
+
+		bool canCache(size_t sizeBytes) const;
+
+		// Returns the cached samples for key, decoding them if necessary. Concurrent requests for the same key only decode once.
+		std::shared_ptr<const AudioPCMData> getOrDecode(const Key& key, const Decoder& decoder);
+
+		size_t getSizeBytes() const;
+		size_t getNumEntries() const;
+		size_t getNumHits() const;
+		size_t getNumMisses() const;
+		void clear();
+
+	private:
+		struct KeyHasher
+		{
+			size_t operator()(const Key& key) const;
+		};
+
+		struct Slot
+		{
+			std::mutex decodeMutex;
+			std::shared_ptr<const AudioPCMData> data;
+		};
+
+		struct Entry
+		{
+			Key key;
+			std::shared_ptr<Slot> slot;
+			size_t sizeBytes = 0;
+		};
+
+		mutable std::mutex mutex;
+		std::list<Entry> entries; // Most recently used first
+		std::unordered_map<Key, std::list<Entry>::iterator, KeyHasher> index;
+		size_t budget;
+		size_t maxClipSize;
+		size_t totalSize = 0;
+		size_t hits = 0;
+		size_t misses = 0;
+
+		void evict();
+	};
+}
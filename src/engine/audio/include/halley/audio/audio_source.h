@@ -14,6 +14,14 @@ namespace Halley
 
 		virtual uint8_t getNumberOfChannels() const = 0;
 		virtual bool isReady() const { return true; }
+
+		// False if reading from this source touches state shared with other sources, which forces its voice to be mixed on the audio thread
+		virtual bool isThreadSafe() const { return true; }
 		virtual bool getAudioData(size_t numSamples, AudioSourceData& dst) = 0;
+
+		// Sources which can skip ahead cheaply allow their voice to go virtual while inaudible
+		// skipAudioData advances playback as if numSamples had been read, and returns false if the source has finished
+		virtual bool canSkip() const { return false; }
+		virtual bool skipAudioData(size_t numSamples) { return true; }
 	};
 }
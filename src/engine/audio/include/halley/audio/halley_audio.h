@@ -5,6 +5,7 @@ namespace Halley {}
 #include "audio_clip.h"
 #include "audio_event.h"
 #include "audio_filter_biquad.h"
+#include "audio_pcm_cache.h"
 #include "audio_position.h"
 #include "audio_source.h"
 
@@ -24,6 +24,13 @@ AudioBufferRef::AudioBufferRef(AudioBufferRef&& other) noexcept
 
 AudioBufferRef& AudioBufferRef::operator=(AudioBufferRef&& other) noexcept
 {
+	if (this == &other) {
+		return *this;
+	}
+	if (buffer && pool) {
+		pool->returnBuffer(*buffer);
+	}
+
 	buffer = other.buffer;
 	pool = other.pool;
 	other.buffer = nullptr;
@@ -83,6 +90,17 @@ AudioBuffersRef::AudioBuffersRef(AudioBuffersRef&& other) noexcept
 
 AudioBuffersRef& AudioBuffersRef::operator=(AudioBuffersRef&& other) noexcept
 {
+	if (this == &other) {
+		return *this;
+	}
+
+	// Return whatever this was holding before taking over the other's buffers
+	if (pool) {
+		for (size_t i = 0; i < nBuffers; ++i) {
+			pool->returnBuffer(*buffers[i]);
+		}
+	}
+
 	buffers = other.buffers;
 	nBuffers = other.nBuffers;
 	pool = other.pool;
@@ -58,6 +58,7 @@ namespace Halley
 		AudioBufferPool* pool;
 	};
 
+	// Not thread safe, so every thread mixing audio takes its buffers from its own pool
 	class AudioBufferPool
 	{
 	public:
@@ -0,0 +1,152 @@
+#include "audio_bus.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace Halley;
+
+namespace {
+	gsl::span<AudioConfig::SampleFormat> getSamples(AudioBuffer& buffer, size_t numSamples)
+	{
+		return gsl::span<AudioConfig::SampleFormat>(buffer.packs.data()->samples.data(), numSamples);
+	}
+}
+
+AudioBusFilter::AudioBusFilter(AudioBiquad biquad)
+	: biquad(biquad)
+{
+}
+
+void AudioBusFilter::process(gsl::span<AudioBuffer*> buffers, size_t numSamples)
+{
+	for (size_t i = 0; i < size_t(buffers.size()); ++i) {
+		biquad.process(i, getSamples(*buffers[i], numSamples));
+	}
+}
+
+AudioBusCompressor::AudioBusCompressor(float thresholdDb, float ratio, float attackTime, float releaseTime)
+	: thresholdDb(thresholdDb)
+	, slope(1.0f - 1.0f / std::max(ratio, 1.0f))
+	, attackCoef(std::exp(-1.0f / (std::max(attackTime, 0.0001f) * AudioConfig::sampleRate)))
+	, releaseCoef(std::exp(-1.0f / (std::max(releaseTime, 0.0001f) * AudioConfig::sampleRate)))
+{
+}
+
+void AudioBusCompressor::process(gsl::span<AudioBuffer*> buffers, size_t numSamples)
+{
+	constexpr size_t packSize = AudioSamplePack::NumSamples;
+	const size_t nChannels = buffers.size();
+
+	// The envelope is followed per sample, but the gain is only recomputed once per pack and ramped across it
+	for (size_t pack = 0; pack < numSamples / packSize; ++pack) {
+		for (size_t i = 0; i < packSize; ++i) {
+			float peak = 0.0f;
+			for (size_t ch = 0; ch < nChannels; ++ch) {
+				peak = std::max(peak, std::abs(buffers[ch]->packs[pack].samples[i]));
+			}
+			const float coef = peak > envelope ? attackCoef : releaseCoef;
+			envelope = coef * envelope + (1.0f - coef) * peak;
+		}
+
+		const float envelopeDb = 20.0f * std::log10(std::max(envelope, 0.00001f));
+		const float overDb = std::max(envelopeDb - thresholdDb, 0.0f);
+		const float targetGain = std::pow(10.0f, -overDb * slope / 20.0f);
+
+		const float gainStep = (targetGain - gain) / packSize;
+		for (size_t ch = 0; ch < nChannels; ++ch) {
+			auto& samples = buffers[ch]->packs[pack].samples;
+			for (size_t i = 0; i < packSize; ++i) {
+				samples[i] *= gain + gainStep * (i + 1);
+			}
+		}
+		gain = targetGain;
+	}
+}
+
+AudioBus::AudioBus(String name)
+	: name(std::move(name))
+{
+}
+
+const String& AudioBus::getName() const
+{
+	return name;
+}
+
+void AudioBus::setConfig(AudioBusConfig c)
+{
+	config = std::move(c);
+
+	effects.clear();
+	if (config.highPassCutoff > 0) {
+		effects.push_back(std::make_unique<AudioBusFilter>(AudioBiquad::makeHighPass(config.highPassCutoff)));
+	}
+	if (config.lowPassCutoff > 0) {
+		effects.push_back(std::make_unique<AudioBusFilter>(AudioBiquad::makeLowPass(config.lowPassCutoff)));
+	}
+	if (config.compressorRatio > 1.0f) {
+		effects.push_back(std::make_unique<AudioBusCompressor>(config.compressorThreshold, config.compressorRatio, config.compressorAttack, config.compressorRelease));
+	}
+}
+
+const AudioBusConfig& AudioBus::getConfig() const
+{
+	return config;
+}
+
+void AudioBus::setGain(float g)
+{
+	gain = g;
+}
+
+float AudioBus::getGain() const
+{
+	return gain;
+}
+
+void AudioBus::setParent(int id)
+{
+	parent = id;
+}
+
+int AudioBus::getParent() const
+{
+	return parent;
+}
+
+void AudioBus::setSend(int id)
+{
+	send = id;
+}
+
+int AudioBus::getSend() const
+{
+	return send;
+}
+
+bool AudioBus::isPassthrough() const
+{
+	return effects.empty() && (config.send.isEmpty() || config.sendGain <= 0.0f);
+}
+
+void AudioBus::setMixBuffers(AudioBuffersRef buffers)
+{
+	mixBuffers = std::move(buffers);
+}
+
+gsl::span<AudioBuffer*> AudioBus::getMixBuffers()
+{
+	return mixBuffers.getBuffers();
+}
+
+void AudioBus::releaseMixBuffers()
+{
+	mixBuffers = AudioBuffersRef();
+}
+
+void AudioBus::process(size_t numSamples)
+{
+	const auto buffers = mixBuffers.getBuffers();
+	for (auto& effect: effects) {
+		effect->process(buffers, numSamples);
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "audio_buffer.h"
+#include "audio_filter_biquad.h"
+
+namespace Halley {
+	class AudioBusEffect {
+	public:
+		virtual ~AudioBusEffect() = default;
+
+		// Processes the first numSamples of each channel in place
+		virtual void process(gsl::span<AudioBuffer*> buffers, size_t numSamples) = 0;
+	};
+
+	class AudioBusFilter final : public AudioBusEffect {
+	public:
+		AudioBusFilter(AudioBiquad biquad);
+		void process(gsl::span<AudioBuffer*> buffers, size_t numSamples) override;
+
+	private:
+		AudioBiquad biquad;
+	};
+
+	// Feed-forward peak compressor, with the envelope linked across channels so the stereo image doesn't move
+	class AudioBusCompressor final : public AudioBusEffect {
+	public:
+		AudioBusCompressor(float thresholdDb, float ratio, float attackTime, float releaseTime);
+		void process(gsl::span<AudioBuffer*> buffers, size_t numSamples) override;
+
+	private:
+		float thresholdDb;
+		float slope;
+		float attackCoef;
+		float releaseCoef;
+		float envelope = 0.0f;
+		float gain = 1.0f;
+	};
+
+	class AudioBus {
+	public:
+		static constexpr int master = -1;
+
+		AudioBus(String name);
+
+		const String& getName() const;
+
+		void setConfig(AudioBusConfig config);
+		const AudioBusConfig& getConfig() const;
+
+		void setGain(float gain);
+		float getGain() const;
+
+		void setParent(int id);
+		int getParent() const;
+		void setSend(int id);
+		int getSend() const;
+
+		// Buses without effects or sends don't get a buffer, their voices are mixed into the parent's
+		bool isPassthrough() const;
+
+		void setMixBuffers(AudioBuffersRef buffers);
+		gsl::span<AudioBuffer*> getMixBuffers();
+		void releaseMixBuffers();
+
+		void process(size_t numSamples);
+
+	private:
+		String name;
+		AudioBusConfig config;
+		float gain = 1.0f;
+		int parent = master;
+		int send = master;
+
+		std::vector<std::unique_ptr<AudioBusEffect>> effects;
+		AudioBuffersRef mixBuffers;
+	};
+}
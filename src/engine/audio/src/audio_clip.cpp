@@ -1,6 +1,9 @@
 #include "audio_clip.h"
 #include "halley/resources/resource_data.h"
 #include "vorbis_dec.h"
+#include "audio_clip_streamer.h"
+#include "audio_pcm_cache.h"
+#include "halley/utils/hash.h"
 #include "halley/resources/metadata.h"
 #include "halley/concurrency/concurrent.h"
 #include "halley/text/string_converter.h"
@@ -24,20 +27,17 @@ AudioClip& AudioClip::operator=(AudioClip&& other) noexcept
 	sampleLength = other.sampleLength;
 	numChannels = other.numChannels;
 	loopPoint = other.loopPoint;
-	streamPos = other.streamPos;
 	streaming = other.streaming;
 
-	temp0 = std::move(other.temp0);
-	temp1 = std::move(other.temp1);
-	samples = std::move(other.samples);
-	vorbisData = std::move(other.vorbisData);
+	pcm = std::move(other.pcm);
+	stream = std::move(other.stream);
 
 	doneLoading();
 
 	return *this;
 }
 
-void AudioClip::loadFromStatic(std::shared_ptr<ResourceDataStatic> data, Metadata metadata)
+void AudioClip::loadFromStatic(std::shared_ptr<ResourceDataStatic> data, Metadata metadata, const String& assetId)
 {
 	VorbisData vorbis(data);
 	if (vorbis.getSampleRate() != AudioConfig::sampleRate) {
@@ -48,11 +48,23 @@ void AudioClip::loadFromStatic(std::shared_ptr<ResourceDataStatic> data, Metadat
 	loopPoint = metadata.getInt("loopPoint", 0);
 	streaming = false;
 
-	samples.resize(numChannels);
-	for (size_t i = 0; i < numChannels; ++i) {
-		samples[i].resize(sampleLength);
+	auto decode = [&] ()
+	{
+		AudioPCMData result;
+		result.samples.resize(numChannels);
+		for (size_t i = 0; i < numChannels; ++i) {
+			result.samples[i].resize(sampleLength);
+		}
+		vorbis.read(result.samples);
+		return result;
+	};
+
+	auto& cache = AudioPCMCache::get();
+	if (cache.canCache(sampleLength * numChannels * sizeof(AudioConfig::SampleFormat))) {
+		pcm = cache.getOrDecode(AudioPCMCache::Key{ assetId, Hash::hash(data->getSpan()) }, decode);
+	} else {
+		pcm = std::make_shared<const AudioPCMData>(decode());
 	}
-	vorbis.read(samples);
 	vorbis.close();
 
 	doneLoading();
@@ -60,58 +72,38 @@ void AudioClip::loadFromStatic(std::shared_ptr<ResourceDataStatic> data, Metadat
 
 void AudioClip::loadFromStream(std::shared_ptr<ResourceDataStream> data, Metadata metadata)
 {
-	vorbisData = std::make_unique<VorbisData>(data);
-	uint8_t nChannels = vorbisData->getNumChannels();
-	if (vorbisData->getSampleRate() != AudioConfig::sampleRate) {
+	VorbisData vorbis(data);
+	if (vorbis.getSampleRate() != AudioConfig::sampleRate) {
 		throw Exception("Sound clip should be " + toString(AudioConfig::sampleRate) + " Hz.", HalleyExceptions::AudioEngine);
 	}
-	
-	samples.resize(nChannels);
-	numChannels = nChannels;
-	sampleLength = vorbisData->getNumSamples();
+
+	numChannels = uint8_t(vorbis.getNumChannels());
+	sampleLength = vorbis.getNumSamples();
 	loopPoint = metadata.getInt("loopPoint", 0);
-	streamPos = 0;
 	streaming = true;
+	stream = std::make_shared<const AudioClipStream>(data, vorbis, loopPoint);
+	vorbis.close();
+
 	doneLoading();
 }
 
 size_t AudioClip::copyChannelData(size_t channelN, size_t pos, size_t len, gsl::span<AudioConfig::SampleFormat> dst) const
 {
 	Expects(pos + len <= sampleLength);
+	Expects(!streaming); // Streaming clips are read through makeReader()
 
-	if (streaming) {
-		auto& temp = pos == 0 ? temp0 : temp1; // pos == 0 has a different buffer because if it loops around, it will be used together with another buffer
-		if (temp.size() != numChannels) {
-			temp.resize(numChannels);
-		}
-
-		if (channelN == 0) { // TODO: this assumes the channels will be read in order. This will break threading.
-			if (pos != streamPos) {
-				vorbisData->seek(pos);
-				streamPos = pos;
-			}
-
-			size_t toRead = len;
-			for (size_t i = 0; i < numChannels; ++i) {
-				if (temp[i].size() < toRead) {
-					temp[i].resize(toRead);
-				}
-			}
-			vorbisData->read(temp);
-			streamPos += len;
-		}
-
-		auto& buf = samples.at(channelN);
-		if (buf.size() < len) {
-			buf.resize(len);
-		}
+	memcpy(dst.data(), pcm->samples.at(channelN).data() + pos, len * sizeof(AudioConfig::SampleFormat));
+	return len;
+}
 
-		memcpy(dst.data(), temp[channelN].data(), len * sizeof(AudioConfig::SampleFormat));
-		return len;
-	} else {
-		memcpy(dst.data(), samples.at(channelN).data() + pos, len * sizeof(AudioConfig::SampleFormat));
-		return len;
+std::shared_ptr<IAudioClipReader> AudioClip::makeReader() const
+{
+	Expects(isLoaded());
+	if (streaming) {
+		// Executors aren't always around (such as in tools), in which case the voice decodes for itself
+		return std::make_shared<AudioClipStreamer>(stream, Executors::hasInstance() ? &Executors::getDiskIO() : nullptr);
 	}
+	return {};
 }
 
 size_t AudioClip::getLength() const
@@ -136,6 +128,11 @@ bool AudioClip::isLoaded() const
 	return AsyncResource::isLoaded();
 }
 
+size_t AudioClip::getStreamUnderruns() const
+{
+	return stream ? stream->getUnderruns() : 0;
+}
+
 std::shared_ptr<AudioClip> AudioClip::loadResource(ResourceLoader& loader)
 {
 	auto meta = loader.getMeta();
@@ -151,8 +148,8 @@ std::shared_ptr<AudioClip> AudioClip::loadResource(ResourceLoader& loader)
 	} else {
 		loader
 			.getAsync()
-			.then([result, meta](std::unique_ptr<ResourceDataStatic> data) {
-				result->loadFromStatic(std::shared_ptr<ResourceDataStatic>(std::move(data)), meta);
+			.then([result, meta, assetId = loader.getName()](std::unique_ptr<ResourceDataStatic> data) {
+				result->loadFromStatic(std::shared_ptr<ResourceDataStatic>(std::move(data)), meta, assetId);
 			});
 	}
 
@@ -214,6 +211,11 @@ size_t StreamingAudioClip::getLength() const
 	return length;
 }
 
+bool StreamingAudioClip::isSeekable() const
+{
+	return false;
+}
+
 size_t StreamingAudioClip::getSamplesLeft() const
 {
 	std::unique_lock<std::mutex> lock(mutex);
@@ -0,0 +1,254 @@
+#include "audio_clip_streamer.h"
+#include "vorbis_dec.h"
+#include "halley/concurrency/concurrent.h"
+#include "halley/support/logger.h"
+#include "halley/utils/utils.h"
+#include <algorithm>
+#include <gsl/gsl_assert>
+
+using namespace Halley;
+
+namespace {
+	constexpr size_t ringCapacity = 32768; // Per channel, ~0.7s
+	constexpr size_t headLength = 8192;
+	constexpr size_t decodeChunkSize = 4096;
+}
+
+size_t AudioClipStream::Head::getEnd() const
+{
+	return start + (samples.empty() ? 0 : samples[0].size());
+}
+
+AudioClipStream::AudioClipStream(std::shared_ptr<ResourceData> data, VorbisData& vorbis, size_t loopPoint)
+	: data(std::move(data))
+	, numChannels(uint8_t(vorbis.getNumChannels()))
+	, length(vorbis.getNumSamples())
+	, underruns(0)
+{
+	decodeHead(vorbis, 0);
+	if (loopPoint > 0 && loopPoint < length) {
+		decodeHead(vorbis, loopPoint);
+	}
+}
+
+uint8_t AudioClipStream::getNumberOfChannels() const
+{
+	return numChannels;
+}
+
+size_t AudioClipStream::getLength() const
+{
+	return length;
+}
+
+size_t AudioClipStream::getUnderruns() const
+{
+	return underruns;
+}
+
+void AudioClipStream::decodeHead(VorbisData& vorbis, size_t start)
+{
+	auto& head = heads.emplace_back();
+	head.start = start;
+	head.samples.resize(numChannels);
+	for (auto& s: head.samples) {
+		s.resize(std::min(headLength, length - start));
+	}
+
+	vorbis.seek(start);
+	const size_t nRead = vorbis.read(head.samples);
+	for (auto& s: head.samples) {
+		s.resize(nRead);
+	}
+}
+
+AudioClipStreamer::AudioClipStreamer(std::shared_ptr<const AudioClipStream> s, ExecutionQueue* decodeQueue)
+	: stream(std::move(s))
+	, decodeQueue(decodeQueue)
+	, underruns(0)
+{
+	Expects(stream != nullptr);
+	seekRequest = stream->heads.front().getEnd();
+}
+
+AudioClipStreamer::~AudioClipStreamer() = default;
+
+size_t AudioClipStreamer::getUnderruns() const
+{
+	return underruns;
+}
+
+size_t AudioClipStreamer::copyChannelData(size_t channelN, size_t pos, size_t len, gsl::span<AudioConfig::SampleFormat> dst)
+{
+	Expects(channelN < stream->numChannels);
+	Expects(pos + len <= stream->length);
+	Expects(size_t(dst.size()) >= len);
+
+	if (!copyDecoded(channelN, pos, len, dst, decodeQueue != nullptr) && !decodeQueue) {
+		// Nothing to decode in the background with, so wait for it here rather than play silence
+		fill();
+		copyDecoded(channelN, pos, len, dst, true);
+	}
+
+	bool fillNow;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		fillNow = requestFill();
+	}
+	if (fillNow) {
+		startFill();
+	}
+	return len;
+}
+
+bool AudioClipStreamer::copyDecoded(size_t channelN, size_t pos, size_t len, gsl::span<AudioConfig::SampleFormat> dst, bool countUnderrun)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+
+	// Where the decoder has data for, or is about to
+	const auto isDecoderAt = [&] (size_t p)
+	{
+		if (seekRequest) {
+			return p == seekRequest.value();
+		}
+		const size_t validStart = std::max(ringStart, ringEnd - std::min(ringEnd, ringCapacity));
+		return p >= validStart && p <= ringEnd;
+	};
+
+	size_t written = 0;
+	while (written < len) {
+		const size_t curPos = pos + written;
+		const size_t remaining = len - written;
+
+		const auto& heads = stream->heads;
+		const auto head = std::find_if(heads.begin(), heads.end(), [&] (const AudioClipStream::Head& h) { return curPos >= h.start && curPos < h.getEnd(); });
+		if (head != heads.end()) {
+			const size_t n = std::min(remaining, head->getEnd() - curPos);
+			memcpy(dst.data() + written, head->samples[channelN].data() + (curPos - head->start), n * sizeof(AudioConfig::SampleFormat));
+			written += n;
+
+			// Get the decoder ready to pick up from where the head ends
+			if (!isDecoderAt(head->getEnd()) && head->getEnd() < stream->length) {
+				seekRequest = head->getEnd();
+			}
+		} else if (!seekRequest && isDecoderAt(curPos) && curPos < ringEnd) {
+			const size_t n = std::min(remaining, ringEnd - curPos);
+			const size_t ringPos = curPos % ringCapacity;
+			const size_t n0 = std::min(n, ringCapacity - ringPos);
+			memcpy(dst.data() + written, ring[channelN].data() + ringPos, n0 * sizeof(AudioConfig::SampleFormat));
+			memcpy(dst.data() + written + n0, ring[channelN].data(), (n - n0) * sizeof(AudioConfig::SampleFormat));
+			written += n;
+			readPos = curPos;
+		} else {
+			// Not decoded yet. Rather than waiting for it, play silence
+			if (!isDecoderAt(curPos)) {
+				seekRequest = curPos;
+			}
+			memset(dst.data() + written, 0, remaining * sizeof(AudioConfig::SampleFormat));
+			if (channelN == 0 && countUnderrun) {
+				++underruns;
+				++stream->underruns;
+			}
+			return false;
+		}
+	}
+
+	return true;
+}
+
+size_t AudioClipStreamer::getFreeSpace() const
+{
+	const size_t consumedUpTo = clamp(readPos, ringStart, ringEnd);
+	return ringCapacity - (ringEnd - consumedUpTo);
+}
+
+bool AudioClipStreamer::requestFill()
+{
+	// Only wake the decoder once there's a decent amount of space, so it doesn't get scheduled on every buffer
+	const bool needsData = seekRequest || (ringEnd < stream->length && getFreeSpace() >= ringCapacity / 4);
+	if (!fillPending && !failed && needsData) {
+		fillPending = true;
+		return true;
+	}
+	return false;
+}
+
+void AudioClipStreamer::startFill()
+{
+	if (decodeQueue) {
+		Concurrent::execute(*decodeQueue, [self = shared_from_this()] ()
+		{
+			self->fill();
+		});
+	} else {
+		fill();
+	}
+}
+
+void AudioClipStreamer::fill()
+{
+	try {
+		const size_t numChannels = stream->numChannels;
+		const size_t length = stream->length;
+
+		if (!vorbis) {
+			vorbis = std::make_unique<VorbisData>(stream->data);
+			vorbisPos = 0;
+			decodeBuffer.resize(numChannels);
+
+			std::vector<std::vector<AudioConfig::SampleFormat>> newRing(numChannels, std::vector<AudioConfig::SampleFormat>(ringCapacity));
+			std::unique_lock<std::mutex> lock(mutex);
+			ring = std::move(newRing);
+		}
+
+		while (true) {
+			size_t decodePos;
+			size_t toDecode;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				if (seekRequest) {
+					ringStart = ringEnd = readPos = seekRequest.value();
+					seekRequest.reset();
+				}
+				decodePos = ringEnd;
+				toDecode = std::min(std::min(getFreeSpace(), decodeChunkSize), length - ringEnd);
+				if (toDecode == 0) {
+					fillPending = false;
+					return;
+				}
+			}
+
+			// Decode outside the lock, so the audio thread is never kept waiting on it
+			if (decodePos != vorbisPos) {
+				vorbis->seek(decodePos);
+			}
+			for (auto& buffer: decodeBuffer) {
+				buffer.resize(toDecode);
+			}
+			const size_t nRead = vorbis->read(decodeBuffer);
+			vorbisPos = decodePos + nRead;
+
+			std::unique_lock<std::mutex> lock(mutex);
+			if (nRead == 0) {
+				// The stream ended earlier than it claimed to
+				failed = true;
+				fillPending = false;
+				return;
+			}
+			if (!seekRequest && ringEnd == decodePos) {
+				for (size_t i = 0; i < numChannels; ++i) {
+					const size_t ringPos = decodePos % ringCapacity;
+					const size_t n0 = std::min(nRead, ringCapacity - ringPos);
+					memcpy(ring[i].data() + ringPos, decodeBuffer[i].data(), n0 * sizeof(AudioConfig::SampleFormat));
+					memcpy(ring[i].data(), decodeBuffer[i].data() + n0, (nRead - n0) * sizeof(AudioConfig::SampleFormat));
+				}
+				ringEnd += nRead;
+			}
+		}
+	} catch (const std::exception& e) {
+		Logger::logException(e);
+		std::unique_lock<std::mutex> lock(mutex);
+		failed = true;
+		fillPending = false;
+	}
+}
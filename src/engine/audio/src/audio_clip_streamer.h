@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+#include <gsl/span>
+#include "audio_clip.h"
+
+namespace Halley {
+	class ExecutionQueue;
+	class ResourceData;
+	class VorbisData;
+
+	// What every voice streaming the same clip shares: where to decode it from, and the start of the clip (and of its loop)
+	// The heads are decoded when the clip loads, so starting and looping don't underrun.
+	class AudioClipStream {
+	public:
+		AudioClipStream(std::shared_ptr<ResourceData> data, VorbisData& vorbis, size_t loopPoint);
+
+		uint8_t getNumberOfChannels() const;
+		size_t getLength() const;
+		size_t getUnderruns() const; // Across every voice streaming it
+
+	private:
+		friend class AudioClipStreamer;
+
+		struct Head {
+			size_t start = 0;
+			std::vector<std::vector<AudioConfig::SampleFormat>> samples;
+
+			size_t getEnd() const;
+		};
+
+		std::shared_ptr<ResourceData> data;
+		const uint8_t numChannels;
+		const size_t length;
+		std::vector<Head> heads;
+		mutable std::atomic<size_t> underruns;
+
+		void decodeHead(VorbisData& vorbis, size_t start);
+	};
+
+	// Decodes a streaming clip ahead of one voice's playhead on the given queue (normally disk IO), with its own decoder
+	// The audio thread only ever copies PCM which has already been decoded. If it asks for something which isn't there yet,
+	// it gets silence, the underrun is counted, and the decoder is moved to wherever it's reading from.
+	// Without a queue, anything missing is decoded on the reading thread instead, so it never underruns.
+	class AudioClipStreamer final : public IAudioClipReader, public std::enable_shared_from_this<AudioClipStreamer> {
+	public:
+		AudioClipStreamer(std::shared_ptr<const AudioClipStream> stream, ExecutionQueue* decodeQueue);
+		~AudioClipStreamer();
+
+		size_t getUnderruns() const;
+
+		size_t copyChannelData(size_t channelN, size_t pos, size_t len, gsl::span<AudioConfig::SampleFormat> dst) override;
+
+	private:
+		const std::shared_ptr<const AudioClipStream> stream;
+		ExecutionQueue* const decodeQueue;
+
+		std::mutex mutex;
+		std::vector<std::vector<AudioConfig::SampleFormat>> ring; // Allocated by the decoder, so starting a voice doesn't have to
+		size_t ringStart = 0; // Clip position of the first sample since the last seek
+		size_t ringEnd = 0; // Clip position after the last decoded sample
+		size_t readPos = 0; // Samples before this can be overwritten
+		std::optional<size_t> seekRequest;
+		bool fillPending = false;
+		bool failed = false;
+		std::atomic<size_t> underruns;
+
+		// Only touched by the decoder
+		std::unique_ptr<VorbisData> vorbis;
+		std::vector<std::vector<AudioConfig::SampleFormat>> decodeBuffer;
+		size_t vorbisPos = 0;
+
+		bool copyDecoded(size_t channelN, size_t pos, size_t len, gsl::span<AudioConfig::SampleFormat> dst, bool countUnderrun);
+		size_t getFreeSpace() const;
+		bool requestFill();
+		void startFill();
+		void fill();
+	};
+}
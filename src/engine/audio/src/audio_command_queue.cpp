@@ -0,0 +1,118 @@
+#include "audio_command_queue.h"
+#include "audio_engine.h"
+#include "audio_event.h"
+#include "behaviours/audio_voice_fade_behaviour.h"
+#include "halley/support/logger.h"
+
+using namespace Halley;
+
+AudioCommand::AudioCommand(Type type, uint32_t id, float value)
+	: type(type)
+	, id(id)
+	, value(value)
+{
+}
+
+AudioCommandQueue::AudioCommandQueue(size_t capacity)
+	: commands(capacity)
+	, capacity(capacity)
+{
+}
+
+size_t AudioCommandQueue::getCapacity() const
+{
+	return capacity;
+}
+
+size_t AudioCommandQueue::getNumPending() const
+{
+	return commands.availableToRead();
+}
+
+bool AudioCommandQueue::push(AudioCommand command)
+{
+	if (!commands.canWrite(1)) {
+		return false;
+	}
+	commands.writeOne(std::move(command));
+	return true;
+}
+
+size_t AudioCommandQueue::execute(AudioEngine& engine)
+{
+	// Only run what was there on entry, so a busy game thread can't keep us here
+	const size_t n = commands.availableToRead();
+	for (size_t i = 0; i < n; ++i) {
+		auto command = commands.readOne();
+		execute(engine, command);
+	}
+	return n;
+}
+
+void AudioCommandQueue::execute(AudioEngine& engine, AudioCommand& command)
+{
+	using Type = AudioCommand::Type;
+
+	switch (command.type) {
+	case Type::None:
+		break;
+
+	case Type::PostEvent:
+		engine.postEvent(command.id, *command.event, command.position);
+		break;
+
+	case Type::Play:
+		engine.play(command.id, std::move(command.clip), std::move(command.position), command.value, command.loop);
+		break;
+
+	case Type::SetMasterGain:
+		engine.setMasterGain(command.value);
+		break;
+
+	case Type::SetListener:
+		engine.setListener(AudioListenerData(command.vector, command.value));
+		break;
+
+	case Type::SetVoiceGain:
+		for (auto* voice: engine.getSources(command.id)) {
+			voice->setUserGain(command.value);
+		}
+		break;
+
+	case Type::SetVoicePosition:
+		for (auto* voice: engine.getSources(command.id)) {
+			voice->setAudioSourcePosition(command.vector);
+		}
+		break;
+
+	case Type::SetVoicePan:
+		for (auto* voice: engine.getSources(command.id)) {
+			voice->setAudioSourcePosition(AudioPosition::makeUI(command.value));
+		}
+		break;
+
+	case Type::StopVoice:
+		for (auto* voice: engine.getSources(command.id)) {
+			if (command.value >= 0.001f) {
+				voice->addBehaviour(std::make_unique<AudioVoiceFadeBehaviour>(command.value, 1.0f, 0.0f, true));
+			} else {
+				voice->stop();
+			}
+		}
+		break;
+
+	case Type::AddVoiceBehaviour:
+		for (auto* voice: engine.getSources(command.id)) {
+			if (command.behaviour) {
+				voice->addBehaviour(std::move(command.behaviour));
+			} else {
+				Logger::logWarning("AudioVoiceBehaviour lost since event has more than one voice.");
+			}
+		}
+		break;
+
+	case Type::Action:
+		(*command.action)();
+		break;
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include "audio_position.h"
+#include "behaviours/audio_voice_behaviour.h"
+#include "halley/data_structures/ring_buffer.h"
+#include "halley/maths/vector3.h"
+
+namespace Halley {
+	class AudioEngine;
+	class AudioEvent;
+	class IAudioClip;
+
+	// A request from the game thread to the audio thread
+	// Records have a fixed layout and are moved in and out of slots allocated up front, so the common commands never touch the heap.
+	// Events are referenced by pointer, kept alive by whoever queues them, and clips are moved through without touching their refcount.
+	struct AudioCommand {
+		enum class Type : uint8_t {
+			None,
+			PostEvent,
+			Play,
+			SetMasterGain,
+			SetListener,
+			SetVoiceGain,
+			SetVoicePosition,
+			SetVoicePan,
+			StopVoice,
+			AddVoiceBehaviour,
+			Action // Anything rare enough not to need its own record, such as configuration changes
+		};
+
+		AudioCommand() = default;
+		AudioCommand(Type type, uint32_t id = 0, float value = 0.0f);
+
+		Type type = Type::None;
+		bool loop = false;
+		uint32_t id = 0;
+		float value = 0.0f;
+		Vector3f vector;
+		const AudioEvent* event = nullptr;
+		std::shared_ptr<const IAudioClip> clip;
+		AudioPosition position;
+		std::unique_ptr<AudioVoiceBehaviour> behaviour;
+		std::unique_ptr<std::function<void()>> action;
+	};
+
+	// Single producer, single consumer queue of commands
+	class AudioCommandQueue {
+	public:
+		explicit AudioCommandQueue(size_t capacity = 16384);
+
+		size_t getCapacity() const;
+		size_t getNumPending() const;
+
+		// Game thread. Returns false if the queue is full, in which case the command is dropped.
+		bool push(AudioCommand command);
+
+		// Audio thread. Runs the commands queued so far, and returns how many there were.
+		size_t execute(AudioEngine& engine);
+
+	private:
+		RingBuffer<AudioCommand> commands;
+		size_t capacity;
+
+		void execute(AudioEngine& engine, AudioCommand& command);
+	};
+}
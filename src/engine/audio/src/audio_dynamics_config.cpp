@@ -2,6 +2,7 @@
 
 #include "halley/file_formats/config_file.h"
 #include "halley/bytes/byte_serializer.h"
+#include "audio_variable_table.h"
 
 using namespace Halley;
 
@@ -40,6 +41,7 @@ AudioDynamicsConfig::Variable::Variable()
 AudioDynamicsConfig::Variable::Variable(const ConfigNode& node)
 {
 	name = node["name"].asString();
+	id = AudioVariableTable::getId(name);
 }
 
 void AudioDynamicsConfig::Variable::serialize(Serializer& s) const
@@ -50,6 +52,7 @@ void AudioDynamicsConfig::Variable::serialize(Serializer& s) const
 void AudioDynamicsConfig::Variable::deserialize(Deserializer& s)
 {
 	s >> name;
+	id = AudioVariableTable::getId(name);
 }
 
 float AudioDynamicsConfig::Variable::getValue(float variable) const
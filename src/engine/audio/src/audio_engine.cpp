@@ -2,6 +2,7 @@
 #include "audio_mixer.h"
 #include <thread>
 #include <chrono>
+#include <limits>
 #include "audio_source_clip.h"
 #include "audio_filter_resample.h"
 #include "halley/support/debug.h"
@@ -14,10 +15,15 @@
 
 using namespace Halley;
 
+namespace {
+	constexpr size_t noMixTarget = std::numeric_limits<size_t>::max();
+}
+
 AudioEngine::AudioEngine()
 	: mixer(AudioMixer::makeMixer())
 	, pool(std::make_unique<AudioBufferPool>())
 	, variableTable(std::make_unique<AudioVariableTable>())
+	, resamplerQuality(Debug::isDebug() ? AudioResamplerQuality::Fast : AudioResamplerQuality::Medium)
 	, audioOutputBuffer(4096 * 8)
 	, running(true)
 	, needsBuffer(true)
@@ -77,9 +83,81 @@ void AudioEngine::addEmitter(uint32_t id, std::unique_ptr<AudioVoice> src)
 {
 	emitters.emplace_back(std::move(src));
 	emitters.back()->setId(id);
+	emitters.back()->setStartOrder(nextStartOrder++);
 	idToSource[id].push_back(emitters.back().get());
 }
 
+bool AudioEngine::reserveVoice(const AudioEvent& event, uint8_t group, int priority)
+{
+	const auto enforceLimit = [&] (int maxInstances, bool sameEvent) -> bool
+	{
+		if (maxInstances <= 0) {
+			return true;
+		}
+
+		int count = 0;
+		for (const auto& e: emitters) {
+			if (!e->isDone() && !e->isStolen() && (sameEvent ? e->getEventId() == event.getEventId() : e->getGroup() == group)) {
+				++count;
+			}
+		}
+
+		for (; count >= maxInstances; --count) {
+			auto* victim = pickVoiceToSteal(event, group, sameEvent);
+			if (!victim || (event.getStealPolicy() == AudioVoiceStealPolicy::LowestPriority && victim->getPriority() > priority)) {
+				return false;
+			}
+			victim->steal();
+		}
+		return true;
+	};
+
+	return enforceLimit(event.getMaxInstances(), true) && enforceLimit(event.getMaxGroupInstances(), false);
+}
+
+AudioVoice* AudioEngine::pickVoiceToSteal(const AudioEvent& event, uint8_t group, bool sameEvent) const
+{
+	const auto policy = event.getStealPolicy();
+	if (policy == AudioVoiceStealPolicy::None) {
+		return nullptr;
+	}
+
+	const auto isBetterVictim = [&] (const AudioVoice& a, const AudioVoice& b)
+	{
+		if (policy == AudioVoiceStealPolicy::Quietest && a.getAudibility() != b.getAudibility()) {
+			return a.getAudibility() < b.getAudibility();
+		}
+		if (policy == AudioVoiceStealPolicy::LowestPriority && a.getPriority() != b.getPriority()) {
+			return a.getPriority() < b.getPriority();
+		}
+		return a.getStartOrder() < b.getStartOrder();
+	};
+
+	AudioVoice* best = nullptr;
+	for (const auto& e: emitters) {
+		if (e->isDone() || e->isStolen()) {
+			continue;
+		}
+		if (sameEvent ? e->getEventId() != event.getEventId() : e->getGroup() != group) {
+			continue;
+		}
+		if (!best || isBetterVictim(*e, *best)) {
+			best = e.get();
+		}
+	}
+	return best;
+}
+
+void AudioEngine::setMaxRealVoices(size_t maxVoices)
+{
+	maxRealVoices = maxVoices;
+}
+
+size_t AudioEngine::getMaxRealVoices() const
+{
+	return maxRealVoices;
+}
+
 const std::vector<AudioVoice*>& AudioEngine::getSources(uint32_t id)
 {
 	auto src = idToSource.find(id);
@@ -108,7 +186,7 @@ void AudioEngine::start(AudioSpec s, AudioOutputAPI& o)
 	channels[1].pan = 1.0f;
 
 	if (spec.sampleRate != 48000) {
-		outResampler = std::make_unique<AudioResampler>(48000, spec.sampleRate, spec.numChannels, Debug::isDebug() ? 0.0f : 0.5f);
+		outResampler = std::make_unique<AudioPolyphaseResampler>(AudioConfig::sampleRate, spec.sampleRate, size_t(spec.numChannels), Debug::isDebug() ? AudioResamplerQuality::Fast : AudioResamplerQuality::High);
 	}
 }
 
@@ -183,11 +261,9 @@ void AudioEngine::queueAudioFloat(gsl::span<const float> data)
 		if (tmpShort.size() < numSamples) {
 			tmpShort.resize(numSamples);
 		}
-		for (size_t i = 0; i < data.size(); ++i) {
-			tmpShort[i] = static_cast<short>(data[i] * 32768.0f);
-		}
+		mixer->convertToInt16(data, tmpShort);
 
-		queueAudioBytes(gsl::as_bytes(gsl::span<short>(tmpShort)));
+		queueAudioBytes(gsl::as_bytes(gsl::span<short>(tmpShort).subspan(0, numSamples)));
 	}
 
 	// Int32
@@ -195,11 +271,9 @@ void AudioEngine::queueAudioFloat(gsl::span<const float> data)
 		if (tmpInt.size() < numSamples) {
 			tmpInt.resize(numSamples);
 		}
-		for (size_t i = 0; i < data.size(); ++i) {
-			tmpInt[i] = static_cast<int>(data[i] * 2147483648.0f);
-		}
+		mixer->convertToInt32(data, tmpInt);
 
-		queueAudioBytes(gsl::as_bytes(gsl::span<int>(tmpInt)));
+		queueAudioBytes(gsl::as_bytes(gsl::span<int>(tmpInt).subspan(0, numSamples)));
 	}
 }
 
@@ -258,6 +332,16 @@ AudioVariableTable& AudioEngine::getVariableTable() const
 	return *variableTable;
 }
 
+void AudioEngine::setResamplerQuality(AudioResamplerQuality quality)
+{
+	resamplerQuality = quality;
+}
+
+AudioResamplerQuality AudioEngine::getResamplerQuality() const
+{
+	return resamplerQuality;
+}
+
 void AudioEngine::setMasterGain(float gain)
 {
 	masterGain = gain;
@@ -265,29 +349,338 @@ void AudioEngine::setMasterGain(float gain)
 
 void AudioEngine::setGroupGain(const String& name, float gain)
 {
-	groupGains[getGroupId(name)] = gain;
+	buses[getGroupId(name)]->setGain(gain);
+}
+
+void AudioEngine::setGroupBus(const String& name, AudioBusConfig config)
+{
+	const int id = getGroupId(name);
+	const int parent = config.parent.isEmpty() ? AudioBus::master : getGroupId(config.parent);
+	const int send = config.send.isEmpty() ? AudioBus::master : getGroupId(config.send);
+
+	for (int p = parent; p != AudioBus::master; p = buses[p]->getParent()) {
+		if (p == id) {
+			Logger::logError("Audio group \"" + config.parent + "\" can't be the parent of \"" + name + "\", as it's already mixed into it.");
+			return;
+		}
+	}
+
+	auto& bus = *buses[id];
+	bus.setParent(parent);
+	bus.setSend(send);
+	bus.setConfig(std::move(config));
+	busGraphDirty = true;
+}
+
+void AudioEngine::setMixWorkers(size_t numWorkers, AudioWorkerPool::MakeThread makeThread)
+{
+	mixWorkers.reset();
+	workerPools.clear();
+	if (numWorkers > 1) {
+		mixWorkers = std::make_unique<AudioWorkerPool>(numWorkers, std::move(makeThread));
+		for (size_t i = 1; i < numWorkers; ++i) {
+			workerPools.push_back(std::make_unique<AudioBufferPool>());
+		}
+	}
+}
+
+size_t AudioEngine::getNumMixWorkers() const
+{
+	return mixWorkers ? mixWorkers->getNumWorkers() : 1;
 }
 
 void AudioEngine::mixEmitters(size_t numSamples, size_t nChannels, gsl::span<AudioBuffer*> buffers)
 {
+	// Below this, the cost of waking the workers is higher than mixing the voices
+	constexpr size_t minVoicesPerJob = 8;
+
 	// Clear buffers
 	for (size_t i = 0; i < nChannels; ++i) {
 		clearBuffer(buffers[i]->packs);
 	}
+	if (busGraphDirty) {
+		updateBusGraph();
+	}
+	for (const int id: busMixOrder) {
+		buses[id]->setMixBuffers(pool->getBuffers(nChannels, numSamples));
+		for (auto* buffer: buses[id]->getMixBuffers()) {
+			clearBuffer(buffer->packs);
+		}
+	}
 
-	// Mix every emitter
+	// Start playing if necessary
+	voicesToMix.clear();
+	threadSafeVoices.clear();
 	for (auto& e: emitters) {
-		// Start playing if necessary
 		if (!e->isPlaying() && !e->isDone() && e->isReady()) {
 			e->start();
 		}
-
-		// Mix it in!
 		if (e->isPlaying()) {
-			e->update(channels, listener, masterGain * getGroupGain(e->getGroup()));
-			e->mixTo(numSamples, buffers, *mixer, *pool);
+			voicesToMix.push_back(e.get());
+			if (e->isThreadSafe()) {
+				threadSafeVoices.push_back(e.get());
+			}
+		}
+	}
+
+	// Update gains first, so the virtual voices can be picked before mixing
+	for (auto* voice: voicesToMix) {
+		voice->update(channels, listener, masterGain * getGroupGain(voice->getGroup()));
+	}
+	updateVirtualVoices();
+
+	const size_t numJobs = std::min(getNumMixWorkers(), threadSafeVoices.size() / minVoicesPerJob);
+	if (numJobs > 1) {
+		mixEmittersParallel(numJobs, numSamples, nChannels, buffers);
+	} else {
+		for (auto* voice: voicesToMix) {
+			mixVoice(*voice, numSamples, getMixTargetBuffers(groupMixTarget[voice->getGroup()], buffers), *pool);
 		}
 	}
+
+	mixBuses(numSamples, buffers);
+}
+
+void AudioEngine::mixEmittersParallel(size_t numJobs, size_t numSamples, size_t nChannels, gsl::span<AudioBuffer*> buffers)
+{
+	const size_t numPacks = numSamples / AudioSamplePack::NumSamples;
+
+	// Job 0 mixes straight into the mix targets, every other job into its own accumulators, which are summed afterwards
+	// Accumulators are only taken for the targets a job actually mixes into
+	// They come from the same size class as the output, as the gain interpolation depends on the buffer size
+	const size_t numTargets = getNumMixTargets();
+	mixAccumulators.clear();
+	mixAccumulators.resize((numJobs - 1) * numTargets);
+
+	const size_t voicesPerJob = alignUp(threadSafeVoices.size(), numJobs) / numJobs;
+	auto getJobVoices = [&] (size_t jobIdx)
+	{
+		const size_t start = std::min(jobIdx * voicesPerJob, threadSafeVoices.size());
+		const size_t end = std::min(start + voicesPerJob, threadSafeVoices.size());
+		return gsl::span<AudioVoice* const>(threadSafeVoices.data() + start, end - start);
+	};
+
+	mixWorkers->run(numJobs, [&] (size_t jobIdx)
+	{
+		if (jobIdx == 0) {
+			// Voices which can't leave the audio thread
+			for (auto* voice: voicesToMix) {
+				if (!voice->isThreadSafe()) {
+					mixVoice(*voice, numSamples, getMixTargetBuffers(groupMixTarget[voice->getGroup()], buffers), *pool);
+				}
+			}
+			for (auto* voice: getJobVoices(0)) {
+				mixVoice(*voice, numSamples, getMixTargetBuffers(groupMixTarget[voice->getGroup()], buffers), *pool);
+			}
+		} else {
+			auto& jobPool = *workerPools[jobIdx - 1];
+			for (auto* voice: getJobVoices(jobIdx)) {
+				auto& accumulator = mixAccumulators[(jobIdx - 1) * numTargets + groupMixTarget[voice->getGroup()]];
+				if (accumulator.getBuffers().empty()) {
+					accumulator = jobPool.getBuffers(nChannels, numSamples);
+					for (auto* buffer: accumulator.getBuffers()) {
+						clearBuffer(buffer->packs);
+					}
+				}
+				mixVoice(*voice, numSamples, accumulator.getBuffers(), jobPool);
+			}
+		}
+	});
+
+	// Reduce, always in the same order so the output is deterministic
+	for (size_t i = 0; i < mixAccumulators.size(); ++i) {
+		auto src = mixAccumulators[i].getBuffers();
+		if (!src.empty()) {
+			auto dst = getMixTargetBuffers(i % numTargets, buffers);
+			for (size_t j = 0; j < nChannels; ++j) {
+				mixer->sumAudio(gsl::span<const AudioSamplePack>(src[j]->packs).subspan(0, numPacks), dst[j]->packs);
+			}
+		}
+	}
+	mixAccumulators.clear();
+}
+
+void AudioEngine::mixVoice(AudioVoice& voice, size_t numSamples, gsl::span<AudioBuffer*> buffers, AudioBufferPool& voicePool)
+{
+	voice.mixTo(numSamples, buffers, *mixer, voicePool);
+}
+
+void AudioEngine::mixBuses(size_t numSamples, gsl::span<AudioBuffer*> buffers)
+{
+	const size_t numPacks = numSamples / AudioSamplePack::NumSamples;
+
+	// Every bus comes after all of its inputs, so each one is complete by the time it's processed
+	for (size_t i = 0; i < busMixOrder.size(); ++i) {
+		auto& bus = *buses[busMixOrder[i]];
+		bus.process(numSamples);
+
+		const auto src = bus.getMixBuffers();
+		const auto dst = getMixTargetBuffers(busParentTarget[i], buffers);
+		for (size_t j = 0; j < size_t(src.size()); ++j) {
+			mixer->sumAudio(gsl::span<const AudioSamplePack>(src[j]->packs).subspan(0, numPacks), dst[j]->packs);
+		}
+
+		if (busSendTarget[i] != noMixTarget) {
+			const float sendGain = bus.getConfig().sendGain;
+			const auto sendDst = getMixTargetBuffers(busSendTarget[i], buffers);
+			for (size_t j = 0; j < size_t(src.size()); ++j) {
+				mixer->mixAudio(gsl::span<const AudioSamplePack>(src[j]->packs).subspan(0, numPacks), sendDst[j]->packs, sendGain, sendGain);
+			}
+		}
+	}
+
+	for (const int id: busMixOrder) {
+		buses[id]->releaseMixBuffers();
+	}
+}
+
+void AudioEngine::updateBusGraph()
+{
+	busGraphDirty = false;
+	const int nBuses = int(buses.size());
+
+	// Passthrough buses are skipped over, anything routed into one goes to the closest bus above it with a buffer
+	const auto resolve = [&] (int id)
+	{
+		while (id != AudioBus::master && buses[id]->isPassthrough()) {
+			id = buses[id]->getParent();
+		}
+		return id;
+	};
+
+	std::vector<int> parentOf(nBuses, AudioBus::master);
+	std::vector<int> sendOf(nBuses, AudioBus::master);
+	for (int i = 0; i < nBuses; ++i) {
+		if (!buses[i]->isPassthrough()) {
+			parentOf[i] = resolve(buses[i]->getParent());
+		}
+	}
+
+	const auto reaches = [&] (int from, int to)
+	{
+		std::vector<int> pending = { from };
+		std::vector<bool> visited(nBuses, false);
+		while (!pending.empty()) {
+			const int id = pending.back();
+			pending.pop_back();
+			if (id == to) {
+				return true;
+			}
+			if (id != AudioBus::master && !visited[id]) {
+				visited[id] = true;
+				pending.push_back(parentOf[id]);
+				pending.push_back(sendOf[id]);
+			}
+		}
+		return false;
+	};
+
+	// Parents can't form loops, but sends can. Add them one at a time, and drop only the ones that would close a loop.
+	for (int i = 0; i < nBuses; ++i) {
+		if (!buses[i]->isPassthrough() && buses[i]->getSend() != AudioBus::master) {
+			const int dst = resolve(buses[i]->getSend());
+			if (dst == AudioBus::master) {
+				continue;
+			}
+			if (reaches(dst, i)) {
+				Logger::logWarning("Audio group \"" + buses[i]->getName() + "\" sends into a loop, ignoring the send.");
+			} else {
+				sendOf[i] = dst;
+			}
+		}
+	}
+
+	// Order the buses so each comes after everything mixed into it
+	std::vector<int> numInputs(nBuses, 0);
+	for (int i = 0; i < nBuses; ++i) {
+		if (!buses[i]->isPassthrough()) {
+			for (const int dst: { parentOf[i], sendOf[i] }) {
+				if (dst != AudioBus::master) {
+					++numInputs[dst];
+				}
+			}
+		}
+	}
+
+	busMixOrder.clear();
+	for (int i = 0; i < nBuses; ++i) {
+		if (!buses[i]->isPassthrough() && numInputs[i] == 0) {
+			busMixOrder.push_back(i);
+		}
+	}
+	for (size_t i = 0; i < busMixOrder.size(); ++i) {
+		const int id = busMixOrder[i];
+		for (const int dst: { parentOf[id], sendOf[id] }) {
+			if (dst != AudioBus::master && --numInputs[dst] == 0) {
+				busMixOrder.push_back(dst);
+			}
+		}
+	}
+
+	std::vector<size_t> targetOf(nBuses, noMixTarget);
+	for (size_t i = 0; i < busMixOrder.size(); ++i) {
+		targetOf[busMixOrder[i]] = i + 1;
+	}
+	const auto getTarget = [&] (int id) -> size_t
+	{
+		return id == AudioBus::master ? 0 : targetOf[id];
+	};
+
+	groupMixTarget.resize(nBuses);
+	for (int i = 0; i < nBuses; ++i) {
+		groupMixTarget[i] = getTarget(resolve(i));
+	}
+
+	busParentTarget.clear();
+	busSendTarget.clear();
+	for (const int id: busMixOrder) {
+		busParentTarget.push_back(getTarget(parentOf[id]));
+		busSendTarget.push_back(sendOf[id] == AudioBus::master ? noMixTarget : getTarget(sendOf[id]));
+	}
+}
+
+size_t AudioEngine::getNumMixTargets() const
+{
+	return busMixOrder.size() + 1;
+}
+
+gsl::span<AudioBuffer*> AudioEngine::getMixTargetBuffers(size_t target, gsl::span<AudioBuffer*> buffers)
+{
+	return target == 0 ? buffers : buses[busMixOrder[target - 1]]->getMixBuffers();
+}
+
+void AudioEngine::updateVirtualVoices()
+{
+	// Voices which can't skip have to be real, so they take their share of the budget first
+	size_t budget = maxRealVoices;
+	voicesByImportance.clear();
+	for (auto* voice: voicesToMix) {
+		if (voice->canBeVirtual()) {
+			voicesByImportance.push_back(voice);
+		} else if (budget > 0) {
+			--budget;
+		}
+	}
+
+	if (voicesByImportance.size() > budget) {
+		std::sort(voicesByImportance.begin(), voicesByImportance.end(), [] (const AudioVoice* a, const AudioVoice* b)
+		{
+			if (a->isAudible() != b->isAudible()) {
+				return a->isAudible();
+			}
+			if (a->getPriority() != b->getPriority()) {
+				return a->getPriority() > b->getPriority();
+			}
+			if (a->getAudibility() != b->getAudibility()) {
+				return a->getAudibility() > b->getAudibility();
+			}
+			return a->getStartOrder() < b->getStartOrder();
+		});
+	}
+
+	for (size_t i = 0; i < voicesByImportance.size(); ++i) {
+		voicesByImportance[i]->setVirtual(i >= budget);
+	}
 }
 
 void AudioEngine::removeFinishedEmitters()
@@ -320,13 +713,13 @@ void AudioEngine::clearBuffer(gsl::span<AudioSamplePack> dst)
 
 int AudioEngine::getGroupId(const String& group)
 {
-	const auto iter = std::find(groupNames.begin(), groupNames.end(), group);
-	if (iter != groupNames.end()) {
-		return int(iter - groupNames.begin());
+	const auto iter = std::find_if(buses.begin(), buses.end(), [&] (const std::unique_ptr<AudioBus>& bus) { return bus->getName() == group; });
+	if (iter != buses.end()) {
+		return int(iter - buses.begin());
 	} else {
-		groupNames.push_back(group);
-		groupGains.push_back(1.0f);
-		return int(groupNames.size()) - 1;
+		buses.push_back(std::make_unique<AudioBus>(group));
+		busGraphDirty = true;
+		return int(buses.size()) - 1;
 	}
 }
 
@@ -335,6 +728,11 @@ void AudioEngine::setVariable(const String& name, float value)
 	variableTable->set(name, value);
 }
 
+void AudioEngine::setVariable(int id, float value)
+{
+	variableTable->set(id, value);
+}
+
 int64_t AudioEngine::getLastTimeElapsed() const
 {
 	return lastTimeElapsed.load();
@@ -342,5 +740,10 @@ int64_t AudioEngine::getLastTimeElapsed() const
 
 float AudioEngine::getGroupGain(uint8_t id) const
 {
-	return groupGains[id];
+	// Gains are applied per voice rather than on the bus, so voices which are too quiet can still be virtualised
+	float gain = 1.0f;
+	for (int bus = id; bus != AudioBus::master; bus = buses[bus]->getParent()) {
+		gain *= buses[bus]->getGain();
+	}
+	return gain;
 }
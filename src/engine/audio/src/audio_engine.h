@@ -1,12 +1,14 @@
 #pragma once
 #include "audio_buffer.h"
+#include "audio_bus.h"
 #include <atomic>
 #include <condition_variable>
 #include <map>
 #include <vector>
 
 #include "audio_voice.h"
-#include "halley/audio/resampler.h"
+#include "audio_worker_pool.h"
+#include "audio_polyphase_resampler.h"
 #include "halley/data_structures/ring_buffer.h"
 #include "halley/maths/random.h"
 
@@ -15,6 +17,7 @@ namespace Halley {
 	class IAudioClip;
 	class Resources;
 	class AudioVariableTable;
+	class AudioEvent;
 
     class AudioEngine: private IAudioOutput
     {
@@ -29,6 +32,14 @@ namespace Halley {
 
 		void addEmitter(uint32_t id, std::unique_ptr<AudioVoice> src);
 
+		// Enforces the event's instance limits for a new voice on the given group, stealing a playing voice if its policy allows
+		// Returns false if the new voice should not be played
+		bool reserveVoice(const AudioEvent& event, uint8_t group, int priority);
+
+		// Only the most important audible voices are mixed, the rest are virtualised until they make it back into the budget
+		void setMaxRealVoices(size_t maxVoices);
+		size_t getMaxRealVoices() const;
+
 		const std::vector<AudioVoice*>& getSources(uint32_t id);
 		std::vector<uint32_t> getFinishedSounds();
 
@@ -38,16 +49,27 @@ namespace Halley {
 		void pause();
 
 		void generateBuffer();
+
+		// Voices are partitioned across this many workers (including the audio thread itself) when mixing
+		// With a single worker, voices are mixed serially, in the order they were added
+		void setMixWorkers(size_t numWorkers, AudioWorkerPool::MakeThread makeThread);
+		size_t getNumMixWorkers() const;
 	    
     	Random& getRNG();
 		AudioBufferPool& getPool() const;
 		AudioVariableTable& getVariableTable() const;
 
+		// Quality of the resampling done for voice pitch; the output is always resampled at high quality
+		void setResamplerQuality(AudioResamplerQuality quality);
+		AudioResamplerQuality getResamplerQuality() const;
+
 		void setMasterGain(float gain);
 		void setGroupGain(const String& name, float gain);
+		void setGroupBus(const String& name, AudioBusConfig config);
 		int getGroupId(const String& group);
 
     	void setVariable(const String& name, float value);
+		void setVariable(int id, float value);
 
 		int64_t getLastTimeElapsed() const;
 
@@ -56,7 +78,7 @@ namespace Halley {
 		AudioOutputAPI* out = nullptr;
 		std::unique_ptr<AudioMixer> mixer;
 		std::unique_ptr<AudioBufferPool> pool;
-		std::unique_ptr<AudioResampler> outResampler;
+		std::unique_ptr<AudioPolyphaseResampler> outResampler;
 		std::unique_ptr<AudioVariableTable> variableTable;
 		std::vector<short> tmpShort;
 		std::vector<int> tmpInt;
@@ -66,14 +88,29 @@ namespace Halley {
 		std::atomic<bool> needsBuffer;
 
 		std::vector<std::unique_ptr<AudioVoice>> emitters;
+		uint64_t nextStartOrder = 0;
+		size_t maxRealVoices = AudioConfig::maxVoices;
+		std::unique_ptr<AudioWorkerPool> mixWorkers;
+		std::vector<AudioVoice*> voicesToMix;
+		std::vector<AudioVoice*> voicesByImportance;
+		std::vector<AudioVoice*> threadSafeVoices;
+		std::vector<AudioBuffersRef> mixAccumulators; // Per job (other than the first) and mix target
+		std::vector<std::unique_ptr<AudioBufferPool>> workerPools; // Per job other than the first, which uses the main pool
 		std::vector<AudioChannelData> channels;
 		
 		std::map<uint32_t, std::vector<AudioVoice*>> idToSource;
 		std::vector<AudioVoice*> dummyIdSource;
 
+		AudioResamplerQuality resamplerQuality;
 		float masterGain = 1.0f;
-		std::vector<String> groupNames;
-    	std::vector<float> groupGains;
+		std::vector<std::unique_ptr<AudioBus>> buses; // Indexed by group id
+
+		// Mix targets are the master output (target 0) followed by every bus which has its own buffer, in processing order
+		bool busGraphDirty = true;
+		std::vector<int> busMixOrder;
+		std::vector<size_t> groupMixTarget;
+		std::vector<size_t> busParentTarget;
+		std::vector<size_t> busSendTarget;
 
 		AudioListenerData listener;
 
@@ -83,6 +120,14 @@ namespace Halley {
     	std::vector<uint32_t> finishedSounds;
 
 		void mixEmitters(size_t numSamples, size_t channels, gsl::span<AudioBuffer*> buffers);
+		void mixEmittersParallel(size_t numJobs, size_t numSamples, size_t channels, gsl::span<AudioBuffer*> buffers);
+		void mixVoice(AudioVoice& voice, size_t numSamples, gsl::span<AudioBuffer*> buffers, AudioBufferPool& voicePool);
+		void mixBuses(size_t numSamples, gsl::span<AudioBuffer*> buffers);
+		void updateBusGraph();
+		size_t getNumMixTargets() const;
+		gsl::span<AudioBuffer*> getMixTargetBuffers(size_t target, gsl::span<AudioBuffer*> buffers);
+		void updateVirtualVoices();
+		AudioVoice* pickVoiceToSteal(const AudioEvent& event, uint8_t group, bool sameEvent) const;
 	    void removeFinishedEmitters();
 		void clearBuffer(gsl::span<AudioSamplePack> dst);
 		void queueAudioFloat(gsl::span<const float> data);
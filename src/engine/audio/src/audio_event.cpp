@@ -10,13 +10,29 @@
 #include "audio_filter_resample.h"
 #include "behaviours/audio_voice_dynamics_behaviour.h"
 #include "halley/support/logger.h"
+#include <atomic>
 
 using namespace Halley;
 
-AudioEvent::AudioEvent() = default;
+namespace {
+	std::atomic<uint32_t> nextEventId { 1 };
+}
+
+AudioEvent::AudioEvent()
+	: eventId(nextEventId++)
+{
+}
 
 AudioEvent::AudioEvent(const ConfigNode& config)
+	: eventId(nextEventId++)
 {
+	priority = config["priority"].asInt(0);
+	maxInstances = config["maxInstances"].asInt(0);
+	maxGroupInstances = config["maxGroupInstances"].asInt(0);
+	if (config.hasKey("stealPolicy")) {
+		stealPolicy = fromString<AudioVoiceStealPolicy>(config["stealPolicy"].asString());
+	}
+
 	if (config.hasKey("actions")) {
 		for (auto& actionNode: config["actions"]) {
 			const auto type = fromString<AudioEventActionType>(actionNode["type"].asString());
@@ -31,15 +47,44 @@ size_t AudioEvent::run(AudioEngine& engine, uint32_t id, const AudioPosition& po
 {
 	size_t nEmitters = 0;
 	for (const auto& a: actions) {
-		if (a->run(engine, id, position)) {
+		if (a->run(engine, id, position, *this)) {
 			++nEmitters;
 		}
 	}
 	return nEmitters;
 }
 
+uint32_t AudioEvent::getEventId() const
+{
+	return eventId;
+}
+
+int AudioEvent::getPriority() const
+{
+	return priority;
+}
+
+int AudioEvent::getMaxInstances() const
+{
+	return maxInstances;
+}
+
+int AudioEvent::getMaxGroupInstances() const
+{
+	return maxGroupInstances;
+}
+
+AudioVoiceStealPolicy AudioEvent::getStealPolicy() const
+{
+	return stealPolicy;
+}
+
 void AudioEvent::serialize(Serializer& s) const
 {
+	s << priority;
+	s << maxInstances;
+	s << maxGroupInstances;
+	s << toString(stealPolicy);
 	s << uint32_t(actions.size());
 	for (auto& a: actions) {
 		s << toString(a->getType());
@@ -49,6 +94,13 @@ void AudioEvent::serialize(Serializer& s) const
 
 void AudioEvent::deserialize(Deserializer& s)
 {
+	s >> priority;
+	s >> maxInstances;
+	s >> maxGroupInstances;
+	String policy;
+	s >> policy;
+	stealPolicy = fromString<AudioVoiceStealPolicy>(policy);
+
 	uint32_t size;
 	s >> size;
 	for (uint32_t i = 0; i < size; ++i) {
@@ -65,7 +117,10 @@ void AudioEvent::deserialize(Deserializer& s)
 
 void AudioEvent::reload(Resource&& resource)
 {
+	// Keep the id, so voices which are already playing still count towards this event's limits
+	const auto id = eventId;
 	*this = std::move(dynamic_cast<AudioEvent&>(resource));
+	eventId = id;
 }
 
 std::shared_ptr<AudioEvent> AudioEvent::loadResource(ResourceLoader& loader)
@@ -122,7 +177,7 @@ AudioEventActionPlay::AudioEventActionPlay(AudioEvent& event, const ConfigNode&
 	}
 }
 
-bool AudioEventActionPlay::run(AudioEngine& engine, uint32_t id, const AudioPosition& position) const
+bool AudioEventActionPlay::run(AudioEngine& engine, uint32_t id, const AudioPosition& position, const AudioEvent& sourceEvent) const
 {
 	if (clips.empty()) {
 		return false;
@@ -140,16 +195,24 @@ bool AudioEventActionPlay::run(AudioEngine& engine, uint32_t id, const AudioPosi
 		return false;
 	}
 
+	// The event is passed in rather than read from the member, as reloading moves actions to a new owner
+	const auto groupId = uint8_t(engine.getGroupId(group));
+	if (!engine.reserveVoice(sourceEvent, groupId, sourceEvent.getPriority())) {
+		return false;
+	}
+
 	const float curVolume = rng.getFloat(volume.start, volume.end);
 	const float curPitch = clamp(rng.getFloat(pitch.start, pitch.end), 0.1f, 2.0f);
 
 	constexpr int sampleRate = 48000;
 	std::shared_ptr<AudioSource> source = std::make_shared<AudioSourceClip>(clip, loop, lround(delay * sampleRate));
 	if (std::abs(curPitch - 1.0f) > 0.01f) {
-		source = std::make_shared<AudioFilterResample>(source, int(lround(sampleRate * curPitch)), sampleRate, engine.getPool());
+		source = std::make_shared<AudioFilterResample>(source, int(lround(sampleRate * curPitch)), sampleRate, engine.getResamplerQuality());
 	}
 
-	auto voice = std::make_unique<AudioVoice>(source, position, curVolume, engine.getGroupId(group));
+	auto voice = std::make_unique<AudioVoice>(source, position, curVolume, groupId);
+	voice->setPriority(sourceEvent.getPriority());
+	voice->setEventId(sourceEvent.getEventId());
 	if (dynamics) {
 		voice->addBehaviour(std::make_unique<AudioVoiceDynamicsBehaviour>(dynamics.value(), engine));
 	}
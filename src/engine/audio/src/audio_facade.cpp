@@ -1,4 +1,5 @@
 #include "audio_facade.h"
+#include "audio_command_queue.h"
 #include "audio_engine.h"
 #include "audio_handle_impl.h"
 #include "behaviours/audio_voice_behaviour.h"
@@ -6,6 +7,7 @@
 #include "halley/support/logger.h"
 #include "halley/core/resources/resources.h"
 #include "audio_event.h"
+#include "audio_variable_table.h"
 #include "behaviours/audio_voice_fade_behaviour.h"
 
 using namespace Halley;
@@ -15,11 +17,13 @@ AudioFacade::AudioFacade(AudioOutputAPI& o, SystemAPI& system)
 	, system(system)
 	, running(false)
 	, started(false)
-	, commandQueue(1024)
+	, commandQueue(std::make_unique<AudioCommandQueue>())
+	, handlePool(std::make_shared<AudioHandlePool>())
 	, exceptions(16)
 	, finishedSoundsQueue(4)
 	, ownAudioThread(o.needsAudioThread())
 {
+	playingSounds.reserve(AudioConfig::maxVoices * 2);
 }
 
 AudioFacade::~AudioFacade()
@@ -67,6 +71,13 @@ void AudioFacade::doStartPlayback(int deviceNumber, bool createEngine)
 	if (int(devices.size()) > deviceNumber) {
 		if (createEngine) {
 			engine = std::make_unique<AudioEngine>();
+
+			// Keep most cores for the game; mixing only fans out when there are enough voices to be worth it
+			const size_t numMixWorkers = std::clamp(size_t(std::thread::hardware_concurrency()) / 2, size_t(1), size_t(3));
+			engine->setMixWorkers(numMixWorkers, [this] (String name, std::function<void()> runnable)
+			{
+				return system.createThread(name, ThreadPriority::High, std::move(runnable));
+			});
 		}
 
 		AudioSpec format;
@@ -162,27 +173,67 @@ AudioHandle AudioFacade::postEvent(const String& name, AudioPosition position)
 {
 	uint32_t id = uniqueId++;
 
-	if (resources->exists<AudioEvent>(name)) {
-		const auto event = resources->get<AudioEvent>(name);
-		enqueue([=]() {
-			engine->postEvent(id, *event, position);
-		});
+	if (const auto* event = getEvent(name)) {
+		auto command = AudioCommand(AudioCommand::Type::PostEvent, id);
+		command.event = event;
+		command.position = std::move(position);
+		if (enqueue(std::move(command))) {
+			playingSounds.push_back(PlayingSound{ id, event });
+		}
 	} else {
 		Logger::logError("Unknown audio event: \"" + name + "\"");
 	}
 
-	playingSounds.push_back(id);
-	return std::make_shared<AudioHandleImpl>(*this, id);
+	return makeHandle(id);
 }
 
 AudioHandle AudioFacade::play(std::shared_ptr<const IAudioClip> clip, AudioPosition position, float volume, bool loop)
 {
 	uint32_t id = uniqueId++;
-	enqueue([=] () {
-		engine->play(id, clip, position, volume, loop);
-	});
-	playingSounds.push_back(id);
-	return std::make_shared<AudioHandleImpl>(*this, id);
+
+	auto command = AudioCommand(AudioCommand::Type::Play, id, volume);
+	command.clip = std::move(clip);
+	command.position = std::move(position);
+	command.loop = loop;
+	if (enqueue(std::move(command))) {
+		playingSounds.push_back(PlayingSound{ id, nullptr });
+	}
+
+	return makeHandle(id);
+}
+
+const AudioEvent* AudioFacade::getEvent(const String& name)
+{
+	const auto iter = events.find(name);
+	if (iter != events.end()) {
+		return iter->second.get();
+	}
+
+	if (!resources->exists<AudioEvent>(name)) {
+		return nullptr;
+	}
+	auto event = resources->get<AudioEvent>(name);
+	const auto* result = event.get();
+	events[name] = std::move(event);
+	return result;
+}
+
+void AudioFacade::releaseFinishedEvents()
+{
+	for (auto iter = events.begin(); iter != events.end(); ) {
+		const auto* event = iter->second.get();
+		const bool playing = std::any_of(playingSounds.begin(), playingSounds.end(), [&] (const PlayingSound& sound) { return sound.event == event; });
+		if (playing) {
+			++iter;
+		} else {
+			iter = events.erase(iter);
+		}
+	}
+}
+
+AudioHandle AudioFacade::makeHandle(uint32_t id)
+{
+	return std::allocate_shared<AudioHandleImpl>(AudioHandleAllocator<AudioHandleImpl>(handlePool), *this, id);
 }
 
 AudioHandle AudioFacade::playMusic(const String& eventName, int track, float fadeInTime)
@@ -230,9 +281,7 @@ void AudioFacade::stopAllMusic(float fadeOutTime)
 
 void AudioFacade::setMasterVolume(float volume)
 {
-	enqueue([=] () {
-		engine->setMasterGain(volumeToGain(volume));
-	});
+	enqueue(AudioCommand(AudioCommand::Type::SetMasterGain, 0, volumeToGain(volume)));
 }
 
 void AudioFacade::setGroupVolume(const String& groupName, float volume)
@@ -242,6 +291,13 @@ void AudioFacade::setGroupVolume(const String& groupName, float volume)
 	});
 }
 
+void AudioFacade::setGroupBus(const String& groupName, AudioBusConfig config)
+{
+	enqueue([=] () {
+		engine->setGroupBus(groupName, config);
+	});
+}
+
 void AudioFacade::setOutputChannels(std::vector<AudioChannelData> audioChannelData)
 {
 	enqueue([=, audioChannelData = std::move(audioChannelData)] () mutable
@@ -268,18 +324,27 @@ void AudioFacade::onNeedBuffer()
 
 void AudioFacade::setListener(AudioListenerData listener)
 {
-	enqueue([=] () {
-		engine->setListener(listener);
-	});
+	auto command = AudioCommand(AudioCommand::Type::SetListener, 0, listener.referenceDistance);
+	command.vector = listener.position;
+	enqueue(std::move(command));
 }
 
 void AudioFacade::setGlobalVariable(const String& variable, float value)
 {
-	String nameCopy = variable;
-	enqueue([this, nameCopy = std::move(nameCopy), value]()
-	{
-		engine->setVariable(nameCopy, value);
-	});
+	setGlobalVariable(getGlobalVariableId(variable), value);
+}
+
+void AudioFacade::setGlobalVariable(int variableId, float value)
+{
+	// The variable table is safe to write from here, so this skips the command queue
+	if (engine) {
+		engine->setVariable(variableId, value);
+	}
+}
+
+int AudioFacade::getGlobalVariableId(const String& variable)
+{
+	return AudioVariableTable::getId(variable);
 }
 
 void AudioFacade::onAudioException(std::exception& e)
@@ -311,12 +376,7 @@ void AudioFacade::stepAudio()
 			}
 		}
 
-		const size_t nToRead = commandQueue.availableToRead();
-		inbox.resize(nToRead);
-		commandQueue.read(gsl::span<std::function<void()>>(inbox.data(), nToRead));
-		for (auto& action : inbox) {
-			action();
-		}
+		commandQueue->execute(*engine);
 
 		if (ownAudioThread) {
 			engine->run();
@@ -328,15 +388,22 @@ void AudioFacade::stepAudio()
 	}
 }
 
-void AudioFacade::enqueue(std::function<void()> action)
+bool AudioFacade::enqueue(AudioCommand command)
 {
 	if (running) {
-		if (commandQueue.canWrite(1)) {
-			commandQueue.writeOne(std::move(action));
-		} else {
-			Logger::logError("Out of space on audio command queue.");
+		if (commandQueue->push(std::move(command))) {
+			return true;
 		}
+		Logger::logError("Out of space on audio command queue.");
 	}
+	return false;
+}
+
+void AudioFacade::enqueue(std::function<void()> action)
+{
+	auto command = AudioCommand(AudioCommand::Type::Action);
+	command.action = std::make_unique<std::function<void()>>(std::move(action));
+	enqueue(std::move(command));
 }
 
 void AudioFacade::pump()
@@ -352,12 +419,20 @@ void AudioFacade::pump()
 	}
 
 	if (running) {
+		bool finishedEvent = false;
 		while (finishedSoundsQueue.canRead(1)) {
 			auto finishedSounds = finishedSoundsQueue.readOne();
-			playingSounds.erase(std::remove_if(playingSounds.begin(), playingSounds.end(), [&] (uint32_t id) -> bool
+			playingSounds.erase(std::remove_if(playingSounds.begin(), playingSounds.end(), [&] (const PlayingSound& sound) -> bool
 			{
-				return std::find(finishedSounds.begin(), finishedSounds.end(), id) != finishedSounds.end();
+				const bool finished = std::find(finishedSounds.begin(), finishedSounds.end(), sound.id) != finishedSounds.end();
+				finishedEvent |= finished && sound.event;
+				return finished;
 			}), playingSounds.end());
 		}
+
+		// Events are only needed until their last command has run, and the engine has reported all of their sounds as finished
+		if (finishedEvent) {
+			releaseFinishedEvents();
+		}
 	}
 }
@@ -1,12 +1,83 @@
 #include "audio_filter_biquad.h"
+#include <algorithm>
+#include <cmath>
 
 using namespace Halley;
 
+AudioBiquad::AudioBiquad()
+{
+}
+
+AudioBiquad AudioBiquad::makeLowPass(float cutoffHz, float q, float sampleRate)
+{
+	// Coefficients from the Audio EQ Cookbook (R. Bristow-Johnson)
+	const float w0 = 2.0f * 3.14159265f * std::min(cutoffHz, sampleRate * 0.49f) / sampleRate;
+	const float cosW0 = std::cos(w0);
+	const float alpha = std::sin(w0) / (2.0f * q);
+	const float norm = 1.0f / (1.0f + alpha);
+
+	AudioBiquad result;
+	result.setParameters((1.0f - cosW0) * 0.5f * norm, (1.0f - cosW0) * norm, (1.0f - cosW0) * 0.5f * norm, -2.0f * cosW0 * norm, (1.0f - alpha) * norm);
+	return result;
+}
+
+AudioBiquad AudioBiquad::makeHighPass(float cutoffHz, float q, float sampleRate)
+{
+	const float w0 = 2.0f * 3.14159265f * std::min(cutoffHz, sampleRate * 0.49f) / sampleRate;
+	const float cosW0 = std::cos(w0);
+	const float alpha = std::sin(w0) / (2.0f * q);
+	const float norm = 1.0f / (1.0f + alpha);
+
+	AudioBiquad result;
+	result.setParameters((1.0f + cosW0) * 0.5f * norm, -(1.0f + cosW0) * norm, (1.0f + cosW0) * 0.5f * norm, -2.0f * cosW0 * norm, (1.0f - alpha) * norm);
+	return result;
+}
+
+void AudioBiquad::setParameters(float a0, float a1, float a2, float b1, float b2)
+{
+	this->a0 = a0;
+	this->a1 = a1;
+	this->a2 = a2;
+	this->b1 = b1;
+	this->b2 = b2;
+}
+
+void AudioBiquad::reset()
+{
+	state = {};
+}
+
+void AudioBiquad::process(size_t channel, gsl::span<AudioConfig::SampleFormat> samples)
+{
+	Expects(channel < state.size());
+
+	// Transposed direct form II, which keeps just two values of state per channel
+	float z1 = state[channel].z1;
+	float z2 = state[channel].z2;
+	for (auto& sample: samples) {
+		const float x = sample;
+		const float y = a0 * x + z1;
+		z1 = a1 * x - b1 * y + z2;
+		z2 = a2 * x - b2 * y;
+		sample = y;
+	}
+
+	// Keep denormals from piling up once the input goes silent
+	constexpr float epsilon = 1e-15f;
+	state[channel].z1 = std::abs(z1) < epsilon ? 0.0f : z1;
+	state[channel].z2 = std::abs(z2) < epsilon ? 0.0f : z2;
+}
+
 AudioFilterBiquad::AudioFilterBiquad(std::shared_ptr<AudioSource> src)
 	: src(std::move(src))
 {
 }
 
+void AudioFilterBiquad::setParameters(float a0, float a1, float a2, float b1, float b2)
+{
+	biquad.setParameters(a0, a1, a2, b1, b2);
+}
+
 uint8_t AudioFilterBiquad::getNumberOfChannels() const
 {
 	return src->getNumberOfChannels();
@@ -17,8 +88,29 @@ bool AudioFilterBiquad::isReady() const
 	return src->isReady();
 }
 
+bool AudioFilterBiquad::isThreadSafe() const
+{
+	return src->isThreadSafe();
+}
+
 bool AudioFilterBiquad::getAudioData(size_t numSamples, AudioSourceData& dst)
 {
-	// TODO
-	return src->getAudioData(numSamples, dst);
+	const bool playing = src->getAudioData(numSamples, dst);
+	const size_t nChannels = getNumberOfChannels();
+	for (size_t i = 0; i < nChannels; ++i) {
+		biquad.process(i, dst[i].subspan(0, numSamples));
+	}
+	return playing;
+}
+
+bool AudioFilterBiquad::canSkip() const
+{
+	return src->canSkip();
+}
+
+bool AudioFilterBiquad::skipAudioData(size_t numSamples)
+{
+	// The filter history no longer matches the input once it's been skipped over
+	biquad.reset();
+	return src->skipAudioData(numSamples);
 }
@@ -1,13 +1,12 @@
 #include "audio_filter_resample.h"
-#include "halley/support/debug.h"
 
 using namespace Halley;
 
-AudioFilterResample::AudioFilterResample(std::shared_ptr<AudioSource> source, int fromHz, int toHz, AudioBufferPool& pool)
-	: pool(pool)
-	, source(std::move(source))
+AudioFilterResample::AudioFilterResample(std::shared_ptr<AudioSource> source, int fromHz, int toHz, AudioResamplerQuality quality)
+	: source(std::move(source))
 	, fromHz(fromHz)
 	, toHz(toHz)
+	, quality(quality)
 {
 }
 
@@ -21,50 +20,51 @@ bool AudioFilterResample::isReady() const
 	return source->isReady();
 }
 
-bool AudioFilterResample::getAudioData(size_t numSamples, AudioSourceData& dstBuffers)
+bool AudioFilterResample::isThreadSafe() const
 {
-	const size_t nChannels = source->getNumberOfChannels();
-	const size_t additionalPaddingSamples = 2;
-	const size_t nLeftOver = leftoverSamples[0].n;
-	const size_t samplesToGenerate = numSamples - nLeftOver;
-	const size_t numSamplesSrc = samplesToGenerate * fromHz / toHz + additionalPaddingSamples;
+	return source->isThreadSafe();
+}
 
-	if (resamplers.empty()) {
-		for (size_t i = 0; i < nChannels; ++i) {
-			resamplers.push_back(std::make_unique<AudioResampler>(fromHz, toHz, 1, Debug::isDebug() ? 0.0f : 0.3f));
-		}
+bool AudioFilterResample::canSkip() const
+{
+	return source->canSkip();
+}
+
+bool AudioFilterResample::skipAudioData(size_t numSamples)
+{
+	// The resampler history goes stale, but the voice fades back in from silence when it becomes real again
+	if (resampler) {
+		resampler->reset();
 	}
+	// Carry the fraction of a source sample over to the next skip, so long skips don't drift out of sync
+	const size_t total = numSamples * size_t(fromHz) + skipRemainder;
+	skipRemainder = total % size_t(toHz);
+	return source->skipAudioData(total / size_t(toHz));
+}
 
-	// Read upstream data
-	auto srcBuffers = pool.getBuffers(nChannels, numSamplesSrc);
-	auto srcs = srcBuffers.getSampleSpans();
-	bool playing = source->getAudioData(numSamplesSrc, srcs);
+bool AudioFilterResample::getAudioData(size_t numSamples, AudioSourceData& dstBuffers)
+{
+	const size_t nChannels = source->getNumberOfChannels();
+	if (!resampler) {
+		resampler = std::make_unique<AudioPolyphaseResampler>(fromHz, toHz, nChannels, quality);
+	}
 
-	// Prepare temporary destination data
-	auto tmpBuffer = pool.getBuffer(numSamples + 2 * AudioSamplePack::NumSamples);
-	auto tmp = tmpBuffer.getSampleSpan();
-	
-	// Resample
+	// Read exactly as much upstream data as the resampler needs for this buffer, so nothing is left over
+	const size_t numSamplesSrc = resampler->getInputSamplesNeeded(numSamples);
+	constexpr size_t packSize = AudioSamplePack::NumSamples;
+	const size_t numPacksSrc = std::max(alignUp(numSamplesSrc, packSize) / packSize, size_t(1));
+	if (srcBuffer.size() < numPacksSrc * nChannels) {
+		srcBuffer.resize(numPacksSrc * nChannels);
+	}
+	AudioSourceData srcs;
 	for (size_t channel = 0; channel < nChannels; ++channel) {
-		// First copy any leftovers
-		Expects(leftoverSamples[channel].n == nLeftOver);
-		for (size_t i = 0; i < nLeftOver; ++i) {
-			tmp[i] = leftoverSamples[channel].samples[i];
-		}
-
-		auto result = resamplers[channel]->resample(srcs[channel].subspan(0, numSamplesSrc), tmp.subspan(nLeftOver), 0);
-		Expects(result.nRead == numSamplesSrc);
-		Expects(result.nWritten >= samplesToGenerate);
-
-		// Store left overs
-		size_t leftOver = result.nWritten + nLeftOver - numSamples;
-		for (size_t i = 0; i < leftOver; ++i) {
-			leftoverSamples[channel].samples[i] = tmp[i + numSamples];
-		}
-		leftoverSamples[channel].n = leftOver;
+		srcs[channel] = gsl::span<AudioConfig::SampleFormat>(srcBuffer[channel * numPacksSrc].samples.data(), numPacksSrc * packSize);
+	}
+	const bool playing = numSamplesSrc == 0 || source->getAudioData(numSamplesSrc, srcs);
 
-		// Copy to destination
-		memcpy(dstBuffers[channel].data(), tmp.data(), numSamples * sizeof(AudioConfig::SampleFormat));
+	for (size_t channel = 0; channel < nChannels; ++channel) {
+		const auto result = resampler->resample(srcs[channel].subspan(0, numSamplesSrc), dstBuffers[channel].subspan(0, numSamples), channel);
+		Expects(result.nWritten == numSamples);
 	}
 
 	return playing;
@@ -1,31 +1,29 @@
 #pragma once
 #include "audio_source.h"
-#include "halley/audio/resampler.h"
 #include "audio_buffer.h"
+#include "audio_polyphase_resampler.h"
 
 namespace Halley
 {
 	class AudioFilterResample final : public AudioSource
 	{
 	public:
-		AudioFilterResample(std::shared_ptr<AudioSource> source, int fromHz, int toHz, AudioBufferPool& pool);
+		AudioFilterResample(std::shared_ptr<AudioSource> source, int fromHz, int toHz, AudioResamplerQuality quality = AudioResamplerQuality::Medium);
 
 		uint8_t getNumberOfChannels() const override;
 		bool isReady() const override;
+		bool isThreadSafe() const override;
 		bool getAudioData(size_t numSamples, AudioSourceData& dst) override;
+		bool canSkip() const override;
+		bool skipAudioData(size_t numSamples) override;
 
 	private:
-		AudioBufferPool& pool;
 		std::shared_ptr<AudioSource> source;
-		std::vector<std::unique_ptr<AudioResampler>> resamplers;
+		std::unique_ptr<AudioPolyphaseResampler> resampler;
 		int fromHz;
 		int toHz;
-
-		struct LeftOverData
-		{
-			std::array<AudioConfig::SampleFormat, 8> samples;
-			size_t n = 0;
-		};
-		std::array<LeftOverData, AudioConfig::maxChannels> leftoverSamples;
+		AudioResamplerQuality quality;
+		size_t skipRemainder = 0; // Fraction of a source sample left over from skipping, in steps of 1 / toHz
+		Vector<AudioSamplePack> srcBuffer; // Owned rather than pooled, as the voice may be mixed on any thread
 	};
 }
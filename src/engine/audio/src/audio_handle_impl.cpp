@@ -1,12 +1,51 @@
 #include "audio_handle_impl.h"
 #include "audio_facade.h"
-#include "audio_engine.h"
+#include "audio_command_queue.h"
 #include <algorithm>
-#include "behaviours/audio_voice_fade_behaviour.h"
-#include "halley/support/logger.h"
+#include <cstddef>
+#include "halley/utils/utils.h"
 
 using namespace Halley;
 
+void* AudioHandlePool::allocate(size_t size)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	if (blockSize == 0) {
+		// Every handle is the same type, so the first one decides the block size
+		blockSize = alignUp(std::max(size, sizeof(FreeBlock)), alignof(std::max_align_t));
+	}
+	if (size > blockSize) {
+		return ::operator new(size);
+	}
+
+	if (!freeBlocks) {
+		chunks.emplace_back(new char[blockSize * blocksPerChunk]);
+		char* chunk = chunks.back().get();
+		for (size_t i = blocksPerChunk; i-- > 0; ) {
+			auto* block = reinterpret_cast<FreeBlock*>(chunk + i * blockSize);
+			block->next = freeBlocks;
+			freeBlocks = block;
+		}
+	}
+
+	auto* block = freeBlocks;
+	freeBlocks = block->next;
+	return block;
+}
+
+void AudioHandlePool::deallocate(void* p, size_t size)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	if (size > blockSize) {
+		::operator delete(p);
+		return;
+	}
+
+	auto* block = static_cast<FreeBlock*>(p);
+	block->next = freeBlocks;
+	freeBlocks = block;
+}
+
 AudioHandleImpl::AudioHandleImpl(AudioFacade& facade, uint32_t id)
 	: facade(facade)
 	, handleId(id)
@@ -17,10 +56,7 @@ void AudioHandleImpl::setGain(float gain)
 {
 	if (std::abs(gain - this->gain) > 0.00001f) {
 		this->gain = gain;
-		enqueue([gain] (AudioVoice& src)
-		{
-			src.setUserGain(gain);
-		});
+		facade.enqueue(AudioCommand(AudioCommand::Type::SetVoiceGain, handleId, gain));
 	}
 }
 
@@ -31,81 +67,31 @@ void AudioHandleImpl::setVolume(float volume)
 
 void AudioHandleImpl::setPosition(Vector2f pos)
 {
-	enqueue([pos] (AudioVoice& src)
-	{
-		src.setAudioSourcePosition(Vector3f(pos));
-	});
+	auto command = AudioCommand(AudioCommand::Type::SetVoicePosition, handleId);
+	command.vector = Vector3f(pos);
+	facade.enqueue(std::move(command));
 }
 
 void AudioHandleImpl::setPan(float pan)
 {
-	enqueue([pan] (AudioVoice& src)
-	{
-		src.setAudioSourcePosition(AudioPosition::makeUI(pan));
-	});
+	facade.enqueue(AudioCommand(AudioCommand::Type::SetVoicePan, handleId, pan));
 }
 
 void AudioHandleImpl::stop(float fadeTime)
 {
-	enqueue([fadeTime] (AudioVoice& src)
-	{
-		if (fadeTime >= 0.001f) {
-			src.addBehaviour(std::make_unique<AudioVoiceFadeBehaviour>(fadeTime, 1.0f, 0.0f, true));
-		} else {
-			src.stop();
-		}
-	});
+	facade.enqueue(AudioCommand(AudioCommand::Type::StopVoice, handleId, fadeTime));
 }
 
-// This is kind of like a unique_ptr, but copying it also moves it. >_>
-template <typename T>
-class BadPointer {
-public:
-	BadPointer(T* v) : v(v) {}
-	BadPointer(const BadPointer& other) : v(other.v) { other.v = nullptr; }
-	BadPointer(BadPointer&& other) : v(other.v) { other.v = nullptr; }
-	~BadPointer() { delete v; }
-
-	T* release()
-	{
-		auto value = v;
-		v = nullptr;
-		return value;
-	}
-
-private:
-	mutable T* v = nullptr;
-};
-
-void AudioHandleImpl::addBehaviour(std::unique_ptr<AudioVoiceBehaviour> b)
+void AudioHandleImpl::addBehaviour(std::unique_ptr<AudioVoiceBehaviour> behaviour)
 {
-	// Gotta work around std::function requiring copyable
-	BadPointer<AudioVoiceBehaviour> behaviour = b.release();
-	enqueue([behaviour] (AudioVoice& src) mutable
-	{
-		auto b = std::unique_ptr<AudioVoiceBehaviour>(behaviour.release());
-		if (b) {
-			src.addBehaviour(std::move(b));
-		} else {
-			Logger::logWarning("AudioVoiceBehaviour lost since event has more than one voice.");
-		}
-	});
+	auto command = AudioCommand(AudioCommand::Type::AddVoiceBehaviour, handleId);
+	command.behaviour = std::move(behaviour);
+	facade.enqueue(std::move(command));
 }
 
 bool AudioHandleImpl::isPlaying() const
 {
-	auto& playing = facade.playingSounds;
-	return std::binary_search(playing.begin(), playing.end(), handleId);
-}
-
-
-void AudioHandleImpl::enqueue(std::function<void(AudioVoice& src)> f)
-{
-	uint32_t id = handleId;
-	AudioEngine* engine = facade.engine.get();
-	facade.enqueue([id, engine, f = std::move(f)] () {
-		for (const auto& src: engine->getSources(id)) {
-			f(*src);
-		}
-	});
+	const auto& playing = facade.playingSounds;
+	const auto iter = std::lower_bound(playing.begin(), playing.end(), handleId);
+	return iter != playing.end() && iter->id == handleId;
 }
@@ -1,12 +1,70 @@
 #pragma once
 #include "halley/core/api/audio_api.h"
-#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace Halley
 {
 	class AudioFacade;
 	class AudioVoice;
 
+	// Recycles the memory of handles (together with their shared_ptr control blocks), so handing one out doesn't hit the heap once warmed up
+	// Handles may be released on any thread, hence the lock
+	class AudioHandlePool
+	{
+	public:
+		void* allocate(size_t size);
+		void deallocate(void* p, size_t size);
+
+	private:
+		struct FreeBlock {
+			FreeBlock* next;
+		};
+
+		static constexpr size_t blocksPerChunk = 256;
+
+		std::mutex mutex;
+		FreeBlock* freeBlocks = nullptr;
+		size_t blockSize = 0;
+		std::vector<std::unique_ptr<char[]>> chunks;
+	};
+
+	template <typename T>
+	class AudioHandleAllocator
+	{
+	public:
+		using value_type = T;
+
+		explicit AudioHandleAllocator(std::shared_ptr<AudioHandlePool> pool)
+			: pool(std::move(pool))
+		{}
+
+		template <typename U>
+		AudioHandleAllocator(const AudioHandleAllocator<U>& other)
+			: pool(other.pool)
+		{}
+
+		T* allocate(size_t n)
+		{
+			return static_cast<T*>(pool->allocate(n * sizeof(T)));
+		}
+
+		void deallocate(T* p, size_t n)
+		{
+			pool->deallocate(p, n * sizeof(T));
+		}
+
+		template <typename U>
+		bool operator==(const AudioHandleAllocator<U>& other) const { return pool == other.pool; }
+
+		template <typename U>
+		bool operator!=(const AudioHandleAllocator<U>& other) const { return pool != other.pool; }
+
+		// Keeps the pool alive for as long as any handle is
+		std::shared_ptr<AudioHandlePool> pool;
+	};
+
 	class AudioHandleImpl final : public IAudioHandle
 	{
 	public:
@@ -24,7 +82,5 @@ namespace Halley
 		AudioFacade& facade;
 		uint32_t handleId;
 		float gain = 1.0f;
-
-		void enqueue(std::function<void(AudioVoice& src)> f);
 	};
 }
@@ -27,6 +27,16 @@ void AudioMixer::mixAudio(gsl::span<const AudioSamplePack> src, gsl::span<AudioS
 	}
 }
 
+void AudioMixer::sumAudio(gsl::span<const AudioSamplePack> src, gsl::span<AudioSamplePack> dst)
+{
+	const size_t nPacks = size_t(src.size());
+	for (size_t i = 0; i < nPacks; ++i) {
+		for (size_t j = 0; j < AudioSamplePack::NumSamples; ++j) {
+			dst[i].samples[j] += src[i].samples[j];
+		}
+	}
+}
+
 void AudioMixer::interleaveChannels(gsl::span<AudioSamplePack> dstBuffer, gsl::span<AudioBuffer*> srcs)
 {
 	Expects(srcs.size() == 2);
@@ -66,71 +76,62 @@ void AudioMixer::compressRange(gsl::span<AudioSamplePack> buffer)
 	}
 }
 
-#ifdef HAS_SSE
-
-#ifdef _MSC_VER
-
-#include <intrin.h>
-
-#else
-
-#include <cpuid.h>
-static inline unsigned long long _xgetbv(unsigned int index){
-	unsigned int eax, edx;
-	__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
-	return ((unsigned long long)edx << 32) | eax;
+void AudioMixer::convertToInt16(gsl::span<const AudioConfig::SampleFormat> src, gsl::span<short> dst)
+{
+	Expects(dst.size() >= src.size());
+	for (size_t i = 0; i < size_t(src.size()); ++i) {
+		dst[i] = static_cast<short>(src[i] * 32768.0f);
+	}
 }
-#define _XCR_XFEATURE_ENABLED_MASK 0
 
-#endif
+void AudioMixer::convertToInt32(gsl::span<const AudioConfig::SampleFormat> src, gsl::span<int> dst)
+{
+	Expects(dst.size() >= src.size());
+	for (size_t i = 0; i < size_t(src.size()); ++i) {
+		dst[i] = static_cast<int>(src[i] * 2147483648.0f);
+	}
+}
 
+#if defined(HAS_AVX) && defined(_MSC_VER)
+#include <intrin.h>
 #endif
 
-#ifdef HAS_AVX
-static bool hasAVX()
+bool AudioMixer::hasAVX2()
 {
-#ifndef _MSC_VER
-    // It's crashing on Linux :(
-    return false;
-#endif
-
-#ifdef HAS_SSE
+#if !defined(HAS_AVX)
+	return false;
+#elif defined(_MSC_VER)
 	int regs[4];
-	int i = 1;
-
-#ifdef _WIN32
-	__cpuid(regs, i);
-#else
-	asm volatile
-	("cpuid" : "=a" (regs[0]), "=b" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
-	: "a" (i), "c" (0));
-	// ECX is set to zero for CPUID function 4
-#endif
-
-	bool osUsesXSAVE_XRSTORE = regs[2] & (1 << 27) || false;
-	bool cpuAVXSuport = regs[2] & (1 << 28) || false;
+	__cpuid(regs, 1);
+	const bool osUsesXSAVE_XRSTORE = (regs[2] & (1 << 27)) != 0;
+	const bool cpuAVXSupport = (regs[2] & (1 << 28)) != 0;
+	const bool cpuFMASupport = (regs[2] & (1 << 12)) != 0;
+	if (!osUsesXSAVE_XRSTORE || !cpuAVXSupport || !cpuFMASupport) {
+		return false;
+	}
 
-	if (osUsesXSAVE_XRSTORE && cpuAVXSuport) {
-		unsigned long long xcrFeatureMask = _xgetbv(_XCR_XFEATURE_ENABLED_MASK);
-		return (xcrFeatureMask & 0x6) == 0x6;
-	} else {
+	// The OS has to save the YMM registers too
+	if ((_xgetbv(_XCR_XFEATURE_ENABLED_MASK) & 0x6) != 0x6) {
 		return false;
 	}
+
+	__cpuidex(regs, 7, 0);
+	return (regs[1] & (1 << 5)) != 0;
 #else
-	return false;
+	// Also checks that the OS saves the YMM registers
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
 #endif
 }
-#endif
 
 std::unique_ptr<AudioMixer> AudioMixer::makeMixer()
 {
 #ifdef HAS_AVX
-	if (hasAVX()) {
+	if (hasAVX2()) {
 		return std::make_unique<AudioMixerAVX>();
-	} else {
-		return std::make_unique<AudioMixerSSE>();
 	}
-#elif HAS_SEE
+#endif
+
+#ifdef HAS_SSE
 	return std::make_unique<AudioMixerSSE>();
 #else
 	return std::make_unique<AudioMixer>();
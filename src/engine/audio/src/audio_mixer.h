@@ -5,9 +5,7 @@
 
 #if defined(_M_X64) || defined(__x86_64__)
 #define HAS_SSE
-#if !defined(__linux__)
-#define HAS_AVX
-#endif
+#define HAS_AVX // Only compiled in, makeMixer checks whether the CPU supports it
 #endif
 
 #if defined(_M_IX86) || defined(__i386)
@@ -23,9 +21,15 @@ namespace Halley
 		virtual ~AudioMixer() {}
 
 		virtual void mixAudio(gsl::span<const AudioSamplePack> src, gsl::span<AudioSamplePack> dst, float gainStart, float gainEnd);
+		virtual void sumAudio(gsl::span<const AudioSamplePack> src, gsl::span<AudioSamplePack> dst);
 		virtual void interleaveChannels(gsl::span<AudioSamplePack> dst, gsl::span<AudioBuffer*> srcs);
 		virtual void concatenateChannels(gsl::span<AudioSamplePack> dst, gsl::span<AudioBuffer*> srcs);
 		virtual void compressRange(gsl::span<AudioSamplePack> buffer);
+		virtual void convertToInt16(gsl::span<const AudioConfig::SampleFormat> src, gsl::span<short> dst);
+		virtual void convertToInt32(gsl::span<const AudioConfig::SampleFormat> src, gsl::span<int> dst);
+
+		// Picks the fastest mixer the CPU supports
 		static std::unique_ptr<AudioMixer> makeMixer();
+		static bool hasAVX2();
 	};
 }
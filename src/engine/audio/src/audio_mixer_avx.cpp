@@ -1,11 +1,9 @@
 #include "audio_mixer_avx.h"
 
 #ifdef HAS_AVX
-#include <xmmintrin.h>
-
-#ifdef __clang__
+// This file is compiled with AVX2 and FMA enabled, and is only used once makeMixer has checked that the CPU supports them
+// Avoid calling anything non-trivial from here: inline functions instantiated in this file could end up being the copy the whole program uses
 #include <immintrin.h>
-#endif
 
 #ifdef _MSC_VER
 #include <intrin.h>
@@ -15,47 +13,112 @@ using namespace Halley;
 
 void AudioMixerAVX::mixAudio(gsl::span<const AudioSamplePack> srcRaw, gsl::span<AudioSamplePack> dstRaw, float gain0, float gain1)
 {
-	gsl::span<const __m256> src(reinterpret_cast<const __m256*>(srcRaw.data()), srcRaw.size() * 2);
-	gsl::span<__m256> dst(reinterpret_cast<__m256*>(dstRaw.data()), dstRaw.size() * 2);
-	const size_t nSamples = size_t(src.size());
+	const auto* src = reinterpret_cast<const __m256*>(srcRaw.data());
+	auto* dst = reinterpret_cast<__m256*>(dstRaw.data());
+	const size_t nSamples = size_t(srcRaw.size()) * 2;
 
 	if (gain0 == gain1) {
-		__m256 gain = _mm256_broadcast_ss(&gain0);
+		const __m256 gain = _mm256_set1_ps(gain0);
 		for (size_t i = 0; i < nSamples; i += 2) {
-			dst[i] = _mm256_add_ps(dst[i], _mm256_mul_ps(src[i], gain));
-			dst[i + 1] = _mm256_add_ps(dst[i + 1], _mm256_mul_ps(src[i + 1], gain));
+			dst[i] = _mm256_fmadd_ps(src[i], gain, dst[i]);
+			dst[i + 1] = _mm256_fmadd_ps(src[i + 1], gain, dst[i + 1]);
 		}
 	} else {
-		const float sc = 1.0f / (dst.size() * 16);
-		const float gainDiff = gain1 - gain0;
-		const float eight = 8.0f;
-
-		__m256 gain0p = _mm256_broadcast_ss(&gain0);
-		__m256 gain1p = _mm256_broadcast_ss(&gainDiff);
-		__m256 scale = _mm256_broadcast_ss(&sc);
-		__m256 inc = _mm256_broadcast_ss(&eight);
-		__m256 offset = { 0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f };
+		const float sc = 1.0f / (dstRaw.size() * 16);
+
+		const __m256 gain0p = _mm256_set1_ps(gain0);
+		const __m256 gainDiff = _mm256_set1_ps(gain1 - gain0);
+		const __m256 scale = _mm256_set1_ps(sc);
+		const __m256 inc = _mm256_set1_ps(8.0f);
+		__m256 offset = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
 		for (size_t i = 0; i < nSamples; ++i) {
-			__m256 t = _mm256_mul_ps(offset, scale);
-			__m256 gain = _mm256_add_ps(gain0p, _mm256_mul_ps(gain1p, t));
+			const __m256 gain = _mm256_fmadd_ps(gainDiff, _mm256_mul_ps(offset, scale), gain0p);
 			offset = _mm256_add_ps(offset, inc);
-			dst[i] = _mm256_add_ps(dst[i], _mm256_mul_ps(src[i], gain));
+			dst[i] = _mm256_fmadd_ps(src[i], gain, dst[i]);
 		}
 	}
 }
 
+void AudioMixerAVX::sumAudio(gsl::span<const AudioSamplePack> srcRaw, gsl::span<AudioSamplePack> dstRaw)
+{
+	const auto* src = reinterpret_cast<const __m256*>(srcRaw.data());
+	auto* dst = reinterpret_cast<__m256*>(dstRaw.data());
+	const size_t nSamples = size_t(srcRaw.size()) * 2;
+
+	for (size_t i = 0; i < nSamples; i += 2) {
+		dst[i] = _mm256_add_ps(dst[i], src[i]);
+		dst[i + 1] = _mm256_add_ps(dst[i + 1], src[i + 1]);
+	}
+}
+
+void AudioMixerAVX::interleaveChannels(gsl::span<AudioSamplePack> dstBuffer, gsl::span<AudioBuffer*> srcs)
+{
+	if (srcs.size() != 2) {
+		AudioMixer::interleaveChannels(dstBuffer, srcs);
+		return;
+	}
+
+	const auto* left = reinterpret_cast<const __m256*>(srcs[0]->packs.data());
+	const auto* right = reinterpret_cast<const __m256*>(srcs[1]->packs.data());
+	auto* dst = reinterpret_cast<__m256*>(dstBuffer.data());
+	const size_t nSamples = size_t(dstBuffer.size());
+
+	for (size_t i = 0; i < nSamples; ++i) {
+		// Unpacking works within each 128-bit lane, so the halves need swapping around afterwards
+		const __m256 lo = _mm256_unpacklo_ps(left[i], right[i]);
+		const __m256 hi = _mm256_unpackhi_ps(left[i], right[i]);
+		dst[2 * i] = _mm256_permute2f128_ps(lo, hi, 0x20);
+		dst[2 * i + 1] = _mm256_permute2f128_ps(lo, hi, 0x31);
+	}
+}
+
 void AudioMixerAVX::compressRange(gsl::span<AudioSamplePack> buffer)
 {
-	gsl::span<__m256> dst(reinterpret_cast<__m256*>(buffer.data()), buffer.size() * 2);
-	const size_t nSamples = size_t(dst.size());
+	auto* dst = reinterpret_cast<__m256*>(buffer.data());
+	const size_t nSamples = size_t(buffer.size()) * 2;
 
-	float val = 0.99995f;
-	__m256 minVal = { -val, -val, -val, -val, -val, -val, -val, -val };
-	__m256 maxVal = { val, val, val, val, val, val, val, val };
+	const __m256 minVal = _mm256_set1_ps(-0.99995f);
+	const __m256 maxVal = _mm256_set1_ps(0.99995f);
 
 	for (size_t i = 0; i < nSamples; ++i) {
 		dst[i] = _mm256_max_ps(minVal, _mm256_min_ps(dst[i], maxVal));
 	}
 }
 
+void AudioMixerAVX::convertToInt16(gsl::span<const AudioConfig::SampleFormat> src, gsl::span<short> dst)
+{
+	Expects(dst.size() >= src.size());
+	const size_t nVector = size_t(src.size()) & ~size_t(15);
+	const __m256 scale = _mm256_set1_ps(32768.0f);
+
+	for (size_t i = 0; i < nVector; i += 16) {
+		const __m256i a = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src.data() + i), scale));
+		const __m256i b = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src.data() + i + 8), scale));
+
+		// Packing also works per lane, which leaves the middle two quarters swapped
+		const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst.data() + i), packed);
+	}
+
+	for (size_t i = nVector; i < size_t(src.size()); ++i) {
+		dst[i] = static_cast<short>(src[i] * 32768.0f);
+	}
+}
+
+void AudioMixerAVX::convertToInt32(gsl::span<const AudioConfig::SampleFormat> src, gsl::span<int> dst)
+{
+	Expects(dst.size() >= src.size());
+	const size_t nVector = size_t(src.size()) & ~size_t(7);
+	const __m256 scale = _mm256_set1_ps(2147483648.0f);
+
+	for (size_t i = 0; i < nVector; i += 8) {
+		const __m256i a = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src.data() + i), scale));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst.data() + i), a);
+	}
+
+	for (size_t i = nVector; i < size_t(src.size()); ++i) {
+		dst[i] = static_cast<int>(src[i] * 2147483648.0f);
+	}
+}
+
 #endif
@@ -2,6 +2,7 @@
 
 #ifdef HAS_SSE
 #include <xmmintrin.h>
+#include <emmintrin.h>
 
 #ifdef _MSC_VER
 #include <intrin.h>
@@ -24,7 +25,7 @@ void AudioMixerSSE::mixAudio(gsl::span<const AudioSamplePack> srcRaw, gsl::span<
 			dst[i + 3] = _mm_add_ps(dst[i + 3], _mm_mul_ps(src[i + 3], gain));
 		}
 	} else {
-		const float sc = 1.0f / (dst.size() * 16);
+		const float sc = 1.0f / (dstRaw.size() * AudioSamplePack::NumSamples);
 		const float gainDiff = gain1 - gain0;
 
 		__m128 gain0p = { gain0, gain0, gain0, gain0 };
@@ -41,6 +42,38 @@ void AudioMixerSSE::mixAudio(gsl::span<const AudioSamplePack> srcRaw, gsl::span<
 	}
 }
 
+void AudioMixerSSE::sumAudio(gsl::span<const AudioSamplePack> srcRaw, gsl::span<AudioSamplePack> dstRaw)
+{
+	const auto* src = reinterpret_cast<const __m128*>(srcRaw.data());
+	auto* dst = reinterpret_cast<__m128*>(dstRaw.data());
+	const size_t nSamples = size_t(srcRaw.size()) * 4;
+
+	for (size_t i = 0; i < nSamples; i += 4) {
+		dst[i] = _mm_add_ps(dst[i], src[i]);
+		dst[i + 1] = _mm_add_ps(dst[i + 1], src[i + 1]);
+		dst[i + 2] = _mm_add_ps(dst[i + 2], src[i + 2]);
+		dst[i + 3] = _mm_add_ps(dst[i + 3], src[i + 3]);
+	}
+}
+
+void AudioMixerSSE::interleaveChannels(gsl::span<AudioSamplePack> dstBuffer, gsl::span<AudioBuffer*> srcs)
+{
+	if (srcs.size() != 2) {
+		AudioMixer::interleaveChannels(dstBuffer, srcs);
+		return;
+	}
+
+	const size_t nSamples = size_t(dstBuffer.size()) * 2;
+	const auto* left = reinterpret_cast<const __m128*>(srcs[0]->packs.data());
+	const auto* right = reinterpret_cast<const __m128*>(srcs[1]->packs.data());
+	auto* dst = reinterpret_cast<__m128*>(dstBuffer.data());
+
+	for (size_t i = 0; i < nSamples; ++i) {
+		dst[2 * i] = _mm_unpacklo_ps(left[i], right[i]);
+		dst[2 * i + 1] = _mm_unpackhi_ps(left[i], right[i]);
+	}
+}
+
 void AudioMixerSSE::compressRange(gsl::span<AudioSamplePack> buffer)
 {
 	gsl::span<__m128> dst(reinterpret_cast<__m128*>(buffer.data()), buffer.size() * 4);
@@ -55,4 +88,35 @@ void AudioMixerSSE::compressRange(gsl::span<AudioSamplePack> buffer)
 	}
 }
 
+void AudioMixerSSE::convertToInt16(gsl::span<const AudioConfig::SampleFormat> src, gsl::span<short> dst)
+{
+	Expects(dst.size() >= src.size());
+	const size_t n = size_t(src.size());
+	const size_t nVector = n & ~size_t(7);
+	const __m128 scale = _mm_set1_ps(32768.0f);
+
+	for (size_t i = 0; i < nVector; i += 8) {
+		const __m128i a = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(src.data() + i), scale));
+		const __m128i b = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(src.data() + i + 4), scale));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst.data() + i), _mm_packs_epi32(a, b));
+	}
+
+	AudioMixer::convertToInt16(src.subspan(nVector), dst.subspan(nVector));
+}
+
+void AudioMixerSSE::convertToInt32(gsl::span<const AudioConfig::SampleFormat> src, gsl::span<int> dst)
+{
+	Expects(dst.size() >= src.size());
+	const size_t n = size_t(src.size());
+	const size_t nVector = n & ~size_t(3);
+	const __m128 scale = _mm_set1_ps(2147483648.0f);
+
+	for (size_t i = 0; i < nVector; i += 4) {
+		const __m128i a = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(src.data() + i), scale));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst.data() + i), a);
+	}
+
+	AudioMixer::convertToInt32(src.subspan(nVector), dst.subspan(nVector));
+}
+
 #endif
@@ -8,7 +8,11 @@ namespace Halley
 	{
 	public:
 		void mixAudio(gsl::span<const AudioSamplePack> src, gsl::span<AudioSamplePack> dst, float gainStart, float gainEnd) override;
+		void sumAudio(gsl::span<const AudioSamplePack> src, gsl::span<AudioSamplePack> dst) override;
+		void interleaveChannels(gsl::span<AudioSamplePack> dst, gsl::span<AudioBuffer*> srcs) override;
 		void compressRange(gsl::span<AudioSamplePack> buffer) override;
+		void convertToInt16(gsl::span<const AudioConfig::SampleFormat> src, gsl::span<short> dst) override;
+		void convertToInt32(gsl::span<const AudioConfig::SampleFormat> src, gsl::span<int> dst) override;
 	};
 }
 #endif
@@ -0,0 +1,188 @@
+#include "audio_offline_renderer.h"
+#include <algorithm>
+#include <cmath>
+#include "audio_engine.h"
+
+using namespace Halley;
+
+double AudioOfflineRenderer::Stats::getRealtimeFactor() const
+{
+	return meanTime > 0 ? bufferDuration / meanTime : 0;
+}
+
+AudioOfflineRenderer::AudioOfflineRenderer(AudioSpec spec)
+	: spec(spec)
+	, engine(std::make_unique<AudioEngine>())
+{
+	engine->start(spec, *this);
+}
+
+AudioOfflineRenderer::~AudioOfflineRenderer()
+{
+}
+
+AudioEngine& AudioOfflineRenderer::getEngine()
+{
+	return *engine;
+}
+
+const AudioSpec& AudioOfflineRenderer::getSpec() const
+{
+	return spec;
+}
+
+void AudioOfflineRenderer::render(size_t numBuffers)
+{
+	for (size_t i = 0; i < numBuffers; ++i) {
+		engine->generateBuffer();
+		bufferTimes.push_back(engine->getLastTimeElapsed());
+	}
+}
+
+void AudioOfflineRenderer::renderSeconds(float seconds)
+{
+	render(size_t(std::ceil(seconds * spec.sampleRate / spec.bufferSize)));
+}
+
+const std::vector<int64_t>& AudioOfflineRenderer::getBufferTimes() const
+{
+	return bufferTimes;
+}
+
+AudioOfflineRenderer::Stats AudioOfflineRenderer::getStats() const
+{
+	Stats stats;
+	stats.numBuffers = bufferTimes.size();
+	stats.bufferDuration = double(spec.bufferSize) / spec.sampleRate;
+	if (bufferTimes.empty()) {
+		return stats;
+	}
+
+	auto sorted = bufferTimes;
+	std::sort(sorted.begin(), sorted.end());
+
+	int64_t total = 0;
+	for (const auto t: sorted) {
+		total += t;
+	}
+	constexpr double toSeconds = 1.0 / 1000000000.0;
+	stats.meanTime = double(total) / sorted.size() * toSeconds;
+	stats.medianTime = sorted[sorted.size() / 2] * toSeconds;
+	stats.p99Time = sorted[std::min(sorted.size() * 99 / 100, sorted.size() - 1)] * toSeconds;
+	stats.maxTime = sorted.back() * toSeconds;
+	return stats;
+}
+
+void AudioOfflineRenderer::resetStats()
+{
+	bufferTimes.clear();
+}
+
+void AudioOfflineRenderer::setRecording(bool enabled)
+{
+	recording = enabled;
+}
+
+gsl::span<const gsl::byte> AudioOfflineRenderer::getRecording() const
+{
+	return recorded;
+}
+
+void AudioOfflineRenderer::clearRecording()
+{
+	recorded.clear();
+}
+
+Bytes AudioOfflineRenderer::makeWAV() const
+{
+	const bool isFloat = spec.format == AudioSampleFormat::Float;
+	const uint16_t formatTag = isFloat ? 3 : 1; // WAVE_FORMAT_IEEE_FLOAT or WAVE_FORMAT_PCM
+	const uint16_t bitsPerSample = spec.format == AudioSampleFormat::Int16 ? 16 : 32;
+	const uint16_t blockAlign = uint16_t(spec.numChannels * bitsPerSample / 8);
+	const auto dataSize = uint32_t(recorded.size());
+
+	Bytes result;
+	auto write = [&] (const void* data, size_t size)
+	{
+		const auto* bytes = static_cast<const Byte*>(data);
+		result.insert(result.end(), bytes, bytes + size);
+	};
+	auto writeU16 = [&] (uint16_t value) { const Byte b[] = { Byte(value), Byte(value >> 8) }; write(b, 2); };
+	auto writeU32 = [&] (uint32_t value) { const Byte b[] = { Byte(value), Byte(value >> 8), Byte(value >> 16), Byte(value >> 24) }; write(b, 4); };
+
+	// Non-PCM formats also need a fact chunk, with the number of frames
+	const uint32_t factSize = isFloat ? 12 : 0;
+
+	write("RIFF", 4);
+	writeU32(4 + 24 + factSize + 8 + dataSize);
+	write("WAVE", 4);
+
+	write("fmt ", 4);
+	writeU32(16);
+	writeU16(formatTag);
+	writeU16(uint16_t(spec.numChannels));
+	writeU32(uint32_t(spec.sampleRate));
+	writeU32(uint32_t(spec.sampleRate) * blockAlign);
+	writeU16(blockAlign);
+	writeU16(bitsPerSample);
+
+	if (isFloat) {
+		write("fact", 4);
+		writeU32(4);
+		writeU32(dataSize / blockAlign);
+	}
+
+	write("data", 4);
+	writeU32(dataSize);
+	write(recorded.data(), recorded.size());
+
+	return result;
+}
+
+void AudioOfflineRenderer::saveWAV(const Path& path) const
+{
+	Path::writeFile(path, makeWAV());
+}
+
+Vector<std::unique_ptr<const AudioDevice>> AudioOfflineRenderer::getAudioDevices()
+{
+	return {};
+}
+
+AudioSpec AudioOfflineRenderer::openAudioDevice(const AudioSpec& requestedFormat, const AudioDevice* device, AudioCallback prepareAudioCallback)
+{
+	return spec;
+}
+
+void AudioOfflineRenderer::closeAudioDevice()
+{
+}
+
+void AudioOfflineRenderer::startPlayback()
+{
+}
+
+void AudioOfflineRenderer::stopPlayback()
+{
+}
+
+void AudioOfflineRenderer::onAudioAvailable()
+{
+	// Take everything straight away, so the engine's output buffer never fills up
+	auto& src = getAudioOutputInterface();
+	const size_t available = src.getAvailable();
+	auto& dst = recording ? recorded : discarded;
+	const size_t start = recording ? recorded.size() : 0;
+	dst.resize(start + available);
+	src.output(gsl::span<gsl::byte>(dst.data() + start, available), false);
+}
+
+bool AudioOfflineRenderer::needsMoreAudio()
+{
+	return true;
+}
+
+bool AudioOfflineRenderer::needsAudioThread() const
+{
+	return false;
+}
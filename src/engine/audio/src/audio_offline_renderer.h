@@ -0,0 +1,65 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "halley/core/api/audio_api.h"
+#include "halley/file/path.h"
+#include "halley/utils/utils.h"
+
+namespace Halley {
+	class AudioEngine;
+
+	// Drives an AudioEngine without an audio device, generating buffers back to back as fast as the engine can mix them
+	// Used to measure the cost of mixing, and to capture the engine's output for regression tests
+	class AudioOfflineRenderer final : public AudioOutputAPI {
+	public:
+		struct Stats {
+			size_t numBuffers = 0;
+			double bufferDuration = 0; // Seconds of audio in each buffer
+			double meanTime = 0; // Seconds taken to generate a buffer
+			double medianTime = 0;
+			double p99Time = 0;
+			double maxTime = 0;
+
+			// How many times faster than real time the buffers were generated, on average
+			double getRealtimeFactor() const;
+		};
+
+		explicit AudioOfflineRenderer(AudioSpec spec = AudioSpec(AudioConfig::sampleRate, 2, 512, AudioSampleFormat::Float));
+		~AudioOfflineRenderer();
+
+		AudioEngine& getEngine();
+		const AudioSpec& getSpec() const;
+
+		void render(size_t numBuffers);
+		void renderSeconds(float seconds);
+
+		const std::vector<int64_t>& getBufferTimes() const; // In nanoseconds
+		Stats getStats() const;
+		void resetStats();
+
+		// When recording, everything rendered is kept, in the output format, and can be saved as a WAV file
+		void setRecording(bool enabled);
+		gsl::span<const gsl::byte> getRecording() const;
+		void clearRecording();
+		Bytes makeWAV() const;
+		void saveWAV(const Path& path) const;
+
+		Vector<std::unique_ptr<const AudioDevice>> getAudioDevices() override;
+		AudioSpec openAudioDevice(const AudioSpec& requestedFormat, const AudioDevice* device, AudioCallback prepareAudioCallback) override;
+		void closeAudioDevice() override;
+		void startPlayback() override;
+		void stopPlayback() override;
+		void onAudioAvailable() override;
+		bool needsMoreAudio() override;
+		bool needsAudioThread() const override;
+
+	private:
+		AudioSpec spec;
+		std::unique_ptr<AudioEngine> engine;
+
+		bool recording = false;
+		std::vector<gsl::byte> recorded;
+		std::vector<gsl::byte> discarded;
+		std::vector<int64_t> bufferTimes;
+	};
+}
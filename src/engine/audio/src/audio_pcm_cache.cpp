@@ -0,0 +1,166 @@
+#include "audio_pcm_cache.h"
+
+using namespace Halley;
+
+size_t AudioPCMData::getSizeBytes() const
+{
+	size_t size = 0;
+	for (const auto& channel: samples) {
+		size += channel.size() * sizeof(AudioConfig::SampleFormat);
+	}
+	return size;
+}
+
+bool AudioPCMCache::Key::operator==(const Key& other) const
+{
+	return version == other.version && assetId == other.assetId;
+}
+
+size_t AudioPCMCache::KeyHasher::operator()(const Key& key) const
+{
+	return std::hash<String>()(key.assetId) ^ std::hash<uint64_t>()(key.version);
+}
+
+AudioPCMCache::AudioPCMCache(size_t budgetBytes, size_t maxClipBytes)
+	: budget(budgetBytes)
+	, maxClipSize(maxClipBytes)
+{
+}
+
+AudioPCMCache& AudioPCMCache::get()
+{
+	// Clips are loaded on resource threads, with no engine around, so the cache is shared by the whole process
+	static AudioPCMCache cache;
+	return cache;
+}
+
+void AudioPCMCache::setBudget(size_t bytes)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	budget = bytes;
+	evict();
+}
+
+size_t AudioPCMCache::getBudget() const
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	return budget;
+}
+
+void AudioPCMCache::setMaxClipSize(size_t bytes)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	maxClipSize = bytes;
+}
+
+size_t AudioPCMCache::getMaxClipSize() const
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	return maxClipSize;
+}
+
+bool AudioPCMCache::canCache(size_t sizeBytes) const
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	return sizeBytes <= maxClipSize && sizeBytes <= budget;
+}
+
+std::shared_ptr<const AudioPCMData> AudioPCMCache::getOrDecode(const Key& key, const Decoder& decoder)
+{
+	std::shared_ptr<Slot> slot;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		const auto iter = index.find(key);
+		if (iter != index.end()) {
+			entries.splice(entries.begin(), entries, iter->second);
+			slot = iter->second->slot;
+		} else {
+			entries.push_front(Entry{ key, std::make_shared<Slot>(), 0 });
+			index[key] = entries.begin();
+			slot = entries.front().slot;
+		}
+	}
+
+	// Anyone else asking for the same key waits here until it's decoded
+	std::unique_lock<std::mutex> decodeLock(slot->decodeMutex);
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (slot->data) {
+			++hits;
+			evict();
+			return slot->data;
+		}
+	}
+
+	std::shared_ptr<const AudioPCMData> data;
+	try {
+		data = std::make_shared<const AudioPCMData>(decoder());
+	} catch (...) {
+		std::unique_lock<std::mutex> lock(mutex);
+		const auto iter = index.find(key);
+		if (iter != index.end() && iter->second->slot == slot) {
+			entries.erase(iter->second);
+			index.erase(iter);
+		}
+		throw;
+	}
+
+	std::unique_lock<std::mutex> lock(mutex);
+	++misses;
+	slot->data = data;
+	const auto iter = index.find(key);
+	if (iter != index.end() && iter->second->slot == slot) {
+		iter->second->sizeBytes = data->getSizeBytes();
+		totalSize += iter->second->sizeBytes;
+	}
+	evict();
+
+	return data;
+}
+
+size_t AudioPCMCache::getSizeBytes() const
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	return totalSize;
+}
+
+size_t AudioPCMCache::getNumEntries() const
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	return entries.size();
+}
+
+size_t AudioPCMCache::getNumHits() const
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	return hits;
+}
+
+size_t AudioPCMCache::getNumMisses() const
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	return misses;
+}
+
+void AudioPCMCache::clear()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	const size_t prevBudget = budget;
+	budget = 0;
+	evict();
+	budget = prevBudget;
+}
+
+void AudioPCMCache::evict()
+{
+	// Only entries which nobody else holds free any memory when dropped
+	// The entry being returned is always held at this point, so it only becomes evictable on a later call
+	for (auto iter = entries.end(); iter != entries.begin() && totalSize > budget; ) {
+		--iter;
+		if (iter->slot->data && iter->slot->data.use_count() == 1) {
+			totalSize -= iter->sizeBytes;
+			index.erase(iter->key);
+			iter = entries.erase(iter);
+		}
+	}
+}
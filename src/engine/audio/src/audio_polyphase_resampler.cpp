@@ -0,0 +1,300 @@
+#include "audio_polyphase_resampler.h"
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <tuple>
+#include "audio_mixer.h"
+
+#ifdef HAS_SSE
+#include <xmmintrin.h>
+#endif
+
+using namespace Halley;
+
+struct AudioPolyphaseResampler::FilterBank {
+	size_t numTaps = 0;
+	size_t numPhases = 0;
+
+	// numPhases + 1 phases of numTaps each; the last is the first one shifted by a whole sample, so any phase can be interpolated with the next
+	std::vector<float> coefficients;
+};
+
+namespace {
+	constexpr size_t maxExactPhases = 256;
+	constexpr size_t interpolatedPhases = 256;
+	constexpr int cutoffSteps = 64;
+
+	struct QualityParameters {
+		size_t numTaps;
+		double kaiserBeta;
+		double rolloff; // Fraction of the Nyquist frequency that's kept
+	};
+
+	QualityParameters getQualityParameters(AudioResamplerQuality quality)
+	{
+		switch (quality) {
+		case AudioResamplerQuality::Fast:
+			return { 8, 5.0, 0.85 };
+		case AudioResamplerQuality::High:
+			return { 32, 9.0, 0.94 };
+		default:
+			return { 16, 7.0, 0.9 };
+		}
+	}
+
+	double besselI0(double x)
+	{
+		double sum = 1.0;
+		double term = 1.0;
+		for (int k = 1; k < 50 && term > sum * 1e-12; ++k) {
+			const double y = x / (2 * k);
+			term *= y * y;
+			sum += term;
+		}
+		return sum;
+	}
+
+	std::shared_ptr<const AudioPolyphaseResampler::FilterBank> makeFilterBank(size_t numPhases, AudioResamplerQuality quality, double cutoff)
+	{
+		constexpr double pi = 3.14159265358979323846;
+		const auto params = getQualityParameters(quality);
+		const size_t numTaps = params.numTaps;
+		const double centre = double(numTaps / 2 - 1);
+		const double halfWidth = double(numTaps / 2);
+		const double i0Beta = besselI0(params.kaiserBeta);
+		const double fc = cutoff * params.rolloff;
+
+		auto bank = std::make_shared<AudioPolyphaseResampler::FilterBank>();
+		bank->numTaps = numTaps;
+		bank->numPhases = numPhases;
+		bank->coefficients.resize((numPhases + 1) * numTaps);
+
+		for (size_t phase = 0; phase <= numPhases; ++phase) {
+			const double offset = double(phase) / double(numPhases);
+			float* taps = bank->coefficients.data() + phase * numTaps;
+
+			double sum = 0;
+			for (size_t i = 0; i < numTaps; ++i) {
+				const double t = double(i) - centre - offset;
+				const double x = pi * fc * t;
+				const double sinc = std::abs(x) < 1e-9 ? 1.0 : std::sin(x) / x;
+				const double r = t / halfWidth;
+				const double window = std::abs(r) >= 1.0 ? 0.0 : besselI0(params.kaiserBeta * std::sqrt(1.0 - r * r)) / i0Beta;
+				const double value = fc * sinc * window;
+				taps[i] = float(value);
+				sum += value;
+			}
+
+			// Normalise every phase to unity gain at DC, otherwise the phases' ripple shows up as noise
+			for (size_t i = 0; i < numTaps; ++i) {
+				taps[i] = float(taps[i] / sum);
+			}
+		}
+
+		return bank;
+	}
+
+	std::shared_ptr<const AudioPolyphaseResampler::FilterBank> getFilterBank(size_t numPhases, AudioResamplerQuality quality, double ratio)
+	{
+		// Downsampling ratios only differ in their cutoff, which is rounded down to a few steps
+		// That keeps random pitches from each making their own bank, and rounding down can only take away a little treble, never alias
+		const int cutoffKey = std::max(1, int(std::floor(std::min(ratio, 1.0) * cutoffSteps)));
+		const auto key = std::make_tuple(numPhases, int(quality), cutoffKey);
+
+		static std::mutex mutex;
+		static std::map<std::tuple<size_t, int, int>, std::weak_ptr<const AudioPolyphaseResampler::FilterBank>> banks;
+
+		std::unique_lock<std::mutex> lock(mutex);
+		auto bank = banks[key].lock();
+		if (!bank) {
+			for (auto iter = banks.begin(); iter != banks.end(); ) {
+				iter = iter->second.expired() ? banks.erase(iter) : std::next(iter);
+			}
+			bank = makeFilterBank(numPhases, quality, double(cutoffKey) / cutoffSteps);
+			banks[key] = bank;
+		}
+		return bank;
+	}
+
+	float dotProduct(const float* a, const float* b, size_t n)
+	{
+#ifdef HAS_SSE
+		// Tap counts are always a multiple of 8
+		__m128 sum0 = _mm_setzero_ps();
+		__m128 sum1 = _mm_setzero_ps();
+		for (size_t i = 0; i < n; i += 8) {
+			sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+			sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+		}
+		__m128 sum = _mm_add_ps(sum0, sum1);
+		sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+		sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+		return _mm_cvtss_f32(sum);
+#else
+		float sum = 0;
+		for (size_t i = 0; i < n; ++i) {
+			sum += a[i] * b[i];
+		}
+		return sum;
+#endif
+	}
+}
+
+AudioPolyphaseResampler::AudioPolyphaseResampler(int from, int to, size_t nChannels, AudioResamplerQuality quality)
+{
+	Expects(from > 0);
+	Expects(to > 0);
+
+	const int divisor = std::gcd(from, to);
+	upFactor = uint64_t(to / divisor);
+	downFactor = uint64_t(from / divisor);
+	exact = upFactor <= maxExactPhases;
+	if (upFactor != downFactor) {
+		bank = getFilterBank(exact ? size_t(upFactor) : interpolatedPhases, quality, double(upFactor) / double(downFactor));
+	}
+
+	channels.resize(nChannels);
+	reset();
+}
+
+AudioPolyphaseResampler::~AudioPolyphaseResampler() = default;
+
+AudioResamplerResult AudioPolyphaseResampler::resample(gsl::span<const float> src, gsl::span<float> dst, size_t channel)
+{
+	Expects(channel < channels.size());
+
+	AudioResamplerResult result;
+	result.nRead = size_t(src.size());
+	result.nWritten = process(channels[channel], src.data(), size_t(src.size()), 1, dst.data(), size_t(dst.size()), 1);
+	return result;
+}
+
+AudioResamplerResult AudioPolyphaseResampler::resampleInterleaved(gsl::span<const float> src, gsl::span<float> dst)
+{
+	const size_t nChannels = channels.size();
+	const size_t srcFrames = size_t(src.size()) / nChannels;
+	const size_t dstFrames = size_t(dst.size()) / nChannels;
+
+	AudioResamplerResult result;
+	result.nRead = srcFrames;
+	result.nWritten = 0;
+	for (size_t i = 0; i < nChannels; ++i) {
+		result.nWritten = process(channels[i], src.data() + i, srcFrames, nChannels, dst.data() + i, dstFrames, nChannels);
+	}
+	return result;
+}
+
+AudioResamplerResult AudioPolyphaseResampler::resampleNoninterleaved(gsl::span<const float> src, gsl::span<float> dst, size_t numChannels)
+{
+	Expects(numChannels <= channels.size());
+	const size_t srcFrames = size_t(src.size()) / numChannels;
+	const size_t dstFrames = size_t(dst.size()) / numChannels;
+
+	// Every channel advances in lockstep, so the output channels are packed back to back, just like the input
+	AudioResamplerResult result;
+	result.nRead = srcFrames;
+	result.nWritten = 0;
+	for (size_t i = 0; i < numChannels; ++i) {
+		const size_t dstOffset = i * result.nWritten;
+		result.nWritten = process(channels[i], src.data() + i * srcFrames, srcFrames, 1, dst.data() + dstOffset, std::min(dstFrames, size_t(dst.size()) - dstOffset), 1);
+	}
+	return result;
+}
+
+size_t AudioPolyphaseResampler::getInputSamplesNeeded(size_t numOutputSamples, size_t channel) const
+{
+	Expects(channel < channels.size());
+	if (numOutputSamples == 0) {
+		return 0;
+	}
+
+	const auto& state = channels[channel];
+	const uint64_t numTaps = bank ? bank->numTaps : 1;
+	const uint64_t lastPos = (state.phase + uint64_t(numOutputSamples - 1) * downFactor) / upFactor;
+	const uint64_t needed = state.skip + lastPos + numTaps;
+	return needed > state.window.size() ? size_t(needed - state.window.size()) : 0;
+}
+
+size_t AudioPolyphaseResampler::numOutputSamples(size_t numInputSamples) const
+{
+	return size_t(uint64_t(numInputSamples) * upFactor / downFactor);
+}
+
+void AudioPolyphaseResampler::reset()
+{
+	// Starting with half a filter of silence centres the first output on the first input sample, so there's no delay
+	const size_t history = bank ? bank->numTaps / 2 - 1 : 0;
+	for (auto& state: channels) {
+		state.window.assign(history, 0.0f);
+		state.phase = 0;
+		state.skip = 0;
+	}
+}
+
+size_t AudioPolyphaseResampler::process(ChannelState& state, const float* src, size_t srcLen, size_t srcStride, float* dst, size_t dstLen, size_t dstStride)
+{
+	// Drop any input the previous call already stepped past
+	const size_t skipped = std::min(state.skip, srcLen);
+	state.skip -= skipped;
+
+	auto& window = state.window;
+	const size_t prevSize = window.size();
+	window.resize(prevSize + srcLen - skipped);
+	for (size_t i = skipped; i < srcLen; ++i) {
+		window[prevSize + i - skipped] = src[i * srcStride];
+	}
+
+	const size_t numTaps = bank ? bank->numTaps : 1;
+	size_t pos = 0;
+	size_t written = 0;
+
+	if (downFactor == 1) {
+		// Integer upsampling (or none at all): run through every phase on the same input position, with no divisions
+		while (written < dstLen && pos + numTaps <= window.size()) {
+			dst[written * dstStride] = filter(window.data() + pos, state.phase);
+			++written;
+			if (++state.phase == upFactor) {
+				state.phase = 0;
+				++pos;
+			}
+		}
+	} else {
+		while (written < dstLen && pos + numTaps <= window.size()) {
+			dst[written * dstStride] = filter(window.data() + pos, state.phase);
+			++written;
+			state.phase += downFactor;
+			pos += size_t(state.phase / upFactor);
+			state.phase %= upFactor;
+		}
+	}
+
+	if (pos >= window.size()) {
+		state.skip += pos - window.size();
+		window.clear();
+	} else {
+		window.erase(window.begin(), window.begin() + pos);
+	}
+
+	return written;
+}
+
+float AudioPolyphaseResampler::filter(const float* window, uint64_t phase) const
+{
+	if (!bank) {
+		return window[0];
+	}
+
+	const size_t numTaps = bank->numTaps;
+	const float* coefficients = bank->coefficients.data();
+	if (exact) {
+		return dotProduct(window, coefficients + phase * numTaps, numTaps);
+	}
+
+	const double position = double(phase) * double(bank->numPhases) / double(upFactor);
+	const auto index = size_t(position);
+	const auto frac = float(position - double(index));
+	const float a = dotProduct(window, coefficients + index * numTaps, numTaps);
+	const float b = dotProduct(window, coefficients + (index + 1) * numTaps, numTaps);
+	return a + (b - a) * frac;
+}
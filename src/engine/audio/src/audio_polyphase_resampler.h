@@ -0,0 +1,52 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <gsl/gsl>
+#include "halley/audio/resampler.h"
+#include "halley/core/api/audio_api.h"
+
+namespace Halley {
+	enum class AudioResamplerQuality {
+		Fast, // 8 taps
+		Medium, // 16 taps
+		High // 32 taps
+	};
+
+	// Windowed-sinc resampler, with the filter split into phases precomputed per rate ratio and quality, and shared by every resampler using them
+	// Ratios that reduce to few enough phases are exact, such as 24 kHz to 48 kHz; others interpolate between the two nearest phases
+	// Each channel only keeps the input samples the filter still needs, plus its position in them
+	class AudioPolyphaseResampler {
+	public:
+		AudioPolyphaseResampler(int from, int to, size_t nChannels, AudioResamplerQuality quality = AudioResamplerQuality::Medium);
+		~AudioPolyphaseResampler();
+
+		// All input is always consumed; whatever isn't needed for the output produced yet is kept for the next call
+		AudioResamplerResult resample(gsl::span<const float> src, gsl::span<float> dst, size_t channel);
+		AudioResamplerResult resampleInterleaved(gsl::span<const float> src, gsl::span<float> dst);
+		AudioResamplerResult resampleNoninterleaved(gsl::span<const float> src, gsl::span<float> dst, size_t numChannels);
+
+		// Exact number of input samples the given channel needs to produce numOutputSamples more samples
+		size_t getInputSamplesNeeded(size_t numOutputSamples, size_t channel = 0) const;
+		size_t numOutputSamples(size_t numInputSamples) const;
+
+		void reset();
+
+		struct FilterBank;
+
+	private:
+		struct ChannelState {
+			std::vector<float> window; // Input samples from the current position onwards
+			uint64_t phase = 0; // Position between input samples, in units of 1/upFactor
+			size_t skip = 0; // Input samples to drop before the next one is used
+		};
+
+		uint64_t upFactor;
+		uint64_t downFactor;
+		bool exact;
+		std::shared_ptr<const FilterBank> bank;
+		std::vector<ChannelState> channels;
+
+		size_t process(ChannelState& state, const float* src, size_t srcLen, size_t srcStride, float* dst, size_t dstLen, size_t dstStride);
+		float filter(const float* window, uint64_t phase) const;
+	};
+}
@@ -23,10 +23,43 @@ bool AudioSourceClip::isReady() const
 	return clip->isLoaded();
 }
 
+bool AudioSourceClip::isThreadSafe() const
+{
+	return clip->isThreadSafe();
+}
+
+bool AudioSourceClip::canSkip() const
+{
+	return clip->isSeekable();
+}
+
+bool AudioSourceClip::skipAudioData(size_t numSamples)
+{
+	Expects(isReady());
+	const auto playbackLength = int64_t(clip->getLength());
+
+	playbackPos += int64_t(numSamples);
+	if (playbackPos >= playbackLength && looping) {
+		const auto loopPoint = int64_t(clip->getLoopPoint());
+		if (loopPoint < playbackLength) {
+			playbackPos = loopPoint + (playbackPos - loopPoint) % (playbackLength - loopPoint);
+		} else {
+			looping = false;
+		}
+	}
+
+	if (playbackPos >= playbackLength) {
+		playbackPos = playbackLength;
+		return false;
+	}
+	return true;
+}
+
 bool AudioSourceClip::getAudioData(size_t samplesRequested, AudioSourceData& dstChannels)
 {
 	Expects(isReady());
 	if (!initialised) {
+		reader = clip->makeReader();
 		initialised = true;
 	}
 	const auto playbackLength = int64_t(clip->getLength());
@@ -73,7 +106,7 @@ bool AudioSourceClip::getAudioData(size_t samplesRequested, AudioSourceData& dst
 			// We have some samples that we can read, so go ahead with reading them
 			for (size_t srcChannel = 0; srcChannel < nChannels; ++srcChannel) {
 				auto dst = gsl::span<AudioConfig::SampleFormat>(dstChannels[srcChannel].data() + samplesWritten, samplesToRead);
-				size_t nCopied = clip->copyChannelData(srcChannel, size_t(playbackPos), samplesToRead, dst);
+				size_t nCopied = reader ? reader->copyChannelData(srcChannel, size_t(playbackPos), samplesToRead, dst) : clip->copyChannelData(srcChannel, size_t(playbackPos), samplesToRead, dst);
 				Expects(nCopied <= samplesRequested * sizeof(AudioConfig::SampleFormat));
 			}
 
@@ -3,6 +3,8 @@
 
 namespace Halley
 {
+	class IAudioClipReader;
+
 	class AudioSourceClip final : public AudioSource
 	{
 	public:
@@ -11,9 +13,13 @@ namespace Halley
 		uint8_t getNumberOfChannels() const override;
 		bool getAudioData(size_t numSamples, AudioSourceData& dst) override;
 		bool isReady() const override;
+		bool isThreadSafe() const override;
+		bool canSkip() const override;
+		bool skipAudioData(size_t numSamples) override;
 
 	private:
 		const std::shared_ptr<const IAudioClip> clip;
+		std::shared_ptr<IAudioClipReader> reader;
 		
 		int64_t playbackPos = 0;
 
@@ -1,17 +1,64 @@
 #include "audio_variable_table.h"
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include "halley/support/exception.h"
 
 using namespace Halley;
 
-void AudioVariableTable::set(const String& name, float value)
+AudioVariableTable::AudioVariableTable()
 {
-	variables[name] = value;
+	for (auto& value: values) {
+		value.store(0.0f, std::memory_order_relaxed);
+	}
 }
 
-float AudioVariableTable::get(const String& name) const
+int AudioVariableTable::getId(const String& name)
 {
-	const auto iter = variables.find(name);
-	if (iter != variables.end()) {
+	static std::shared_mutex mutex;
+	static std::unordered_map<String, int> ids;
+
+	{
+		std::shared_lock<std::shared_mutex> lock(mutex);
+		const auto iter = ids.find(name);
+		if (iter != ids.end()) {
+			return iter->second;
+		}
+	}
+
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	const auto iter = ids.find(name);
+	if (iter != ids.end()) {
 		return iter->second;
 	}
-	return 0;
+	const int id = int(ids.size());
+	if (id >= maxVariables) {
+		throw Exception("Too many audio variables, can't add \"" + name + "\".", HalleyExceptions::AudioEngine);
+	}
+	ids[name] = id;
+	return id;
+}
+
+void AudioVariableTable::set(int id, float value)
+{
+	Expects(id >= 0 && id < maxVariables);
+	values[id].store(value, std::memory_order_relaxed);
+}
+
+float AudioVariableTable::get(int id) const
+{
+	if (id < 0 || id >= maxVariables) {
+		return 0;
+	}
+	return values[id].load(std::memory_order_relaxed);
+}
+
+void AudioVariableTable::set(const String& name, float value)
+{
+	set(getId(name), value);
+}
+
+float AudioVariableTable::get(const String& name) const
+{
+	return get(getId(name));
 }
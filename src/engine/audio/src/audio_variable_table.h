@@ -1,18 +1,29 @@
 #pragma once
-#include <unordered_map>
+#include <array>
+#include <atomic>
 #include <halley/text/halleystring.h>
 
 namespace Halley {
 	class String;
 
-	// TODO: this class is not very efficient for something in audio engine
-	// Variables should probably be replaced by ints identifying them
+	// Variable names are interned to ids process-wide, normally when the events and configs using them are loaded
+	// Values live in a flat array of atomics, so the game thread can set them directly while voices read them on the audio thread
 	class AudioVariableTable {
     public:
+		static constexpr int maxVariables = 4096;
+		static constexpr int invalidId = -1;
+
+		AudioVariableTable();
+
+		static int getId(const String& name);
+
+		void set(int id, float value);
+		float get(int id) const;
+
 		void set(const String& name, float value);
 		float get(const String& name) const;
 
 	private:
-		std::unordered_map<String, float> variables;
+		std::array<std::atomic<float>, maxVariables> values;
     };
 }
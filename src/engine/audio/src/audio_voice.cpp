@@ -12,6 +12,11 @@ AudioVoice::AudioVoice(std::shared_ptr<AudioSource> source, AudioPosition source
 	, playing(false)
 	, done(false)
 	, isFirstUpdate(true)
+	, isFirstMix(true)
+	, virtualVoice(false)
+	, skipping(false)
+	, stolen(false)
+	, audibility(gain)
 	, baseGain(gain)
 	, userGain(1.0f)
 	, source(std::move(source))
@@ -60,6 +65,10 @@ bool AudioVoice::isDone() const
 	return done;
 }
 
+bool AudioVoice::isThreadSafe() const
+{
+	return source->isThreadSafe();
+}
 
 void AudioVoice::addBehaviour(std::unique_ptr<AudioVoiceBehaviour> value)
 {
@@ -78,6 +87,75 @@ uint8_t AudioVoice::getGroup() const
 	return group;
 }
 
+void AudioVoice::setPriority(int p)
+{
+	priority = p;
+}
+
+int AudioVoice::getPriority() const
+{
+	return priority;
+}
+
+void AudioVoice::setEventId(uint32_t id)
+{
+	eventId = id;
+}
+
+uint32_t AudioVoice::getEventId() const
+{
+	return eventId;
+}
+
+void AudioVoice::setStartOrder(uint64_t order)
+{
+	startOrder = order;
+}
+
+uint64_t AudioVoice::getStartOrder() const
+{
+	return startOrder;
+}
+
+float AudioVoice::getAudibility() const
+{
+	return audibility;
+}
+
+bool AudioVoice::isAudible() const
+{
+	return audibility >= 0.0001f;
+}
+
+bool AudioVoice::canBeVirtual() const
+{
+	return source->canSkip();
+}
+
+void AudioVoice::setVirtual(bool v)
+{
+	Expects(!v || canBeVirtual());
+	virtualVoice = v;
+}
+
+bool AudioVoice::isVirtual() const
+{
+	return virtualVoice;
+}
+
+void AudioVoice::steal()
+{
+	if (!playing || isFirstMix) {
+		stop();
+	}
+	stolen = true;
+}
+
+bool AudioVoice::isStolen() const
+{
+	return stolen;
+}
+
 void AudioVoice::setBaseGain(float gain)
 {
 	baseGain = gain;
@@ -138,6 +216,12 @@ void AudioVoice::update(gsl::span<const AudioChannelData> channels, const AudioL
 		prevChannelMix = channelMix;
 		isFirstUpdate = false;
 	}
+
+	const size_t nMixes = nChannels * size_t(channels.size());
+	audibility = 0;
+	for (size_t i = 0; i < nMixes; ++i) {
+		audibility += channelMix[i];
+	}
 }
 
 void AudioVoice::mixTo(size_t numSamples, gsl::span<AudioBuffer*> dst, AudioMixer& mixer, AudioBufferPool& pool)
@@ -150,6 +234,16 @@ void AudioVoice::mixTo(size_t numSamples, gsl::span<AudioBuffer*> dst, AudioMixe
 	const size_t nSrcChannels = getNumberOfChannels();
 	const auto nDstChannels = size_t(dst.size());
 
+	// Silence the voice if it's been virtualised or stolen. If it was audible on the last mix, this becomes a fade out.
+	// A voice which was skipping had nothing audible last time, so fade it in from silence
+	if (skipping || (isFirstMix && virtualVoice)) {
+		prevChannelMix.fill(0.0f);
+	}
+	if (virtualVoice || stolen) {
+		channelMix.fill(0.0f);
+	}
+	isFirstMix = false;
+
 	// Figure out the total mix in the previous update, and now. If it's zero, then there's nothing to listen here.
 	float totalMix = 0.0f;
 	const size_t nMixes = nSrcChannels * nDstChannels;
@@ -157,39 +251,48 @@ void AudioVoice::mixTo(size_t numSamples, gsl::span<AudioBuffer*> dst, AudioMixe
 	for (size_t i = 0; i < nMixes; ++i) {
 		totalMix += prevChannelMix[i] + channelMix[i];
 	}
+	const bool audible = totalMix >= 0.0001f;
 
-	// Read data from source
-	std::array<gsl::span<AudioSamplePack>, AudioConfig::maxChannels> audioData;
-	std::array<gsl::span<AudioConfig::SampleFormat>, AudioConfig::maxChannels> audioSampleData;
-	std::array<AudioBufferRef, AudioConfig::maxChannels> bufferRefs;
-	for (size_t srcChannel = 0; srcChannel < nSrcChannels; ++srcChannel) {
-		bufferRefs[srcChannel] = pool.getBuffer(numSamples);
-		audioData[srcChannel] = bufferRefs[srcChannel].getSpan().subspan(0, numPacks);
-		audioSampleData[srcChannel] = audioData[srcChannel].data()->samples;
-	}
-	bool isPlaying = source->getAudioData(numSamples, audioSampleData);
-
-	// If we're audible, render
-	if (totalMix >= 0.0001f) {
-		// Render each emitter channel
+	bool isPlaying;
+	if (!audible && source->canSkip()) {
+		// Nothing to hear, so just move the playback position along
+		isPlaying = source->skipAudioData(numSamples);
+		skipping = true;
+	} else {
+		// Read data from source
+		std::array<gsl::span<AudioSamplePack>, AudioConfig::maxChannels> audioData;
+		std::array<gsl::span<AudioConfig::SampleFormat>, AudioConfig::maxChannels> audioSampleData;
+		std::array<AudioBufferRef, AudioConfig::maxChannels> bufferRefs;
 		for (size_t srcChannel = 0; srcChannel < nSrcChannels; ++srcChannel) {
-			// Read to buffer
-			for (size_t dstChannel = 0; dstChannel < nDstChannels; ++dstChannel) {
-				// Compute mix
-				const size_t mixIndex = (srcChannel * nChannels) + dstChannel;
-				const float gain0 = prevChannelMix[mixIndex];
-				const float gain1 = channelMix[mixIndex];
-
-				// Render to destination
-				if (gain0 + gain1 > 0.0001f) {
-					mixer.mixAudio(audioData[srcChannel], dst[dstChannel]->packs, gain0, gain1);
+			bufferRefs[srcChannel] = pool.getBuffer(numSamples);
+			audioData[srcChannel] = bufferRefs[srcChannel].getSpan().subspan(0, numPacks);
+			audioSampleData[srcChannel] = gsl::span<AudioConfig::SampleFormat>(audioData[srcChannel].data()->samples.data(), numSamples);
+		}
+		isPlaying = source->getAudioData(numSamples, audioSampleData);
+		skipping = false;
+
+		// If we're audible, render
+		if (audible) {
+			// Render each emitter channel
+			for (size_t srcChannel = 0; srcChannel < nSrcChannels; ++srcChannel) {
+				// Read to buffer
+				for (size_t dstChannel = 0; dstChannel < nDstChannels; ++dstChannel) {
+					// Compute mix
+					const size_t mixIndex = (srcChannel * nChannels) + dstChannel;
+					const float gain0 = prevChannelMix[mixIndex];
+					const float gain1 = channelMix[mixIndex];
+
+					// Render to destination
+					if (gain0 + gain1 > 0.0001f) {
+						mixer.mixAudio(audioData[srcChannel], dst[dstChannel]->packs, gain0, gain1);
+					}
 				}
 			}
 		}
 	}
 
 	advancePlayback(numSamples);
-	if (!isPlaying) {
+	if (!isPlaying || stolen) {
 		stop();
 	}
 }
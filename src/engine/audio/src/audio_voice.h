@@ -5,6 +5,7 @@
 #include <limits>
 
 namespace Halley {
+	class AudioEvent;
 	class AudioBufferPool;
 	class AudioMixer;
 	class AudioVoiceBehaviour;
@@ -21,6 +22,7 @@ namespace Halley {
 		bool isPlaying() const;
 		bool isReady() const;
 		bool isDone() const;
+		bool isThreadSafe() const;
 
 		void setBaseGain(float gain);
 		float getBaseGain() const;
@@ -43,6 +45,27 @@ namespace Halley {
 		
 		uint8_t getGroup() const;
 
+		void setPriority(int priority);
+		int getPriority() const;
+		void setEventId(uint32_t eventId); // Id of the AudioEvent which started this voice, or 0
+		uint32_t getEventId() const;
+		void setStartOrder(uint64_t order);
+		uint64_t getStartOrder() const;
+
+		// Sum of the channel gains computed on the last update
+		float getAudibility() const;
+		bool isAudible() const;
+
+		// A virtual voice keeps advancing its source without decoding or mixing it
+		// Voices also skip on their own whenever they're inaudible, and fade back in when they become real again
+		bool canBeVirtual() const;
+		void setVirtual(bool virtualVoice);
+		bool isVirtual() const;
+
+		// Fades out over the next mix, then stops
+		void steal();
+		bool isStolen() const;
+
 	private:
 		uint32_t id = std::numeric_limits<uint32_t>::max();
 		uint8_t group = 0;
@@ -50,6 +73,14 @@ namespace Halley {
 		bool playing : 1;
 		bool done : 1;
 		bool isFirstUpdate : 1;
+		bool isFirstMix : 1;
+		bool virtualVoice : 1;
+		bool skipping : 1;
+		bool stolen : 1;
+		int priority = 0;
+		uint64_t startOrder = 0;
+		float audibility = 0.0f;
+		uint32_t eventId = 0;
     	float baseGain = 1.0f;
 		float dynamicGain = 1.0f;
 		float userGain = 1.0f;
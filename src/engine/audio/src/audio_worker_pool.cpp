@@ -0,0 +1,104 @@
+#include "audio_worker_pool.h"
+#include "halley/text/string_converter.h"
+#include <gsl/gsl_assert>
+
+using namespace Halley;
+
+AudioWorkerPool::AudioWorkerPool(size_t numWorkers, MakeThread makeThread)
+{
+	Expects(numWorkers >= 1);
+
+	for (size_t i = 1; i < numWorkers; ++i) {
+		threads.push_back(makeThread("AudioMix" + toString(i), [this, i] () { workerLoop(i); }));
+	}
+}
+
+AudioWorkerPool::~AudioWorkerPool()
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	workAvailable.notify_all();
+
+	for (auto& thread: threads) {
+		thread.join();
+	}
+}
+
+size_t AudioWorkerPool::getNumWorkers() const
+{
+	return threads.size() + 1;
+}
+
+void AudioWorkerPool::run(size_t n, const Job& job)
+{
+	Expects(n <= getNumWorkers());
+	if (n == 0) {
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		currentJob = &job;
+		numJobs = n;
+		jobsPending = n - 1;
+		error = {};
+		++generation;
+	}
+	if (n > 1) {
+		workAvailable.notify_all();
+	}
+
+	std::exception_ptr localError;
+	try {
+		job(0);
+	} catch (...) {
+		localError = std::current_exception();
+	}
+
+	std::unique_lock<std::mutex> lock(mutex);
+	workDone.wait(lock, [&] () { return jobsPending == 0; });
+	currentJob = nullptr;
+
+	if (localError) {
+		std::rethrow_exception(localError);
+	}
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
+
+void AudioWorkerPool::workerLoop(size_t workerIdx)
+{
+	uint64_t lastGeneration = 0;
+
+	while (true) {
+		const Job* job = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			workAvailable.wait(lock, [&] () { return stopping || (generation != lastGeneration && workerIdx < numJobs); });
+			if (stopping) {
+				return;
+			}
+			lastGeneration = generation;
+			job = currentJob;
+		}
+
+		std::exception_ptr jobError;
+		try {
+			(*job)(workerIdx);
+		} catch (...) {
+			jobError = std::current_exception();
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			if (jobError && !error) {
+				error = jobError;
+			}
+			--jobsPending;
+		}
+		workDone.notify_one();
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "halley/text/halleystring.h"
+
+namespace Halley {
+	// A small set of threads dedicated to audio work
+	// run() hands one job to each worker and blocks until they're all done. The calling thread runs job 0 itself,
+	// so a pool with n workers only owns n - 1 threads.
+	class AudioWorkerPool {
+	public:
+		using MakeThread = std::function<std::thread(String, std::function<void()>)>;
+		using Job = std::function<void(size_t)>;
+
+		AudioWorkerPool(size_t numWorkers, MakeThread makeThread);
+		~AudioWorkerPool();
+
+		size_t getNumWorkers() const;
+
+		// Runs job(0) ... job(numJobs - 1), each on a different worker. numJobs must not exceed the number of workers.
+		// Exceptions thrown by jobs are rethrown here.
+		void run(size_t numJobs, const Job& job);
+
+	private:
+		std::vector<std::thread> threads;
+		std::mutex mutex;
+		std::condition_variable workAvailable;
+		std::condition_variable workDone;
+
+		const Job* currentJob = nullptr;
+		size_t numJobs = 0;
+		size_t jobsPending = 0;
+		uint64_t generation = 0;
+		bool stopping = false;
+		std::exception_ptr error;
+
+		void workerLoop(size_t workerIdx);
+	};
+}
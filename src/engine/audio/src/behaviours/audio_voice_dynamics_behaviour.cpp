@@ -22,7 +22,7 @@ bool AudioVoiceDynamicsBehaviour::update(float elapsedTime, AudioVoice& audioSou
 	const auto& vars = engine.getVariableTable();
 	float& gain = audioSource.getDynamicGainRef();
 	for (const auto& vol: config.getVolume()) {
-		gain *= volumeToGain(vol.getValue(vars.get(vol.name)));
+		gain *= volumeToGain(vol.getValue(vars.get(vol.id)));
 	}
 	
 	return true;
@@ -96,6 +96,25 @@ namespace Halley
 		float gain = 1.0f;
 	};
 
+	// Each group mixes into a bus, which runs its effects once per buffer on the sum of its voices and then mixes into its parent
+	// A bus with no effects and no send costs nothing, its voices mix straight into the parent
+	class AudioBusConfig
+	{
+	public:
+		String parent; // Group to mix into, empty for the master output
+
+		float highPassCutoff = 0.0f; // Hz, 0 to disable
+		float lowPassCutoff = 0.0f; // Hz, 0 to disable
+
+		float compressorThreshold = 0.0f; // dB
+		float compressorRatio = 1.0f; // 1 to disable
+		float compressorAttack = 0.005f; // Seconds
+		float compressorRelease = 0.1f; // Seconds
+
+		String send; // Group which also receives this bus's output (e.g. one with a reverb), after the effects
+		float sendGain = 0.0f;
+	};
+
 	using AudioCallback = std::function<void()>;
 
 	class IAudioOutput
@@ -179,10 +198,15 @@ namespace Halley
 
 		virtual void setMasterVolume(float gain = 1.0f) = 0;
 		virtual void setGroupVolume(const String& groupName, float gain = 1.0f) = 0;
+		virtual void setGroupBus(const String& groupName, AudioBusConfig config) = 0;
 		virtual void setOutputChannels(std::vector<AudioChannelData> audioChannelData) = 0;
 
 		virtual void setGlobalVariable(const String& variable, float value) = 0;
 
+		// Variables set every frame can be looked up once, and then set by id without going through their name again
+		virtual void setGlobalVariable(int variableId, float value) = 0;
+		virtual int getGlobalVariableId(const String& variable) = 0;
+
 		virtual void setListener(AudioListenerData listener) = 0;
 
 		virtual int64_t getLastTimeElapsed() const = 0;
@@ -50,7 +50,7 @@ namespace Halley
 
 		bool operator!=(const BlendType& other) const
 		{
-			return mode != other.mode && premultiplied != other.premultiplied;
+			return mode != other.mode || premultiplied != other.premultiplied;
 		}
 
 		bool operator<(const BlendType& other) const
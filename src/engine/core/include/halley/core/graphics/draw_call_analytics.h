@@ -0,0 +1,89 @@
+#pragma once
+
+#include <halley/data_structures/vector.h>
+#include <halley/data_structures/config_node.h>
+#include <halley/maths/rect.h>
+#include <halley/text/halleystring.h>
+#include <memory>
+#include <optional>
+
+namespace Halley
+{
+	class Path;
+	class Plugin;
+	class VideoAPI;
+
+	struct DrawCallRecord
+	{
+		String material;
+		int pass = 0;
+		Vector<String> textures;
+		size_t numVertices = 0;
+		size_t numIndices = 0;
+		size_t numInstances = 0;
+		String renderTarget;
+		std::optional<Rect4i> clip;
+		bool shaderChanged = false;
+
+		ConfigNode toConfigNode() const;
+	};
+
+	struct DrawCallSummary
+	{
+		size_t drawCalls = 0;
+		size_t vertices = 0;
+		size_t triangles = 0;
+		size_t materialSwitches = 0;
+		size_t shaderSwitches = 0;
+		size_t textureSwitches = 0;
+		size_t renderTargetSwitches = 0;
+		size_t clipChanges = 0;
+
+		ConfigNode toConfigNode() const;
+		String toString() const;
+	};
+
+	// Records every draw call submitted by the analytics video backend, for headless performance tests
+	// Register the backend with makeVideoPlugin() (it takes priority over any other video plugin),
+	// then fetch the recorder from the video API with get()
+	class DrawCallAnalytics
+	{
+	public:
+		enum class GoldenMode
+		{
+			Compare,
+			Update
+		};
+
+		struct GoldenResult
+		{
+			bool matches = true;
+			Vector<String> differences;
+		};
+
+		static std::unique_ptr<Plugin> makeVideoPlugin(int priority = 1000);
+		static DrawCallAnalytics* get(VideoAPI& video);
+
+		void startFrame();
+		void endFrame();
+		void recordDraw(DrawCallRecord record);
+
+		// These refer to the last completed frame
+		const Vector<DrawCallRecord>& getDrawCalls() const;
+		DrawCallSummary getSummary() const;
+		size_t getNumFramesRecorded() const;
+
+		ConfigNode toConfigNode() const;
+
+		GoldenResult compareWithGolden(const ConfigNode& golden) const;
+
+		// Compare mode fails if the file is missing; update mode (re)writes it and always matches
+		GoldenResult checkGoldenFile(const Path& path, GoldenMode mode) const;
+
+	private:
+		Vector<DrawCallRecord> currentFrame;
+		Vector<DrawCallRecord> lastFrame;
+		size_t numFrames = 0;
+		bool inFrame = false;
+	};
+}
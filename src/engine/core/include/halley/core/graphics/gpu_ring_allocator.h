@@ -0,0 +1,62 @@
+#pragma once
+
+#include <halley/data_structures/vector.h>
+#include <memory>
+#include <optional>
+
+namespace Halley
+{
+	// A fence inserted into the GPU command stream, signalled once the GPU has consumed every command issued before it
+	class GPUFence
+	{
+	public:
+		virtual ~GPUFence() {}
+
+		virtual bool isSignalled() = 0;
+		virtual void wait() = 0;
+	};
+
+	// Sub-allocates per-frame streaming data (vertices, indices, uniforms) from a buffer split into numSegments segments.
+	// Each frame writes to its own segment, and a fence is stored when the frame ends. When that segment comes round again,
+	// beginFrame waits on its fence, so the CPU never overwrites data that the GPU might still be reading.
+	// This class only manages offsets; the backend owns the actual buffer.
+	class GPURingAllocator
+	{
+	public:
+		explicit GPURingAllocator(size_t segmentSize = 0, size_t numSegments = 3);
+
+		// Waits for every pending fence and resizes the segments
+		void reset(size_t segmentSize);
+
+		void beginFrame();
+		void endFrame(std::unique_ptr<GPUFence> fence);
+		void waitAll();
+
+		// Returns the offset from the start of the buffer, or empty if this frame's segment is full
+		std::optional<size_t> allocate(size_t size, size_t alignment = 16);
+
+		size_t getSegmentSize() const { return segmentSize; }
+		size_t getNumSegments() const { return numSegments; }
+		size_t getCapacity() const { return segmentSize * numSegments; }
+		size_t getCurrentSegment() const { return curSegment; }
+		size_t getBytesUsed() const { return head; }
+		uint64_t getFrameId() const { return frameId; }
+
+		// Number of times beginFrame had to block on a fence that wasn't signalled yet
+		size_t getNumStalls() const { return numStalls; }
+
+		// True if an allocation failed since the last reset
+		bool hasOverflowed() const { return overflowed; }
+
+	private:
+		Vector<std::unique_ptr<GPUFence>> fences;
+		size_t segmentSize = 0;
+		size_t numSegments = 0;
+		size_t curSegment = 0;
+		size_t head = 0;
+		uint64_t frameId = 0;
+		size_t numStalls = 0;
+		bool overflowed = false;
+		bool inFrame = false;
+	};
+}
@@ -200,6 +200,13 @@ namespace Halley
 		size_t getVertexSize() const;
 		size_t getVertexStride() const;
 		size_t getVertexPosOffset() const;
+
+		// Instanced materials submit sprites as one record per sprite instead of four vertices
+		// The record is the vertex layout without the vertPos attribute, which the backend supplies per-vertex
+		bool isInstanced() const;
+		size_t getInstanceSize() const;
+		size_t getInstanceStride() const;
+		size_t getInstanceAttributeOffset(const MaterialAttribute& attribute) const;
 		const Vector<MaterialAttribute>& getAttributes() const { return attributes; }
 		const Vector<MaterialUniformBlock>& getUniformBlocks() const { return uniformBlocks; }
 		const Vector<MaterialTexture>& getTextures() const { return textures; }
@@ -227,12 +234,13 @@ namespace Halley
 		int vertexPosOffset = 0;
 		int defaultMask = 1;
 		bool columnMajor = false;
+		bool instanced = false;
 
 		std::shared_ptr<const Texture> fallbackTexture;
 
 		void loadUniforms(const ConfigNode& node);
 		void loadTextures(const ConfigNode& node);
-		void loadAttributes(const ConfigNode& node);
+		std::optional<ShaderParameterType> loadAttributes(const ConfigNode& node); // Returns the type of the vertPos attribute, if any
 		ShaderParameterType parseParameterType(const String& rawType) const;
 		TextureSamplerType parseSamplerType(const String& rawType) const;
 	};
@@ -5,6 +5,8 @@
 #include "graphics_enums.h"
 #include <condition_variable>
 #include <halley/maths/vector4.h>
+#include <halley/data_structures/hash_map.h>
+#include <halley/data_structures/frame_allocator.h>
 
 
 #include "texture.h"
@@ -22,11 +24,42 @@ namespace Halley
 	class Camera;
 	class RenderContext;
 	class Core;
+	class PainterTestAccess;
+
+	// Tracks resources currently bound on the device, so backends only apply the deltas between draw calls
+	class PainterBindCache
+	{
+	public:
+		constexpr static size_t maxTextureUnits = 16;
+		constexpr static size_t maxConstantBuffers = 16;
+
+		void reset();
+
+		// Each of these returns true if the state changed, meaning that the backend has to bind it
+		bool changeTexture(int unit, const void* handle, size_t variant = 0);
+		bool changeConstantBuffer(int bindPoint, const void* handle, size_t offset = 0);
+		bool changeBlend(BlendType blend);
+
+		void invalidateTexture(int unit);
+
+	private:
+		struct Slot {
+			const void* handle = nullptr;
+			size_t extra = 0;
+		};
+
+		std::array<Slot, maxTextureUnits> textures;
+		std::array<Slot, maxConstantBuffers> constantBuffers;
+		std::optional<BlendType> blend;
+
+		static bool changeSlot(Slot& slot, const void* handle, size_t extra);
+	};
 
 	class Painter
 	{
 		friend class RenderContext;
 		friend class Core;
+		friend class PainterTestAccess; // Only defined by the tests, to drive frames without a Core
 
 		struct PainterVertexData
 		{
@@ -38,6 +71,20 @@ namespace Halley
 			IndexType firstIndex;
 		};
 
+		struct PendingBatch
+		{
+			std::shared_ptr<Material> material;
+			Vector<char> vertexBuffer;
+			Vector<IndexType> indexBuffer;
+			size_t verticesPending = 0;
+			size_t bytesPending = 0;
+			size_t indicesPending = 0;
+			size_t instancesPending = 0;
+			bool allIndicesAreQuads = true;
+			bool instanced = false;
+			std::optional<Rect4f> bounds;
+		};
+
 	public:
 		Painter(Resources& resources);
 		virtual ~Painter();
@@ -56,18 +103,42 @@ namespace Halley
 		void setClip(Rect4i rect);
 		void setClip();
 
+		// Reorder window: how many pending batches can be kept open at once.
+		// A draw with known world bounds can be merged into an earlier batch with the same material,
+		// as long as it doesn't overlap anything drawn in between. Draws without bounds are never moved.
+		// 0 (the default) disables reordering.
+		void setReorderWindow(size_t window);
+		size_t getReorderWindow() const { return reorderWindow; }
+
 		// Draws primitives
-		void draw(const std::shared_ptr<Material>& material, size_t numVertices, const void* vertexData, gsl::span<const IndexType> indices, PrimitiveType primitiveType = PrimitiveType::Triangle);
+		// bounds (world space) is optional, and only used by the reorder window
+		void draw(const std::shared_ptr<Material>& material, size_t numVertices, const void* vertexData, gsl::span<const IndexType> indices, PrimitiveType primitiveType = PrimitiveType::Triangle, std::optional<Rect4f> bounds = {});
 
 		// Draws quads
-		void drawQuads(const std::shared_ptr<Material>& material, size_t numVertices, const void* vertexData);
+		void drawQuads(const std::shared_ptr<Material>& material, size_t numVertices, const void* vertexData, std::optional<Rect4f> bounds = {});
 
 		// Draw sprites takes a single vertex per sprite, duplicates the data across multiple vertices, and draws
 		// vertPosOffset is the offset, in bytes, from the start of each vertex's data, to a Vector2f which will be filled with the vertex's position in 0-1 space.
-		void drawSprites(const std::shared_ptr<Material>& material, size_t numSprites, const void* vertexData);
+		// If the material is instanced, each sprite is submitted as a single instance record instead, and the quad is expanded on the GPU.
+		void drawSprites(const std::shared_ptr<Material>& material, size_t numSprites, const void* vertexData, std::optional<Rect4f> bounds = {});
+
+		// Expands numSprites vertices (one per sprite) into four vertices per sprite, in the same way that drawSprites does
+		// dstVertexData must have space for numSprites * 4 vertices
+		static void expandSpriteVertices(const MaterialDefinition& material, size_t numSprites, const void* vertexData, void* dstVertexData);
+
+		// Packs numSprites vertices (one per sprite) into instance records, as drawSprites does for instanced materials
+		// dstInstanceData must have space for numSprites * material.getInstanceStride() bytes
+		static void writeSpriteInstances(const MaterialDefinition& material, size_t numSprites, const void* vertexData, void* dstInstanceData);
+
+		// Expands instance records back into four vertices each, for backends without instancing
+		// dstVertexData must have space for numInstances * 4 vertices
+		static void expandSpriteInstances(const MaterialDefinition& material, size_t numInstances, const void* instanceData, void* dstVertexData);
+
+		// The vertPos of each of the four vertices of a sprite, in the order used by the quad indices
+		static gsl::span<const Vector4f> getSpriteCorners();
 
 		// Draw one sliced sprite. Slices -> x = left, y = top, z = right, w = bottom, in [0..1] space relative to the texture
-		void drawSlicedSprite(const std::shared_ptr<Material>& material, Vector2f scale, Vector4f slices, const void* vertexData);
+		void drawSlicedSprite(const std::shared_ptr<Material>& material, Vector2f scale, Vector4f slices, const void* vertexData, std::optional<Rect4f> bounds = {});
 
 		// Draws a line across all points (if no material is specified, use standard one)
 		void drawLine(gsl::span<const Vector2f> points, float width, Colour4f colour, bool loop = false, std::shared_ptr<Material> material = {});
@@ -100,6 +171,10 @@ namespace Halley
 
 		void setLogging(bool logging);
 
+		// Scratch memory for the current frame, released when rendering ends
+		// Use with FrameVector/FrameAllocatorAdapter for per-frame containers
+		FrameAllocator& getFrameAllocator() { return frameAllocator; }
+
 	protected:
 		virtual void startDrawCall() {}
 		virtual void endDrawCall() {}
@@ -108,6 +183,10 @@ namespace Halley
 		virtual void setVertices(const MaterialDefinition& material, size_t numVertices, void* vertexData, size_t numIndices, IndexType* indices, bool standardQuadsOnly) = 0;
 		virtual void drawTriangles(size_t numIndices) = 0;
 
+		// Instanced sprite submission. The default implementation expands the instances on the CPU, and draws them as regular quads.
+		virtual void setInstances(const MaterialDefinition& material, size_t numInstances, void* instanceData);
+		virtual void drawInstances(size_t numInstances);
+
 		virtual void setViewPort(Rect4i rect) = 0;
 		virtual void setClip(Rect4i clip, bool enable) = 0;
 
@@ -116,6 +195,7 @@ namespace Halley
 		RenderTarget& getActiveRenderTarget();
 
 		std::unique_ptr<Material> halleyGlobalMaterial;
+		PainterBindCache bindCache;
 
 	private:
 		Resources& resources;
@@ -125,13 +205,9 @@ namespace Halley
 		Rect4i viewPort;
 		Camera camera;
 
-		size_t verticesPending = 0;
-		size_t bytesPending = 0;
-		size_t indicesPending = 0;
-		bool allIndicesAreQuads = true;
-		Vector<char> vertexBuffer;
-		Vector<IndexType> indexBuffer;
-		std::shared_ptr<Material> materialPending;
+		Vector<PendingBatch> batches;
+		size_t numBatchesPending = 0;
+		size_t reorderWindow = 0;
 		std::shared_ptr<Material> solidLineMaterial;
 		std::shared_ptr<Material> solidPolygonMaterial;
 		std::shared_ptr<Material> blitMaterial;
@@ -145,23 +221,42 @@ namespace Halley
 		bool logging = true;
 
 		Vector<IndexType> stdQuadIndexCache;
+		Vector<char> instanceExpansionScratch;
+		FrameAllocator frameAllocator;
+
+		struct LineVertex;
+		struct PolygonTriangulation {
+			Vector<IndexType> indices;
+			uint32_t lastUsedFrame = 0;
+		};
+
+		Vector<IndexType> polygonIndexScratch;
+
+		// Triangulations of recently drawn concave polygons, keyed by Polygon::getRevision
+		HashMap<uint64_t, PolygonTriangulation> polygonTriangulations;
+		uint32_t frameNumber = 0;
 		std::optional<Rect4i> curClip;
 		std::optional<Rect4i> pendingClip;
 
 		void bind(RenderContext& context);
 		void unbind(RenderContext& context);
 		
+		// Frame boundaries, driven by Core. Ending a frame releases everything taken from the frame allocator.
 		void startRender();
 		void endRender();
 		
 		void resetPending();
-		void startDrawCall(const std::shared_ptr<Material>& material);
+		PendingBatch& startDrawCall(const std::shared_ptr<Material>& material, size_t numVertices, bool instanced, const std::optional<Rect4f>& bounds);
 		void flushPending();
-		void executeDrawPrimitives(Material& material, size_t numVertices, void* vertexData, gsl::span<const IndexType> indices, PrimitiveType primitiveType = PrimitiveType::Triangle);
+		void flushBatch(PendingBatch& batch);
+		void resetBatch(PendingBatch& batch);
+		void executeDrawPrimitives(Material& material, size_t numVertices, void* vertexData, gsl::span<const IndexType> indices, bool allIndicesAreQuads, PrimitiveType primitiveType = PrimitiveType::Triangle);
+		void executeDrawInstances(Material& material, size_t numInstances, void* instanceData);
 
-		void makeSpaceForPendingVertices(size_t numBytes);
-		void makeSpaceForPendingIndices(size_t numIndices);
-		PainterVertexData addDrawData(const std::shared_ptr<Material>& material, size_t numVertices, size_t numIndices, bool standardQuadsOnly);
+		void makeSpaceForPendingVertices(PendingBatch& batch, size_t numBytes);
+		void makeSpaceForPendingIndices(PendingBatch& batch, size_t numIndices);
+		PainterVertexData addDrawData(const std::shared_ptr<Material>& material, size_t numVertices, size_t numIndices, bool standardQuadsOnly, const std::optional<Rect4f>& bounds);
+		char* addInstanceData(const std::shared_ptr<Material>& material, size_t numInstances, const std::optional<Rect4f>& bounds);
 
 		IndexType* getStandardQuadIndices(size_t numQuads);
 		void generateQuadIndicesOffset(IndexType firstVertex, IndexType lineStride, IndexType* target);
@@ -173,5 +268,8 @@ namespace Halley
 
 		std::shared_ptr<Material> getSolidLineMaterial();
 		std::shared_ptr<Material> getSolidPolygonMaterial();
+
+		gsl::span<const IndexType> getPolygonTriangulation(const Polygon& polygon);
+		void evictPolygonTriangulations(uint32_t maxFramesUnused);
 	};
 }
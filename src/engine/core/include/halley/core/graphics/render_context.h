@@ -9,6 +9,7 @@ namespace Halley
 	class RenderContext
 	{
 		friend class Core;
+		friend class PainterTestAccess;
 
 	public:
 		void bind(const std::function<void(Painter&)>& f)
@@ -28,6 +29,7 @@ namespace Halley
 		const Camera& getCamera() const { return camera; }
 
 		RenderTarget& getDefaultRenderTarget() const;
+		FrameAllocator& getFrameAllocator() const;
 
 		void flush();
 
@@ -17,6 +17,7 @@ namespace Halley {
 	class Painter;
 	class Material;
 	class RenderGraphNode;
+	class RenderGraphTexturePool;
 	
 	class RenderGraph {
 	public:
@@ -24,6 +25,7 @@ namespace Halley {
 
 		RenderGraph();
 		explicit RenderGraph(std::shared_ptr<const RenderGraphDefinition> graphDefinition);
+		~RenderGraph();
 
 		void update();
 		void render(const RenderContext& rc, VideoAPI& video, std::optional<Vector2i> renderSize = {});
@@ -77,6 +79,7 @@ namespace Halley {
 		
 		std::vector<std::unique_ptr<RenderGraphNode>> nodes;
 		std::map<String, RenderGraphNode*> nodeMap;
+		std::unique_ptr<RenderGraphTexturePool> texturePool;
 		
 		std::map<String, Camera> cameras;
 		std::map<String, PaintMethod> paintMethods;
@@ -6,6 +6,7 @@
 #include "render_graph_definition.h"
 #include "render_graph_pin_type.h"
 #include "halley/core/graphics/texture_descriptor.h"
+#include "halley/data_structures/frame_allocator.h"
 
 namespace Halley {
 	class Material;
@@ -14,6 +15,32 @@ namespace Halley {
 	class Texture;
 	class RenderGraph;
 	class TextureRenderTarget;
+
+	// Transient textures shared between the passes of a RenderGraph
+	// Each texture is reference counted by the nodes which still need it in the current frame, and becomes
+	// available to later passes as soon as the last of them is done. Textures not used in a frame are dropped.
+	class RenderGraphTexturePool {
+	public:
+		std::shared_ptr<Texture> acquire(VideoAPI& video, Vector2i size, RenderGraphPinType type);
+		void addReference(const std::shared_ptr<Texture>& texture);
+		void release(const std::shared_ptr<Texture>& texture);
+		void endFrame();
+
+		size_t getNumTextures() const;
+
+	private:
+		struct Entry {
+			std::shared_ptr<Texture> texture;
+			Vector2i size;
+			RenderGraphPinType type = RenderGraphPinType::Unknown;
+			int references = 0;
+			bool usedThisFrame = false;
+		};
+
+		std::vector<Entry> entries;
+
+		Entry* tryGetEntry(const std::shared_ptr<Texture>& texture);
+	};
 	
 	class RenderGraphNode {
 		friend class RenderGraph;
@@ -49,13 +76,13 @@ namespace Halley {
 		void startRender();
 		void prepareDependencyGraph(VideoAPI& video, Vector2i targetSize);
 		void prepareInputPin(InputPin& pin, VideoAPI& video, Vector2i targetSize);
-		void prepareTextures(VideoAPI& video, const RenderContext& rc);
+		void prepareTextures(VideoAPI& video, const RenderContext& rc, RenderGraphTexturePool& texturePool);
 		
-		void render(const RenderGraph& graph, VideoAPI& video, const RenderContext& rc, std::vector<RenderGraphNode*>& renderQueue);
-		void notifyOutputs(std::vector<RenderGraphNode*>& renderQueue);
+		void render(const RenderGraph& graph, VideoAPI& video, const RenderContext& rc, FrameVector<RenderGraphNode*>& renderQueue, RenderGraphTexturePool& texturePool);
+		void notifyOutputs(FrameVector<RenderGraphNode*>& renderQueue, RenderGraphTexturePool& texturePool);
+		void releaseTextures(RenderGraphTexturePool& texturePool);
 
 		void resetTextures();
-		std::shared_ptr<Texture> makeTexture(VideoAPI& video, RenderGraphPinType type);
 
 		void determineIfNeedsRenderTarget();
 		
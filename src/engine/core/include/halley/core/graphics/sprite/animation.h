@@ -5,6 +5,7 @@
 #include <halley/resources/resource.h>
 #include "halley/maths/vector2.h"
 #include "halley/maths/rect.h"
+#include "sprite_sheet.h"
 
 namespace Halley
 {
@@ -12,6 +13,7 @@ namespace Halley
 	class Deserializer;
 	class Serializer;
 	class ResourceLoader;
+	class Resources;
 	class SpriteSheet;
 	class SpriteSheetEntry;
 	class Material;
@@ -26,12 +28,18 @@ namespace Halley
 		const SpriteSheetEntry& getSprite(int dir) const
 		{
 			Expects(dir >= 0 && dir < int(sprites.size()));
-			return *sprites[dir];
+			return sheet->getSprite(sprites[dir]);
+		}
+		SpriteHandle getSpriteHandle(int dir) const
+		{
+			Expects(dir >= 0 && dir < int(sprites.size()));
+			return sprites[dir];
 		}
 		int getDuration() const;
 
 	private:
-		Vector<const SpriteSheetEntry*> sprites;
+		const SpriteSheet* sheet;
+		Vector<SpriteHandle> sprites;
 		int duration;
 	};
 
@@ -70,6 +78,11 @@ namespace Halley
 		bool isLooping() const { return loop; }
 		bool isNoFlip() const { return noFlip; }
 
+		// Total length, and frame lookup by time, both in milliseconds (each frame lasts at least 1ms)
+		// Only available once the animation dependencies are loaded
+		int getDuration() const { return duration; }
+		size_t getFrameAtTime(int timeMs) const;
+
 		void serialize(Serializer& s) const;
 		void deserialize(Deserializer& s);
 
@@ -83,6 +96,13 @@ namespace Halley
 		String name;
 		bool loop = false;
 		bool noFlip = false;
+
+		Vector<int> frameStartTimes;
+		Vector<uint16_t> frameTable;
+		int frameTableStep = 1;
+		int duration = 0;
+
+		void buildFrameTable();
 	};
 
 	class AnimationDirection
@@ -140,6 +160,7 @@ namespace Halley
 		void serialize(Serializer& s) const;
 		void deserialize(Deserializer& s);
 		void loadDependencies(ResourceLoader& loader);
+		void loadDependencies(Resources& resources);
 
 		void setName(const String& name);
 		void setMaterialName(const String& name);
@@ -127,6 +127,46 @@ namespace Halley
 		int curDir = 0;
 	};
 
+	// Advances many simple animations in a single pass, for large numbers of animated sprites
+	// Timing is kept in contiguous arrays, frames are looked up through the sequence frame tables,
+	// and only the sprites of players whose frame actually changed are touched.
+	// Player i drives sprites[i] of the span passed to update().
+	class AnimationPlayerBatch
+	{
+	public:
+		size_t add(std::shared_ptr<const Animation> animation, const String& sequence = "default", const String& direction = "default");
+		void remove(size_t idx); // The last player is moved to idx
+		void clear();
+		size_t size() const;
+
+		void setSequence(size_t idx, const String& sequence);
+		void setDirection(size_t idx, const String& direction);
+		void setPlaybackSpeed(size_t idx, float speed);
+		int getCurrentFrame(size_t idx) const;
+
+		// Returns how many sprites were changed
+		size_t update(Time time, gsl::span<Sprite> sprites);
+
+	private:
+		struct State
+		{
+			std::shared_ptr<const Animation> animation;
+			const AnimationSequence* sequence = nullptr;
+			String sequenceName;
+			int direction = 0;
+			int assetVersion = 0;
+			bool flip = false;
+		};
+
+		Vector<State> states;
+		Vector<float> times;
+		Vector<float> speeds;
+		Vector<int> frames;
+		Vector<uint32_t> changed;
+
+		void resolve(size_t idx);
+	};
+
 	class Resources;
 
 	template<>
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <memory>
+#include "halley/data_structures/bin_pack.h"
+#include "halley/data_structures/hash_map.h"
+#include "halley/text/halleystring.h"
+
+namespace Halley
+{
+	class VideoAPI;
+	class Image;
+	class Texture;
+	class SpriteSheet;
+	class SpriteResource;
+
+	// Packs images created at runtime (generated textures, loose images from mods, cached text...) into shared atlas pages,
+	// so that sprites made from them share a texture and can be batched together.
+	// Images are identified by a key, and both add() and get() count as a use. When the atlas is full, the least recently
+	// used images which are no longer referenced outside the atlas are evicted to make room.
+	// The SpriteResource returned is what keeps an image in the atlas: a Sprite made from it only copies its coordinates,
+	// so callers must hold on to it for as long as anything might still draw the image.
+	class DynamicAtlas
+	{
+	public:
+		explicit DynamicAtlas(VideoAPI& video, Vector2i pageSize = Vector2i(2048, 2048), size_t maxPages = 4, int padding = 1);
+		~DynamicAtlas();
+
+		// Image must be RGBA. Returns null if it doesn't fit in a page, or if every page is full of images still in use.
+		std::shared_ptr<const SpriteResource> add(const String& key, const Image& image);
+		std::shared_ptr<const SpriteResource> get(const String& key);
+		bool has(const String& key) const;
+
+		size_t getNumPages() const;
+		size_t getNumEntries() const;
+		std::shared_ptr<const Texture> getPageTexture(size_t page) const;
+
+	private:
+		struct Page
+		{
+			std::shared_ptr<Texture> texture;
+			std::shared_ptr<SpriteSheet> spriteSheet;
+			BinPackShelfAllocator allocator;
+			Vector<Rect4i> freeSlots;
+			Vector<size_t> freeSpriteIndices;
+			size_t numEntries = 0;
+
+			explicit Page(Vector2i size) : allocator(size) {}
+		};
+
+		struct Entry
+		{
+			std::shared_ptr<SpriteResource> handle;
+			size_t page = 0;
+			size_t spriteIdx = 0;
+			Rect4i slot;
+			uint64_t lastUsed = 0;
+		};
+
+		VideoAPI& video;
+		Vector2i pageSize;
+		size_t maxPages;
+		int padding;
+
+		Vector<std::unique_ptr<Page>> pages;
+		HashMap<String, Entry> entries;
+		uint64_t useCounter = 0;
+
+		std::optional<std::pair<size_t, Rect4i>> allocate(Vector2i size);
+		std::optional<Rect4i> allocateInPage(Page& page, Vector2i size);
+		bool evictLeastRecentlyUsed();
+		void createPage();
+	};
+}
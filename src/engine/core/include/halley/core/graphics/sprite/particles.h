@@ -10,16 +10,6 @@ namespace Halley {
 	class Animation;
 	
 	class Particles {
-		struct Particle {
-			Vector2f pos;
-			Vector2f vel;
-			Angle1f angle;
-			float scale = 1;
-			float time = 0;
-			float ttl = 1;
-			bool alive = true;
-		};
-		
 	public:
 		Particles();
 		Particles(const ConfigNode& node, Resources& resources);
@@ -56,8 +46,17 @@ namespace Halley {
 		float spawnRateMultiplier = 1.0f;
 
 		std::vector<Sprite> sprites;
-		std::vector<Particle> particles;
 		std::vector<AnimationPlayerLite> animationPlayers;
+
+		// Particle state is kept as a structure of arrays, so each update pass is a tight loop the compiler can vectorise
+		// A particle is alive while time < ttl
+		std::vector<Vector2f> positions;
+		std::vector<Vector2f> velocities;
+		std::vector<Angle1f> angles;
+		std::vector<float> scales;
+		std::vector<float> times;
+		std::vector<float> ttls;
+		std::vector<Angle1f> scatterAngles;
 		
 		size_t nParticlesAlive = 0;
 		size_t nParticlesVisible = 0;
@@ -92,6 +91,8 @@ namespace Halley {
 		void spawn(size_t n);
 		void initializeParticle(size_t index);
 		void updateParticles(float t);
+		void updateParticleRange(size_t start, size_t end, float t);
+		void removeDeadParticles();
 
 		Vector2f getSpawnPosition() const;
 	};
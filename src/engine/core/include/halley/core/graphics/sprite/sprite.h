@@ -5,6 +5,7 @@
 #include <halley/maths/colour.h>
 #include <halley/maths/vector4.h>
 #include <halley/bytes/config_node_serializer_base.h>
+#include "sprite_sheet.h"
 
 namespace Halley
 {
@@ -42,6 +43,8 @@ namespace Halley
 
 	class Sprite
 	{
+		friend class StaticSpriteBatch;
+
 	public:
 		struct RectInfo {
 			Vector2f pivot;
@@ -81,12 +84,13 @@ namespace Halley
 		Sprite& setSprite(Resources& resources, const String& spriteSheetName, const String& imageName, String materialName = "");
 		Sprite& setSprite(const SpriteResource& sprite, bool applyPivot = true);
 		Sprite& setSprite(const SpriteSheet& sheet, const String& name, bool applyPivot = true);
+		Sprite& setSprite(const SpriteSheet& sheet, SpriteHandle handle, bool applyPivot = true);
 		Sprite& setSprite(const SpriteSheetEntry& entry, bool applyPivot = true);
 
-		Sprite& setPos(Vector2f pos) { Expects(pos.isValid()); vertexAttrib.pos = pos; return *this; }
-		Sprite& setPosition(Vector2f pos) { Expects(pos.isValid()); vertexAttrib.pos = pos; return *this; }
+		Sprite& setPos(Vector2f pos) { Expects(pos.isValid()); vertexAttrib.pos = pos; aabbDirty = true; return *this; }
+		Sprite& setPosition(Vector2f pos) { Expects(pos.isValid()); vertexAttrib.pos = pos; aabbDirty = true; return *this; }
 		Vector2f getPosition() const { return vertexAttrib.pos; }
-		Vector2f& getPosition() { return vertexAttrib.pos; }
+		Vector2f& getPosition() { aabbDirty = true; return vertexAttrib.pos; }
 
 		Sprite& setPivot(Vector2f pivot);
 		Sprite& setAbsolutePivot(Vector2f pivot);
@@ -153,7 +157,7 @@ namespace Halley
 		void setRectInfo(const RectInfo& info);
 
 		Rect4f getLocalAABB() const;
-		Rect4f getAABB() const;
+		Rect4f getAABB() const; // Cached until the transform changes
 		Rect4f getUncroppedAABB() const;
 		
 		bool isInView(Rect4f rect) const
@@ -178,15 +182,18 @@ namespace Halley
 		float sliceScale = 1;
 		Vector4s outerBorder;
 		Rect4f clip; // This is not a std::optional<Rect4f>, and instead has a companion bool, because it allows for better memory alignment
+		mutable Rect4f aabb;
 		bool hasClip = false;
 		bool absoluteClip = false;
 		bool visible = true;
 		bool flip = false;
 		bool sliced = false;
 		bool sharedMaterial = false;
+		mutable bool aabbDirty = true;
 
 		void doSetSprite(const SpriteSheetEntry& entry, bool applyPivot);
 		void computeSize();
+		Rect4f computeAABB() const;
 
 		template<typename F> void paintWithClip(Painter& painter, const std::optional<Rect4f>& clip, F f) const;
 
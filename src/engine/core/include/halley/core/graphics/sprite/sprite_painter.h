@@ -3,6 +3,7 @@
 #include <halley/data_structures/vector.h>
 #include <cstddef>
 #include "halley/maths/rect.h"
+#include "halley/maths/aabb_list.h"
 #include <limits>
 #include <optional>
 
@@ -12,6 +13,7 @@ namespace Halley
 	class String;
 	class Sprite;
 	class Painter;
+	class StaticSpriteBatch;
 
 	enum class SpritePainterEntryType
 	{
@@ -19,7 +21,8 @@ namespace Halley
 		SpriteCached,
 		TextRef,
 		TextCached,
-		Callback
+		Callback,
+		StaticBatch
 	};
 
 	class SpritePainterEntry
@@ -29,12 +32,14 @@ namespace Halley
 		
 		SpritePainterEntry(gsl::span<const Sprite> sprites, int mask, int layer, float tieBreaker, size_t insertOrder, std::optional<Rect4f> clip);
 		SpritePainterEntry(gsl::span<const TextRenderer> texts, int mask, int layer, float tieBreaker, size_t insertOrder, std::optional<Rect4f> clip);
+		SpritePainterEntry(const StaticSpriteBatch& batch, int mask, int layer, float tieBreaker, size_t insertOrder, std::optional<Rect4f> clip);
 		SpritePainterEntry(SpritePainterEntryType type, size_t spriteIdx, size_t count, int mask, int layer, float tieBreaker, size_t insertOrder, std::optional<Rect4f> clip);
 
 		bool operator<(const SpritePainterEntry& o) const;
 		SpritePainterEntryType getType() const;
 		gsl::span<const Sprite> getSprites() const;
 		gsl::span<const TextRenderer> getTexts() const;
+		const StaticSpriteBatch& getStaticBatch() const;
 		uint32_t getIndex() const;
 		uint32_t getCount() const;
 		int getMask() const;
@@ -65,6 +70,7 @@ namespace Halley
 		void add(const TextRenderer& sprite, int mask, int layer, float tieBreaker, std::optional<Rect4f> clip = {});
 		void addCopy(const TextRenderer& text, int mask, int layer, float tieBreaker, std::optional<Rect4f> clip = {});
 		void add(SpritePainterEntry::Callback callback, int mask, int layer, float tieBreaker, std::optional<Rect4f> clip = {});
+		void add(const StaticSpriteBatch& batch, int mask, int layer, float tieBreaker, std::optional<Rect4f> clip = {});
 		
 		void draw(int mask, Painter& painter);
 
@@ -75,8 +81,12 @@ namespace Halley
 		Vector<SpritePainterEntry::Callback> callbacks;
 		bool dirty = false;
 
-		void draw(gsl::span<const Sprite> sprite, Painter& painter, Rect4f view, const std::optional<Rect4f>& clip) const;
+		AABBList aabbs;
+
+		gsl::span<const Sprite> getSprites(const SpritePainterEntry& entry) const;
+		void draw(gsl::span<const Sprite> sprites, gsl::span<const uint32_t> visibleIndices, size_t firstIndex, Painter& painter, const std::optional<Rect4f>& clip) const;
 		void draw(gsl::span<const TextRenderer> text, Painter& painter, Rect4f view, const std::optional<Rect4f>& clip) const;
 		void draw(const SpritePainterEntry::Callback& callback, Painter& painter, const std::optional<Rect4f>& clip) const;
+		void draw(const StaticSpriteBatch& batch, Painter& painter, Rect4f view, const std::optional<Rect4f>& clip) const;
 	};
 }
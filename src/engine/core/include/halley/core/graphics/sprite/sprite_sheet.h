@@ -7,6 +7,7 @@
 #include <halley/text/halleystring.h>
 #include <halley/data_structures/hash_map.h>
 #include <gsl/span>
+#include <limits>
 #include "halley/maths/vector4.h"
 
 namespace Halley
@@ -43,6 +44,26 @@ namespace Halley
 #endif
 	};
 
+	// Numeric handle to a sprite in a SpriteSheet
+	// Resolve it once with SpriteSheet::getHandle, then look sprites up by array index instead of by name
+	// Handles stay valid when the sheet is hot-reloaded; sprites removed by the reload resolve to a dummy entry
+	class SpriteHandle
+	{
+	public:
+		constexpr SpriteHandle() = default;
+		constexpr explicit SpriteHandle(uint32_t idx) : idx(idx) {}
+
+		constexpr bool isValid() const { return idx != invalidIdx; }
+		constexpr uint32_t getIndex() const { return idx; }
+
+		constexpr bool operator==(const SpriteHandle& other) const { return idx == other.idx; }
+		constexpr bool operator!=(const SpriteHandle& other) const { return idx != other.idx; }
+
+	private:
+		constexpr static uint32_t invalidIdx = std::numeric_limits<uint32_t>::max();
+		uint32_t idx = invalidIdx;
+	};
+
 	class SpriteSheetFrameTag
 	{
 	public:
@@ -83,6 +104,7 @@ namespace Halley
 		const std::shared_ptr<const Texture>& getTexture() const;
 		const SpriteSheetEntry& getSprite(const String& name) const;
 		const SpriteSheetEntry& getSprite(size_t idx) const;
+		const SpriteSheetEntry& getSprite(SpriteHandle handle) const;
 		const SpriteSheetEntry* tryGetSprite(const String& name) const;
 		const SpriteSheetEntry& getDummySprite() const;
 
@@ -92,12 +114,15 @@ namespace Halley
 
 		size_t getSpriteCount() const;
 		std::optional<size_t> getIndex(const String& name) const;
+		SpriteHandle getHandle(const String& name) const;
 		bool hasSprite(const String& name) const;
 
 		void loadJson(gsl::span<const gsl::byte> data);
 
 		void addSprite(String name, const SpriteSheetEntry& sprite);
+		void setSprite(size_t idx, const SpriteSheetEntry& sprite);
 		void setTextureName(String name);
+		void setTexture(std::shared_ptr<const Texture> texture);
 
 		std::shared_ptr<Material> getMaterial(const String& name) const;
 		void setDefaultMaterialName(String materialName);
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <halley/data_structures/vector.h>
+#include "halley/maths/rect.h"
+#include "sprite.h"
+#include <memory>
+
+namespace Halley
+{
+	class Painter;
+	class Material;
+
+	// A retained batch of sprites which don't move (tilemaps, decorations, background props...)
+	// The sprites are expanded into vertices once, split into spatial chunks, and only rebuilt when the contents change.
+	// Drawing culls whole chunks, and issues one draw per material run in each visible chunk.
+	// Sprites may be drawn out of order to keep chunks together, but never relative to a sprite they overlap.
+	// Sliced and clipped sprites are not supported.
+	class StaticSpriteBatch
+	{
+	public:
+		explicit StaticSpriteBatch(float chunkSize = 512.0f);
+
+		void clear();
+		void add(const Sprite& sprite);
+		void add(gsl::span<const Sprite> sprites);
+		void setSprites(Vector<Sprite> sprites);
+
+		gsl::span<const Sprite> getSprites() const;
+		size_t getNumChunks() const;
+		Vector<uint32_t> getDrawOrder() const; // Indices of the sprites which will be drawn. Overlapping sprites keep the order they were added in.
+		bool isDirty() const { return dirty; }
+
+		void draw(Painter& painter, Rect4f view) const;
+
+	private:
+		struct Run
+		{
+			std::shared_ptr<Material> material;
+			size_t firstVertex = 0;
+			size_t numVertices = 0;
+		};
+
+		struct Chunk
+		{
+			Rect4f aabb;
+			Vector<uint32_t> sprites;
+			Vector<char> vertices;
+			Vector<Run> runs;
+		};
+
+		float chunkSize;
+		Vector<Sprite> sprites;
+		mutable Vector<Chunk> chunks;
+		mutable bool dirty = false;
+
+		void rebuild() const;
+		void buildChunk(gsl::span<const uint32_t> spriteIndices) const;
+	};
+}
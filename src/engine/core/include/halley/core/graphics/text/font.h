@@ -3,6 +3,8 @@
 #include <cstdint>
 #include <memory>
 #include <unordered_map>
+#include <array>
+#include <limits>
 #include "halley/core/graphics/texture.h"
 #include "halley/core/graphics/sprite/sprite.h"
 
@@ -81,6 +83,18 @@ namespace Halley
 		std::vector<String> fallback;
 
 		std::shared_ptr<Material> material;
-		std::unordered_map<int, Glyph> glyphs;
+		Vector<Glyph> glyphs;
+
+		// Direct-indexed lookup for the Basic Multilingual Plane, one table of 256 indices into glyphs for each page that has any
+		// Anything outside of it is looked up in extraGlyphs instead
+		constexpr static size_t glyphPageSize = 256;
+		constexpr static size_t numBMPPages = 0x10000 / glyphPageSize;
+		constexpr static uint32_t noGlyph = std::numeric_limits<uint32_t>::max();
+		std::array<uint16_t, numBMPPages> bmpPageIndex = {}; // 0 = no page, otherwise index into bmpPages + 1
+		Vector<std::array<uint32_t, glyphPageSize>> bmpPages;
+		std::unordered_map<int, uint32_t> extraGlyphs;
+
+		const Glyph* findGlyph(int code) const;
+		uint32_t& getGlyphIndex(int code);
 	};
 }
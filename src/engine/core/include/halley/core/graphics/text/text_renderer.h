@@ -96,11 +96,31 @@ namespace Halley
 
 		std::vector<ColourOverride> colourOverrides;
 
+		// Layout is cached separately from placement: glyph offsets are relative to the text's position,
+		// so moving or recolouring the text doesn't require laying it out again
 		mutable Vector<Sprite> spritesCache;
+		mutable Vector<Vector2f> glyphOffsets;
+		mutable Vector<uint32_t> glyphCharIndices;
+		mutable std::optional<Vector2f> extentsCache;
 		mutable bool materialDirty = true;
 		mutable bool glyphsDirty = true;
+		mutable bool colourDirty = true;
 		mutable bool positionDirty = true;
 
+		struct SplitCache {
+			StringUTF32 text;
+			StringUTF32 result;
+			const Font* font = nullptr;
+			float size = 0;
+			float width = 0;
+		};
+		mutable std::optional<SplitCache> splitCache;
+
+		void markLayoutDirty();
+		void layoutGlyphs() const;
+		void applyColours() const;
+		void applyPosition() const;
+
 		std::shared_ptr<Material> getMaterial(const Font& font) const;
 		void updateMaterial(Material& material, const Font& font) const;
 		void updateMaterialForFont(const Font& font) const;
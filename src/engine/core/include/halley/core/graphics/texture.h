@@ -2,6 +2,7 @@
 
 #include "halley/resources/resource.h"
 #include "halley/maths/vector2.h"
+#include "halley/maths/rect.h"
 #include "texture_descriptor.h"
 #include <memory>
 
@@ -26,6 +27,9 @@ namespace Halley
 		Vector2i getSize() const { return size; }
 		const TextureDescriptor& getDescriptor() const { return descriptor; }
 
+		// Replaces the pixels in region with image, which must be RGBA and the same size as region
+		void updateRegion(Rect4i region, const Image& image);
+
 		void copyToTexture(Painter& painter, Texture& other) const;
 		void copyToImage(Painter& painter, Image& image) const;
 		std::unique_ptr<Image> makeImage(Painter& painter) const;
@@ -35,6 +39,7 @@ namespace Halley
 		TextureDescriptor descriptor;
 
 		virtual void doLoad(TextureDescriptor& descriptor);
+		virtual void doUpdateRegion(Rect4i region, const Image& image);
 		virtual void doCopyToTexture(Painter& painter, Texture& other) const;
 		virtual void doCopyToImage(Painter& painter, Image& image) const;
 	};
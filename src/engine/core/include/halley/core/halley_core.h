@@ -13,6 +13,8 @@ namespace Halley {} // Get GitHub to realise this is C++ :3
 #include "game/game_platform.h"
 
 #include "graphics/blend.h"
+#include "graphics/draw_call_analytics.h"
+#include "graphics/gpu_ring_allocator.h"
 #include "graphics/painter.h"
 #include "graphics/render_context.h"
 #include "graphics/shader.h"
@@ -42,10 +44,12 @@ namespace Halley {} // Get GitHub to realise this is C++ :3
 
 #include "graphics/sprite/animation.h"
 #include "graphics/sprite/animation_player.h"
+#include "graphics/sprite/dynamic_atlas.h"
 #include "graphics/sprite/particles.h"
 #include "graphics/sprite/sprite.h"
 #include "graphics/sprite/sprite_painter.h"
 #include "graphics/sprite/sprite_sheet.h"
+#include "graphics/sprite/static_sprite_batch.h"
 
 #include "graphics/window.h"
 
@@ -109,6 +109,35 @@ int DummyVideoPlugin::getPriority() const
 	return -1;
 }
 
+AnalyticsVideoPlugin::AnalyticsVideoPlugin(int priority)
+	: priority(priority)
+{}
+
+PluginType AnalyticsVideoPlugin::getType()
+{
+	return PluginType::GraphicsAPI;
+}
+
+String AnalyticsVideoPlugin::getName()
+{
+	return "Video/Analytics";
+}
+
+HalleyAPIInternal* AnalyticsVideoPlugin::createAPI(SystemAPI* system)
+{
+	return new AnalyticsVideoAPI(*system);
+}
+
+int AnalyticsVideoPlugin::getPriority() const
+{
+	return priority;
+}
+
+std::unique_ptr<Plugin> DrawCallAnalytics::makeVideoPlugin(int priority)
+{
+	return std::make_unique<AnalyticsVideoPlugin>(priority);
+}
+
 PluginType DummyInputPlugin::getType()
 {
 	return PluginType::InputAPI;
@@ -10,6 +10,19 @@ namespace Halley {
 		int getPriority() const override;
 	};
 
+	class AnalyticsVideoPlugin : public Plugin {
+	public:
+		explicit AnalyticsVideoPlugin(int priority);
+
+		PluginType getType() override;
+		String getName() override;
+		HalleyAPIInternal* createAPI(SystemAPI*) override;
+		int getPriority() const override;
+
+	private:
+		int priority;
+	};
+
 	class DummyAudioPlugin : public Plugin {
 	public:
 		PluginType getType() override;
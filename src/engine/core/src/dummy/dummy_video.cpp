@@ -3,6 +3,9 @@
 #include <halley/core/graphics/texture.h>
 #include <halley/core/graphics/shader.h>
 #include <halley/core/graphics/render_target/render_target_texture.h>
+#include <halley/core/graphics/render_target/render_target_screen.h>
+#include <halley/core/graphics/material/material.h>
+#include <halley/core/graphics/material/material_definition.h>
 #include "dummy_system.h"
 
 using namespace Halley;
@@ -123,3 +126,114 @@ void DummyPainter::setClip(Rect4i, bool) {}
 void DummyPainter::setMaterialData(const Material&) {}
 
 void DummyPainter::onUpdateProjection(Material&) {}
+
+AnalyticsVideoAPI::AnalyticsVideoAPI(SystemAPI& system)
+	: DummyVideoAPI(system)
+{}
+
+std::unique_ptr<Painter> AnalyticsVideoAPI::makePainter(Resources& resources)
+{
+	return std::make_unique<AnalyticsPainter>(resources, analytics);
+}
+
+void* AnalyticsVideoAPI::getImplementationPointer(const String& id)
+{
+	if (id == "DrawCallAnalytics") {
+		return &analytics;
+	}
+	return nullptr;
+}
+
+AnalyticsPainter::AnalyticsPainter(Resources& resources, DrawCallAnalytics& analytics)
+	: DummyPainter(resources)
+	, analytics(analytics)
+{}
+
+void AnalyticsPainter::setMaterialPass(const Material& material, int pass)
+{
+	const auto& definition = material.getDefinition();
+	current.material = definition.getName();
+	current.pass = pass;
+	currentShader = &definition.getPass(pass).getShader();
+
+	current.textures.clear();
+	for (const auto& texture: material.getTextures()) {
+		current.textures.push_back(getTextureName(texture.get()));
+	}
+}
+
+void AnalyticsPainter::doStartRender()
+{
+	frameNames.clear();
+	numUnnamedTextures = 0;
+	numUnnamedTargets = 0;
+	current = DrawCallRecord();
+	currentShader = nullptr;
+	lastDrawShader = nullptr;
+
+	analytics.startFrame();
+}
+
+void AnalyticsPainter::doEndRender()
+{
+	analytics.endFrame();
+}
+
+void AnalyticsPainter::setVertices(const MaterialDefinition&, size_t numVertices, void*, size_t numIndices, unsigned short*, bool)
+{
+	current.numVertices = numVertices;
+	current.numIndices = numIndices;
+	current.numInstances = 0;
+}
+
+void AnalyticsPainter::setInstances(const MaterialDefinition& material, size_t numInstances, void* instanceData)
+{
+	// Let the base expand them, so vertex counts match what a non-instanced draw would report
+	Painter::setInstances(material, numInstances, instanceData);
+	current.numInstances = numInstances;
+}
+
+void AnalyticsPainter::drawTriangles(size_t numIndices)
+{
+	auto record = current;
+	record.numIndices = numIndices;
+	record.renderTarget = getRenderTargetName(getActiveRenderTarget());
+	record.shaderChanged = currentShader != lastDrawShader;
+	lastDrawShader = currentShader;
+
+	analytics.recordDraw(std::move(record));
+}
+
+void AnalyticsPainter::setClip(Rect4i clip, bool enable)
+{
+	current.clip = enable ? clip : std::optional<Rect4i>();
+}
+
+String AnalyticsPainter::getTextureName(const Texture* texture)
+{
+	if (!texture) {
+		return "null";
+	}
+	if (!texture->getAssetId().isEmpty()) {
+		return texture->getAssetId();
+	}
+
+	auto& name = frameNames[texture];
+	if (name.isEmpty()) {
+		name = "texture#" + toString(numUnnamedTextures++);
+	}
+	return name;
+}
+
+String AnalyticsPainter::getRenderTargetName(RenderTarget& target)
+{
+	if (dynamic_cast<ScreenRenderTarget*>(&target)) {
+		return "screen";
+	}
+
+	auto& name = frameNames[&target];
+	if (name.isEmpty()) {
+		name = "target#" + toString(numUnnamedTargets++);
+	}
+	return name;
+}
@@ -5,6 +5,7 @@
 #include "graphics/render_target/render_target_screen.h"
 #include "graphics/shader.h"
 #include "graphics/painter.h"
+#include "graphics/draw_call_analytics.h"
 
 namespace Halley {
 	class DummyVideoAPI : public VideoAPIInternal {
@@ -65,4 +66,44 @@ namespace Halley {
 		void setMaterialData(const Material& material) override;
 		void onUpdateProjection(Material& material) override;
 	};
+
+	// Dummy backend which records every draw call into a DrawCallAnalytics
+	class AnalyticsVideoAPI final : public DummyVideoAPI {
+	public:
+		explicit AnalyticsVideoAPI(SystemAPI& system);
+
+		std::unique_ptr<Painter> makePainter(Resources& resources) override;
+		void* getImplementationPointer(const String& id) override;
+
+	private:
+		DrawCallAnalytics analytics;
+	};
+
+	class AnalyticsPainter : public DummyPainter
+	{
+	public:
+		AnalyticsPainter(Resources& resources, DrawCallAnalytics& analytics);
+
+		void setMaterialPass(const Material& material, int pass) override;
+		void doStartRender() override;
+		void doEndRender() override;
+		void setVertices(const MaterialDefinition& material, size_t numVertices, void* vertexData, size_t numIndices, unsigned short* indices, bool standardQuadsOnly) override;
+		void drawTriangles(size_t numIndices) override;
+		void setInstances(const MaterialDefinition& material, size_t numInstances, void* instanceData) override;
+		void setClip(Rect4i clip, bool enable) override;
+
+	private:
+		DrawCallAnalytics& analytics;
+		DrawCallRecord current;
+		const Shader* currentShader = nullptr;
+		const Shader* lastDrawShader = nullptr;
+
+		// Objects without an asset id are named by order of first appearance in the frame, so goldens are stable between runs
+		HashMap<const void*, String> frameNames;
+		size_t numUnnamedTextures = 0;
+		size_t numUnnamedTargets = 0;
+
+		String getTextureName(const Texture* texture);
+		String getRenderTargetName(RenderTarget& target);
+	};
 }
@@ -0,0 +1,200 @@
+#include "graphics/draw_call_analytics.h"
+#include "api/video_api.h"
+#include "halley/file/path.h"
+#include "halley/file_formats/yaml_convert.h"
+#include "halley/support/exception.h"
+#include "halley/text/string_converter.h"
+#include <gsl/gsl_assert>
+
+using namespace Halley;
+
+namespace {
+	constexpr size_t maxReportedDifferences = 20;
+
+	String describe(const ConfigNode& node)
+	{
+		if (node.getType() == ConfigNodeType::Undefined) {
+			return "<none>";
+		}
+		return YAMLConvert::generateYAML(node, {}).replaceAll("\n", " ").trimBoth();
+	}
+}
+
+ConfigNode DrawCallRecord::toConfigNode() const
+{
+	ConfigNode::MapType result;
+	result["material"] = material;
+	result["pass"] = pass;
+	result["textures"] = textures;
+	result["vertices"] = int(numVertices);
+	result["indices"] = int(numIndices);
+	if (numInstances > 0) {
+		result["instances"] = int(numInstances);
+	}
+	result["target"] = renderTarget;
+	if (clip) {
+		result["clip"] = ConfigNode::SequenceType{ ConfigNode(clip->getLeft()), ConfigNode(clip->getTop()), ConfigNode(clip->getWidth()), ConfigNode(clip->getHeight()) };
+	}
+	if (shaderChanged) {
+		result["shaderChanged"] = true;
+	}
+	return result;
+}
+
+ConfigNode DrawCallSummary::toConfigNode() const
+{
+	ConfigNode::MapType result;
+	result["drawCalls"] = int(drawCalls);
+	result["vertices"] = int(vertices);
+	result["triangles"] = int(triangles);
+	result["materialSwitches"] = int(materialSwitches);
+	result["shaderSwitches"] = int(shaderSwitches);
+	result["textureSwitches"] = int(textureSwitches);
+	result["renderTargetSwitches"] = int(renderTargetSwitches);
+	result["clipChanges"] = int(clipChanges);
+	return result;
+}
+
+String DrawCallSummary::toString() const
+{
+	return Halley::toString(drawCalls) + " draw calls, " + Halley::toString(vertices) + " vertices, " + Halley::toString(triangles) + " triangles, "
+		+ Halley::toString(materialSwitches) + " material switches, " + Halley::toString(shaderSwitches) + " shader switches, "
+		+ Halley::toString(textureSwitches) + " texture switches, " + Halley::toString(renderTargetSwitches) + " render target switches, "
+		+ Halley::toString(clipChanges) + " clip changes";
+}
+
+DrawCallAnalytics* DrawCallAnalytics::get(VideoAPI& video)
+{
+	return static_cast<DrawCallAnalytics*>(video.getImplementationPointer("DrawCallAnalytics"));
+}
+
+void DrawCallAnalytics::startFrame()
+{
+	currentFrame.clear();
+	inFrame = true;
+}
+
+void DrawCallAnalytics::endFrame()
+{
+	if (inFrame) {
+		std::swap(currentFrame, lastFrame);
+		currentFrame.clear();
+		++numFrames;
+		inFrame = false;
+	}
+}
+
+void DrawCallAnalytics::recordDraw(DrawCallRecord record)
+{
+	currentFrame.push_back(std::move(record));
+}
+
+const Vector<DrawCallRecord>& DrawCallAnalytics::getDrawCalls() const
+{
+	return lastFrame;
+}
+
+DrawCallSummary DrawCallAnalytics::getSummary() const
+{
+	DrawCallSummary summary;
+	const DrawCallRecord* prev = nullptr;
+
+	for (const auto& draw: lastFrame) {
+		++summary.drawCalls;
+		summary.vertices += draw.numVertices;
+		summary.triangles += draw.numIndices / 3;
+
+		// The first draw of the frame counts as a switch for everything, since it has to bind it
+		if (!prev || prev->material != draw.material || prev->pass != draw.pass) {
+			++summary.materialSwitches;
+		}
+		if (!prev || draw.shaderChanged) {
+			++summary.shaderSwitches;
+		}
+		if (!prev || prev->textures != draw.textures) {
+			++summary.textureSwitches;
+		}
+		if (!prev || prev->renderTarget != draw.renderTarget) {
+			++summary.renderTargetSwitches;
+		}
+		if (prev && prev->clip != draw.clip) {
+			++summary.clipChanges;
+		}
+		prev = &draw;
+	}
+
+	return summary;
+}
+
+size_t DrawCallAnalytics::getNumFramesRecorded() const
+{
+	return numFrames;
+}
+
+ConfigNode DrawCallAnalytics::toConfigNode() const
+{
+	ConfigNode::SequenceType draws;
+	draws.reserve(lastFrame.size());
+	for (const auto& draw: lastFrame) {
+		draws.push_back(draw.toConfigNode());
+	}
+
+	ConfigNode::MapType result;
+	result["summary"] = getSummary().toConfigNode();
+	result["drawCalls"] = std::move(draws);
+	return result;
+}
+
+DrawCallAnalytics::GoldenResult DrawCallAnalytics::compareWithGolden(const ConfigNode& golden) const
+{
+	GoldenResult result;
+	const auto actual = toConfigNode();
+
+	auto addDifference = [&] (String difference)
+	{
+		result.matches = false;
+		if (result.differences.size() < maxReportedDifferences) {
+			result.differences.push_back(std::move(difference));
+		}
+	};
+
+	for (const auto& [key, value]: actual["summary"].asMap()) {
+		const auto& expected = golden["summary"][key];
+		if (expected.getType() == ConfigNodeType::Undefined || expected.asInt() != value.asInt()) {
+			addDifference("Summary " + key + ": expected " + describe(expected) + ", got " + toString(value.asInt()));
+		}
+	}
+
+	// Goldens may omit the draw call list, to only check the summary
+	if (golden.hasKey("drawCalls")) {
+		const auto& expectedDraws = golden["drawCalls"].asSequence();
+		const auto& actualDraws = actual["drawCalls"].asSequence();
+		for (size_t i = 0; i < std::max(expectedDraws.size(), actualDraws.size()); ++i) {
+			const auto expected = i < expectedDraws.size() ? ConfigNode(expectedDraws[i]) : ConfigNode();
+			const auto got = i < actualDraws.size() ? ConfigNode(actualDraws[i]) : ConfigNode();
+			if (!(expected == got)) {
+				addDifference("Draw call #" + toString(i) + ": expected " + describe(expected) + ", got " + describe(got));
+			}
+		}
+	}
+
+	return result;
+}
+
+DrawCallAnalytics::GoldenResult DrawCallAnalytics::checkGoldenFile(const Path& path, GoldenMode mode) const
+{
+	if (mode == GoldenMode::Update) {
+		Path::writeFile(path, YAMLConvert::generateYAML(toConfigNode(), {}));
+		return GoldenResult();
+	}
+
+	const auto data = Path::readFile(path);
+	if (data.empty()) {
+		GoldenResult result;
+		result.matches = false;
+		result.differences.push_back("Golden file \"" + path.getString() + "\" is missing or empty");
+		return result;
+	}
+
+	return compareWithGolden(YAMLConvert::parseConfig(data).getRoot());
+}
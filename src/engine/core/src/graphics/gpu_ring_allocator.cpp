@@ -0,0 +1,79 @@
+#include "graphics/gpu_ring_allocator.h"
+#include <gsl/gsl_assert>
+
+using namespace Halley;
+
+namespace {
+	constexpr size_t segmentAlignment = 256;
+}
+
+GPURingAllocator::GPURingAllocator(size_t segmentSize, size_t numSegments)
+	: numSegments(numSegments)
+{
+	Expects(numSegments > 0);
+	fences.resize(numSegments);
+	reset(segmentSize);
+}
+
+void GPURingAllocator::reset(size_t size)
+{
+	Expects(!inFrame);
+
+	waitAll();
+	segmentSize = (size + segmentAlignment - 1) / segmentAlignment * segmentAlignment;
+	curSegment = 0;
+	head = 0;
+	overflowed = false;
+}
+
+void GPURingAllocator::beginFrame()
+{
+	Expects(!inFrame);
+
+	inFrame = true;
+	++frameId;
+	curSegment = size_t(frameId % numSegments);
+	head = 0;
+
+	auto& fence = fences[curSegment];
+	if (fence) {
+		if (!fence->isSignalled()) {
+			++numStalls;
+			fence->wait();
+		}
+		fence.reset();
+	}
+}
+
+void GPURingAllocator::endFrame(std::unique_ptr<GPUFence> fence)
+{
+	Expects(inFrame);
+
+	inFrame = false;
+	fences[curSegment] = std::move(fence);
+}
+
+void GPURingAllocator::waitAll()
+{
+	for (auto& fence: fences) {
+		if (fence) {
+			fence->wait();
+			fence.reset();
+		}
+	}
+}
+
+std::optional<size_t> GPURingAllocator::allocate(size_t size, size_t alignment)
+{
+	Expects(inFrame);
+	Expects(alignment > 0 && alignment <= segmentAlignment && (alignment & (alignment - 1)) == 0);
+
+	const size_t start = (head + alignment - 1) & ~(alignment - 1);
+	if (start + size > segmentSize) {
+		overflowed = true;
+		return {};
+	}
+
+	head = start + size;
+	return curSegment * segmentSize + start;
+}
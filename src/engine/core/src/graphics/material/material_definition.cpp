@@ -10,6 +10,7 @@
 #include "halley/file_formats/binary_file.h"
 #include "halley/file_formats/config_file.h"
 #include "halley/utils/algorithm.h"
+#include <gsl/gsl_assert>
 
 using namespace Halley;
 
@@ -171,10 +172,12 @@ void MaterialDefinition::load(const ConfigNode& root)
 	// Load name
 	name = root["name"].asString("Unknown");
 	defaultMask = root["defaultMask"].asInt(1);
+	instanced = root["instanced"].asBool(instanced);
 
 	// Load attributes & uniforms
+	std::optional<ShaderParameterType> vertPosType;
 	if (root.hasKey("attributes")) {
-		loadAttributes(root["attributes"]);
+		vertPosType = loadAttributes(root["attributes"]);
 	}
 	if (root.hasKey("uniforms")) {
 		loadUniforms(root["uniforms"]);
@@ -182,6 +185,10 @@ void MaterialDefinition::load(const ConfigNode& root)
 	if (root.hasKey("textures")) {
 		loadTextures(root["textures"]);
 	}
+
+	if (instanced && vertPosType != ShaderParameterType::Float4) {
+		throw Exception("Material \"" + name + "\" is instanced, but doesn't have a vec4 vertPos attribute.", HalleyExceptions::Resources);
+	}
 }
 
 int MaterialDefinition::getNumPasses() const
@@ -223,6 +230,28 @@ size_t MaterialDefinition::getVertexPosOffset() const
 	return size_t(vertexPosOffset);
 }
 
+bool MaterialDefinition::isInstanced() const
+{
+	return instanced;
+}
+
+size_t MaterialDefinition::getInstanceSize() const
+{
+	return getVertexSize() - sizeof(Vector4f);
+}
+
+size_t MaterialDefinition::getInstanceStride() const
+{
+	const auto size = getInstanceSize();
+	return size % 16 != 0 ? size + 16 - size % 16 : size;
+}
+
+size_t MaterialDefinition::getInstanceAttributeOffset(const MaterialAttribute& attribute) const
+{
+	Expects(attribute.offset != vertexPosOffset);
+	return size_t(attribute.offset < vertexPosOffset ? attribute.offset : attribute.offset - int(sizeof(Vector4f)));
+}
+
 bool MaterialDefinition::hasTexture(const String& name) const
 {
 	return std_ex::contains_if(textures, [&] (const auto& t) { return t.name == name; });
@@ -258,6 +287,7 @@ void MaterialDefinition::serialize(Serializer& s) const
 	s << vertexSize;
 	s << vertexPosOffset;
 	s << defaultMask;
+	s << instanced;
 }
 
 void MaterialDefinition::deserialize(Deserializer& s)
@@ -270,6 +300,7 @@ void MaterialDefinition::deserialize(Deserializer& s)
 	s >> vertexSize;
 	s >> vertexPosOffset;
 	s >> defaultMask;
+	s >> instanced;
 }
 
 bool MaterialDefinition::isColumnMajor() const
@@ -332,10 +363,11 @@ void MaterialDefinition::loadTextures(const ConfigNode& node)
 	}
 }
 
-void MaterialDefinition::loadAttributes(const ConfigNode& node)
+std::optional<ShaderParameterType> MaterialDefinition::loadAttributes(const ConfigNode& node)
 {
 	int location = int(attributes.size());
 	int offset = vertexSize;
+	std::optional<ShaderParameterType> vertPosType;
 
 	for (const auto& attribEntry: node.asSequence()) {
 		const ShaderParameterType type = parseParameterType(attribEntry["type"].asString());
@@ -360,10 +392,12 @@ void MaterialDefinition::loadAttributes(const ConfigNode& node)
 
 		if (attribEntry["special"].asString("") == "vertPos") {
 			vertexPosOffset = a.offset;
+			vertPosType = type;
 		}
 	}
 
 	vertexSize = offset;
+	return vertPosType;
 }
 
 ShaderParameterType MaterialDefinition::parseParameterType(const String& rawType) const
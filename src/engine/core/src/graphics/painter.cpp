@@ -17,7 +17,7 @@
 
 using namespace Halley;
 
-struct LineVertex {
+struct Painter::LineVertex {
 	Vector4f colour;
 	Vector2f position;
 	Vector2f normal;
@@ -38,9 +38,59 @@ Painter::~Painter()
 {
 }
 
+void PainterBindCache::reset()
+{
+	textures.fill(Slot());
+	constantBuffers.fill(Slot());
+	blend.reset();
+}
+
+bool PainterBindCache::changeTexture(int unit, const void* handle, size_t variant)
+{
+	if (unit < 0 || unit >= int(maxTextureUnits)) {
+		return true;
+	}
+	return changeSlot(textures[unit], handle, variant);
+}
+
+bool PainterBindCache::changeConstantBuffer(int bindPoint, const void* handle, size_t offset)
+{
+	if (bindPoint < 0 || bindPoint >= int(maxConstantBuffers)) {
+		return true;
+	}
+	return changeSlot(constantBuffers[bindPoint], handle, offset);
+}
+
+bool PainterBindCache::changeBlend(BlendType type)
+{
+	if (blend == type) {
+		return false;
+	}
+	blend = type;
+	return true;
+}
+
+void PainterBindCache::invalidateTexture(int unit)
+{
+	if (unit >= 0 && unit < int(maxTextureUnits)) {
+		textures[unit] = Slot();
+	}
+}
+
+bool PainterBindCache::changeSlot(Slot& slot, const void* handle, size_t extra)
+{
+	if (slot.handle == handle && slot.extra == extra && handle != nullptr) {
+		return false;
+	}
+	slot.handle = handle;
+	slot.extra = extra;
+	return true;
+}
+
 void Painter::startRender()
 {
 	Material::resetBindCache();
+	bindCache.reset();
 	prevDrawCalls = nDrawCalls;
 	prevTriangles = nTriangles;
 	prevVertices = nVertices;
@@ -56,6 +106,10 @@ void Painter::endRender()
 	doEndRender();
 	camera = Camera();
 	viewPort = Rect4i(0, 0, 0, 0);
+
+	++frameNumber;
+	evictPolygonTriangulations(60);
+	frameAllocator.reset();
 }
 
 void Painter::flush()
@@ -76,7 +130,15 @@ static Vector4f& getVertPos(char* vertexAttrib, size_t vertPosOffset)
 	return *reinterpret_cast<Vector4f*>(vertexAttrib + vertPosOffset);
 }
 
-Painter::PainterVertexData Painter::addDrawData(const std::shared_ptr<Material>& material, size_t numVertices, size_t numIndices, bool standardQuadsOnly)
+void Painter::setReorderWindow(size_t window)
+{
+	if (window != reorderWindow) {
+		flushPending();
+		reorderWindow = window;
+	}
+}
+
+Painter::PainterVertexData Painter::addDrawData(const std::shared_ptr<Material>& material, size_t numVertices, size_t numIndices, bool standardQuadsOnly, const std::optional<Rect4f>& bounds)
 {
 	updateClip();
 
@@ -84,42 +146,61 @@ Painter::PainterVertexData Painter::addDrawData(const std::shared_ptr<Material>&
 	if (numVertices > maxVertices) {
 		throw Exception("Too many vertices in draw call: " + toString(numVertices) + ", maximum is " + toString(maxVertices), HalleyExceptions::Graphics);
 	}
-	if (verticesPending + numVertices > maxVertices) {
-		flushPending();
-	}
 
 	Expects(material != nullptr);
 	Expects(numVertices > 0);
 	Expects(numIndices >= numVertices);
 
-	startDrawCall(material);
+	auto& batch = startDrawCall(material, numVertices, false, bounds);
 
 	PainterVertexData result;
 
 	result.vertexSize = material->getDefinition().getVertexSize();
 	result.vertexStride = material->getDefinition().getVertexStride();
 	result.dataSize = numVertices * result.vertexStride;
-	makeSpaceForPendingVertices(result.dataSize);
-	makeSpaceForPendingIndices(numIndices);
+	makeSpaceForPendingVertices(batch, result.dataSize);
+	makeSpaceForPendingIndices(batch, numIndices);
+
+	result.dstVertex = batch.vertexBuffer.data() + batch.bytesPending;
+	result.dstIndex = batch.indexBuffer.data() + batch.indicesPending;
+	result.firstIndex = static_cast<IndexType>(batch.verticesPending);
+
+	batch.indicesPending += numIndices;
+	batch.verticesPending += numVertices;
+	batch.bytesPending += result.dataSize;
+	batch.allIndicesAreQuads &= standardQuadsOnly;
+
+	return result;
+}
+
+char* Painter::addInstanceData(const std::shared_ptr<Material>& material, size_t numInstances, const std::optional<Rect4f>& bounds)
+{
+	updateClip();
+
+	Expects(material != nullptr);
+	Expects(numInstances > 0);
 
-	result.dstVertex = vertexBuffer.data() + bytesPending;
-	result.dstIndex = indexBuffer.data() + indicesPending;
-	result.firstIndex = static_cast<IndexType>(verticesPending);
+	// Instanced batches still count the vertices they expand to, so backends without instancing can draw them with 16-bit indices
+	const size_t numVertices = numInstances * 4;
+	auto& batch = startDrawCall(material, numVertices, true, bounds);
 
-	indicesPending += numIndices;
-	verticesPending += numVertices;
-	bytesPending += result.dataSize;
-	allIndicesAreQuads &= standardQuadsOnly;
+	const size_t dataSize = numInstances * material->getDefinition().getInstanceStride();
+	makeSpaceForPendingVertices(batch, dataSize);
+	char* result = batch.vertexBuffer.data() + batch.bytesPending;
+
+	batch.instancesPending += numInstances;
+	batch.verticesPending += numVertices;
+	batch.bytesPending += dataSize;
 
 	return result;
 }
 
-void Painter::draw(const std::shared_ptr<Material>& material, size_t numVertices, const void* vertexData, gsl::span<const IndexType> indices, PrimitiveType primitiveType)
+void Painter::draw(const std::shared_ptr<Material>& material, size_t numVertices, const void* vertexData, gsl::span<const IndexType> indices, PrimitiveType primitiveType, std::optional<Rect4f> bounds)
 {
 	Expects(primitiveType == PrimitiveType::Triangle);
 	Expects(indices.size() % 3 == 0);
 
-	const auto result = addDrawData(material, numVertices, indices.size(), false);
+	const auto result = addDrawData(material, numVertices, indices.size(), false, bounds);
 
 	memcpy(result.dstVertex, vertexData, result.dataSize);
 
@@ -128,61 +209,125 @@ void Painter::draw(const std::shared_ptr<Material>& material, size_t numVertices
 	}
 }
 
-void Painter::drawQuads(const std::shared_ptr<Material>& material, size_t numVertices, const void* vertexData)
+void Painter::drawQuads(const std::shared_ptr<Material>& material, size_t numVertices, const void* vertexData, std::optional<Rect4f> bounds)
 {
 	Expects(numVertices % 4 == 0);
 	Expects(vertexData != nullptr);
 
-	const auto result = addDrawData(material, numVertices, numVertices * 3 / 2, true);
+	const auto result = addDrawData(material, numVertices, numVertices * 3 / 2, true, bounds);
 
 	memcpy(result.dstVertex, vertexData, result.dataSize);
 	generateQuadIndices(result.firstIndex, numVertices / 4, result.dstIndex);
 }
 
-void Painter::drawSprites(const std::shared_ptr<Material>& material, size_t totalNumSprites, const void* vertexData)
+void Painter::drawSprites(const std::shared_ptr<Material>& material, size_t totalNumSprites, const void* vertexData, std::optional<Rect4f> bounds)
 {
 	Expects(vertexData != nullptr);
 
 	const size_t verticesPerSprite = 4;
 	const size_t maxSpritesPerCall = (static_cast<size_t>(std::numeric_limits<IndexType>::max()) + 1) / verticesPerSprite;
+	const bool instanced = material->getDefinition().isInstanced();
 	size_t numSpritesLeft = totalNumSprites;
 	size_t offset = 0;
 
 	while (numSpritesLeft > 0) {
 		const size_t numSprites = std::min(numSpritesLeft, maxSpritesPerCall);
-		
-		const size_t numVertices = verticesPerSprite * numSprites;
-		const size_t vertPosOffset = material->getDefinition().getVertexPosOffset();
-
-		const auto result = addDrawData(material, numVertices, numSprites * 6, true);
-
 		const char* const src = reinterpret_cast<const char*>(vertexData) + offset;
 
-		for (size_t i = 0; i < numSprites; i++) {
-			for (size_t j = 0; j < verticesPerSprite; j++) {
-				const size_t srcOffset = i * result.vertexStride;
-				const size_t dstOffset = (i * verticesPerSprite + j) * result.vertexStride;
-				memcpy(result.dstVertex + dstOffset, src + srcOffset, result.vertexSize);
-
-				// j -> vertPos
-				// 0 -> 0, 0
-				// 1 -> 1, 0
-				// 2 -> 1, 1
-				// 3 -> 0, 1
-				const float x = ((j & 1) ^ ((j & 2) >> 1)) * 1.0f;
-				const float y = ((j & 2) >> 1) * 1.0f;
-				getVertPos(result.dstVertex + dstOffset, vertPosOffset) = Vector4f(x, y, x, y);
-			}
+		if (instanced) {
+			char* dst = addInstanceData(material, numSprites, bounds);
+			writeSpriteInstances(material->getDefinition(), numSprites, src, dst);
+		} else {
+			const size_t numVertices = verticesPerSprite * numSprites;
+			const auto result = addDrawData(material, numVertices, numSprites * 6, true, bounds);
+			expandSpriteVertices(material->getDefinition(), numSprites, src, result.dstVertex);
+			generateQuadIndices(result.firstIndex, numSprites, result.dstIndex);
 		}
 
-		generateQuadIndices(result.firstIndex, numSprites, result.dstIndex);
-
 		numSpritesLeft -= numSprites;
 		offset += numSprites * material->getDefinition().getVertexStride();
 	}
 }
 
-void Painter::drawSlicedSprite(const std::shared_ptr<Material>& material, Vector2f scale, Vector4f slices, const void* vertexData)
+void Painter::expandSpriteVertices(const MaterialDefinition& material, size_t numSprites, const void* vertexData, void* dstVertexData)
+{
+	constexpr size_t verticesPerSprite = 4;
+	const size_t vertexSize = material.getVertexSize();
+	const size_t vertexStride = material.getVertexStride();
+	const size_t vertPosOffset = material.getVertexPosOffset();
+
+	const auto corners = getSpriteCorners();
+
+	const char* const src = static_cast<const char*>(vertexData);
+	char* const dst = static_cast<char*>(dstVertexData);
+
+	for (size_t i = 0; i < numSprites; i++) {
+		for (size_t j = 0; j < verticesPerSprite; j++) {
+			const size_t srcOffset = i * vertexStride;
+			const size_t dstOffset = (i * verticesPerSprite + j) * vertexStride;
+			memcpy(dst + dstOffset, src + srcOffset, vertexSize);
+			getVertPos(dst + dstOffset, vertPosOffset) = corners[j];
+		}
+	}
+}
+
+void Painter::writeSpriteInstances(const MaterialDefinition& material, size_t numSprites, const void* vertexData, void* dstInstanceData)
+{
+	const size_t vertexStride = material.getVertexStride();
+	const size_t instanceStride = material.getInstanceStride();
+	const size_t vertPosOffset = material.getVertexPosOffset();
+	const size_t vertPosEnd = vertPosOffset + sizeof(Vector4f);
+	const size_t tailSize = material.getVertexSize() - vertPosEnd;
+
+	const char* src = static_cast<const char*>(vertexData);
+	char* dst = static_cast<char*>(dstInstanceData);
+
+	// The record is the sprite's vertex with vertPos cut out
+	for (size_t i = 0; i < numSprites; i++) {
+		memcpy(dst, src, vertPosOffset);
+		memcpy(dst + vertPosOffset, src + vertPosEnd, tailSize);
+		src += vertexStride;
+		dst += instanceStride;
+	}
+}
+
+void Painter::expandSpriteInstances(const MaterialDefinition& material, size_t numInstances, const void* instanceData, void* dstVertexData)
+{
+	constexpr size_t verticesPerSprite = 4;
+	const size_t vertexStride = material.getVertexStride();
+	const size_t instanceStride = material.getInstanceStride();
+	const size_t vertPosOffset = material.getVertexPosOffset();
+	const size_t vertPosEnd = vertPosOffset + sizeof(Vector4f);
+	const size_t tailSize = material.getVertexSize() - vertPosEnd;
+	const auto corners = getSpriteCorners();
+
+	const char* src = static_cast<const char*>(instanceData);
+	char* dst = static_cast<char*>(dstVertexData);
+
+	for (size_t i = 0; i < numInstances; i++) {
+		for (size_t j = 0; j < verticesPerSprite; j++) {
+			memcpy(dst, src, vertPosOffset);
+			getVertPos(dst, vertPosOffset) = corners[j];
+			memcpy(dst + vertPosEnd, src + vertPosOffset, tailSize);
+			dst += vertexStride;
+		}
+		src += instanceStride;
+	}
+}
+
+gsl::span<const Vector4f> Painter::getSpriteCorners()
+{
+	// xy is the position in the quad, zw is the texture coordinate
+	static const std::array<Vector4f, 4> corners = {
+		Vector4f(0, 0, 0, 0),
+		Vector4f(1, 0, 1, 0),
+		Vector4f(1, 1, 1, 1),
+		Vector4f(0, 1, 0, 1)
+	};
+	return corners;
+}
+
+void Painter::drawSlicedSprite(const std::shared_ptr<Material>& material, Vector2f scale, Vector4f slices, const void* vertexData, std::optional<Rect4f> bounds)
 {
 	Expects(vertexData != nullptr);
 	if (scale.x < 0.00001f || scale.y < 0.00001f) {
@@ -206,7 +351,7 @@ void Painter::drawSlicedSprite(const std::shared_ptr<Material>& material, Vector
 	const size_t numIndices = 9 * 6; // 9 quads, 6 indices per quad
 	const size_t vertPosOffset = material->getDefinition().getVertexPosOffset();
 
-	const auto result = addDrawData(material, numVertices, numIndices, false);
+	const auto result = addDrawData(material, numVertices, numIndices, false, bounds);
 	const char* const src = static_cast<const char*>(vertexData);
 
 	// Vertices
@@ -251,7 +396,7 @@ void Painter::drawLine(gsl::span<const Vector2f> points, float width, Colour4f c
 
 	const size_t nPoints = points.size();
 	const size_t nSegments = (loop ? nPoints : (nPoints - 1));
-	std::vector<LineVertex> vertices(nSegments * 4);
+	FrameVector<LineVertex> vertices(nSegments * 4, frameAllocator);
 
 	auto segmentNormal = [&] (size_t i) -> std::optional<Vector2f>
 	{
@@ -323,7 +468,8 @@ static size_t getSegmentsForArc(float radius, float arcLen)
 void Painter::drawCircle(Vector2f centre, float radius, float width, Colour4f colour, std::shared_ptr<Material> material)
 {
 	const size_t n = getSegmentsForArc(radius, 2 * float(pi()));
-	std::vector<Vector2f> points;
+	FrameVector<Vector2f> points(frameAllocator);
+	points.reserve(n);
 	for (size_t i = 0; i < n; ++i) {
 		points.push_back(centre + Vector2f(radius, 0).rotate(Angle1f::fromRadians(i * 2.0f * float(pi()) / n)));
 	}
@@ -339,7 +485,8 @@ void Painter::drawCircleArc(Vector2f centre, float radius, float width, Angle1f
 {
 	const float arcLen = (to - from).getRadians() + (from.turnSide(to) > 0 ? 0.0f : 0 * float(pi()));
 	const size_t n = getSegmentsForArc(radius, arcLen);
-	std::vector<Vector2f> points;
+	FrameVector<Vector2f> points(frameAllocator);
+	points.reserve(n);
 	for (size_t i = 0; i < n; ++i) {
 		points.push_back(centre + Vector2f(radius, 0).rotate(from + Angle1f::fromRadians(i * arcLen / (n - 1))));
 	}
@@ -354,7 +501,8 @@ void Painter::drawCircleArc(Circle circle, float width, Angle1f from, Angle1f to
 void Painter::drawEllipse(Vector2f centre, Vector2f radius, float width, Colour4f colour, std::shared_ptr<Material> material)
 {
 	const size_t n = getSegmentsForArc(std::max(radius.x, radius.y), 2 * float(pi()));
-	std::vector<Vector2f> points;
+	FrameVector<Vector2f> points(frameAllocator);
+	points.reserve(n);
 	for (size_t i = 0; i < n; ++i) {
 		points.push_back(centre + Vector2f(1.0f, 0).rotate(Angle1f::fromRadians(i * 2.0f * float(pi()) / n)) * radius);
 	}
@@ -363,11 +511,7 @@ void Painter::drawEllipse(Vector2f centre, Vector2f radius, float width, Colour4
 
 void Painter::drawRect(Rect4f rect, float width, Colour4f colour, std::shared_ptr<Material> material)
 {
-	std::vector<Vector2f> points;
-	points.push_back(rect.getTopLeft());
-	points.push_back(rect.getTopRight());
-	points.push_back(rect.getBottomRight());
-	points.push_back(rect.getBottomLeft());
+	const std::array<Vector2f, 4> points = { rect.getTopLeft(), rect.getTopRight(), rect.getBottomRight(), rect.getBottomLeft() };
 	drawLine(points, width, colour, true, std::move(material));
 }
 
@@ -380,33 +524,144 @@ void Painter::drawPolygon(const Polygon& polygon, Colour4f colour, std::shared_p
 	if (!material) {
 		material = getSolidPolygonMaterial();
 	}
-	
-	if (!polygon.isConvex()) {
-		for (const auto& p: polygon.splitIntoConvex()) {
-			drawPolygon(p, colour, material);
-		}
+
+	const auto indices = getPolygonTriangulation(polygon);
+	if (indices.empty()) {
 		return;
 	}
 
-	auto col = Vector4f(colour.r, colour.g, colour.b, colour.a);
-	
+	const auto col = Vector4f(colour.r, colour.g, colour.b, colour.a);
 	const auto& vs = polygon.getVertices();
 	const auto n = vs.size();
-	std::vector<LineVertex> vertices(n);
+	FrameVector<LineVertex> vertices(n, frameAllocator);
 	for (size_t i = 0; i < n; ++i) {
 		vertices[i].position = vs[i];
 		vertices[i].colour = col;
 		vertices[i].normal = Vector2f();
 		vertices[i].width = Vector2f();
 	}
-	std::vector<IndexType> indices((n - 2) * 3);
-	for (size_t i = 0; i < n - 2; ++i) {
-		indices.push_back(0);
-		indices.push_back(static_cast<IndexType>(i) + 1);
-		indices.push_back(static_cast<IndexType>(i) + 2);
+
+	draw(material, n, vertices.data(), indices, PrimitiveType::Triangle);
+}
+
+namespace {
+	void triangulatePolygon(gsl::span<const Vector2f> vs, bool convex, Vector<IndexType>& indices, FrameAllocator& frameAllocator)
+	{
+		const size_t n = vs.size();
+		indices.clear();
+		if (n < 3) {
+			return;
+		}
+		indices.reserve((n - 2) * 3);
+
+		if (convex) {
+			for (size_t i = 1; i + 1 < n; ++i) {
+				indices.push_back(0);
+				indices.push_back(static_cast<IndexType>(i));
+				indices.push_back(static_cast<IndexType>(i + 1));
+			}
+			return;
+		}
+
+		// Ear clipping, independent of the winding of the polygon
+		float area2 = 0;
+		for (size_t i = 0; i < n; ++i) {
+			area2 += vs[i].cross(vs[(i + 1) % n]);
+		}
+		const float orientation = area2 >= 0 ? 1.0f : -1.0f;
+
+		auto isConvexCorner = [&] (Vector2f a, Vector2f b, Vector2f c)
+		{
+			return (b - a).cross(c - b) * orientation > 0;
+		};
+		auto isInsideTriangle = [&] (Vector2f p, Vector2f a, Vector2f b, Vector2f c)
+		{
+			return (b - a).cross(p - a) * orientation > 0 && (c - b).cross(p - b) * orientation > 0 && (a - c).cross(p - c) * orientation > 0;
+		};
+
+		FrameVector<IndexType> remaining(n, frameAllocator);
+		for (size_t i = 0; i < n; ++i) {
+			remaining[i] = static_cast<IndexType>(i);
+		}
+
+		size_t cur = 0;
+		size_t attempts = 0;
+		while (remaining.size() > 3) {
+			const size_t m = remaining.size();
+			cur %= m;
+			const auto i0 = remaining[(cur + m - 1) % m];
+			const auto i1 = remaining[cur];
+			const auto i2 = remaining[(cur + 1) % m];
+			const auto a = vs[i0];
+			const auto b = vs[i1];
+			const auto c = vs[i2];
+
+			bool isEar = isConvexCorner(a, b, c);
+			for (size_t j = 0; isEar && j < m; ++j) {
+				const auto idx = remaining[j];
+				if (idx != i0 && idx != i1 && idx != i2 && isInsideTriangle(vs[idx], a, b, c)) {
+					isEar = false;
+				}
+			}
+
+			// If a full loop found no ears, the polygon is degenerate; clip anyway so we always terminate
+			if (isEar || attempts >= m) {
+				indices.push_back(i0);
+				indices.push_back(i1);
+				indices.push_back(i2);
+				remaining.erase(remaining.begin() + cur);
+				attempts = 0;
+			} else {
+				++cur;
+				++attempts;
+			}
+		}
+
+		indices.push_back(remaining[0]);
+		indices.push_back(remaining[1]);
+		indices.push_back(remaining[2]);
+	}
+}
+
+gsl::span<const IndexType> Painter::getPolygonTriangulation(const Polygon& polygon)
+{
+	const auto& vs = polygon.getVertices();
+
+	// Convex polygons are just a fan, which is cheaper to build than to look up
+	if (polygon.isConvex()) {
+		triangulatePolygon(vs, true, polygonIndexScratch, frameAllocator);
+		return polygonIndexScratch;
+	}
+
+	auto iter = polygonTriangulations.find(polygon.getRevision());
+	if (iter == polygonTriangulations.end()) {
+		// When full, make room by dropping whatever wasn't drawn this frame. If everything was, just don't cache this one.
+		constexpr size_t maxCachedTriangulations = 1024;
+		if (polygonTriangulations.size() >= maxCachedTriangulations) {
+			evictPolygonTriangulations(0);
+		}
+		if (polygonTriangulations.size() >= maxCachedTriangulations) {
+			triangulatePolygon(vs, false, polygonIndexScratch, frameAllocator);
+			return polygonIndexScratch;
+		}
+
+		iter = polygonTriangulations.emplace(polygon.getRevision(), PolygonTriangulation()).first;
+		triangulatePolygon(vs, false, iter->second.indices, frameAllocator);
 	}
 
-	draw(material, vertices.size(), vertices.data(), indices, PrimitiveType::Triangle);
+	iter->second.lastUsedFrame = frameNumber;
+	return iter->second.indices;
+}
+
+void Painter::evictPolygonTriangulations(uint32_t maxFramesUnused)
+{
+	for (auto iter = polygonTriangulations.begin(); iter != polygonTriangulations.end();) {
+		if (frameNumber - iter->second.lastUsedFrame > maxFramesUnused) {
+			iter = polygonTriangulations.erase(iter);
+		} else {
+			++iter;
+		}
+	}
 }
 
 void Painter::blitTexture(const std::shared_ptr<const Texture>& texture)
@@ -434,19 +689,19 @@ void Painter::setLogging(bool logging)
 	this->logging = logging;
 }
 
-void Painter::makeSpaceForPendingVertices(size_t numBytes)
+void Painter::makeSpaceForPendingVertices(PendingBatch& batch, size_t numBytes)
 {
-	size_t requiredSize = bytesPending + numBytes;
-	if (vertexBuffer.size() < requiredSize) {
-		vertexBuffer.resize(requiredSize * 2);
+	size_t requiredSize = batch.bytesPending + numBytes;
+	if (batch.vertexBuffer.size() < requiredSize) {
+		batch.vertexBuffer.resize(requiredSize * 2);
 	}
 }
 
-void Painter::makeSpaceForPendingIndices(size_t numIndices)
+void Painter::makeSpaceForPendingIndices(PendingBatch& batch, size_t numIndices)
 {
-	size_t requiredSize = indicesPending + numIndices;
-	if (indexBuffer.size() < requiredSize) {
-		indexBuffer.resize(requiredSize * 2);
+	size_t requiredSize = batch.indicesPending + numIndices;
+	if (batch.indexBuffer.size() < requiredSize) {
+		batch.indexBuffer.resize(requiredSize * 2);
 	}
 }
 
@@ -462,6 +717,7 @@ void Painter::bind(RenderContext& context)
 		throw Exception("No active render target", HalleyExceptions::Core);
 	}
 	activeRenderTarget->onBind(*this);
+	bindCache.reset();
 
 	// Set viewport
 	viewPort = camera.getActiveViewPort();
@@ -528,40 +784,96 @@ std::shared_ptr<Material> Painter::getSolidPolygonMaterial()
 	return solidPolygonMaterial;
 }
 
-void Painter::startDrawCall(const std::shared_ptr<Material>& material)
+Painter::PendingBatch& Painter::startDrawCall(const std::shared_ptr<Material>& material, size_t numVertices, bool instanced, const std::optional<Rect4f>& bounds)
 {
-	constexpr bool enableDynamicBatching = true;
+	constexpr auto maxVertices = size_t(std::numeric_limits<IndexType>::max()) + 1;
+
+	auto canAppendTo = [&] (const PendingBatch& batch)
+	{
+		return batch.verticesPending + numVertices <= maxVertices
+			&& batch.instanced == instanced
+			&& (batch.material == material || *batch.material == *material);
+	};
 
-	if (material != materialPending) {
-		if (!enableDynamicBatching || (materialPending != std::shared_ptr<Material>() && !(*material == *materialPending))) {
-			flushPending();
+	// Look for a batch to merge into, newest first. The draw can only move back past batches that it doesn't overlap.
+	for (size_t i = numBatchesPending; i-- > 0; ) {
+		auto& batch = batches[i];
+		if (canAppendTo(batch)) {
+			if (batch.bounds && bounds) {
+				batch.bounds = batch.bounds->merge(*bounds);
+			} else {
+				batch.bounds = {};
+			}
+			return batch;
+		}
+		if (!bounds || !batch.bounds || batch.bounds->overlaps(*bounds)) {
+			break;
 		}
-		materialPending = material;
 	}
+
+	// Open a new batch, flushing the oldest if the window is full
+	if (numBatchesPending > reorderWindow) {
+		flushBatch(batches[0]);
+		std::rotate(batches.begin(), batches.begin() + 1, batches.begin() + numBatchesPending);
+		--numBatchesPending;
+	}
+	if (batches.size() <= numBatchesPending) {
+		batches.resize(numBatchesPending + 1);
+	}
+
+	auto& batch = batches[numBatchesPending++];
+	batch.material = material;
+	batch.bounds = bounds;
+	batch.instanced = instanced;
+	return batch;
 }
 
 void Painter::flushPending()
 {
-	if (verticesPending > 0) {
-		executeDrawPrimitives(*materialPending, verticesPending, vertexBuffer.data(), gsl::span<const IndexType>(indexBuffer.data(), indicesPending));
+	for (size_t i = 0; i < numBatchesPending; ++i) {
+		flushBatch(batches[i]);
 	}
 
 	resetPending();
 }
 
+void Painter::flushBatch(PendingBatch& batch)
+{
+	if (batch.instanced) {
+		if (batch.instancesPending > 0) {
+			executeDrawInstances(*batch.material, batch.instancesPending, batch.vertexBuffer.data());
+		}
+	} else if (batch.verticesPending > 0) {
+		executeDrawPrimitives(*batch.material, batch.verticesPending, batch.vertexBuffer.data(), gsl::span<const IndexType>(batch.indexBuffer.data(), batch.indicesPending), batch.allIndicesAreQuads);
+	}
+
+	resetBatch(batch);
+}
+
 void Painter::resetPending()
 {
-	bytesPending = 0;
-	verticesPending = 0;
-	indicesPending = 0;
-	allIndicesAreQuads = true;
-	if (materialPending) {
+	for (size_t i = 0; i < numBatchesPending; ++i) {
+		resetBatch(batches[i]);
+	}
+	numBatchesPending = 0;
+}
+
+void Painter::resetBatch(PendingBatch& batch)
+{
+	batch.bytesPending = 0;
+	batch.verticesPending = 0;
+	batch.indicesPending = 0;
+	batch.instancesPending = 0;
+	batch.allIndicesAreQuads = true;
+	batch.instanced = false;
+	batch.bounds = {};
+	if (batch.material) {
 		Material::resetBindCache();
-		materialPending.reset();
+		batch.material.reset();
 	}
 }
 
-void Painter::executeDrawPrimitives(Material& material, size_t numVertices, void* vertexData, gsl::span<const IndexType> indices, PrimitiveType primitiveType)
+void Painter::executeDrawPrimitives(Material& material, size_t numVertices, void* vertexData, gsl::span<const IndexType> indices, bool allIndicesAreQuads, PrimitiveType primitiveType)
 {
 	Expects(primitiveType == PrimitiveType::Triangle);
 
@@ -596,6 +908,43 @@ void Painter::executeDrawPrimitives(Material& material, size_t numVertices, void
 	endDrawCall();
 }
 
+void Painter::executeDrawInstances(Material& material, size_t numInstances, void* instanceData)
+{
+	startDrawCall();
+
+	setInstances(material.getDefinition(), numInstances, instanceData);
+
+	material.uploadData(*this);
+	setMaterialData(material);
+
+	for (int i = 0; i < material.getDefinition().getNumPasses(); i++) {
+		if (material.isPassEnabled(i)) {
+			material.bind(i, *this);
+			drawInstances(numInstances);
+
+			if (logging) {
+				nDrawCalls++;
+				nTriangles += numInstances * 2;
+				nVertices += numInstances * 4;
+			}
+		}
+	}
+
+	endDrawCall();
+}
+
+void Painter::setInstances(const MaterialDefinition& material, size_t numInstances, void* instanceData)
+{
+	instanceExpansionScratch.resize(numInstances * 4 * material.getVertexStride());
+	expandSpriteInstances(material, numInstances, instanceData, instanceExpansionScratch.data());
+	setVertices(material, numInstances * 4, instanceExpansionScratch.data(), numInstances * 6, getStandardQuadIndices(numInstances), true);
+}
+
+void Painter::drawInstances(size_t numInstances)
+{
+	drawTriangles(numInstances * 6);
+}
+
 IndexType* Painter::getStandardQuadIndices(size_t numQuads)
 {
 	size_t sz = numQuads * 6;
@@ -63,6 +63,11 @@ RenderTarget& RenderContext::getDefaultRenderTarget() const
 	return defaultRenderTarget;
 }
 
+FrameAllocator& RenderContext::getFrameAllocator() const
+{
+	return painter.getFrameAllocator();
+}
+
 void RenderContext::flush()
 {
 	painter.flush();
@@ -13,14 +13,18 @@ using namespace Halley;
 
 
 RenderGraph::RenderGraph()
+	: texturePool(std::make_unique<RenderGraphTexturePool>())
 {
 }
 
 RenderGraph::RenderGraph(std::shared_ptr<const RenderGraphDefinition> def)
+	: texturePool(std::make_unique<RenderGraphTexturePool>())
 {
 	loadDefinition(std::move(def));
 }
 
+RenderGraph::~RenderGraph() = default;
+
 void RenderGraph::loadDefinition(std::shared_ptr<const RenderGraphDefinition> definition)
 {
 	nodes.clear();
@@ -92,7 +96,7 @@ void RenderGraph::render(const RenderContext& rc, VideoAPI& video, std::optional
 		node->determineIfNeedsRenderTarget();
 	}
 	
-	std::vector<RenderGraphNode*> renderQueue;
+	FrameVector<RenderGraphNode*> renderQueue(rc.getFrameAllocator());
 	renderQueue.reserve(nodes.size());
 	for (auto& node: nodes) {
 		if (node->activeInCurrentPass && node->depsLeft == 0) {
@@ -100,8 +104,17 @@ void RenderGraph::render(const RenderContext& rc, VideoAPI& video, std::optional
 		}
 	}
 
+	// Only nodes reachable from an active output are queued, so passes feeding nothing are culled
+	// Transient textures go back to the pool as soon as their last reader is done, so later passes can reuse them
 	for (size_t i = 0; i < renderQueue.size(); ++i) {
-		renderQueue[i]->render(*this, video, rc, renderQueue);
+		renderQueue[i]->render(*this, video, rc, renderQueue, *texturePool);
+	}
+	texturePool->endFrame();
+
+	for (auto& node: nodes) {
+		if (!node->activeInCurrentPass) {
+			node->renderTarget.reset();
+		}
 	}
 
 	RenderContext(rc).bind([] (Painter& painter)
@@ -174,30 +174,15 @@ void RenderGraphNode::resetTextures()
 	}
 }
 
-std::shared_ptr<Texture> RenderGraphNode::makeTexture(VideoAPI& video, RenderGraphPinType type)
+void RenderGraphNode::render(const RenderGraph& graph, VideoAPI& video, const RenderContext& rc, FrameVector<RenderGraphNode*>& renderQueue, RenderGraphTexturePool& texturePool)
 {
-	Expects (type == RenderGraphPinType::ColourBuffer || type == RenderGraphPinType::DepthStencilBuffer);
-
-	const auto size = Vector2i::max(currentSize, Vector2i(4, 4));
-	auto texture = video.createTexture(size);
-
-	auto desc = TextureDescriptor(size, type == RenderGraphPinType::ColourBuffer ? TextureFormat::RGBA : TextureFormat::Depth);
-	desc.isRenderTarget = true;
-	desc.isDepthStencil = type == RenderGraphPinType::DepthStencilBuffer;
-	desc.useFiltering = false; // TODO: allow filtering
-	texture->load(std::move(desc));
-
-	return texture;
-}
-
-void RenderGraphNode::render(const RenderGraph& graph, VideoAPI& video, const RenderContext& rc, std::vector<RenderGraphNode*>& renderQueue)
-{
-	prepareTextures(video, rc);
+	prepareTextures(video, rc, texturePool);
 	renderNode(graph, rc);
-	notifyOutputs(renderQueue);
+	notifyOutputs(renderQueue, texturePool);
+	releaseTextures(texturePool);
 }
 
-void RenderGraphNode::prepareTextures(VideoAPI& video, const RenderContext& rc)
+void RenderGraphNode::prepareTextures(VideoAPI& video, const RenderContext& rc, RenderGraphTexturePool& texturePool)
 {
 	getRenderTarget(video);
 
@@ -205,17 +190,16 @@ void RenderGraphNode::prepareTextures(VideoAPI& video, const RenderContext& rc)
 		int colourIdx = 0;
 		for (auto& input: inputPins) {
 			if (renderTarget) {
-				// Create Colour/DepthStencil textures for render target, if needed
+				// Get Colour/DepthStencil textures for render target from the pool, if needed
 				if (!input.other.node && input.type != RenderGraphPinType::Texture) {
-					if (!input.texture) {
-						input.texture = makeTexture(video, input.type);
-					}
+					input.texture = texturePool.acquire(video, Vector2i::max(currentSize, Vector2i(4, 4)), input.type);
 				}
 
 				// Assign textures to render target
-				if (input.type == RenderGraphPinType::ColourBuffer && !renderTarget->hasColourBuffer(colourIdx)) {
+				// The pool hands out textures in a stable order, so this is normally a no-op after the first frame
+				if (input.type == RenderGraphPinType::ColourBuffer && input.texture) {
 					renderTarget->setTarget(colourIdx++, input.texture);
-				} else if (input.type == RenderGraphPinType::DepthStencilBuffer && !renderTarget->hasDepthBuffer()) {
+				} else if (input.type == RenderGraphPinType::DepthStencilBuffer) {
 					renderTarget->setDepthTexture(input.texture);
 				}
 			} else {
@@ -312,7 +296,7 @@ RenderContext RenderGraphNode::getTargetRenderContext(const RenderContext& rc) c
 	}
 }
 
-void RenderGraphNode::notifyOutputs(std::vector<RenderGraphNode*>& renderQueue)
+void RenderGraphNode::notifyOutputs(FrameVector<RenderGraphNode*>& renderQueue, RenderGraphTexturePool& texturePool)
 {
 	std::shared_ptr<Texture> colour;
 	std::shared_ptr<Texture> depthStencil;
@@ -341,6 +325,7 @@ void RenderGraphNode::notifyOutputs(std::vector<RenderGraphNode*>& renderQueue)
 			if (other.node->activeInCurrentPass) {
 				// TODO: copy when needed
 				other.node->inputPins[other.otherId].texture = texture;
+				texturePool.addReference(texture);
 				
 				if (--other.node->depsLeft == 0) {
 					renderQueue.push_back(other.node);
@@ -350,6 +335,17 @@ void RenderGraphNode::notifyOutputs(std::vector<RenderGraphNode*>& renderQueue)
 	}
 }
 
+void RenderGraphNode::releaseTextures(RenderGraphTexturePool& texturePool)
+{
+	// This pass is done with its inputs, so any texture not forwarded to a later pass can be reused
+	for (auto& input: inputPins) {
+		if (input.texture) {
+			texturePool.release(input.texture);
+			input.texture.reset();
+		}
+	}
+}
+
 void RenderGraphNode::connectInput(uint8_t inputPin, RenderGraphNode& node, uint8_t outputPin)
 {
 	auto& input = inputPins.at(inputPin);
@@ -373,3 +369,69 @@ void RenderGraphNode::disconnectInput(uint8_t inputPin)
 	auto& outs = outputPin.others;
 	outs.erase(std::remove_if(outs.begin(), outs.end(), [=] (const OtherPin& o) { return o.node == this; }), outs.end());
 }
+
+std::shared_ptr<Texture> RenderGraphTexturePool::acquire(VideoAPI& video, Vector2i size, RenderGraphPinType type)
+{
+	Expects (type == RenderGraphPinType::ColourBuffer || type == RenderGraphPinType::DepthStencilBuffer);
+
+	for (auto& entry: entries) {
+		if (entry.references == 0 && entry.size == size && entry.type == type) {
+			entry.references = 1;
+			entry.usedThisFrame = true;
+			return entry.texture;
+		}
+	}
+
+	std::shared_ptr<Texture> texture = video.createTexture(size);
+
+	auto desc = TextureDescriptor(size, type == RenderGraphPinType::ColourBuffer ? TextureFormat::RGBA : TextureFormat::Depth);
+	desc.isRenderTarget = true;
+	desc.isDepthStencil = type == RenderGraphPinType::DepthStencilBuffer;
+	desc.useFiltering = false; // TODO: allow filtering
+	texture->load(std::move(desc));
+
+	entries.push_back(Entry{ texture, size, type, 1, true });
+	return texture;
+}
+
+void RenderGraphTexturePool::addReference(const std::shared_ptr<Texture>& texture)
+{
+	if (auto* entry = tryGetEntry(texture)) {
+		++entry->references;
+	}
+}
+
+void RenderGraphTexturePool::release(const std::shared_ptr<Texture>& texture)
+{
+	if (auto* entry = tryGetEntry(texture)) {
+		Expects(entry->references > 0);
+		--entry->references;
+	}
+}
+
+void RenderGraphTexturePool::endFrame()
+{
+	entries.erase(std::remove_if(entries.begin(), entries.end(), [] (const Entry& e) { return !e.usedThisFrame; }), entries.end());
+	for (auto& entry: entries) {
+		entry.references = 0;
+		entry.usedThisFrame = false;
+	}
+}
+
+size_t RenderGraphTexturePool::getNumTextures() const
+{
+	return entries.size();
+}
+
+RenderGraphTexturePool::Entry* RenderGraphTexturePool::tryGetEntry(const std::shared_ptr<Texture>& texture)
+{
+	if (!texture) {
+		return nullptr;
+	}
+	for (auto& entry: entries) {
+		if (entry.texture == texture) {
+			return &entry;
+		}
+	}
+	return nullptr;
+}
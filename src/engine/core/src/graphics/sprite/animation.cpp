@@ -8,21 +8,23 @@
 #include "halley/bytes/byte_serializer.h"
 #include <gsl/gsl_assert>
 #include <utility>
+#include <numeric>
 
 #include "halley/support/logger.h"
 
 using namespace Halley;
 
 AnimationFrame::AnimationFrame(int frameNumber, int duration, const String& imageName, const SpriteSheet& sheet, const Vector<AnimationDirection>& directions)
-	: duration(duration)
+	: sheet(&sheet)
+	, duration(duration)
 {
+	// Names are resolved to handles once here; looking up a frame at runtime is just an array index
 	const size_t n = directions.size();
 	sprites.resize(n);
 	for (size_t i = 0; i < n; i++) {
 		const auto& name = directions[i].needsToProcessFrameName(imageName) ? directions[i].getFrameName(frameNumber, imageName) : imageName;
-		sprites[i] = sheet.tryGetSprite(name);
-		if (!sprites[i]) {
-			sprites[i] = &sheet.getDummySprite();
+		sprites[i] = sheet.getHandle(name);
+		if (!sprites[i].isValid()) {
 			Logger::logWarning("Missing animation frame: " + name);
 		}
 	}
@@ -92,6 +94,49 @@ void AnimationSequence::addFrame(const AnimationFrameDefinition& animationFrameD
 	frameDefinitions.push_back(animationFrameDefinition);
 }
 
+size_t AnimationSequence::getFrameAtTime(int timeMs) const
+{
+	if (frames.empty()) {
+		return 0;
+	}
+
+	const int time = clamp(timeMs, 0, duration - 1);
+	if (!frameTable.empty()) {
+		return frameTable[time / frameTableStep];
+	}
+	return size_t(std::upper_bound(frameStartTimes.begin(), frameStartTimes.end(), time) - frameStartTimes.begin() - 1);
+}
+
+void AnimationSequence::buildFrameTable()
+{
+	constexpr int maxTableSize = 4096;
+
+	frameStartTimes.clear();
+	frameTable.clear();
+	duration = 0;
+	frameTableStep = 0;
+
+	for (const auto& frame: frames) {
+		const int frameDuration = std::max(1, frame.getDuration());
+		frameStartTimes.push_back(duration);
+		duration += frameDuration;
+		frameTableStep = std::gcd(frameTableStep, frameDuration);
+	}
+
+	// Every frame boundary is a multiple of the step, so each slot of the table maps to exactly one frame
+	if (frameTableStep > 0 && duration / frameTableStep <= maxTableSize && frames.size() <= std::numeric_limits<uint16_t>::max()) {
+		frameTable.resize(size_t(duration / frameTableStep));
+		for (size_t i = 0; i < frames.size(); ++i) {
+			const int end = i + 1 < frames.size() ? frameStartTimes[i + 1] : duration;
+			for (int t = frameStartTimes[i]; t < end; t += frameTableStep) {
+				frameTable[size_t(t / frameTableStep)] = uint16_t(i);
+			}
+		}
+	} else {
+		frameTableStep = 1;
+	}
+}
+
 Rect4i AnimationSequence::getBounds() const
 {
 	Vector2i topLeft(99999, 99999);
@@ -195,9 +240,14 @@ void Animation::reload(Resource&& resource)
 
 void Animation::loadDependencies(ResourceLoader& loader)
 {
-	spriteSheet = loader.getResources().get<SpriteSheet>(spriteSheetName);
+	loadDependencies(loader.getResources());
+}
+
+void Animation::loadDependencies(Resources& resources)
+{
+	spriteSheet = resources.get<SpriteSheet>(spriteSheetName);
 
-	auto matDef = loader.getResources().get<MaterialDefinition>(materialName);
+	auto matDef = resources.get<MaterialDefinition>(materialName);
 	material = std::make_shared<Material>(matDef);
 	material->set(0, spriteSheet->getTexture());
 
@@ -205,6 +255,7 @@ void Animation::loadDependencies(ResourceLoader& loader)
 		for (auto& f : s.frameDefinitions) {
 			s.frames.emplace_back(f.makeFrame(*spriteSheet, directions));
 		}
+		s.buildFrameTable();
 	}
 }
 
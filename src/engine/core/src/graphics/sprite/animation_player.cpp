@@ -449,6 +449,143 @@ void AnimationPlayerLite::update(Time time, Sprite& sprite)
 	}
 }
 
+size_t AnimationPlayerBatch::add(std::shared_ptr<const Animation> animation, const String& sequence, const String& direction)
+{
+	Expects(animation);
+
+	const size_t idx = states.size();
+	auto& state = states.emplace_back();
+	state.animation = std::move(animation);
+	state.sequenceName = sequence;
+	state.direction = state.animation->getDirection(direction).getId();
+	times.push_back(0);
+	speeds.push_back(1.0f);
+	frames.push_back(-1);
+
+	resolve(idx);
+	return idx;
+}
+
+void AnimationPlayerBatch::remove(size_t idx)
+{
+	Expects(idx < states.size());
+
+	const size_t last = states.size() - 1;
+	if (idx != last) {
+		states[idx] = std::move(states[last]);
+		times[idx] = times[last];
+		speeds[idx] = speeds[last];
+		frames[idx] = frames[last];
+	}
+	states.pop_back();
+	times.pop_back();
+	speeds.pop_back();
+	frames.pop_back();
+}
+
+void AnimationPlayerBatch::clear()
+{
+	states.clear();
+	times.clear();
+	speeds.clear();
+	frames.clear();
+}
+
+size_t AnimationPlayerBatch::size() const
+{
+	return states.size();
+}
+
+void AnimationPlayerBatch::setSequence(size_t idx, const String& sequence)
+{
+	auto& state = states.at(idx);
+	if (state.sequenceName != sequence) {
+		state.sequenceName = sequence;
+		times[idx] = 0;
+		resolve(idx);
+	}
+}
+
+void AnimationPlayerBatch::setDirection(size_t idx, const String& direction)
+{
+	auto& state = states.at(idx);
+	const int dirId = state.animation->getDirection(direction).getId();
+	if (state.direction != dirId) {
+		state.direction = dirId;
+		resolve(idx);
+	}
+}
+
+void AnimationPlayerBatch::setPlaybackSpeed(size_t idx, float speed)
+{
+	speeds.at(idx) = speed;
+}
+
+int AnimationPlayerBatch::getCurrentFrame(size_t idx) const
+{
+	return frames.at(idx);
+}
+
+size_t AnimationPlayerBatch::update(Time time, gsl::span<Sprite> sprites)
+{
+	const size_t n = states.size();
+	Expects(size_t(sprites.size()) >= n);
+
+	// Advance all clocks, in milliseconds
+	const float dt = static_cast<float>(time * 1000.0);
+	for (size_t i = 0; i < n; ++i) {
+		times[i] += dt * speeds[i];
+	}
+
+	// Find the current frame of each player, and which ones changed
+	changed.clear();
+	for (size_t i = 0; i < n; ++i) {
+		if (states[i].assetVersion != states[i].animation->getAssetVersion()) {
+			resolve(i);
+		}
+
+		const auto& seq = *states[i].sequence;
+		const int duration = seq.getDuration();
+		if (duration == 0) {
+			continue;
+		}
+
+		if (times[i] >= static_cast<float>(duration)) {
+			times[i] = seq.isLooping() ? std::fmod(times[i], static_cast<float>(duration)) : static_cast<float>(duration);
+		}
+
+		const int frame = static_cast<int>(seq.getFrameAtTime(static_cast<int>(times[i])));
+		if (frame != frames[i]) {
+			frames[i] = frame;
+			changed.push_back(static_cast<uint32_t>(i));
+		}
+	}
+
+	// Only touch the sprites that need it
+	for (const auto i: changed) {
+		const auto& state = states[i];
+		const auto& material = state.animation->getMaterial();
+		auto& sprite = sprites[i];
+		if (!sprite.hasCompatibleMaterial(*material)) {
+			sprite.setMaterial(material, true);
+		}
+		sprite
+			.setSprite(state.sequence->getFrame(size_t(frames[i])).getSprite(state.direction), false)
+			.setFlip(state.flip);
+	}
+
+	return changed.size();
+}
+
+void AnimationPlayerBatch::resolve(size_t idx)
+{
+	auto& state = states[idx];
+	state.assetVersion = state.animation->getAssetVersion();
+	state.sequence = &state.animation->getSequence(state.sequenceName);
+	state.flip = state.animation->getDirection(state.direction).shouldFlip() && !state.sequence->isNoFlip();
+	frames[idx] = -1;
+}
+
 ConfigNode ConfigNodeSerializer<AnimationPlayer>::serialize(const AnimationPlayer& player, const ConfigNodeSerializationContext& context)
 {
 	ConfigNode result = ConfigNode::MapType();
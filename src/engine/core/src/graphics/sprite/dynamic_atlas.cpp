@@ -0,0 +1,193 @@
+#include "graphics/sprite/dynamic_atlas.h"
+#include "graphics/sprite/sprite_sheet.h"
+#include "graphics/texture.h"
+#include "graphics/texture_descriptor.h"
+#include "api/video_api.h"
+#include "halley/file_formats/image.h"
+#include "halley/text/string_converter.h"
+#include <gsl/gsl_assert>
+
+using namespace Halley;
+
+DynamicAtlas::DynamicAtlas(VideoAPI& video, Vector2i pageSize, size_t maxPages, int padding)
+	: video(video)
+	, pageSize(pageSize)
+	, maxPages(maxPages)
+	, padding(padding)
+{
+	Expects(pageSize.x > 0 && pageSize.y > 0);
+	Expects(maxPages > 0);
+	Expects(padding >= 0);
+}
+
+DynamicAtlas::~DynamicAtlas() = default;
+
+std::shared_ptr<const SpriteResource> DynamicAtlas::add(const String& key, const Image& image)
+{
+	Expects(image.getFormat() == Image::Format::RGBA || image.getFormat() == Image::Format::RGBAPremultiplied);
+
+	if (auto existing = get(key)) {
+		return existing;
+	}
+
+	const auto imageSize = image.getSize();
+	const auto slotSize = imageSize + Vector2i(2 * padding, 2 * padding);
+	const auto allocation = allocate(slotSize);
+	if (!allocation) {
+		return {};
+	}
+
+	const auto [pageIdx, slot] = allocation.value();
+	auto& page = *pages[pageIdx];
+
+	// Upload the whole slot, so the padding around the image is cleared as well
+	Image slotImage(Image::Format::RGBA, slot.getSize());
+	slotImage.clear(0);
+	slotImage.blitFrom(Vector2i(padding, padding), image);
+	page.texture->updateRegion(slot, slotImage);
+
+	SpriteSheetEntry sprite;
+	sprite.size = Vector2f(imageSize);
+	const auto topLeft = slot.getTopLeft() + Vector2i(padding, padding);
+	sprite.coords = Rect4f(Vector2f(topLeft) / Vector2f(pageSize), Vector2f(topLeft + imageSize) / Vector2f(pageSize));
+
+	size_t spriteIdx;
+	if (!page.freeSpriteIndices.empty()) {
+		spriteIdx = page.freeSpriteIndices.back();
+		page.freeSpriteIndices.pop_back();
+		page.spriteSheet->setSprite(spriteIdx, sprite);
+	} else {
+		spriteIdx = page.spriteSheet->getSpriteCount();
+		page.spriteSheet->addSprite("atlas" + toString(spriteIdx), sprite);
+	}
+	++page.numEntries;
+
+	auto& entry = entries[key];
+	entry.handle = std::make_shared<SpriteResource>(page.spriteSheet, spriteIdx);
+	entry.page = pageIdx;
+	entry.spriteIdx = spriteIdx;
+	entry.slot = slot;
+	entry.lastUsed = ++useCounter;
+	return entry.handle;
+}
+
+std::shared_ptr<const SpriteResource> DynamicAtlas::get(const String& key)
+{
+	const auto iter = entries.find(key);
+	if (iter == entries.end()) {
+		return {};
+	}
+	iter->second.lastUsed = ++useCounter;
+	return iter->second.handle;
+}
+
+bool DynamicAtlas::has(const String& key) const
+{
+	return entries.find(key) != entries.end();
+}
+
+size_t DynamicAtlas::getNumPages() const
+{
+	return pages.size();
+}
+
+size_t DynamicAtlas::getNumEntries() const
+{
+	return entries.size();
+}
+
+std::shared_ptr<const Texture> DynamicAtlas::getPageTexture(size_t page) const
+{
+	return pages.at(page)->texture;
+}
+
+std::optional<std::pair<size_t, Rect4i>> DynamicAtlas::allocate(Vector2i size)
+{
+	if (size.x > pageSize.x || size.y > pageSize.y) {
+		return {};
+	}
+
+	while (true) {
+		for (size_t i = 0; i < pages.size(); ++i) {
+			if (const auto slot = allocateInPage(*pages[i], size)) {
+				return std::pair<size_t, Rect4i>(i, slot.value());
+			}
+		}
+
+		if (pages.size() < maxPages) {
+			createPage();
+		} else if (!evictLeastRecentlyUsed()) {
+			return {};
+		}
+	}
+}
+
+std::optional<Rect4i> DynamicAtlas::allocateInPage(Page& page, Vector2i size)
+{
+	// Reuse the smallest evicted slot that fits, before taking new space
+	// The whole slot is kept, so it can be handed back in one piece when evicted again
+	size_t bestIdx = page.freeSlots.size();
+	int bestArea = std::numeric_limits<int>::max();
+	for (size_t i = 0; i < page.freeSlots.size(); ++i) {
+		const auto slotSize = page.freeSlots[i].getSize();
+		const int area = slotSize.x * slotSize.y;
+		if (slotSize.x >= size.x && slotSize.y >= size.y && area < bestArea) {
+			bestIdx = i;
+			bestArea = area;
+		}
+	}
+
+	if (bestIdx < page.freeSlots.size()) {
+		const auto slot = page.freeSlots[bestIdx];
+		page.freeSlots.erase(page.freeSlots.begin() + bestIdx);
+		return slot;
+	}
+
+	return page.allocator.allocate(size);
+}
+
+bool DynamicAtlas::evictLeastRecentlyUsed()
+{
+	// Sprites don't keep the handle alive, so callers hold on to it while the image might be drawn (see the header)
+	// Anything still referenced outside the atlas is never evicted
+	auto victim = entries.end();
+	for (auto iter = entries.begin(); iter != entries.end(); ++iter) {
+		if (iter->second.handle.use_count() == 1 && (victim == entries.end() || iter->second.lastUsed < victim->second.lastUsed)) {
+			victim = iter;
+		}
+	}
+
+	if (victim == entries.end()) {
+		return false;
+	}
+
+	auto& page = *pages[victim->second.page];
+	page.freeSlots.push_back(victim->second.slot);
+	page.freeSpriteIndices.push_back(victim->second.spriteIdx);
+	if (--page.numEntries == 0) {
+		page.allocator.reset();
+		page.freeSlots.clear();
+	}
+
+	entries.erase(victim);
+	return true;
+}
+
+void DynamicAtlas::createPage()
+{
+	auto& page = *pages.emplace_back(std::make_unique<Page>(pageSize));
+
+	auto image = std::make_unique<Image>(Image::Format::RGBA, pageSize);
+	image->clear(0);
+
+	TextureDescriptor desc(pageSize, TextureFormat::RGBA);
+	desc.pixelData = std::move(image);
+	desc.retainPixelData = true; // Needed by backends which can't upload sub-regions
+
+	page.texture = std::shared_ptr<Texture>(video.createTexture(pageSize));
+	page.texture->startLoading();
+	page.texture->load(std::move(desc));
+
+	page.spriteSheet = std::make_shared<SpriteSheet>();
+	page.spriteSheet->setTexture(page.texture);
+}
@@ -2,6 +2,10 @@
 
 #include "halley/maths/random.h"
 #include "halley/support/logger.h"
+#include "halley/concurrency/concurrent.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 
 using namespace Halley;
 
@@ -133,22 +137,7 @@ void Particles::update(Time t)
 	updateParticles(static_cast<float>(t));
 
 	// Remove dead particles
-	for (size_t i = 0; i < nParticlesAlive; ) {
-		if (!particles[i].alive) {
-			if (i != nParticlesAlive - 1) {
-				// Swap with last particle that's alive
-				std::swap(particles[i], particles[nParticlesAlive - 1]);
-				std::swap(sprites[i], sprites[nParticlesAlive - 1]);
-				if (isAnimated()) {
-					std::swap(animationPlayers[i], animationPlayers[nParticlesAlive - 1]);
-				}
-			}
-			--nParticlesAlive;
-			// Don't increment i here, since i is now a new particle that's still alive
-		} else {
-			++i;
-		}
-	}
+	removeDeadParticles();
 
 	// Update visibility
 	nParticlesVisible = nParticlesAlive;
@@ -196,8 +185,14 @@ void Particles::spawn(size_t n)
 	const size_t start = nParticlesAlive;
 	nParticlesAlive += n;
 	const size_t size = std::max(size_t(8), nextPowerOf2(nParticlesAlive));
-	if (particles.size() < size) {
-		particles.resize(size);
+	if (times.size() < size) {
+		positions.resize(size);
+		velocities.resize(size);
+		angles.resize(size);
+		scales.resize(size);
+		times.resize(size);
+		ttls.resize(size);
+		scatterAngles.resize(size);
 		sprites.resize(size);
 		if (isAnimated()) {
 			animationPlayers.resize(size, AnimationPlayerLite(baseAnimation));
@@ -213,14 +208,12 @@ void Particles::initializeParticle(size_t index)
 {
 	const auto startDirection = Angle1f::fromDegrees(rng->getFloat(angle - angleScatter, angle + angleScatter));
 	
-	auto& particle = particles[index];
-	particle.alive = true;
-	particle.time = 0;
-	particle.ttl = rng->getFloat(ttl - ttlScatter, ttl + ttlScatter);
-	particle.pos = getSpawnPosition();
-	particle.angle = rotateTowardsMovement ? startDirection : Angle1f();
-	particle.scale = startScale;
-	particle.vel = Vector2f(rng->getFloat(speed - speedScatter, speed + speedScatter), startDirection);
+	times[index] = 0;
+	ttls[index] = rng->getFloat(ttl - ttlScatter, ttl + ttlScatter);
+	positions[index] = getSpawnPosition();
+	angles[index] = rotateTowardsMovement ? startDirection : Angle1f();
+	scales[index] = startScale;
+	velocities[index] = Vector2f(rng->getFloat(speed - speedScatter, speed + speedScatter), startDirection);
 
 	auto& sprite = sprites[index];
 	if (isAnimated()) {
@@ -233,50 +226,150 @@ void Particles::initializeParticle(size_t index)
 
 void Particles::updateParticles(float time)
 {
-	const bool hasAnim = isAnimated();
-	
-	for (size_t i = 0; i < nParticlesAlive; ++i) {
-		if (hasAnim) {
+	const size_t n = nParticlesAlive;
+
+	if (isAnimated()) {
+		for (size_t i = 0; i < n; ++i) {
 			animationPlayers[i].update(time, sprites[i]);
 		}
-		
-		auto& particle = particles[i];
+	}
+
+	// Random numbers are drawn serially up front, so the rest of the update doesn't touch the RNG
+	if (directionScatter > 0.00001f) {
+		const float maxScatter = directionScatter * time;
+		for (size_t i = 0; i < n; ++i) {
+			scatterAngles[i] = Angle1f::fromDegrees(rng->getFloat(-maxScatter, maxScatter));
+		}
+	}
 
-		particle.time += time;
-		if (particle.time >= particle.ttl) {
-			particle.alive = false;
-		} else {
-			particle.vel += acceleration * time;
-			
-			if (stopTime > 0.00001f && particle.time + stopTime >= particle.ttl) {
-				particle.vel = damp(particle.vel, Vector2f(), 10.0f, time);
-			}
-			
-			if (speedDamp > 0.0001f) {
-				particle.vel = damp(particle.vel, Vector2f(), speedDamp, time);
-			}
+	// Large systems are split across the auxiliary CPU threads, with this thread taking part
+	constexpr size_t parallelThreshold = 4096;
+	constexpr size_t minParticlesPerTask = 1024;
+	const size_t nThreads = n >= parallelThreshold && Executors::hasInstance() ? Executors::getCPUAux().threadCount() : 0;
+	if (nThreads == 0) {
+		updateParticleRange(0, n, time);
+		return;
+	}
 
-			if (directionScatter > 0.00001f) {
-				particle.vel = particle.vel.rotate(Angle1f::fromDegrees(rng->getFloat(-directionScatter * time, directionScatter * time)));
+	// Slices are claimed by whoever gets to them first, this thread included, and this thread only ever waits on slices which are
+	// already running. If the helpers can't start (for example, because this is itself running on a busy cpuAux thread), it
+	// simply ends up doing every slice itself rather than deadlocking.
+	struct SharedState {
+		std::atomic<size_t> nextSlice { 0 };
+		size_t slicesDone = 0;
+		std::mutex mutex;
+		std::condition_variable allDone;
+	};
+
+	const size_t nSlices = std::min(nThreads + 1, n / minParticlesPerTask);
+	const size_t perSlice = (n + nSlices - 1) / nSlices;
+	auto state = std::make_shared<SharedState>();
+
+	// Helpers which start late find nothing left to claim, and never touch this
+	auto runSlices = [this, state, nSlices, perSlice, n, time] ()
+	{
+		for (size_t slice = state->nextSlice++; slice < nSlices; slice = state->nextSlice++) {
+			const size_t start = slice * perSlice;
+			updateParticleRange(start, std::min(start + perSlice, n), time);
+
+			std::unique_lock<std::mutex> lock(state->mutex);
+			if (++state->slicesDone == nSlices) {
+				state->allDone.notify_all();
 			}
-			
-			particle.pos += particle.vel * time;
+		}
+	};
+
+	for (size_t i = 1; i < nSlices; ++i) {
+		Executors::getCPUAux().addToQueue(runSlices);
+	}
+	runSlices();
 
-			if (rotateTowardsMovement && particle.vel.squaredLength() > 0.001f) {
-				particle.angle = particle.vel.angle();
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->allDone.wait(lock, [&] () { return state->slicesDone == nSlices; });
+}
+
+void Particles::updateParticleRange(size_t start, size_t end, float time)
+{
+	for (size_t i = start; i < end; ++i) {
+		times[i] += time;
+	}
+
+	// Damping towards zero is a constant factor for the whole frame
+	const Vector2f deltaVel = acceleration * time;
+	const float speedDampFactor = speedDamp > 0.0001f ? std::exp(-speedDamp * time) : 1.0f;
+	for (size_t i = start; i < end; ++i) {
+		velocities[i] = (velocities[i] + deltaVel) * speedDampFactor;
+	}
+
+	if (stopTime > 0.00001f) {
+		const float stopDampFactor = std::exp(-10.0f * time);
+		for (size_t i = start; i < end; ++i) {
+			velocities[i] *= times[i] + stopTime >= ttls[i] ? stopDampFactor : 1.0f;
+		}
+	}
+
+	if (directionScatter > 0.00001f) {
+		for (size_t i = start; i < end; ++i) {
+			velocities[i] = velocities[i].rotate(scatterAngles[i]);
+		}
+	}
+
+	for (size_t i = start; i < end; ++i) {
+		positions[i] += velocities[i] * time;
+	}
+
+	if (rotateTowardsMovement) {
+		for (size_t i = start; i < end; ++i) {
+			if (velocities[i].squaredLength() > 0.001f) {
+				angles[i] = velocities[i].angle();
 			}
+		}
+	}
 
-			particle.scale = lerp(startScale, endScale, particle.time / particle.ttl);
+	for (size_t i = start; i < end; ++i) {
+		scales[i] = lerp(startScale, endScale, times[i] / ttls[i]);
+	}
 
-			if (fadeInTime > 0.000001f || fadeOutTime > 0.00001f) {
-				const float alpha = clamp(std::min(particle.time / fadeInTime, (particle.ttl - particle.time) / fadeOutTime), 0.0f, 1.0f);
-				sprites[i].getColour().a = alpha;
+	// Write the results into the sprites of the particles that are still alive
+	const bool fade = fadeInTime > 0.000001f || fadeOutTime > 0.00001f;
+	for (size_t i = start; i < end; ++i) {
+		if (times[i] < ttls[i]) {
+			auto& sprite = sprites[i];
+			if (fade) {
+				sprite.getColour().a = clamp(std::min(times[i] / fadeInTime, (ttls[i] - times[i]) / fadeOutTime), 0.0f, 1.0f);
 			}
+			sprite
+				.setPosition(positions[i])
+				.setRotation(angles[i])
+				.setScale(scales[i]);
+		}
+	}
+}
 
-			sprites[i]
-				.setPosition(particle.pos)
-				.setRotation(particle.angle)
-				.setScale(particle.scale);
+void Particles::removeDeadParticles()
+{
+	const bool hasAnim = isAnimated();
+	
+	for (size_t i = 0; i < nParticlesAlive; ) {
+		if (times[i] >= ttls[i]) {
+			const size_t last = nParticlesAlive - 1;
+			if (i != last) {
+				// Move the last particle that's alive into this slot
+				positions[i] = positions[last];
+				velocities[i] = velocities[last];
+				angles[i] = angles[last];
+				scales[i] = scales[last];
+				times[i] = times[last];
+				ttls[i] = ttls[last];
+				std::swap(sprites[i], sprites[last]);
+				if (hasAnim) {
+					std::swap(animationPlayers[i], animationPlayers[last]);
+				}
+			}
+			--nParticlesAlive;
+			// Don't increment i here, since i is now a new particle that's still alive
+		} else {
+			++i;
 		}
 	}
 }
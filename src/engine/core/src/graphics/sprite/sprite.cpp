@@ -21,6 +21,15 @@ Sprite::Sprite()
 	setColour(Colour4f(1, 1, 1, 1));
 }
 
+static std::optional<Rect4f> getReorderBounds(const Sprite& sprite, const Painter& painter)
+{
+	// Bounds are only needed if the painter is allowed to reorder draws
+	if (painter.getReorderWindow() > 0) {
+		return sprite.getAABB();
+	}
+	return {};
+}
+
 template <typename F>
 void Sprite::paintWithClip(Painter& painter, const std::optional<Rect4f>& extClip, F f) const
 {
@@ -65,7 +74,7 @@ void Sprite::drawNormal(Painter& painter, const std::optional<Rect4f>& extClip)
 
 		paintWithClip(painter, extClip, [&] ()
 		{
-			painter.drawSprites(material, 1, &vertexAttrib);
+			painter.drawSprites(material, 1, &vertexAttrib, getReorderBounds(*this, painter));
 		});
 	}
 }
@@ -84,7 +93,7 @@ void Sprite::drawSliced(Painter& painter, Vector4s slicesPixel, const std::optio
 			slices.w /= size.y;
 			slices *= sliceScale;
 
-			painter.drawSlicedSprite(material, vertexAttrib.scale, slices, &vertexAttrib);
+			painter.drawSlicedSprite(material, vertexAttrib.scale, slices, &vertexAttrib, getReorderBounds(*this, painter));
 		});
 	}
 }
@@ -98,25 +107,21 @@ void Sprite::draw(gsl::span<const Sprite> sprites, Painter& painter) // static
 	auto& material = sprites[0].material;
 	Expects(material->getDefinition().getVertexStride() == sizeof(SpriteVertexAttrib));
 
-	size_t spriteSize = sizeof(SpriteVertexAttrib);
-	char buffer[4096];
-	char* vertexData;
-	std::vector<char> vertices;
-	const size_t vertexDataSize = sprites.size() * spriteSize;
-	if (vertexDataSize <= 4096) {
-		vertexData = buffer;
-	} else {
-		vertices.resize(vertexDataSize);
-		vertexData = vertices.data();
-	}
+	const size_t spriteSize = sizeof(SpriteVertexAttrib);
+	auto* vertexData = static_cast<char*>(painter.getFrameAllocator().allocate(sprites.size() * spriteSize, alignof(SpriteVertexAttrib)));
 
+	std::optional<Rect4f> bounds;
 	for (size_t i = 0; i < sprites.size(); i++) {
 		auto& sprite = sprites[i];
 		Expects(sprite.material == material);
 		memcpy(&vertexData[i * spriteSize], &sprite.vertexAttrib, spriteSize);
+
+		if (const auto spriteBounds = getReorderBounds(sprite, painter)) {
+			bounds = bounds ? bounds->merge(*spriteBounds) : *spriteBounds;
+		}
 	}
 
-	painter.drawSprites(material, sprites.size(), vertexData);
+	painter.drawSprites(material, sprites.size(), vertexData, bounds);
 }
 
 void Sprite::drawMixedMaterials(const Sprite* sprites, size_t n, Painter& painter)
@@ -147,6 +152,15 @@ Rect4f Sprite::getLocalAABB() const
 }
 
 Rect4f Sprite::getAABB() const
+{
+	if (aabbDirty) {
+		aabb = computeAABB();
+		aabbDirty = false;
+	}
+	return aabb;
+}
+
+Rect4f Sprite::computeAABB() const
 {
 	// PERFORMANCE CRITICAL CODE
 	
@@ -185,12 +199,14 @@ Rect4f Sprite::getUncroppedAABB() const
 Sprite& Sprite::setRotation(Angle1f v)
 {
 	vertexAttrib.rotation = v.getRadians();
+	aabbDirty = true;
 	return *this;
 }
 
 Sprite& Sprite::setScale(Vector2f v)
 {
 	vertexAttrib.scale = v;
+	aabbDirty = true;
 	return *this;
 }
 
@@ -239,6 +255,7 @@ Sprite& Sprite::setPivot(Vector2f v)
 	Expects(v.isValid());
 	
 	vertexAttrib.pivot = v;
+	aabbDirty = true;
 
 	return *this;
 }
@@ -246,6 +263,7 @@ Sprite& Sprite::setPivot(Vector2f v)
 Sprite& Sprite::setAbsolutePivot(Vector2f v)
 {
 	vertexAttrib.pivot = v / size;
+	aabbDirty = true;
 
 	if (std::abs(size.x) < 0.000001f) {
 		vertexAttrib.pivot.x = 0;
@@ -431,6 +449,12 @@ Sprite& Sprite::setSprite(const SpriteSheet& sheet, const String& name, bool app
 	return *this;
 }
 
+Sprite& Sprite::setSprite(const SpriteSheet& sheet, SpriteHandle handle, bool applyPivot)
+{
+	setSprite(sheet.getSprite(handle), applyPivot);
+	return *this;
+}
+
 Sprite& Sprite::setSprite(const SpriteSheetEntry& entry, bool applyPivot)
 {
 	doSetSprite(entry, applyPivot);
@@ -451,6 +475,7 @@ void Sprite::doSetSprite(const SpriteSheetEntry& entry, bool applyPivot)
 	if (applyPivot) {
 		Expects(entry.pivot.isValid());
 		vertexAttrib.pivot = entry.pivot;
+		aabbDirty = true;
 	}
 	vertexAttrib.texRect0 = entry.coords;
 	vertexAttrib.textureRotation = entry.rotated ? 1.0f : 0.0f;
@@ -585,6 +610,7 @@ void Sprite::setRectInfo(const RectInfo& info)
 {
 	vertexAttrib.pivot = info.pivot;
 	size = info.size;
+	aabbDirty = true;
 	vertexAttrib.texRect0 = info.texRect0;
 	vertexAttrib.texRect1 = info.texRect1;
 }
@@ -611,6 +637,7 @@ void Sprite::computeSize()
 	if (flip) {
 		vertexAttrib.size.x *= -1;
 	}
+	aabbDirty = true;
 }
 
 Vector2f Sprite::getUncroppedSize() const
@@ -790,6 +817,7 @@ Sprite& Sprite::operator=(const Sprite& other)
 	sliced = other.sliced;
 	sharedMaterial = other.sharedMaterial;
 	lastAppliedPivot = other.lastAppliedPivot;
+	aabbDirty = true;
 	
 	setHotReload(other.hotReloadRef, other.hotReloadIdx);
 	
@@ -811,6 +839,7 @@ Sprite& Sprite::operator=(Sprite&& other) noexcept
 	sliced = std::move(other.sliced);
 	sharedMaterial = std::move(other.sharedMaterial);
 	lastAppliedPivot = std::move(other.lastAppliedPivot);
+	aabbDirty = true;
 
 	setHotReload(other.hotReloadRef, other.hotReloadIdx);
 	other.setHotReload(nullptr, 0);
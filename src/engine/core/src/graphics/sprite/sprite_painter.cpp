@@ -3,6 +3,7 @@
 #include "graphics/painter.h"
 #include <gsl/gsl>
 #include "graphics/text/text_renderer.h"
+#include "graphics/sprite/static_sprite_batch.h"
 
 using namespace Halley;
 
@@ -29,6 +30,18 @@ SpritePainterEntry::SpritePainterEntry(gsl::span<const TextRenderer> texts, int
 {
 }
 
+SpritePainterEntry::SpritePainterEntry(const StaticSpriteBatch& batch, int mask, int layer, float tieBreaker, size_t insertOrder, std::optional<Rect4f> clip)
+	: ptr(&batch)
+	, count(1)
+	, type(SpritePainterEntryType::StaticBatch)
+	, layer(layer)
+	, mask(mask)
+	, tieBreaker(tieBreaker)
+	, insertOrder(insertOrder)
+	, clip(clip)
+{
+}
+
 SpritePainterEntry::SpritePainterEntry(SpritePainterEntryType type, size_t spriteIdx, size_t count, int mask, int layer, float tieBreaker, size_t insertOrder, std::optional<Rect4f> clip)
 	: count(uint32_t(count))
 	, index(static_cast<int>(spriteIdx))
@@ -70,6 +83,13 @@ gsl::span<const TextRenderer> SpritePainterEntry::getTexts() const
 	return gsl::span<const TextRenderer>(static_cast<const TextRenderer*>(ptr), count);
 }
 
+const StaticSpriteBatch& SpritePainterEntry::getStaticBatch() const
+{
+	Expects(ptr != nullptr);
+	Expects(type == SpritePainterEntryType::StaticBatch);
+	return *static_cast<const StaticSpriteBatch*>(ptr);
+}
+
 uint32_t SpritePainterEntry::getIndex() const
 {
 	Expects(ptr == nullptr);
@@ -96,6 +116,7 @@ void SpritePainter::start()
 	sprites.clear();
 	cachedSprites.clear();
 	cachedText.clear();
+	callbacks.clear();
 }
 
 void SpritePainter::start(size_t)
@@ -160,6 +181,13 @@ void SpritePainter::add(SpritePainterEntry::Callback callback, int mask, int lay
 	dirty = true;
 }
 
+void SpritePainter::add(const StaticSpriteBatch& batch, int mask, int layer, float tieBreaker, std::optional<Rect4f> clip)
+{
+	Expects(mask >= 0);
+	sprites.push_back(SpritePainterEntry(batch, mask, layer, tieBreaker, sprites.size(), std::move(clip)));
+	dirty = true;
+}
+
 void SpritePainter::draw(int mask, Painter& painter)
 {
 	if (dirty) {
@@ -175,31 +203,65 @@ void SpritePainter::draw(int mask, Painter& painter)
 	const auto& cam = painter.getCurrentCamera();
 	Rect4f view = cam.getClippingRectangle();
 
+	// Cull all sprites against the view in one go
+	aabbs.clear();
+	for (auto& s : sprites) {
+		if ((s.getMask() & mask) != 0) {
+			for (const auto& sprite: getSprites(s)) {
+				aabbs.add(sprite.getAABB());
+			}
+		}
+	}
+	FrameVector<uint32_t> visibleSprites(aabbs.size(), painter.getFrameAllocator());
+	visibleSprites.resize(aabbs.cull(view, visibleSprites));
+
 	// Draw!
+	size_t spriteIdx = 0;
+	size_t visibleIdx = 0;
 	for (auto& s : sprites) {
 		if ((s.getMask() & mask) != 0) {
 			const auto type = s.getType();
 			
-			if (type == SpritePainterEntryType::SpriteRef) {
-				draw(s.getSprites(), painter, view, s.getClip());
-			} else if (type == SpritePainterEntryType::SpriteCached) {
-				draw(gsl::span<const Sprite>(cachedSprites.data() + s.getIndex(), s.getCount()), painter, view, s.getClip());
+			if (type == SpritePainterEntryType::SpriteRef || type == SpritePainterEntryType::SpriteCached) {
+				// Visible indices are sorted, so the ones for this entry are the next contiguous range
+				const auto entrySprites = getSprites(s);
+				const size_t firstVisible = visibleIdx;
+				const size_t end = spriteIdx + entrySprites.size();
+				while (visibleIdx < visibleSprites.size() && visibleSprites[visibleIdx] < end) {
+					++visibleIdx;
+				}
+				draw(entrySprites, gsl::span<const uint32_t>(visibleSprites.data() + firstVisible, visibleIdx - firstVisible), spriteIdx, painter, s.getClip());
+				spriteIdx = end;
 			} else if (type == SpritePainterEntryType::TextRef) {
 				draw(s.getTexts(), painter, view, s.getClip());
 			} else if (type == SpritePainterEntryType::TextCached) {
 				draw(gsl::span<const TextRenderer>(cachedText.data() + s.getIndex(), s.getCount()), painter, view, s.getClip());
 			} else if (type == SpritePainterEntryType::Callback) {
 				draw(callbacks.at(s.getIndex()), painter, s.getClip());
+			} else if (type == SpritePainterEntryType::StaticBatch) {
+				draw(s.getStaticBatch(), painter, view, s.getClip());
 			}
 		}
 	}
 	painter.flush();
 }
 
-void SpritePainter::draw(gsl::span<const Sprite> sprites, Painter& painter, Rect4f view, const std::optional<Rect4f>& clip) const
+gsl::span<const Sprite> SpritePainter::getSprites(const SpritePainterEntry& entry) const
+{
+	if (entry.getType() == SpritePainterEntryType::SpriteRef) {
+		return entry.getSprites();
+	} else if (entry.getType() == SpritePainterEntryType::SpriteCached) {
+		return gsl::span<const Sprite>(cachedSprites.data() + entry.getIndex(), entry.getCount());
+	} else {
+		return {};
+	}
+}
+
+void SpritePainter::draw(gsl::span<const Sprite> sprites, gsl::span<const uint32_t> visibleIndices, size_t firstIndex, Painter& painter, const std::optional<Rect4f>& clip) const
 {
-	for (const auto& sprite: sprites) {
-		if (sprite.isInView(view)) {
+	for (const auto idx: visibleIndices) {
+		const auto& sprite = sprites[idx - firstIndex];
+		if (sprite.isVisible()) {
 			sprite.draw(painter, clip);
 		}
 	}
@@ -222,3 +284,14 @@ void SpritePainter::draw(const SpritePainterEntry::Callback& callback, Painter&
 		painter.setClip();
 	}
 }
+
+void SpritePainter::draw(const StaticSpriteBatch& batch, Painter& painter, Rect4f view, const std::optional<Rect4f>& clip) const
+{
+	if (clip) {
+		painter.setRelativeClip(clip.value());
+	}
+	batch.draw(painter, clip ? view.intersection(clip.value()) : view);
+	if (clip) {
+		painter.setClip();
+	}
+}
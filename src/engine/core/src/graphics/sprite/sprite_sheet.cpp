@@ -88,8 +88,8 @@ SpriteSheet::~SpriteSheet()
 
 const std::shared_ptr<const Texture>& SpriteSheet::getTexture() const
 {
-	Expects(resources != nullptr);
 	if (!texture) {
+		Expects(resources != nullptr);
 		loadTexture(*resources);
 	}
 	return texture;
@@ -110,6 +110,12 @@ const SpriteSheetEntry& SpriteSheet::getSprite(size_t idx) const
 	return sprites[idx];
 }
 
+const SpriteSheetEntry& SpriteSheet::getSprite(SpriteHandle handle) const
+{
+	const auto idx = handle.getIndex();
+	return idx < sprites.size() ? sprites[idx] : dummySprite;
+}
+
 const SpriteSheetEntry* SpriteSheet::tryGetSprite(const String& name) const
 {
 	const auto idx = getIndex(name);
@@ -158,6 +164,15 @@ std::optional<size_t> SpriteSheet::getIndex(const String& name) const
 	}
 }
 
+SpriteHandle SpriteSheet::getHandle(const String& name) const
+{
+	const auto iter = spriteIdx.find(name);
+	if (iter == spriteIdx.end()) {
+		return SpriteHandle();
+	}
+	return SpriteHandle(iter->second);
+}
+
 bool SpriteSheet::hasSprite(const String& name) const
 {
 	return spriteIdx.find(name) != spriteIdx.end();
@@ -205,11 +220,21 @@ void SpriteSheet::addSprite(String name, const SpriteSheetEntry& sprite)
 	spriteIdx[std::move(name)] = uint32_t(sprites.size() - 1);
 }
 
+void SpriteSheet::setSprite(size_t idx, const SpriteSheetEntry& sprite)
+{
+	sprites.at(idx) = sprite;
+}
+
 void SpriteSheet::setTextureName(String name)
 {
 	textureName = std::move(name);
 }
 
+void SpriteSheet::setTexture(std::shared_ptr<const Texture> tex)
+{
+	texture = std::move(tex);
+}
+
 std::shared_ptr<Material> SpriteSheet::getMaterial(const String& name) const
 {
 	const auto iter = materials.find(name);
@@ -246,14 +271,27 @@ void SpriteSheet::clearMaterialCache() const
 
 void SpriteSheet::reload(Resource&& resource)
 {
-#ifdef ENABLE_HOT_RELOAD
-	auto oldSpriteIdx = spriteIdx;
-#endif
-
 	auto& reloaded = dynamic_cast<SpriteSheet&>(resource);
 
-	sprites = std::move(reloaded.sprites);
-	spriteIdx = std::move(reloaded.spriteIdx);
+	// Sprites which still exist keep their index, so SpriteHandles and SpriteResources resolved before the reload stay valid
+	// New sprites are appended, and the slots of removed ones are left with the dummy sprite
+	std::vector<SpriteSheetEntry> newSprites(sprites.size(), dummySprite);
+	HashMap<String, uint32_t> newSpriteIdx;
+	for (auto& [name, idx]: reloaded.spriteIdx) {
+		const auto iter = spriteIdx.find(name);
+		uint32_t newIdx;
+		if (iter != spriteIdx.end()) {
+			newIdx = iter->second;
+		} else {
+			newIdx = uint32_t(newSprites.size());
+			newSprites.emplace_back();
+		}
+		newSprites[newIdx] = std::move(reloaded.sprites[idx]);
+		newSpriteIdx[name] = newIdx;
+	}
+
+	sprites = std::move(newSprites);
+	spriteIdx = std::move(newSpriteIdx);
 	frameTags = std::move(reloaded.frameTags);
 
 	if (textureName != reloaded.textureName) {
@@ -270,29 +308,13 @@ void SpriteSheet::reload(Resource&& resource)
 
 	defaultMaterialName = std::move(reloaded.defaultMaterialName);
 
-#ifdef ENABLE_HOT_RELOAD
-	// Create idx mapping
-	HashMap<uint32_t, uint32_t> idxMap;
-	for (const auto& [name, idx]: spriteIdx) {
-		const auto iter = oldSpriteIdx.find(name);
-		if (iter != oldSpriteIdx.end()) {
-			idxMap[iter->second] = idx;
-		}
-	}
-
 	assignIds();
 
-	// Refresh sprite refs
+#ifdef ENABLE_HOT_RELOAD
+	// Refresh sprite refs; indices are stable, so no remapping is needed
 	for (auto& sprite: spriteRefs) {
-		if (sprite.second != std::numeric_limits<uint32_t>::max()) {
-			const auto iter = idxMap.find(sprite.second);
-			if (iter != idxMap.end()) {
-				sprite.second = iter->second;
-			} else {
-				sprite.second = 0;
-			}
-
-			sprite.first->setSprite(sprites.at(sprite.second), sprite.first->hasLastAppliedPivot());
+		if (sprite.second < sprites.size()) {
+			sprite.first->setSprite(sprites[sprite.second], sprite.first->hasLastAppliedPivot());
 		} else {
 			sprite.first->setSprite(dummySprite, sprite.first->hasLastAppliedPivot());
 		}
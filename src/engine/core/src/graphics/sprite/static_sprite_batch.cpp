@@ -0,0 +1,182 @@
+#include "graphics/sprite/static_sprite_batch.h"
+#include "graphics/painter.h"
+#include "graphics/material/material.h"
+#include "graphics/material/material_definition.h"
+#include <gsl/gsl_assert>
+#include <map>
+
+using namespace Halley;
+
+namespace {
+	constexpr size_t verticesPerSprite = 4;
+	constexpr size_t maxSpritesPerChunk = (size_t(std::numeric_limits<IndexType>::max()) + 1) / verticesPerSprite;
+}
+
+StaticSpriteBatch::StaticSpriteBatch(float chunkSize)
+	: chunkSize(chunkSize)
+{
+	Expects(chunkSize > 0);
+}
+
+void StaticSpriteBatch::clear()
+{
+	sprites.clear();
+	dirty = true;
+}
+
+void StaticSpriteBatch::add(const Sprite& sprite)
+{
+	Expects(!sprite.isSliced());
+	Expects(!sprite.getClip());
+
+	sprites.push_back(sprite);
+	dirty = true;
+}
+
+void StaticSpriteBatch::add(gsl::span<const Sprite> newSprites)
+{
+	sprites.reserve(sprites.size() + newSprites.size());
+	for (const auto& sprite: newSprites) {
+		add(sprite);
+	}
+}
+
+void StaticSpriteBatch::setSprites(Vector<Sprite> newSprites)
+{
+	for (const auto& sprite: newSprites) {
+		Expects(!sprite.isSliced());
+		Expects(!sprite.getClip());
+	}
+
+	sprites = std::move(newSprites);
+	dirty = true;
+}
+
+gsl::span<const Sprite> StaticSpriteBatch::getSprites() const
+{
+	return sprites;
+}
+
+size_t StaticSpriteBatch::getNumChunks() const
+{
+	if (dirty) {
+		rebuild();
+	}
+	return chunks.size();
+}
+
+Vector<uint32_t> StaticSpriteBatch::getDrawOrder() const
+{
+	if (dirty) {
+		rebuild();
+	}
+
+	Vector<uint32_t> result;
+	for (const auto& chunk: chunks) {
+		result.insert(result.end(), chunk.sprites.begin(), chunk.sprites.end());
+	}
+	return result;
+}
+
+void StaticSpriteBatch::draw(Painter& painter, Rect4f view) const
+{
+	if (dirty) {
+		rebuild();
+	}
+
+	const bool useBounds = painter.getReorderWindow() > 0;
+
+	for (const auto& chunk: chunks) {
+		if (!chunk.aabb.overlaps(view)) {
+			continue;
+		}
+
+		const auto bounds = useBounds ? std::optional<Rect4f>(chunk.aabb) : std::optional<Rect4f>();
+		for (const auto& run: chunk.runs) {
+			const char* vertexData = chunk.vertices.data() + run.firstVertex * sizeof(SpriteVertexAttrib);
+			painter.drawQuads(run.material, run.numVertices, vertexData, bounds);
+		}
+	}
+}
+
+void StaticSpriteBatch::rebuild() const
+{
+	chunks.clear();
+	dirty = false;
+
+	// Each sprite goes into the latest chunk of the cell containing its centre, as long as that doesn't change what's drawn on top of what.
+	// Chunks are drawn in the order they were created, so joining an older chunk draws the sprite before every chunk created since.
+	// That's only allowed if it doesn't overlap any of them; otherwise it starts a new chunk.
+	Vector<Vector<uint32_t>> chunkSprites;
+	Vector<Rect4f> chunkBounds;
+	std::map<std::pair<int, int>, size_t> latestChunk;
+
+	for (size_t i = 0; i < sprites.size(); ++i) {
+		const auto& sprite = sprites[i];
+		if (!sprite.isVisible() || !sprite.hasMaterial()) {
+			continue;
+		}
+
+		const auto aabb = sprite.getAABB();
+		const auto cell = Vector2i((aabb.getCenter() / chunkSize).floor());
+		const auto key = std::make_pair(cell.x, cell.y);
+
+		const auto iter = latestChunk.find(key);
+		bool canJoin = iter != latestChunk.end() && chunkSprites[iter->second].size() < maxSpritesPerChunk;
+		if (canJoin) {
+			for (size_t j = iter->second + 1; j < chunkBounds.size(); ++j) {
+				if (chunkBounds[j].overlaps(aabb)) {
+					canJoin = false;
+					break;
+				}
+			}
+		}
+
+		if (canJoin) {
+			chunkSprites[iter->second].push_back(uint32_t(i));
+			chunkBounds[iter->second] = chunkBounds[iter->second].merge(aabb);
+		} else {
+			latestChunk[key] = chunkSprites.size();
+			chunkSprites.emplace_back().push_back(uint32_t(i));
+			chunkBounds.push_back(aabb);
+		}
+	}
+
+	chunks.reserve(chunkSprites.size());
+	for (const auto& indices: chunkSprites) {
+		buildChunk(indices);
+	}
+}
+
+void StaticSpriteBatch::buildChunk(gsl::span<const uint32_t> spriteIndices) const
+{
+	Expects(!spriteIndices.empty());
+	Expects(size_t(spriteIndices.size()) <= maxSpritesPerChunk);
+
+	auto& chunk = chunks.emplace_back();
+	chunk.sprites.assign(spriteIndices.begin(), spriteIndices.end());
+	chunk.vertices.resize(spriteIndices.size() * verticesPerSprite * sizeof(SpriteVertexAttrib));
+
+	size_t vertexIdx = 0;
+	bool first = true;
+	for (const auto idx: spriteIndices) {
+		const auto& sprite = sprites[idx];
+		const auto& material = sprite.material;
+		Expects(material->getDefinition().getVertexStride() == sizeof(SpriteVertexAttrib));
+
+		const auto aabb = sprite.getAABB();
+		chunk.aabb = first ? aabb : chunk.aabb.merge(aabb);
+		first = false;
+
+		// Start a new run whenever the material changes
+		if (chunk.runs.empty() || !(*chunk.runs.back().material == *material)) {
+			auto& run = chunk.runs.emplace_back();
+			run.material = material;
+			run.firstVertex = vertexIdx;
+		}
+
+		Painter::expandSpriteVertices(material->getDefinition(), 1, &sprite.vertexAttrib, chunk.vertices.data() + vertexIdx * sizeof(SpriteVertexAttrib));
+		chunk.runs.back().numVertices += verticesPerSprite;
+		vertexIdx += verticesPerSprite;
+	}
+}
@@ -99,29 +99,33 @@ void Font::onLoaded(Resources& resources)
 
 std::pair<const Font::Glyph&, const Font&> Font::getGlyph(int code) const
 {
-	const auto& font = getFontForGlyph(code);
-	return { font.getGlyphHere(code), font };
+	if (const auto* glyph = findGlyph(code)) {
+		return { *glyph, *this };
+	}
+	for (const auto& font: fallbackFont) {
+		if (const auto* glyph = font->findGlyph(code)) {
+			return { *glyph, *font };
+		}
+	}
+	return { getGlyphHere(code), *this };
 }
 
 const Font::Glyph& Font::getGlyphHere(int code) const
 {
-	auto iter = glyphs.find(code);
-	if (iter == glyphs.end()) {
-		iter = glyphs.find(0);
-		if (iter == glyphs.end()) {
-			throw Exception("Unable to load fallback character, needed for character " + toString(code), HalleyExceptions::Graphics);
-		}
-		return iter->second;
+	if (const auto* glyph = findGlyph(code)) {
+		return *glyph;
 	}
-	return iter->second;
+	if (const auto* glyph = findGlyph(0)) {
+		return *glyph;
+	}
+	throw Exception("Unable to load fallback character, needed for character " + toString(code), HalleyExceptions::Graphics);
 }
 
 const Font& Font::getFontForGlyph(int code) const
 {
-	const auto iter = glyphs.find(code);
-	if (iter == glyphs.end()) {
+	if (!findGlyph(code)) {
 		for (const auto& font: fallbackFont) {
-			if (font->glyphs.find(code) != font->glyphs.end()) {
+			if (font->findGlyph(code)) {
 				return *font;
 			}
 		}
@@ -129,6 +133,38 @@ const Font& Font::getFontForGlyph(int code) const
 	return *this;
 }
 
+const Font::Glyph* Font::findGlyph(int code) const
+{
+	uint32_t idx = noGlyph;
+	if (code >= 0 && code < int(numBMPPages * glyphPageSize)) {
+		const auto page = bmpPageIndex[size_t(code) / glyphPageSize];
+		if (page != 0) {
+			idx = bmpPages[page - 1][size_t(code) % glyphPageSize];
+		}
+	} else {
+		const auto iter = extraGlyphs.find(code);
+		if (iter != extraGlyphs.end()) {
+			idx = iter->second;
+		}
+	}
+	return idx == noGlyph ? nullptr : &glyphs[idx];
+}
+
+uint32_t& Font::getGlyphIndex(int code)
+{
+	if (code < 0 || code >= int(numBMPPages * glyphPageSize)) {
+		return extraGlyphs.try_emplace(code, noGlyph).first->second;
+	}
+
+	auto& page = bmpPageIndex[size_t(code) / glyphPageSize];
+	if (page == 0) {
+		auto& entries = bmpPages.emplace_back();
+		entries.fill(noGlyph);
+		page = uint16_t(bmpPages.size());
+	}
+	return bmpPages[page - 1][size_t(code) % glyphPageSize];
+}
+
 float Font::getLineHeightAtSize(float size) const
 {
 	return height * size / sizePt;
@@ -176,7 +212,13 @@ bool Font::isDistanceField() const
 
 void Font::addGlyph(const Glyph& glyph)
 {
-	glyphs[glyph.charcode] = glyph;
+	auto& idx = getGlyphIndex(glyph.charcode);
+	if (idx == noGlyph) {
+		idx = uint32_t(glyphs.size());
+		glyphs.push_back(glyph);
+	} else {
+		glyphs[idx] = glyph;
+	}
 }
 
 std::shared_ptr<Material> Font::getMaterial() const
@@ -195,7 +237,13 @@ void Font::serialize(Serializer& s) const
 	s << smoothRadius;
 	s << imageSize;
 	s << replacementScale;
-	s << glyphs;
+
+	std::map<int, Glyph> glyphMap;
+	for (const auto& g: glyphs) {
+		glyphMap[g.charcode] = g;
+	}
+	s << glyphMap;
+
 	s << fallback;
 }
 
@@ -210,13 +258,22 @@ void Font::deserialize(Deserializer& s)
 	s >> smoothRadius;
 	s >> imageSize;
 	s >> replacementScale;
-	s >> glyphs;
-	s >> fallback;
 
-	for (auto& g: glyphs) {
+	// Read in code order, so glyphs that are used together are close in memory
+	std::map<int, Glyph> glyphMap;
+	s >> glyphMap;
+	glyphs.clear();
+	glyphs.reserve(glyphMap.size());
+	bmpPageIndex.fill(0);
+	bmpPages.clear();
+	extraGlyphs.clear();
+	for (auto& g: glyphMap) {
 		g.second.charcode = g.first;
+		addGlyph(g.second);
 	}
 
+	s >> fallback;
+
 	//printGlyphs();
 }
 
@@ -224,8 +281,12 @@ void Font::printGlyphs() const
 {
 	std::optional<Range<int>> curRange;
 	std::vector<Range<int>> ranges;
-	for (auto& g: glyphs) {
-		int c = g.first;
+	Vector<int> codes;
+	for (const auto& g: glyphs) {
+		codes.push_back(g.charcode);
+	}
+	std::sort(codes.begin(), codes.end());
+	for (const int c: codes) {
 		if (curRange && curRange->end == c - 1) {
 			curRange->end = c;
 		} else {
@@ -37,6 +37,7 @@ TextRenderer& TextRenderer::setFont(std::shared_ptr<const Font> v)
 {
 	if (font != v) {
 		font = v;
+		markLayoutDirty();
 
 		if (font->isDistanceField()) {
 			materialDirty = true;
@@ -51,7 +52,7 @@ TextRenderer& TextRenderer::setText(const String& v)
 	const auto newText = v.getUTF32();
 	if (newText != text) {
 		text = newText;
-		glyphsDirty = true;
+		markLayoutDirty();
 	}
 	return *this;
 }
@@ -60,7 +61,7 @@ TextRenderer& TextRenderer::setText(const StringUTF32& v)
 {
 	if (v != text) {
 		text = v;
-		glyphsDirty = true;
+		markLayoutDirty();
 	}
 	return *this;
 }
@@ -70,7 +71,7 @@ TextRenderer& TextRenderer::setText(const LocalisedString& v)
 	const auto newText = v.getString().getUTF32();
 	if (newText != text) {
 		text = newText;
-		glyphsDirty = true;
+		markLayoutDirty();
 	}
 	return *this;
 }
@@ -79,7 +80,7 @@ TextRenderer& TextRenderer::setSize(float v)
 {
 	if (size != v) {
 		size = v;
-		glyphsDirty = true;
+		markLayoutDirty();
 	}
 	return *this;
 }
@@ -88,7 +89,7 @@ TextRenderer& TextRenderer::setColour(Colour v)
 {
 	if (colour != v) {
 		colour = v;
-		glyphsDirty = true;
+		colourDirty = true;
 	}
 	return *this;
 }
@@ -145,7 +146,7 @@ TextRenderer& TextRenderer::setPixelOffset(Vector2f offset)
 {
 	if (pixelOffset != offset) {
 		pixelOffset = offset;
-		glyphsDirty = true;
+		positionDirty = true;
 	}
 	return *this;
 }
@@ -154,7 +155,7 @@ TextRenderer& TextRenderer::setColourOverride(const std::vector<ColourOverride>&
 {
 	if (colourOverrides != colOverride) {
 		colourOverrides = colOverride;
-		glyphsDirty = true;
+		colourDirty = true;
 	}
 	return *this;
 }
@@ -163,7 +164,7 @@ TextRenderer& TextRenderer::setLineSpacing(float spacing)
 {
 	if (lineSpacing != spacing) {
 		lineSpacing = spacing;
-		glyphsDirty = true;
+		markLayoutDirty();
 	}
 	return *this;
 }
@@ -186,6 +187,36 @@ void TextRenderer::generateSprites(std::vector<Sprite>& sprites) const
 {
 	Expects(font != nullptr);
 
+	const bool hasMaterialOverride = font->isDistanceField();
+	if (hasMaterialOverride && materialDirty) {
+		updateMaterials();
+		materialDirty = false;
+	}
+
+	if (glyphsDirty) {
+		layoutGlyphs();
+		glyphsDirty = false;
+		colourDirty = true;
+		positionDirty = true;
+	}
+
+	if (colourDirty) {
+		applyColours();
+		colourDirty = false;
+	}
+
+	if (positionDirty) {
+		applyPosition();
+		positionDirty = false;
+	}
+
+	if (&sprites != &spritesCache) {
+		sprites.assign(spritesCache.begin(), spritesCache.end());
+	}
+}
+
+void TextRenderer::layoutGlyphs() const
+{
 	bool floorEnabled = false;
 	auto floorAlign = [floorEnabled] (Vector2f a) -> Vector2f
 	{
@@ -197,94 +228,108 @@ void TextRenderer::generateSprites(std::vector<Sprite>& sprites) const
 	};
 
 	const bool hasMaterialOverride = font->isDistanceField();
-	if (hasMaterialOverride && materialDirty) {
-		updateMaterials();
-		materialDirty = false;
+
+	float mainScale = getScale(*font);
+	Vector2f p = floorAlign(Vector2f(0, font->getAscenderDistance() * mainScale));
+	if (offset != Vector2f(0, 0)) {
+		p -= floorAlign(getExtents() * offset);
 	}
 
-	if (glyphsDirty || positionDirty) {
-		float mainScale = getScale(*font);
-		Vector2f p = floorAlign(position + Vector2f(0, font->getAscenderDistance() * mainScale));
-		if (offset != Vector2f(0, 0)) {
-			p -= floorAlign(getExtents() * offset);
-		}
+	size_t startPos = 0;
+	size_t spritesInserted = 0;
+	Vector2f lineOffset;
 
-		size_t startPos = 0;
-		size_t spritesInserted = 0;
-		Vector2f lineOffset;
-
-		auto flush = [&] ()
-		{
-			// Line break, update previous characters!
-			if (align != 0) {
-				Vector2f off = floorAlign(-lineOffset * align);
-				for (size_t j = startPos; j < spritesInserted; j++) {
-					auto& sprite = sprites[j];
-					sprite.setPos(sprite.getPosition() + off);
-				}
+	auto flush = [&] ()
+	{
+		// Line break, update previous characters!
+		if (align != 0) {
+			Vector2f off = floorAlign(-lineOffset * align);
+			for (size_t j = startPos; j < spritesInserted; j++) {
+				glyphOffsets[j] += off;
 			}
+		}
 
-			// Move pen
-			p.y += getLineHeight();
-
-			// Reset
-			startPos = spritesInserted;
-			lineOffset.x = 0;
-		};
+		// Move pen
+		p.y += getLineHeight();
 
-		auto curCol = colour;
-		size_t curOverride = 0;
+		// Reset
+		startPos = spritesInserted;
+		lineOffset.x = 0;
+	};
 
-		const size_t n = text.size();
+	const size_t n = text.size();
 
-		size_t nGlyphs = 0;
-		for (size_t i = 0; i < n; i++) {
-			if (text[i] != '\n') {
-				++nGlyphs;
-			}
+	size_t nGlyphs = 0;
+	for (size_t i = 0; i < n; i++) {
+		if (text[i] != '\n') {
+			++nGlyphs;
 		}
-		sprites.resize(nGlyphs);
+	}
+	spritesCache.resize(nGlyphs);
+	glyphOffsets.resize(nGlyphs);
+	glyphCharIndices.resize(nGlyphs);
 
-		for (size_t i = 0; i < n; i++) {
-			int c = text[i];
+	for (size_t i = 0; i < n; i++) {
+		int c = text[i];
 
-			// Check for colour override
-			while (curOverride < colourOverrides.size() && colourOverrides[curOverride].first == i) {
-				curCol = colourOverrides[curOverride].second ? colourOverrides[curOverride].second.value() : colour;
-				++curOverride;
-			}
-			
-			if (c == '\n') {
+		if (c == '\n') {
+			flush();
+		} else {
+			const auto& [glyph, fontForGlyph] = font->getGlyph(c);
+			const float scale = getScale(fontForGlyph);
+			const auto fontAdjustment = floorAlign(Vector2f(0, fontForGlyph.getAscenderDistance() - font->getAscenderDistance()) * scale);
+
+			std::shared_ptr<Material> materialToUse = hasMaterialOverride ? getMaterial(fontForGlyph) : fontForGlyph.getMaterial();
+
+			glyphOffsets[spritesInserted] = p + lineOffset + fontAdjustment;
+			glyphCharIndices[spritesInserted] = uint32_t(i);
+			spritesCache[spritesInserted++] = Sprite()
+				.setMaterial(std::move(materialToUse), true)
+				.setSize(glyph.size)
+				.setTexRect(glyph.area)
+				.setPivot(glyph.horizontalBearing / glyph.size * Vector2f(-1, 1))
+				.setScale(scale);
+
+			lineOffset.x += glyph.advance.x * scale;
+
+			if (i == n - 1) {
 				flush();
-			} else {
-				const auto& [glyph, fontForGlyph] = font->getGlyph(c);
-				const float scale = getScale(fontForGlyph);
-				const auto fontAdjustment = floorAlign(Vector2f(0, fontForGlyph.getAscenderDistance() - font->getAscenderDistance()) * scale);
-
-				std::shared_ptr<Material> materialToUse = hasMaterialOverride ? getMaterial(fontForGlyph) : fontForGlyph.getMaterial();
-
-				sprites[spritesInserted++] = Sprite()
-					.setMaterial(std::move(materialToUse), true)
-					.setSize(glyph.size)
-					.setTexRect(glyph.area)
-					.setColour(curCol)
-					.setPivot(glyph.horizontalBearing / glyph.size * Vector2f(-1, 1))
-					.setScale(scale)
-					.setPos(p + lineOffset + pixelOffset + fontAdjustment);
-
-				lineOffset.x += glyph.advance.x * scale;
-
-				if (i == n - 1) {
-					flush();
-				}
 			}
 		}
+	}
+}
 
-		glyphsDirty = false;
-		positionDirty = false;
+void TextRenderer::applyColours() const
+{
+	auto curCol = colour;
+	size_t curOverride = 0;
+
+	for (size_t i = 0; i < spritesCache.size(); ++i) {
+		// Check for colour override
+		const size_t charIdx = glyphCharIndices[i];
+		while (curOverride < colourOverrides.size() && colourOverrides[curOverride].first <= charIdx) {
+			curCol = colourOverrides[curOverride].second ? colourOverrides[curOverride].second.value() : colour;
+			++curOverride;
+		}
+
+		spritesCache[i].setColour(curCol);
 	}
 }
 
+void TextRenderer::applyPosition() const
+{
+	const auto origin = position + pixelOffset;
+	for (size_t i = 0; i < spritesCache.size(); ++i) {
+		spritesCache[i].setPos(origin + glyphOffsets[i]);
+	}
+}
+
+void TextRenderer::markLayoutDirty()
+{
+	glyphsDirty = true;
+	extentsCache.reset();
+}
+
 void TextRenderer::draw(Painter& painter, const std::optional<Rect4f>& extClip) const
 {
 	generateSprites(spritesCache);
@@ -293,7 +338,6 @@ void TextRenderer::draw(Painter& painter, const std::optional<Rect4f>& extClip)
 		// We don't know what the user will do with glyphs, so mark them as dirty
 		spriteFilter(gsl::span<Sprite>(spritesCache.data(), spritesCache.size()));
 		glyphsDirty = true;
-		positionDirty = true;
 	}
 
 	const std::optional<Rect4f> myClip = clip ? clip.value() + position : std::optional<Rect4f>();
@@ -316,7 +360,10 @@ void TextRenderer::setSpriteFilter(SpriteFilter f)
 
 Vector2f TextRenderer::getExtents() const
 {
-	return getExtents(text);
+	if (!extentsCache) {
+		extentsCache = getExtents(text);
+	}
+	return extentsCache.value();
 }
 
 Vector2f TextRenderer::getExtents(const StringUTF32& str) const
@@ -430,6 +477,12 @@ StringUTF32 TextRenderer::split(const String& str, float maxWidth) const
 
 StringUTF32 TextRenderer::split(const StringUTF32& str, float maxWidth, std::function<bool(int32_t)> filter) const
 {
+	// Line breaks only depend on text, font, size and width, so the last result can be reused (unless it's filtered)
+	const bool canCache = !filter;
+	if (canCache && splitCache && splitCache->font == font.get() && splitCache->size == size && splitCache->width == maxWidth && splitCache->text == str) {
+		return splitCache->result;
+	}
+
 	StringUTF32 result;
 
 	gsl::span<const char32_t> src = str;
@@ -477,6 +530,10 @@ StringUTF32 TextRenderer::split(const StringUTF32& str, float maxWidth, std::fun
 			}
 		}
 	}
+
+	if (canCache) {
+		splitCache = SplitCache{ str, result, font.get(), size, maxWidth };
+	}
 	return result;
 }
 
@@ -39,6 +39,24 @@ std::optional<uint32_t> Texture::getPixel(Vector2f texPos) const
 	return {};
 }
 
+void Texture::updateRegion(Rect4i region, const Image& image)
+{
+	const bool inside = region.getLeft() >= 0 && region.getTop() >= 0 && region.getRight() <= size.x && region.getBottom() <= size.y;
+	if (region.getSize() != image.getSize() || !inside) {
+		throw Exception("Invalid region for texture update.", HalleyExceptions::Graphics);
+	}
+	if (descriptor.format != TextureFormat::RGBA || (image.getFormat() != Image::Format::RGBA && image.getFormat() != Image::Format::RGBAPremultiplied)) {
+		throw Exception("Texture region updates are only supported for RGBA.", HalleyExceptions::Graphics);
+	}
+
+	if (descriptor.retainPixelData) {
+		if (auto* img = descriptor.pixelData.getImage()) {
+			img->blitFrom(region.getTopLeft(), image);
+		}
+	}
+	doUpdateRegion(region, image);
+}
+
 void Texture::copyToTexture(Painter& painter, Texture& other) const
 {
 	if (getSize() != other.getSize()) {
@@ -66,6 +84,16 @@ void Texture::doLoad(TextureDescriptor& descriptor)
 {
 }
 
+void Texture::doUpdateRegion(Rect4i region, const Image& image)
+{
+	// Fallback for backends without partial uploads: reupload the whole retained image
+	if (descriptor.retainPixelData && descriptor.pixelData.getImage()) {
+		doLoad(descriptor);
+	} else {
+		Logger::logWarning("Updating texture region requires retained pixel data on this backend.");
+	}
+}
+
 void Texture::doCopyToTexture(Painter& painter, Texture& other) const
 {
 	Logger::logWarning("Copying to texture not implemented.");
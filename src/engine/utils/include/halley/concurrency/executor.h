@@ -41,8 +41,11 @@ namespace Halley
 	class Executors
 	{
 	public:
+		~Executors();
+
 		static Executors& get();
 		static void setInstance(Executors& e);
+		static bool hasInstance() { return instance != nullptr; }
 
 		static ExecutionQueue& getCPU() { return instance->cpu; }
 		static ExecutionQueue& getCPUAux() { return instance->cpuAux; }
@@ -58,4 +58,29 @@ namespace Halley
 		static std::optional<Vector<BinPackResult>> pack(const std::vector<BinPackEntry>& entries, Vector2i binSize);
 		static std::optional<Vector<BinPackResult>> fastPack(const std::vector<BinPackEntry>& entries, Vector2i binSize);
 	};
+
+	// Incremental version of the shelf packing done by BinPack::fastPack, for bins that are filled over time
+	// Shelves are opened top to bottom as needed, and each new entry goes into the first shelf with room that isn't too tall for it
+	class BinPackShelfAllocator
+	{
+	public:
+		explicit BinPackShelfAllocator(Vector2i binSize);
+
+		std::optional<Rect4i> allocate(Vector2i size);
+		void reset();
+
+		Vector2i getBinSize() const { return binSize; }
+
+	private:
+		struct Shelf
+		{
+			int y = 0;
+			int height = 0;
+			int cursorX = 0;
+		};
+
+		Vector2i binSize;
+		Vector<Shelf> shelves;
+		int nextShelfY = 0;
+	};
 }
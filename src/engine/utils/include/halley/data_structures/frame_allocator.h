@@ -0,0 +1,88 @@
+#pragma once
+
+#include "vector.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace Halley {
+	// A linear allocator for memory that only lives for one frame
+	// Allocations bump a pointer, deallocations are no-ops, and everything is released at once by reset()
+	// If a frame overflows the current block, reset() merges the blocks into one, so the next frame of the same size won't allocate
+	class FrameAllocator {
+	public:
+		explicit FrameAllocator(size_t blockSize = 64 * 1024);
+
+		FrameAllocator(const FrameAllocator& other) = delete;
+		FrameAllocator(FrameAllocator&& other) = delete;
+		FrameAllocator& operator=(const FrameAllocator& other) = delete;
+		FrameAllocator& operator=(FrameAllocator&& other) = delete;
+
+		void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+		void reset();
+
+		size_t getBytesUsed() const { return bytesUsed; }
+		size_t getCapacity() const;
+		size_t getNumBlocks() const { return blocks.size(); }
+
+	private:
+		struct Block {
+			std::unique_ptr<char[]> data;
+			size_t size = 0;
+			size_t used = 0;
+		};
+
+		Vector<Block> blocks;
+		size_t curBlock = 0;
+		size_t blockSize;
+		size_t bytesUsed = 0;
+
+		void* allocateFromBlock(Block& block, size_t size, size_t alignment);
+		void addBlock(size_t size);
+	};
+
+	// STL allocator adapter for FrameAllocator
+	// Since memory is only reclaimed at reset, containers should reserve up front rather than grow
+	template <typename T>
+	class FrameAllocatorAdapter {
+		template <typename U> friend class FrameAllocatorAdapter;
+
+	public:
+		using value_type = T;
+
+		FrameAllocatorAdapter(FrameAllocator& allocator) noexcept
+			: allocator(&allocator)
+		{}
+
+		template <typename U>
+		FrameAllocatorAdapter(const FrameAllocatorAdapter<U>& other) noexcept
+			: allocator(other.allocator)
+		{}
+
+		T* allocate(size_t n)
+		{
+			return static_cast<T*>(allocator->allocate(n * sizeof(T), alignof(T)));
+		}
+
+		void deallocate(T*, size_t) noexcept
+		{
+		}
+
+		template <typename U>
+		bool operator==(const FrameAllocatorAdapter<U>& other) const
+		{
+			return allocator == other.allocator;
+		}
+
+		template <typename U>
+		bool operator!=(const FrameAllocatorAdapter<U>& other) const
+		{
+			return allocator != other.allocator;
+		}
+
+	private:
+		FrameAllocator* allocator;
+	};
+
+	template <typename T> using FrameVector = std::vector<T, FrameAllocatorAdapter<T>>;
+}
@@ -93,7 +93,7 @@ namespace Halley {
     	T readOne()
     	{
             Expects(canRead(1));
-            T v = entries[readPos];
+            T v = std::move(entries[readPos]);
             readPos = (readPos + 1) % entries.size();
             --numEntries;
             return v;
@@ -14,6 +14,7 @@ namespace Halley {} // Get GitHub to realise this is C++ :3
 
 #include "data_structures/bin_pack.h"
 #include "data_structures/dynamic_grid.h"
+#include "data_structures/frame_allocator.h"
 #include "data_structures/hash_map.h"
 #include "data_structures/mapped_pool.h"
 #include "data_structures/maybe.h"
@@ -39,6 +40,7 @@ namespace Halley {} // Get GitHub to realise this is C++ :3
 #include "file_formats/xml_file.h"
 #include "file_formats/yaml_convert.h"
 
+#include "maths/aabb_list.h"
 #include "maths/angle.h"
 #include "maths/base_transform.h"
 #include "maths/bezier.h"
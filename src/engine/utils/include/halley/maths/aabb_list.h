@@ -0,0 +1,38 @@
+#pragma once
+
+#include "rect.h"
+#include "halley/data_structures/vector.h"
+#include <cstdint>
+#include <gsl/span>
+
+namespace Halley {
+	// A list of axis-aligned bounding boxes, stored as a structure of arrays so many of them can be culled at once
+	// cull() tests several boxes per instruction with SSE (or AVX, when the build targets it), and always gives
+	// the same results as cullScalar(), which matches Rect4f::overlaps exactly.
+	class AABBList {
+	public:
+		void clear();
+		void reserve(size_t n);
+		void add(Rect4f aabb);
+
+		size_t size() const { return x0.size(); }
+		bool empty() const { return x0.empty(); }
+		Rect4f get(size_t idx) const;
+
+		// Appends the indices of all boxes overlapping view to result, in ascending order
+		void cull(Rect4f view, Vector<uint32_t>& result) const;
+		void cullScalar(Rect4f view, Vector<uint32_t>& result) const;
+
+		// Writes the indices of all boxes overlapping view to result, in ascending order, and returns how many there were
+		// result must have space for size() indices
+		size_t cull(Rect4f view, gsl::span<uint32_t> result) const;
+
+	private:
+		Vector<float> x0;
+		Vector<float> y0;
+		Vector<float> x1;
+		Vector<float> y1;
+
+		uint32_t* cullScalar(Rect4f view, size_t start, size_t end, uint32_t* dst) const;
+	};
+}
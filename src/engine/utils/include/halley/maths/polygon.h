@@ -119,6 +119,10 @@ namespace Halley {
 
 		float getArea() const { return area; }
 
+		// Identifies the vertex list, so work derived from it (such as a triangulation) can be cached
+		// Copies share it. Changing or reordering the vertices gives a new one, but moving, rotating or scaling keeps it.
+		uint64_t getRevision() const { return revision; }
+
 	private:
 		Circle circle;
 		VertexList vertices;
@@ -127,6 +131,7 @@ namespace Halley {
 		bool clockwise = false;
 		bool valid = false;
 		float area = 0;
+		uint64_t revision = 0;
 
 		bool isPointInsideConvex(Vector2f point) const;
 		bool isPointInsideConcave(Vector2f point) const;
@@ -135,7 +140,7 @@ namespace Halley {
 
 		Range<float> project(Vector2f axis) const;
 		void unproject(const Vector2f &axis,const float point,Vector<Vector2f> &ver) const;
-		void realize();
+		void realize(bool newRevision = true);
 		void checkConvex();
 
 		// Split by inserting a new edge between v0 and v1
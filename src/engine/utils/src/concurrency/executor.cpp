@@ -54,6 +54,13 @@ void ExecutionQueue::addToQueue(TaskBase task)
 #endif
 }
 
+Executors::~Executors()
+{
+	if (instance == this) {
+		instance = nullptr;
+	}
+}
+
 Executors& Executors::get()
 {
 	if (!instance) {
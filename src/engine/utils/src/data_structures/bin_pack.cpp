@@ -86,3 +86,51 @@ std::optional<Vector<BinPackResult>> BinPack::fastPack(const std::vector<BinPack
 
 	return result;
 }
+
+BinPackShelfAllocator::BinPackShelfAllocator(Vector2i binSize)
+	: binSize(binSize)
+{
+}
+
+std::optional<Rect4i> BinPackShelfAllocator::allocate(Vector2i size)
+{
+	if (size.x <= 0 || size.y <= 0 || size.x > binSize.x || size.y > binSize.y) {
+		return {};
+	}
+
+	auto place = [&] (Shelf& shelf)
+	{
+		const auto rect = Rect4i(shelf.cursorX, shelf.y, size.x, size.y);
+		shelf.cursorX += size.x;
+		return rect;
+	};
+
+	// Prefer an existing shelf that doesn't waste more than half its height
+	for (auto& shelf: shelves) {
+		if (shelf.height >= size.y && shelf.height <= size.y * 2 && binSize.x - shelf.cursorX >= size.x) {
+			return place(shelf);
+		}
+	}
+
+	// Open a new shelf
+	if (binSize.y - nextShelfY >= size.y) {
+		shelves.push_back(Shelf{ nextShelfY, size.y, 0 });
+		nextShelfY += size.y;
+		return place(shelves.back());
+	}
+
+	// Out of vertical space, take any shelf that fits
+	for (auto& shelf: shelves) {
+		if (shelf.height >= size.y && binSize.x - shelf.cursorX >= size.x) {
+			return place(shelf);
+		}
+	}
+
+	return {};
+}
+
+void BinPackShelfAllocator::reset()
+{
+	shelves.clear();
+	nextShelfY = 0;
+}
@@ -0,0 +1,74 @@
+#include "halley/data_structures/frame_allocator.h"
+#include <gsl/gsl_assert>
+#include <algorithm>
+#include <cstdint>
+
+using namespace Halley;
+
+FrameAllocator::FrameAllocator(size_t blockSize)
+	: blockSize(blockSize)
+{
+	Expects(blockSize > 0);
+}
+
+void* FrameAllocator::allocate(size_t size, size_t alignment)
+{
+	Expects(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+	for (; curBlock < blocks.size(); ++curBlock) {
+		if (auto* result = allocateFromBlock(blocks[curBlock], size, alignment)) {
+			return result;
+		}
+	}
+
+	addBlock(std::max(blockSize, size + alignment));
+	curBlock = blocks.size() - 1;
+	auto* result = allocateFromBlock(blocks[curBlock], size, alignment);
+	Ensures(result != nullptr);
+	return result;
+}
+
+void FrameAllocator::reset()
+{
+	if (blocks.size() > 1) {
+		const size_t totalSize = getCapacity();
+		blocks.clear();
+		addBlock(totalSize);
+	}
+
+	for (auto& block: blocks) {
+		block.used = 0;
+	}
+	curBlock = 0;
+	bytesUsed = 0;
+}
+
+size_t FrameAllocator::getCapacity() const
+{
+	size_t total = 0;
+	for (const auto& block: blocks) {
+		total += block.size;
+	}
+	return total;
+}
+
+void* FrameAllocator::allocateFromBlock(Block& block, size_t size, size_t alignment)
+{
+	const auto base = reinterpret_cast<uintptr_t>(block.data.get());
+	const auto start = (base + block.used + alignment - 1) & ~uintptr_t(alignment - 1);
+	const auto end = start + size;
+	if (end > base + block.size) {
+		return nullptr;
+	}
+
+	bytesUsed += end - (base + block.used);
+	block.used = end - base;
+	return reinterpret_cast<void*>(start);
+}
+
+void FrameAllocator::addBlock(size_t size)
+{
+	auto& block = blocks.emplace_back();
+	block.data = std::make_unique<char[]>(size);
+	block.size = size;
+}
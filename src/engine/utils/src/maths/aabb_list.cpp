@@ -0,0 +1,131 @@
+#include "halley/maths/aabb_list.h"
+#include "halley/maths/simd.h"
+#include <gsl/gsl_assert>
+
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+using namespace Halley;
+
+void AABBList::clear()
+{
+	x0.clear();
+	y0.clear();
+	x1.clear();
+	y1.clear();
+}
+
+void AABBList::reserve(size_t n)
+{
+	x0.reserve(n);
+	y0.reserve(n);
+	x1.reserve(n);
+	y1.reserve(n);
+}
+
+void AABBList::add(Rect4f aabb)
+{
+	x0.push_back(aabb.getLeft());
+	y0.push_back(aabb.getTop());
+	x1.push_back(aabb.getRight());
+	y1.push_back(aabb.getBottom());
+}
+
+Rect4f AABBList::get(size_t idx) const
+{
+	return Rect4f(Vector2f(x0[idx], y0[idx]), Vector2f(x1[idx], y1[idx]));
+}
+
+void AABBList::cull(Rect4f view, Vector<uint32_t>& result) const
+{
+	const size_t start = result.size();
+	result.resize(start + size());
+	const size_t n = cull(view, gsl::span<uint32_t>(result.data() + start, size()));
+	result.resize(start + n);
+}
+
+size_t AABBList::cull(Rect4f view, gsl::span<uint32_t> result) const
+{
+	Expects(size_t(result.size()) >= size());
+	uint32_t* dst = result.data();
+
+	// The wide paths test for separation (<=) and invert, rather than testing for overlap (>),
+	// so that NaNs behave the same way as in Rect4f::overlaps
+	const size_t n = size();
+	size_t i = 0;
+
+#ifdef __AVX__
+	{
+		const __m256 viewX0 = _mm256_set1_ps(view.getLeft());
+		const __m256 viewY0 = _mm256_set1_ps(view.getTop());
+		const __m256 viewX1 = _mm256_set1_ps(view.getRight());
+		const __m256 viewY1 = _mm256_set1_ps(view.getBottom());
+
+		for (; i + 8 <= n; i += 8) {
+			const __m256 sepX0 = _mm256_cmp_ps(_mm256_loadu_ps(x1.data() + i), viewX0, _CMP_LE_OQ);
+			const __m256 sepX1 = _mm256_cmp_ps(viewX1, _mm256_loadu_ps(x0.data() + i), _CMP_LE_OQ);
+			const __m256 sepY0 = _mm256_cmp_ps(_mm256_loadu_ps(y1.data() + i), viewY0, _CMP_LE_OQ);
+			const __m256 sepY1 = _mm256_cmp_ps(viewY1, _mm256_loadu_ps(y0.data() + i), _CMP_LE_OQ);
+			const __m256 separated = _mm256_or_ps(_mm256_or_ps(sepX0, sepX1), _mm256_or_ps(sepY0, sepY1));
+
+			const int visible = ~_mm256_movemask_ps(separated) & 0xFF;
+			for (int j = 0; j < 8; ++j) {
+				if (visible & (1 << j)) {
+					*dst++ = static_cast<uint32_t>(i + j);
+				}
+			}
+		}
+	}
+#endif
+
+#ifdef HAS_SSE
+	{
+		const __m128 viewX0 = _mm_set1_ps(view.getLeft());
+		const __m128 viewY0 = _mm_set1_ps(view.getTop());
+		const __m128 viewX1 = _mm_set1_ps(view.getRight());
+		const __m128 viewY1 = _mm_set1_ps(view.getBottom());
+
+		for (; i + 4 <= n; i += 4) {
+			const __m128 sepX0 = _mm_cmple_ps(_mm_loadu_ps(x1.data() + i), viewX0);
+			const __m128 sepX1 = _mm_cmple_ps(viewX1, _mm_loadu_ps(x0.data() + i));
+			const __m128 sepY0 = _mm_cmple_ps(_mm_loadu_ps(y1.data() + i), viewY0);
+			const __m128 sepY1 = _mm_cmple_ps(viewY1, _mm_loadu_ps(y0.data() + i));
+			const __m128 separated = _mm_or_ps(_mm_or_ps(sepX0, sepX1), _mm_or_ps(sepY0, sepY1));
+
+			const int visible = ~_mm_movemask_ps(separated) & 0xF;
+			for (int j = 0; j < 4; ++j) {
+				if (visible & (1 << j)) {
+					*dst++ = static_cast<uint32_t>(i + j);
+				}
+			}
+		}
+	}
+#endif
+
+	dst = cullScalar(view, i, n, dst);
+	return size_t(dst - result.data());
+}
+
+void AABBList::cullScalar(Rect4f view, Vector<uint32_t>& result) const
+{
+	const size_t start = result.size();
+	result.resize(start + size());
+	const auto* end = cullScalar(view, 0, size(), result.data() + start);
+	result.resize(size_t(end - result.data()));
+}
+
+uint32_t* AABBList::cullScalar(Rect4f view, size_t start, size_t end, uint32_t* dst) const
+{
+	// Same test as Rect4f::overlaps
+	const float viewX0 = view.getLeft();
+	const float viewY0 = view.getTop();
+	const float viewX1 = view.getRight();
+	const float viewY1 = view.getBottom();
+	for (size_t i = start; i < end; ++i) {
+		if (!(x1[i] <= viewX0 || viewX1 <= x0[i] || y1[i] <= viewY0 || viewY1 <= y0[i])) {
+			*dst++ = static_cast<uint32_t>(i);
+		}
+	}
+	return dst;
+}
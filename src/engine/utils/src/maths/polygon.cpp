@@ -21,6 +21,7 @@
 
 
 #include "halley/maths/polygon.h"
+#include <atomic>
 #include <limits>
 
 #include "halley/file_formats/config_file.h"
@@ -55,8 +56,15 @@ Polygon::Polygon(const ConfigNode& node)
 	}
 }
 
-void Polygon::realize()
+namespace {
+	std::atomic<uint64_t> lastRevision { 0 };
+}
+
+void Polygon::realize(bool newRevision)
 {
+	if (newRevision) {
+		revision = ++lastRevision;
+	}
 	checkConvex();
 
 	aabb = Rect4f::getSpanningRect(vertices);
@@ -615,7 +623,7 @@ void Polygon::rotate(Angle<float> angle)
 	for (auto& v: vertices) {
 		v = v.rotate(angle);
 	}
-	realize();
+	realize(false);
 }
 
 void Polygon::rotateAndScale(Angle<float> angle, Vector2f scale)
@@ -623,7 +631,7 @@ void Polygon::rotateAndScale(Angle<float> angle, Vector2f scale)
 	for (auto& v: vertices) {
 		v = (v * scale).rotate(angle);
 	}
-	realize();
+	realize(false);
 }
 
 void Polygon::scale(Vector2f scale)
@@ -631,7 +639,7 @@ void Polygon::scale(Vector2f scale)
 	for (auto& v: vertices) {
 		v *= scale;
 	}
-	realize();
+	realize(false);
 }
 
 void Polygon::expand(float amount, float truncateThreshold)
@@ -1210,7 +1218,7 @@ void Polygon::translate(Vector2f offset)
 	for (auto& v: vertices) {
 		v += offset;
 	}
-	realize();
+	realize(false);
 }
 
 
@@ -79,7 +79,9 @@ void DX11Painter::setMaterialPass(const Material& material, int passN)
 	shader.bind(video);
 
 	// Blend
-	getBlendMode(pass.getBlend()).bind(video);
+	if (bindCache.changeBlend(pass.getBlend())) {
+		getBlendMode(pass.getBlend()).bind(video);
+	}
 
 	// Texture
 	int textureUnit = 0;
@@ -88,7 +90,7 @@ void DX11Painter::setMaterialPass(const Material& material, int passN)
 		auto texture = std::static_pointer_cast<const DX11Texture>(material.getTexture(textureUnit));
 		if (!texture) {
 			throw Exception("Error binding texture to texture unit #" + toString(textureUnit) + " with material \"" + material.getDefinition().getName() + "\": texture is null.", HalleyExceptions::VideoPlugin);
-		} else {
+		} else if (bindCache.changeTexture(textureUnit, texture.get(), size_t(tex.getSamplerType()))) {
 			texture->bind(video, textureUnit, tex.getSamplerType());
 		}
 		if (texture->getDescriptor().isRenderTarget) {
@@ -107,6 +109,9 @@ void DX11Painter::setMaterialData(const Material& material)
 		if (block.getType() != MaterialDataBlockType::SharedExternal) {
 			auto& buffer = static_cast<DX11MaterialConstantBuffer&>(block.getConstantBuffer()).getBuffer();
 			auto dxBuffer = buffer.getBuffer();
+			if (!bindCache.changeConstantBuffer(block.getBindPoint(), dxBuffer, buffer.getOffset())) {
+				continue;
+			}
 			if (Halley::getPlatform() == GamePlatform::UWP || Halley::getPlatform() == GamePlatform::XboxOne) {
 				UINT firstConstant[] = { buffer.getOffset() / 16 };
 				UINT numConstants[] = { buffer.getLastSize() / 16 };
@@ -266,6 +271,7 @@ void DX11Painter::unbindRenderTargetTextureUnits(size_t lastIndex, int minimumTe
 		if (textureUnit >= minimumTextureUnit) {
 			ID3D11ShaderResourceView* null_views[] = { nullptr };
 			video.getDeviceContext().PSSetShaderResources(textureUnit, 1, null_views);
+			bindCache.invalidateTexture(textureUnit);
 		}
 	}
 	// Remove units stored from the previous pass. Keep values of the current pass.
@@ -2,6 +2,7 @@
 #include "halley/core/graphics/material/material_parameter.h"
 #include "halley/core/graphics/material/material_definition.h"
 #include "gl_utils.h"
+#include "gl_ring_buffer.h"
 #include "halley/support/exception.h"
 #include "texture_opengl.h"
 
@@ -19,11 +20,36 @@ ConstantBufferOpenGL::~ConstantBufferOpenGL()
 
 void ConstantBufferOpenGL::update(const MaterialDataBlock& dataBlock)
 {
-	buffer.setData(dataBlock.getData());
+	const auto src = dataBlock.getData();
+	data.assign(src.begin(), src.end());
+	dirty = true;
+}
+
+size_t ConstantBufferOpenGL::upload(GLRingBuffer& ringBuffer)
+{
+	// Ring data only lives for one frame, so it has to be written again every frame it's used
+	if (dirty || uploadFrame != ringBuffer.getFrameId()) {
+		dirty = false;
+		uploadFrame = ringBuffer.getFrameId();
+
+		if (const auto offset = ringBuffer.write(data)) {
+			ring = &ringBuffer;
+			ringOffset = offset.value();
+		} else {
+			ring = nullptr;
+			ringOffset = 0;
+			buffer.setData(data);
+		}
+	}
+	return ringOffset;
 }
 
 void ConstantBufferOpenGL::bind(int bindPoint)
 {
-	buffer.bindToTarget(bindPoint);
+	if (ring) {
+		glBindBufferRange(GL_UNIFORM_BUFFER, bindPoint, ring->getName(), ringOffset, data.size());
+	} else {
+		buffer.bindToTarget(bindPoint);
+	}
 	glCheckError();
 }
@@ -4,15 +4,26 @@
 
 namespace Halley
 {
+	class GLRingBuffer;
+
 	class ConstantBufferOpenGL : public MaterialConstantBuffer
 	{
 	public:
 		explicit ConstantBufferOpenGL();
 		~ConstantBufferOpenGL();
 		void update(const MaterialDataBlock& dataBlock) override;
+
+		// Makes sure the latest data is on the GPU for this frame, streaming it through the ring if possible
+		// Returns the offset of the data in the bound buffer
+		size_t upload(GLRingBuffer& ring);
 		void bind(int bindPoint);
 
 	private:
 		GLBuffer buffer;
+		Vector<gsl::byte> data;
+		GLRingBuffer* ring = nullptr;
+		size_t ringOffset = 0;
+		uint64_t uploadFrame = 0;
+		bool dirty = true;
 	};
 }
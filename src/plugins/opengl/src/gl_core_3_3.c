@@ -88,6 +88,7 @@ static PROC WinGetProcAddress(const char *name)
 #endif
 
 int ogl_ext_KHR_debug = ogl_LOAD_FAILED;
+int ogl_ext_ARB_buffer_storage = ogl_LOAD_FAILED;
 
 void (CODEGEN_FUNCPTR *_ptrc_glDebugMessageCallback)(GLDEBUGPROC callback, const void * userParam) = NULL;
 void (CODEGEN_FUNCPTR *_ptrc_glDebugMessageControl)(GLenum source, GLenum type, GLenum severity, GLsizei count, const GLuint * ids, GLboolean enabled) = NULL;
@@ -129,6 +130,16 @@ static int Load_KHR_debug(void)
 	return numFailed;
 }
 
+void (CODEGEN_FUNCPTR *_ptrc_glBufferStorage)(GLenum target, GLsizeiptr size, const void * data, GLbitfield flags) = NULL;
+
+static int Load_ARB_buffer_storage(void)
+{
+	int numFailed = 0;
+	_ptrc_glBufferStorage = (void (CODEGEN_FUNCPTR *)(GLenum, GLsizeiptr, const void *, GLbitfield))IntGetProcAddress("glBufferStorage");
+	if(!_ptrc_glBufferStorage) numFailed++;
+	return numFailed;
+}
+
 void (CODEGEN_FUNCPTR *_ptrc_glBlendFunc)(GLenum sfactor, GLenum dfactor) = NULL;
 void (CODEGEN_FUNCPTR *_ptrc_glClear)(GLbitfield mask) = NULL;
 void (CODEGEN_FUNCPTR *_ptrc_glClearColor)(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) = NULL;
@@ -1187,11 +1198,12 @@ typedef struct ogl_StrToExtMap_s
 	PFN_LOADFUNCPOINTERS LoadExtension;
 } ogl_StrToExtMap;
 
-static ogl_StrToExtMap ExtensionMap[1] = {
+static ogl_StrToExtMap ExtensionMap[2] = {
 	{"GL_KHR_debug", &ogl_ext_KHR_debug, Load_KHR_debug},
+	{"GL_ARB_buffer_storage", &ogl_ext_ARB_buffer_storage, Load_ARB_buffer_storage},
 };
 
-static int g_extensionMapSize = 1;
+static int g_extensionMapSize = 2;
 
 static ogl_StrToExtMap *FindExtEntry(const char *extensionName)
 {
@@ -1209,6 +1221,7 @@ static ogl_StrToExtMap *FindExtEntry(const char *extensionName)
 static void ClearExtensionVars(void)
 {
 	ogl_ext_KHR_debug = ogl_LOAD_FAILED;
+	ogl_ext_ARB_buffer_storage = ogl_LOAD_FAILED;
 }
 
 
@@ -0,0 +1,150 @@
+#include "gl_ring_buffer.h"
+#include <cstring>
+
+using namespace Halley;
+
+GLFence::GLFence()
+{
+#ifdef WITH_OPENGL
+	sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glCheckError();
+#endif
+}
+
+GLFence::~GLFence()
+{
+#ifdef WITH_OPENGL
+	if (sync) {
+		glDeleteSync(sync);
+	}
+#endif
+}
+
+bool GLFence::isSignalled()
+{
+#ifdef WITH_OPENGL
+	const auto result = glClientWaitSync(sync, 0, 0);
+	return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+#else
+	return true;
+#endif
+}
+
+void GLFence::wait()
+{
+#ifdef WITH_OPENGL
+	constexpr GLuint64 timeout = 1000000000; // 1 second
+	while (true) {
+		const auto result = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+		if (result != GL_TIMEOUT_EXPIRED) {
+			break;
+		}
+	}
+#endif
+}
+
+GLRingBuffer::GLRingBuffer(GLenum target, size_t segmentSize, size_t alignment)
+	: allocator(segmentSize)
+	, target(target)
+	, alignment(alignment)
+{
+	create();
+}
+
+GLRingBuffer::~GLRingBuffer()
+{
+	destroy();
+}
+
+void GLRingBuffer::beginFrame()
+{
+	if (allocator.hasOverflowed()) {
+		// Grow to fit
+		destroy();
+		allocator.reset(allocator.getSegmentSize() * 2);
+		create();
+	}
+
+	allocator.beginFrame();
+	inFrame = true;
+
+	if (!mapped && allocator.getCurrentSegment() == 0) {
+		// Orphan the storage, so the driver doesn't have to wait for the GPU to finish with it
+		bind();
+		glBufferData(target, allocator.getCapacity(), nullptr, GL_STREAM_DRAW);
+		glCheckError();
+	}
+}
+
+void GLRingBuffer::endFrame()
+{
+	allocator.endFrame(mapped ? std::make_unique<GLFence>() : std::unique_ptr<GLFence>());
+	inFrame = false;
+}
+
+std::optional<size_t> GLRingBuffer::write(gsl::span<const gsl::byte> data)
+{
+	if (!inFrame) {
+		return {};
+	}
+
+	const auto size = size_t(data.size_bytes());
+	const auto offset = allocator.allocate(size, alignment);
+	if (!offset) {
+		return {};
+	}
+
+	if (mapped) {
+		memcpy(mapped + offset.value(), data.data(), size);
+	} else {
+		bind();
+		glBufferSubData(target, offset.value(), size, data.data());
+		glCheckError();
+	}
+	return offset;
+}
+
+void GLRingBuffer::bind()
+{
+	glBindBuffer(target, name);
+	glCheckError();
+}
+
+void GLRingBuffer::create()
+{
+	glGenBuffers(1, &name);
+	bind();
+
+	const auto capacity = allocator.getCapacity();
+#ifdef WITH_OPENGL
+	if (ogl_ext_ARB_buffer_storage == ogl_LOAD_SUCCEEDED) {
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(target, capacity, nullptr, flags);
+		mapped = static_cast<char*>(glMapBufferRange(target, 0, capacity, flags));
+		glCheckError();
+	}
+#endif
+
+	if (!mapped) {
+		glBufferData(target, capacity, nullptr, GL_STREAM_DRAW);
+		glCheckError();
+	}
+}
+
+void GLRingBuffer::destroy()
+{
+	allocator.waitAll();
+
+	if (name != 0) {
+#ifdef WITH_OPENGL
+		if (mapped) {
+			bind();
+			glUnmapBuffer(target);
+			mapped = nullptr;
+		}
+#endif
+		glBindBuffer(target, 0);
+		glDeleteBuffers(1, &name);
+		name = 0;
+	}
+}
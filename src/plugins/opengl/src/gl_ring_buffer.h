@@ -0,0 +1,57 @@
+#pragma once
+
+#include "halley_gl.h"
+#include "halley/core/graphics/gpu_ring_allocator.h"
+#include <gsl/gsl>
+#include <optional>
+
+namespace Halley
+{
+	class GLFence final : public GPUFence
+	{
+	public:
+		GLFence();
+		~GLFence();
+
+		bool isSignalled() override;
+		void wait() override;
+
+	private:
+#ifdef WITH_OPENGL
+		GLsync sync = nullptr;
+#endif
+	};
+
+	// Triple-buffered streaming buffer, for data which is rewritten every frame
+	// Uses a persistent, coherent mapping guarded by fences when ARB_buffer_storage is available;
+	// otherwise the buffer is orphaned every time the ring wraps around, and written with glBufferSubData
+	class GLRingBuffer
+	{
+	public:
+		GLRingBuffer(GLenum target, size_t segmentSize, size_t alignment);
+		~GLRingBuffer();
+
+		void beginFrame();
+		void endFrame();
+
+		// Copies data into this frame's segment, and returns its offset in the buffer
+		// Returns empty if the segment is full (the ring will grow next frame) or if no frame is in progress
+		std::optional<size_t> write(gsl::span<const gsl::byte> data);
+
+		void bind();
+		GLuint getName() const { return name; }
+		uint64_t getFrameId() const { return allocator.getFrameId(); }
+		bool isPersistent() const { return mapped != nullptr; }
+
+	private:
+		GPURingAllocator allocator;
+		GLenum target;
+		size_t alignment;
+		GLuint name = 0;
+		char* mapped = nullptr;
+		bool inFrame = false;
+
+		void create();
+		void destroy();
+	};
+}
@@ -1,6 +1,7 @@
 #include "painter_opengl.h"
 #include "halley/core/graphics/material/material_definition.h"
 #include <gsl/gsl_assert>
+#include "halley/utils/algorithm.h"
 #include "shader_opengl.h"
 #include "constant_buffer_opengl.h"
 #include "halley/core/graphics/material/material_parameter.h"
@@ -8,12 +9,60 @@
 
 using namespace Halley;
 
+namespace {
+	void getAttributeFormat(ShaderParameterType type, int& count, int& glType)
+	{
+		switch (type) {
+		case ShaderParameterType::Float:
+			count = 1;
+			glType = GL_FLOAT;
+			break;
+		case ShaderParameterType::Float2:
+			count = 2;
+			glType = GL_FLOAT;
+			break;
+		case ShaderParameterType::Float3:
+			count = 3;
+			glType = GL_FLOAT;
+			break;
+		case ShaderParameterType::Float4:
+			count = 4;
+			glType = GL_FLOAT;
+			break;
+		case ShaderParameterType::Int:
+			count = 1;
+			glType = GL_INT;
+			break;
+		case ShaderParameterType::Int2:
+			count = 2;
+			glType = GL_INT;
+			break;
+		case ShaderParameterType::Int3:
+			count = 3;
+			glType = GL_INT;
+			break;
+		case ShaderParameterType::Int4:
+			count = 4;
+			glType = GL_INT;
+			break;
+		default:
+			count = 0;
+			glType = 0;
+			break;
+		}
+	}
+}
+
 PainterOpenGL::PainterOpenGL(Resources& resources)
 	: Painter(resources)
 {}
 
 PainterOpenGL::~PainterOpenGL()
 {
+	vertexRing.reset();
+	indexRing.reset();
+	uniformRing.reset();
+
 #ifdef WITH_OPENGL
 	if (vao != 0) {
 		glBindVertexArray(0);
@@ -38,6 +87,7 @@ void PainterOpenGL::doStartRender()
 	vertexBuffer.init(GL_ARRAY_BUFFER);
 	elementBuffer.init(GL_ELEMENT_ARRAY_BUFFER);
 	stdQuadElementBuffer.init(GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW);
+	spriteCornerBuffer.init(GL_ARRAY_BUFFER, GL_STATIC_DRAW);
 
 #ifdef WITH_OPENGL
 	if (vao == 0) {
@@ -52,17 +102,42 @@ void PainterOpenGL::doStartRender()
 	glBindVertexArray(vao);
 #endif
 
+	if (!vertexRing) {
+		createRingBuffers();
+	}
+	vertexRing->beginFrame();
+	indexRing->beginFrame();
+	uniformRing->beginFrame();
+
+	// The global block stays bound across frames, but last frame's ring segment is about to be recycled, so upload it again
+	onUpdateProjection(*halleyGlobalMaterial);
+
 	clear(Colour(0, 0, 0, 1.0f), 1.0f, 0);
 }
 
 void PainterOpenGL::doEndRender()
 {
+	vertexRing->endFrame();
+	indexRing->endFrame();
+	uniformRing->endFrame();
+
 #ifdef WITH_OPENGL
 	glBindVertexArray(0);
 #endif
 	glCheckError();
 }
 
+void PainterOpenGL::createRingBuffers()
+{
+	GLint uniformAlignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+	glCheckError();
+
+	vertexRing = std::make_unique<GLRingBuffer>(GL_ARRAY_BUFFER, 4 * 1024 * 1024, 16);
+	indexRing = std::make_unique<GLRingBuffer>(GL_ELEMENT_ARRAY_BUFFER, 1024 * 1024, sizeof(IndexType));
+	uniformRing = std::make_unique<GLRingBuffer>(GL_UNIFORM_BUFFER, 256 * 1024, size_t(std::max(uniformAlignment, 16)));
+}
+
 void PainterOpenGL::clear(std::optional<Colour> colour, std::optional<float> depth, std::optional<uint8_t> stencil)
 {
 	glCheckError();
@@ -129,7 +204,11 @@ void PainterOpenGL::setMaterialData(const Material& material)
 {
 	for (auto& dataBlock: material.getDataBlocks()) {
 		if (dataBlock.getType() != MaterialDataBlockType::SharedExternal) {
-			static_cast<ConstantBufferOpenGL&>(dataBlock.getConstantBuffer()).bind(dataBlock.getBindPoint());
+			auto& buffer = static_cast<ConstantBufferOpenGL&>(dataBlock.getConstantBuffer());
+			const auto offset = buffer.upload(*uniformRing);
+			if (bindCache.changeConstantBuffer(dataBlock.getBindPoint(), &buffer, offset)) {
+				buffer.bind(dataBlock.getBindPoint());
+			}
 		}
 	}
 }
@@ -159,71 +238,60 @@ void PainterOpenGL::setVertices(const MaterialDefinition& material, size_t numVe
 
 	// Load indices into VBO
 	if (standardQuadsOnly) {
-		if (stdQuadElementBuffer.getSize() < numIndices * sizeof(unsigned short)) {
-			size_t indicesToAllocate = nextPowerOf2(numIndices);
-			std::vector<unsigned short> tmp(indicesToAllocate);
-			generateQuadIndices(0, indicesToAllocate / 6, tmp.data());
-			stdQuadElementBuffer.setData(gsl::as_bytes(gsl::span<unsigned short>(tmp)));
+		bindStandardQuadIndices(numIndices);
+	} else {
+		const auto indexData = gsl::as_bytes(gsl::span<unsigned short>(indices, numIndices));
+		if (const auto offset = indexRing->write(indexData)) {
+			indexRing->bind();
+			indexOffset = offset.value();
 		} else {
-			stdQuadElementBuffer.bind();
+			elementBuffer.setData(indexData);
+			indexOffset = 0;
 		}
-	} else {
-		elementBuffer.setData(gsl::as_bytes(gsl::span<unsigned short>(indices, numIndices)));
 	}
 
 	// Load vertices into VBO
 	size_t bytesSize = numVertices * material.getVertexStride();
-	vertexBuffer.setData(gsl::as_bytes(gsl::span<char>(static_cast<char*>(vertexData), bytesSize)));
+	const auto vertexBytes = gsl::as_bytes(gsl::span<char>(static_cast<char*>(vertexData), bytesSize));
+	if (const auto offset = vertexRing->write(vertexBytes)) {
+		vertexRing->bind();
+		vertexOffset = offset.value();
+	} else {
+		vertexBuffer.setData(vertexBytes);
+		vertexOffset = 0;
+	}
 
 	// Set attributes
 	setupVertexAttributes(material);
 }
 
+void PainterOpenGL::bindStandardQuadIndices(size_t numIndices)
+{
+	if (stdQuadElementBuffer.getSize() < numIndices * sizeof(unsigned short)) {
+		size_t indicesToAllocate = nextPowerOf2(numIndices);
+		std::vector<unsigned short> tmp(indicesToAllocate);
+		generateQuadIndices(0, indicesToAllocate / 6, tmp.data());
+		stdQuadElementBuffer.setData(gsl::as_bytes(gsl::span<unsigned short>(tmp)));
+	} else {
+		stdQuadElementBuffer.bind();
+	}
+	indexOffset = 0;
+}
+
 void PainterOpenGL::setupVertexAttributes(const MaterialDefinition& material)
 {
+	if (!instancedLocations.empty()) {
+		resetAttributeDivisors();
+	}
+
 	// Set vertex attribute pointers in VBO
 	size_t vertexStride = material.getVertexStride();
 	for (auto& attribute : material.getAttributes()) {
 		int count = 0;
 		int type = 0;
-		switch (attribute.type) {
-		case ShaderParameterType::Float:
-			count = 1;
-			type = GL_FLOAT;
-			break;
-		case ShaderParameterType::Float2:
-			count = 2;
-			type = GL_FLOAT;
-			break;
-		case ShaderParameterType::Float3:
-			count = 3;
-			type = GL_FLOAT;
-			break;
-		case ShaderParameterType::Float4:
-			count = 4;
-			type = GL_FLOAT;
-			break;
-		case ShaderParameterType::Int:
-			count = 1;
-			type = GL_INT;
-			break;
-		case ShaderParameterType::Int2:
-			count = 2;
-			type = GL_INT;
-			break;
-		case ShaderParameterType::Int3:
-			count = 3;
-			type = GL_INT;
-			break;
-		case ShaderParameterType::Int4:
-			count = 4;
-			type = GL_INT;
-			break;
-		default:
-			break;
-		}
+		getAttributeFormat(attribute.type, count, type);
 		glEnableVertexAttribArray(attribute.location);
-		size_t offset = attribute.offset;
+		size_t offset = vertexOffset + attribute.offset;
 		glVertexAttribPointer(attribute.location, count, type, GL_FALSE, GLsizei(vertexStride), reinterpret_cast<GLvoid*>(offset));
 		glCheckError();
 	}
@@ -236,6 +304,100 @@ void PainterOpenGL::drawTriangles(size_t numIndices)
 	Expects(numIndices > 0);
 	Expects(numIndices % 3 == 0);
 
-	glDrawElements(GL_TRIANGLES, int(numIndices), GL_UNSIGNED_SHORT, nullptr);
+	glDrawElements(GL_TRIANGLES, int(numIndices), GL_UNSIGNED_SHORT, reinterpret_cast<GLvoid*>(indexOffset));
+	glCheckError();
+}
+
+void PainterOpenGL::setInstances(const MaterialDefinition& material, size_t numInstances, void* instanceData)
+{
+#if defined(WITH_OPENGL) || defined(WITH_OPENGL_ES3)
+	Expects(numInstances > 0);
+	Expects(instanceData);
+
+	// Every instance draws the first standard quad
+	bindStandardQuadIndices(6);
+
+	if (spriteCornerBuffer.getSize() == 0) {
+		spriteCornerBuffer.setData(gsl::as_bytes(getSpriteCorners()));
+	}
+
+	const size_t bytesSize = numInstances * material.getInstanceStride();
+	const auto instanceBytes = gsl::as_bytes(gsl::span<char>(static_cast<char*>(instanceData), bytesSize));
+	if (const auto offset = vertexRing->write(instanceBytes)) {
+		vertexOffset = offset.value();
+		setupInstanceAttributes(material, nullptr);
+	} else {
+		vertexBuffer.setData(instanceBytes);
+		vertexOffset = 0;
+		setupInstanceAttributes(material, &vertexBuffer);
+	}
+#else
+	Painter::setInstances(material, numInstances, instanceData);
+#endif
+}
+
+void PainterOpenGL::setupInstanceAttributes(const MaterialDefinition& material, GLBuffer* fallbackBuffer)
+{
+#if defined(WITH_OPENGL) || defined(WITH_OPENGL_ES3)
+	const size_t vertPosOffset = material.getVertexPosOffset();
+	const size_t instanceStride = material.getInstanceStride();
+
+	// vertPos comes from the corner buffer, once per vertex; everything else is read once per instance
+	spriteCornerBuffer.bind();
+	for (auto& attribute: material.getAttributes()) {
+		if (size_t(attribute.offset) == vertPosOffset) {
+			glEnableVertexAttribArray(attribute.location);
+			glVertexAttribPointer(attribute.location, 4, GL_FLOAT, GL_FALSE, GLsizei(sizeof(Vector4f)), nullptr);
+			glVertexAttribDivisor(attribute.location, 0);
+			glCheckError();
+			std_ex::erase_if(instancedLocations, [&] (GLuint location) { return location == GLuint(attribute.location); });
+		}
+	}
+
+	if (fallbackBuffer) {
+		fallbackBuffer->bind();
+	} else {
+		vertexRing->bind();
+	}
+	for (auto& attribute: material.getAttributes()) {
+		if (size_t(attribute.offset) != vertPosOffset) {
+			int count = 0;
+			int type = 0;
+			getAttributeFormat(attribute.type, count, type);
+			glEnableVertexAttribArray(attribute.location);
+			const size_t offset = vertexOffset + material.getInstanceAttributeOffset(attribute);
+			glVertexAttribPointer(attribute.location, count, type, GL_FALSE, GLsizei(instanceStride), reinterpret_cast<GLvoid*>(offset));
+			glVertexAttribDivisor(attribute.location, 1);
+			glCheckError();
+			if (!std_ex::contains(instancedLocations, GLuint(attribute.location))) {
+				instancedLocations.push_back(GLuint(attribute.location));
+			}
+		}
+	}
+#endif
+}
+
+void PainterOpenGL::resetAttributeDivisors()
+{
+#if defined(WITH_OPENGL) || defined(WITH_OPENGL_ES3)
+	// Divisors are per attribute location, not per material, so clear every location an instanced draw set,
+	// even if the next material doesn't use it (or uses it for something else)
+	for (const auto location: instancedLocations) {
+		glVertexAttribDivisor(location, 0);
+	}
 	glCheckError();
+#endif
+	instancedLocations.clear();
+}
+
+void PainterOpenGL::drawInstances(size_t numInstances)
+{
+#if defined(WITH_OPENGL) || defined(WITH_OPENGL_ES3)
+	Expects(numInstances > 0);
+
+	glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, nullptr, GLsizei(numInstances));
+	glCheckError();
+#else
+	Painter::drawInstances(numInstances);
+#endif
 }
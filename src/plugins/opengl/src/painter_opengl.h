@@ -3,6 +3,7 @@
 #include "halley/core/graphics/painter.h"
 #include "halley_gl.h"
 #include "gl_buffer.h"
+#include "gl_ring_buffer.h"
 
 namespace Halley
 {
@@ -27,6 +28,8 @@ namespace Halley
 	protected:
 		void setVertices(const MaterialDefinition& material, size_t numVertices, void* vertexData, size_t numIndices, unsigned short* indices, bool standardQuadsOnly) override;
 		void drawTriangles(size_t numIndices) override;
+		void setInstances(const MaterialDefinition& material, size_t numInstances, void* instanceData) override;
+		void drawInstances(size_t numInstances) override;
 		void setViewPort(Rect4i rect) override;
 		void onUpdateProjection(Material& material) override;
 
@@ -37,8 +40,21 @@ namespace Halley
 		GLBuffer vertexBuffer;
 		GLBuffer elementBuffer;
 		GLBuffer stdQuadElementBuffer;
+		GLBuffer spriteCornerBuffer;
 		std::unique_ptr<GLUtils> glUtils;
 
+		// Per-frame vertex, index and uniform data is streamed through these; the buffers above are the fallback when a ring is full
+		std::unique_ptr<GLRingBuffer> vertexRing;
+		std::unique_ptr<GLRingBuffer> indexRing;
+		std::unique_ptr<GLRingBuffer> uniformRing;
+		size_t vertexOffset = 0;
+		size_t indexOffset = 0;
+		Vector<GLuint> instancedLocations; // Attribute locations currently with a divisor of 1
+
+		void bindStandardQuadIndices(size_t numIndices);
 		void setupVertexAttributes(const MaterialDefinition& material);
+		void setupInstanceAttributes(const MaterialDefinition& material, GLBuffer* fallbackBuffer);
+		void resetAttributeDivisors();
+		void createRingBuffers();
 	};
 }
@@ -15,6 +15,12 @@ TextureRenderTargetOpenGL::~TextureRenderTargetOpenGL()
 
 void TextureRenderTargetOpenGL::onBind(Painter&)
 {
+	// Attachments changed, rebuild the framebuffer
+	if (dirty) {
+		deInit();
+		dirty = false;
+	}
+
 	init();
 	Expects(fbo != 0);
 	
@@ -7,6 +7,7 @@
 #include "video_opengl.h"
 #include "halley/support/logger.h"
 #include "halley/text/string_converter.h"
+#include "halley/file_formats/image.h"
 
 using namespace Halley;
 
@@ -53,6 +54,26 @@ void TextureOpenGL::doLoad(TextureDescriptor& d)
 	finishLoading();
 }
 
+void TextureOpenGL::doUpdateRegion(Rect4i region, const Image& image)
+{
+	waitForOpenGLLoad();
+
+	GLUtils glUtils;
+	glUtils.bindTexture(textureId);
+
+	// The image is tightly packed and exactly the size of the region
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, region.getLeft(), region.getTop(), region.getWidth(), region.getHeight(), GL_RGBA, GL_UNSIGNED_BYTE, image.getPixelBytes().data());
+	glCheckError();
+
+#if defined (WITH_OPENGL) || defined(WITH_OPENGL_ES3)
+	if (descriptor.useMipMap) {
+		glGenerateMipmap(GL_TEXTURE_2D);
+		glCheckError();
+	}
+#endif
+}
+
 void TextureOpenGL::reload(Resource&& resource)
 {
 	*this = std::move(dynamic_cast<TextureOpenGL&>(resource));
@@ -21,6 +21,7 @@ namespace Halley
 		unsigned int getNativeId() const;
 
 		void doLoad(TextureDescriptor& descriptor) override;
+		void doUpdateRegion(Rect4i region, const Image& image) override;
 		void reload(Resource&& resource) override;
 
 	private:
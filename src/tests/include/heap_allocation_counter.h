@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+
+namespace Halley {
+	// Counts heap allocations made through the global operator new, which the test executable replaces
+	class HeapAllocationCounter {
+	public:
+		HeapAllocationCounter();
+
+		// Allocations made by any thread since this counter was constructed
+		size_t getAllocations() const;
+
+		static size_t getTotalAllocations();
+
+	private:
+		size_t start;
+	};
+}
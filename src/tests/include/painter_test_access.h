@@ -0,0 +1,17 @@
+#pragma once
+#include <halley/core/graphics/painter.h>
+#include <halley/core/graphics/render_context.h>
+
+namespace Halley {
+	// Drives painter frames directly, the way Core does, so tests don't need a running engine
+	class PainterTestAccess {
+	public:
+		static void startRender(Painter& painter) { painter.startRender(); }
+		static void endRender(Painter& painter) { painter.endRender(); }
+
+		static RenderContext makeRenderContext(Painter& painter, const Camera& camera, RenderTarget& renderTarget)
+		{
+			return RenderContext(painter, camera, renderTarget);
+		}
+	};
+}
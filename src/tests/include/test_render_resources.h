@@ -0,0 +1,32 @@
+#pragma once
+#include <halley.hpp>
+#include <initializer_list>
+#include "dummy/dummy_system.h"
+#include "dummy/dummy_video.h"
+
+namespace Halley {
+	// YAML for a material with the SpriteVertexAttrib layout, and one texture
+	String makeSpriteMaterialYAML(const String& name, bool instanced = false);
+
+	// Resources for rendering tests, on top of the dummy system and video APIs
+	// Materials are given as YAML and loaded through the regular resource path, each with a single pass.
+	// The materials that Painter needs are always available.
+	class TestRenderResources {
+	public:
+		explicit TestRenderResources(std::initializer_list<String> materials = {});
+		~TestRenderResources();
+
+		Resources& getResources() { return *resources; }
+		VideoAPI& getVideo() { return *video; }
+
+		std::shared_ptr<Material> makeMaterial(const String& name);
+
+	private:
+		class MemorySystemAPI;
+
+		std::unique_ptr<MemorySystemAPI> system;
+		std::unique_ptr<DummyVideoAPI> video;
+		HalleyAPI api;
+		std::unique_ptr<Resources> resources;
+	};
+}
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+using namespace Halley;
+
+TEST(HalleyAABBList, CullMatchesScalar)
+{
+	Random rng(uint32_t(1234));
+
+	AABBList list;
+	Vector<Rect4f> rects;
+	for (int i = 0; i < 1003; ++i) {
+		const auto pos = Vector2f(rng.getFloat(-1000.0f, 1000.0f), rng.getFloat(-1000.0f, 1000.0f));
+		const auto size = Vector2f(rng.getFloat(0.0f, 100.0f), rng.getFloat(0.0f, 100.0f));
+		rects.push_back(Rect4f(pos, pos + size));
+	}
+	
+	// Edge cases: touching the view, degenerate, and exactly the view
+	const auto view = Rect4f(Vector2f(-300, -200), Vector2f(400, 500));
+	rects.push_back(Rect4f(Vector2f(-400, -200), Vector2f(-300, 0)));
+	rects.push_back(Rect4f(Vector2f(400, 0), Vector2f(500, 100)));
+	rects.push_back(Rect4f(Vector2f(0, 0), Vector2f(0, 0)));
+	rects.push_back(view);
+
+	for (const auto& r: rects) {
+		list.add(r);
+	}
+
+	Vector<uint32_t> fast;
+	Vector<uint32_t> scalar;
+	list.cull(view, fast);
+	list.cullScalar(view, scalar);
+	EXPECT_EQ(fast, scalar);
+
+	Vector<uint32_t> expected;
+	for (size_t i = 0; i < rects.size(); ++i) {
+		if (rects[i].overlaps(view)) {
+			expected.push_back(static_cast<uint32_t>(i));
+		}
+	}
+	EXPECT_EQ(scalar, expected);
+	EXPECT_FALSE(expected.empty());
+
+	// Writing into a span gives the same indices, and appending to a vector keeps what was already there
+	Vector<uint32_t> span(list.size());
+	span.resize(list.cull(view, gsl::span<uint32_t>(span)));
+	EXPECT_EQ(span, expected);
+
+	Vector<uint32_t> appended = { 42 };
+	list.cull(view, appended);
+	EXPECT_EQ(appended.size(), expected.size() + 1);
+	EXPECT_EQ(appended.front(), 42u);
+}
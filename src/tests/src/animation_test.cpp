@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+using namespace Halley;
+
+namespace {
+	const char* spriteMaterial = R"(
+name: Test/Sprite
+textures:
+  - tex0: sampler2D
+)";
+
+	constexpr int numSprites = 8;
+
+	class HalleyAnimation : public ::testing::Test {
+	protected:
+		HalleyAPI api {};
+		Resources resources { std::unique_ptr<ResourceLocator>(), api, {} };
+
+		void SetUp() override
+		{
+			resources.init<MaterialDefinition>();
+			resources.init<SpriteSheet>();
+
+			auto material = std::make_shared<MaterialDefinition>();
+			material->load(YAMLConvert::parseConfig(spriteMaterial));
+			resources.of<MaterialDefinition>().setResource(0, "Test/Sprite", material);
+
+			// Sprite n is n + 1 pixels wide, so which one is shown can be read back from a Sprite
+			auto sheet = std::make_shared<SpriteSheet>();
+			sheet->setTexture(std::make_shared<Texture>(Vector2i(64, 64)));
+			for (int i = 0; i < numSprites; ++i) {
+				SpriteSheetEntry entry;
+				entry.size = Vector2f(float(i + 1), 1);
+				sheet->addSprite("sprite" + toString(i), entry);
+			}
+			resources.of<SpriteSheet>().setResource(0, "sheet", sheet);
+		}
+
+		// Frame i lasts durations[i] ms, and shows sprites[i], or sprite i if that's not given
+		std::shared_ptr<Animation> makeAnimation(const Vector<int>& durations, bool loop, const Vector<int>& sprites = {})
+		{
+			AnimationSequence sequence("default", loop, false);
+			for (size_t i = 0; i < durations.size(); ++i) {
+				const int sprite = sprites.empty() ? int(i) : sprites[i];
+				sequence.addFrame(AnimationFrameDefinition(int(i), durations[i], "sprite" + toString(sprite)));
+			}
+
+			auto animation = std::make_shared<Animation>();
+			animation->setSpriteSheetName("sheet");
+			animation->setMaterialName("Test/Sprite");
+			animation->addDirection(AnimationDirection("default", "default", false, 0));
+			animation->addSequence(sequence);
+			animation->loadDependencies(resources);
+			return animation;
+		}
+	};
+
+	int getSpriteShown(const Sprite& sprite)
+	{
+		return int(sprite.getSize().x) - 1;
+	}
+
+	// What getFrameAtTime should return, found the slow way
+	size_t findFrame(const Vector<int>& durations, int time)
+	{
+		int end = 0;
+		for (size_t i = 0; i < durations.size(); ++i) {
+			end += std::max(1, durations[i]);
+			if (time < end) {
+				return i;
+			}
+		}
+		return durations.size() - 1;
+	}
+}
+
+TEST_F(HalleyAnimation, IrregularFrameDurations)
+{
+	// The first is looked up through the table, in 10ms steps. The second is too long for one, and is binary searched.
+	// Frames of 0ms still last 1ms.
+	for (const auto& durations: { Vector<int>{ 100, 30, 250, 20, 0, 50 }, Vector<int>{ 1, 5000, 3, 0, 7 } }) {
+		const auto animation = makeAnimation(durations, true);
+		const auto& sequence = animation->getSequence("default");
+
+		int total = 0;
+		for (const auto d: durations) {
+			total += std::max(1, d);
+		}
+		ASSERT_EQ(sequence.getDuration(), total);
+
+		for (int t = 0; t < total; ++t) {
+			ASSERT_EQ(sequence.getFrameAtTime(t), findFrame(durations, t)) << t;
+		}
+
+		// Out of range times are clamped to the first and last frames
+		EXPECT_EQ(sequence.getFrameAtTime(-10), 0u);
+		EXPECT_EQ(sequence.getFrameAtTime(total), durations.size() - 1);
+		EXPECT_EQ(sequence.getFrameAtTime(total + 1000), durations.size() - 1);
+	}
+}
+
+TEST_F(HalleyAnimation, BatchSkipsFramesInOneStep)
+{
+	AnimationPlayerBatch batch;
+	batch.add(makeAnimation({ 100, 100, 100, 100, 100, 100 }, true));
+	std::array<Sprite, 1> sprites;
+
+	EXPECT_EQ(batch.update(0.0, sprites), 1u);
+	EXPECT_EQ(getSpriteShown(sprites[0]), 0);
+
+	// Straight past frames 1 and 2
+	EXPECT_EQ(batch.update(0.35, sprites), 1u);
+	EXPECT_EQ(batch.getCurrentFrame(0), 3);
+	EXPECT_EQ(getSpriteShown(sprites[0]), 3);
+
+	// Past the end of the loop, and back to the start
+	EXPECT_EQ(batch.update(0.3, sprites), 1u);
+	EXPECT_EQ(batch.getCurrentFrame(0), 0);
+	EXPECT_EQ(getSpriteShown(sprites[0]), 0);
+}
+
+TEST_F(HalleyAnimation, BatchClampsNonLooping)
+{
+	AnimationPlayerBatch batch;
+	batch.add(makeAnimation({ 100, 50, 100 }, false));
+	std::array<Sprite, 1> sprites;
+
+	EXPECT_EQ(batch.update(10.0, sprites), 1u);
+	EXPECT_EQ(batch.getCurrentFrame(0), 2);
+	EXPECT_EQ(getSpriteShown(sprites[0]), 2);
+
+	// Stays on the last frame
+	EXPECT_EQ(batch.update(10.0, sprites), 0u);
+	EXPECT_EQ(batch.getCurrentFrame(0), 2);
+}
+
+TEST_F(HalleyAnimation, BatchOnlyUpdatesChangedSprites)
+{
+	AnimationPlayerBatch batch;
+	const auto animation = makeAnimation({ 100, 100, 100 }, true);
+	batch.add(animation);
+	batch.add(animation);
+	batch.setPlaybackSpeed(1, 0.0f);
+	std::array<Sprite, 2> sprites;
+
+	EXPECT_EQ(batch.update(0.0, sprites), 2u);
+
+	// Within the same frame, nothing is touched
+	sprites[0].setSize(Vector2f(99, 99));
+	sprites[1].setSize(Vector2f(99, 99));
+	EXPECT_EQ(batch.update(0.05, sprites), 0u);
+	EXPECT_EQ(sprites[0].getSize(), Vector2f(99, 99));
+
+	// Only the player that moved on gets its sprite set
+	EXPECT_EQ(batch.update(0.1, sprites), 1u);
+	EXPECT_EQ(getSpriteShown(sprites[0]), 1);
+	EXPECT_EQ(sprites[1].getSize(), Vector2f(99, 99));
+	EXPECT_EQ(batch.getCurrentFrame(1), 0);
+}
+
+TEST_F(HalleyAnimation, BatchPicksUpReloads)
+{
+	AnimationPlayerBatch batch;
+	const auto animation = makeAnimation({ 100, 100, 100 }, true);
+	batch.add(animation);
+	std::array<Sprite, 1> sprites;
+
+	EXPECT_EQ(batch.update(0.15, sprites), 1u);
+	EXPECT_EQ(getSpriteShown(sprites[0]), 1);
+
+	// Same timing but different sprites, so the frame number alone wouldn't show it changed
+	const int version = animation->getAssetVersion();
+	animation->reloadResource(std::move(*makeAnimation({ 100, 100, 100 }, true, { 5, 6, 7 })));
+	EXPECT_NE(animation->getAssetVersion(), version);
+
+	EXPECT_EQ(batch.update(0.0, sprites), 1u);
+	EXPECT_EQ(batch.getCurrentFrame(0), 1);
+	EXPECT_EQ(getSpriteShown(sprites[0]), 6);
+}
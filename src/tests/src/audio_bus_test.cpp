@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include "audio_bus.h"
+#include "audio_engine.h"
+#include "audio_offline_renderer.h"
+#include "audio_source_clip.h"
+using namespace Halley;
+
+namespace {
+	constexpr size_t numSamples = 4096;
+
+	// Peak level over the second half of the buffer, once the filter has settled
+	float getSettledPeak(gsl::span<const float> samples)
+	{
+		float peak = 0.0f;
+		for (size_t i = samples.size() / 2; i < size_t(samples.size()); ++i) {
+			peak = std::max(peak, std::abs(samples[i]));
+		}
+		return peak;
+	}
+
+	void fill(AudioBuffer& buffer, float amplitude, bool alternate)
+	{
+		auto samples = gsl::span<float>(buffer.packs.data()->samples.data(), numSamples);
+		for (size_t i = 0; i < numSamples; ++i) {
+			samples[i] = (alternate && i % 2 == 1) ? -amplitude : amplitude;
+		}
+	}
+
+	class ConstantClip final : public IAudioClip {
+	public:
+		size_t copyChannelData(size_t channelN, size_t pos, size_t len, gsl::span<AudioConfig::SampleFormat> dst) const override
+		{
+			for (size_t i = 0; i < len; ++i) {
+				dst[i] = 0.05f;
+			}
+			return len;
+		}
+
+		uint8_t getNumberOfChannels() const override { return 1; }
+		size_t getLength() const override { return AudioConfig::sampleRate; }
+	};
+
+	// Output level of a constant voice played into the given group, once everything has settled
+	float renderLevel(const String& group, const std::function<void(AudioEngine&)>& setup)
+	{
+		AudioOfflineRenderer renderer(AudioSpec(AudioConfig::sampleRate, 2, 512, AudioSampleFormat::Float));
+		renderer.setRecording(true);
+		auto& engine = renderer.getEngine();
+		setup(engine);
+
+		auto source = std::make_shared<AudioSourceClip>(std::make_shared<ConstantClip>(), true, 0);
+		engine.addEmitter(1, std::make_unique<AudioVoice>(source, AudioPosition::makeUI(), 1.0f, uint8_t(engine.getGroupId(group))));
+		renderer.render(8);
+
+		const auto recording = renderer.getRecording();
+		const auto samples = gsl::span<const float>(reinterpret_cast<const float*>(recording.data()), recording.size() / sizeof(float));
+		return samples[samples.size() - 1];
+	}
+
+	AudioBusConfig makeBusConfig(const String& parent, const String& send, float lowPassCutoff = 0.0f)
+	{
+		AudioBusConfig config;
+		config.parent = parent;
+		config.send = send;
+		config.sendGain = send.isEmpty() ? 0.0f : 1.0f;
+		config.lowPassCutoff = lowPassCutoff;
+		return config;
+	}
+}
+
+TEST(HalleyAudioBus, BiquadLowPass)
+{
+	auto lowPass = AudioBiquad::makeLowPass(1000.0f);
+
+	std::vector<float> dc(numSamples, 0.5f);
+	lowPass.process(0, dc);
+	EXPECT_NEAR(getSettledPeak(dc), 0.5f, 0.001f);
+
+	// Nyquist is as high as it goes, so it should be all but gone
+	std::vector<float> nyquist(numSamples);
+	for (size_t i = 0; i < numSamples; ++i) {
+		nyquist[i] = i % 2 == 0 ? 0.5f : -0.5f;
+	}
+	lowPass.process(1, nyquist);
+	EXPECT_LT(getSettledPeak(nyquist), 0.001f);
+
+	auto highPass = AudioBiquad::makeHighPass(1000.0f);
+	std::vector<float> dc2(numSamples, 0.5f);
+	highPass.process(0, dc2);
+	EXPECT_LT(getSettledPeak(dc2), 0.001f);
+}
+
+TEST(HalleyAudioBus, ProcessesChain)
+{
+	AudioBufferPool pool;
+	AudioBus bus("muffled");
+	EXPECT_TRUE(bus.isPassthrough());
+
+	AudioBusConfig config;
+	config.lowPassCutoff = 500.0f;
+	bus.setConfig(config);
+	EXPECT_FALSE(bus.isPassthrough());
+
+	bus.setMixBuffers(pool.getBuffers(2, numSamples));
+	auto buffers = bus.getMixBuffers();
+	fill(*buffers[0], 0.5f, false);
+	fill(*buffers[1], 0.5f, true);
+	bus.process(numSamples);
+
+	EXPECT_NEAR(getSettledPeak(gsl::span<const float>(buffers[0]->packs.data()->samples.data(), numSamples)), 0.5f, 0.001f);
+	EXPECT_LT(getSettledPeak(gsl::span<const float>(buffers[1]->packs.data()->samples.data(), numSamples)), 0.001f);
+	bus.releaseMixBuffers();
+	EXPECT_TRUE(bus.getMixBuffers().empty());
+}
+
+TEST(HalleyAudioBus, Compressor)
+{
+	AudioBufferPool pool;
+	auto buffers = pool.getBuffers(1, numSamples);
+
+	// 0 dBFS into a -20 dB threshold at 4:1 should settle at -15 dB
+	AudioBusCompressor compressor(-20.0f, 4.0f, 0.001f, 0.1f);
+	fill(*buffers.getBuffers()[0], 1.0f, false);
+	compressor.process(buffers.getBuffers(), numSamples);
+	const float peak = getSettledPeak(gsl::span<const float>(buffers.getBuffers()[0]->packs.data()->samples.data(), numSamples));
+	EXPECT_NEAR(20.0f * std::log10(peak), -15.0f, 0.1f);
+
+	// Below the threshold, it shouldn't touch the signal
+	AudioBusCompressor quietCompressor(-20.0f, 4.0f, 0.001f, 0.1f);
+	fill(*buffers.getBuffers()[0], 0.05f, false);
+	quietCompressor.process(buffers.getBuffers(), numSamples);
+	EXPECT_NEAR(getSettledPeak(gsl::span<const float>(buffers.getBuffers()[0]->packs.data()->samples.data(), numSamples)), 0.05f, 0.0001f);
+}
+
+TEST(HalleyAudioBus, MixesInDependencyOrder)
+{
+	const float dry = renderLevel("", [] (AudioEngine& engine) {});
+	ASSERT_GT(dry, 0.0f);
+
+	// Group ids are created in the reverse of the order the buses have to be mixed in
+	// "a" goes into "b", and both also send into "c", so "c" hears the voice twice and "b" passes it on once
+	const float routed = renderLevel("a", [] (AudioEngine& engine)
+	{
+		engine.getGroupId("c");
+		engine.getGroupId("b");
+		engine.setGroupBus("c", makeBusConfig("", "", 10000.0f));
+		engine.setGroupBus("b", makeBusConfig("", "c"));
+		engine.setGroupBus("a", makeBusConfig("b", "c"));
+	});
+	EXPECT_NEAR(routed, 3.0f * dry, 0.001f);
+}
+
+TEST(HalleyAudioBus, DropsOnlyTheSendClosingALoop)
+{
+	const float dry = renderLevel("", [] (AudioEngine& engine) {});
+	ASSERT_GT(dry, 0.0f);
+
+	// "x" and "y" send into each other. The send from "y" closes the loop and is dropped, but everything else still plays:
+	// "x" goes out directly and into "y", which mixes into "z", and "z" goes out directly and through "w"
+	const float routed = renderLevel("x", [] (AudioEngine& engine)
+	{
+		engine.getGroupId("x");
+		engine.getGroupId("y");
+		engine.setGroupBus("x", makeBusConfig("", "y"));
+		engine.setGroupBus("y", makeBusConfig("z", "x"));
+		engine.setGroupBus("z", makeBusConfig("", "w"));
+		engine.setGroupBus("w", makeBusConfig("", "", 10000.0f));
+	});
+	EXPECT_NEAR(routed, 3.0f * dry, 0.001f);
+}
@@ -0,0 +1,242 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include <vorbis/vorbisenc.h>
+#include "audio_clip.h"
+#include "audio_clip_streamer.h"
+#include "audio_source_clip.h"
+#include "vorbis_dec.h"
+using namespace Halley;
+
+namespace {
+	constexpr size_t numChannels = 2;
+	constexpr size_t bufferSize = 512;
+
+	class MemoryDataReader final : public ResourceDataReader {
+	public:
+		explicit MemoryDataReader(std::shared_ptr<const Bytes> data)
+			: data(std::move(data))
+		{}
+
+		size_t size() const override { return data->size(); }
+		size_t tell() const override { return pos; }
+		void close() override {}
+
+		int read(gsl::span<gsl::byte> dst) override
+		{
+			const size_t n = std::min(size_t(dst.size()), data->size() - std::min(pos, data->size()));
+			memcpy(dst.data(), data->data() + pos, n);
+			pos += n;
+			return int(n);
+		}
+
+		void seek(int64_t offset, int whence) override
+		{
+			if (whence == SEEK_SET) {
+				pos = size_t(offset);
+			} else if (whence == SEEK_CUR) {
+				pos = size_t(int64_t(pos) + offset);
+			} else {
+				pos = size_t(int64_t(data->size()) + offset);
+			}
+		}
+
+	private:
+		std::shared_ptr<const Bytes> data;
+		size_t pos = 0;
+	};
+
+	void writePage(Bytes& dst, const ogg_page& page)
+	{
+		dst.insert(dst.end(), reinterpret_cast<const Byte*>(page.header), reinterpret_cast<const Byte*>(page.header) + page.header_len);
+		dst.insert(dst.end(), reinterpret_cast<const Byte*>(page.body), reinterpret_cast<const Byte*>(page.body) + page.body_len);
+	}
+
+	Bytes encodeVorbis(const std::vector<std::vector<float>>& src)
+	{
+		Bytes result;
+		ogg_stream_state os;
+		ogg_stream_init(&os, 0);
+		vorbis_info vi;
+		vorbis_info_init(&vi);
+		vorbis_encode_init_vbr(&vi, long(src.size()), long(AudioConfig::sampleRate), 0.5f);
+		vorbis_dsp_state v;
+		vorbis_analysis_init(&v, &vi);
+		vorbis_comment vc;
+		vorbis_comment_init(&vc);
+		vorbis_block vb;
+		vorbis_block_init(&v, &vb);
+
+		ogg_packet header;
+		ogg_packet headerComment;
+		ogg_packet headerCode;
+		vorbis_analysis_headerout(&v, &vc, &header, &headerComment, &headerCode);
+		ogg_stream_packetin(&os, &header);
+		ogg_stream_packetin(&os, &headerComment);
+		ogg_stream_packetin(&os, &headerCode);
+		ogg_page page;
+		while (ogg_stream_flush(&os, &page) != 0) {
+			writePage(result, page);
+		}
+
+		const size_t length = src[0].size();
+		size_t pos = 0;
+		bool eos = false;
+		while (!eos) {
+			const size_t n = std::min(length - pos, size_t(1024));
+			float** buffers = vorbis_analysis_buffer(&v, 1024);
+			for (size_t i = 0; i < src.size(); ++i) {
+				std::copy_n(src[i].begin() + pos, n, buffers[i]);
+			}
+			pos += n;
+			vorbis_analysis_wrote(&v, int(n));
+
+			while (vorbis_analysis_blockout(&v, &vb) == 1) {
+				vorbis_analysis(&vb, nullptr);
+				vorbis_bitrate_addblock(&vb);
+				ogg_packet packet;
+				while (vorbis_bitrate_flushpacket(&v, &packet)) {
+					ogg_stream_packetin(&os, &packet);
+					while (ogg_stream_pageout(&os, &page) != 0) {
+						writePage(result, page);
+						eos = eos || ogg_page_eos(&page);
+					}
+				}
+			}
+		}
+
+		vorbis_comment_clear(&vc);
+		vorbis_block_clear(&vb);
+		vorbis_dsp_clear(&v);
+		vorbis_info_clear(&vi);
+		ogg_stream_clear(&os);
+		return result;
+	}
+
+	class HalleyAudioClipStream : public ::testing::Test {
+	protected:
+		std::shared_ptr<ResourceDataStream> data;
+		std::shared_ptr<const AudioClipStream> stream;
+		std::vector<std::vector<float>> reference;
+
+		void SetUp() override
+		{
+			// A tone sweeping upwards, so reading from the wrong place doesn't go unnoticed
+			const size_t length = AudioConfig::sampleRate * 3;
+			std::vector<std::vector<float>> samples(numChannels, std::vector<float>(length));
+			for (size_t i = 0; i < length; ++i) {
+				const float t = float(i) / float(AudioConfig::sampleRate);
+				samples[0][i] = 0.5f * std::sin(t * (200.0f + 300.0f * t) * 6.2831853f);
+				samples[1][i] = 0.5f * std::sin(t * (900.0f - 200.0f * t) * 6.2831853f);
+			}
+			const auto bytes = std::make_shared<const Bytes>(encodeVorbis(samples));
+			data = std::make_shared<ResourceDataStream>("test.ogg", [bytes] () { return std::make_unique<MemoryDataReader>(bytes); });
+
+			// What streaming should produce is what decoding the whole thing in one go does
+			VorbisData vorbis(data);
+			reference.resize(numChannels, std::vector<float>(vorbis.getNumSamples()));
+			vorbis.read(reference);
+			stream = std::make_shared<const AudioClipStream>(data, vorbis, 0);
+		}
+
+		std::vector<std::vector<float>> read(AudioClipStreamer& streamer, size_t pos)
+		{
+			std::vector<std::vector<float>> dst(numChannels, std::vector<float>(bufferSize));
+			for (size_t i = 0; i < numChannels; ++i) {
+				streamer.copyChannelData(i, pos, bufferSize, dst[i]);
+			}
+			return dst;
+		}
+
+		std::vector<std::vector<float>> read(AudioSourceClip& voice)
+		{
+			std::vector<std::vector<float>> dst(numChannels, std::vector<float>(bufferSize));
+			AudioSourceData dstSpans;
+			for (size_t i = 0; i < numChannels; ++i) {
+				dstSpans[i] = gsl::span<float>(dst[i]);
+			}
+			voice.getAudioData(bufferSize, dstSpans);
+			return dst;
+		}
+
+		// Largest difference from the reference at the given position, or from silence if it's not set
+		float getDifference(const std::vector<std::vector<float>>& samples, std::optional<size_t> pos) const
+		{
+			float maxDifference = 0;
+			for (size_t i = 0; i < numChannels; ++i) {
+				for (size_t j = 0; j < bufferSize; ++j) {
+					const float expected = pos ? reference[i][*pos + j] : 0.0f;
+					maxDifference = std::max(maxDifference, std::abs(samples[i][j] - expected));
+				}
+			}
+			return maxDifference;
+		}
+	};
+}
+
+TEST_F(HalleyAudioClipStream, ConcurrentVoicesDecodeIndependently)
+{
+	// The second voice is far enough behind the first that a decoder shared between them would keep seeking back and forth
+	constexpr size_t delay = 40000;
+	ExecutionQueue diskIO;
+	Executor decoder(diskIO);
+	const auto first = std::make_shared<AudioClipStreamer>(stream, &diskIO);
+	const auto second = std::make_shared<AudioClipStreamer>(stream, &diskIO);
+
+	for (size_t pos = 0; pos + bufferSize <= reference[0].size(); pos += bufferSize) {
+		ASSERT_LT(getDifference(read(*first, pos), pos), 0.0001f) << pos;
+		if (pos >= delay) {
+			ASSERT_LT(getDifference(read(*second, pos - delay), pos - delay), 0.0001f) << pos;
+		}
+		decoder.runPending();
+	}
+
+	EXPECT_EQ(first->getUnderruns(), 0u);
+	EXPECT_EQ(second->getUnderruns(), 0u);
+	EXPECT_EQ(stream->getUnderruns(), 0u);
+}
+
+TEST_F(HalleyAudioClipStream, SeekUnderrunsUntilDecoded)
+{
+	ExecutionQueue diskIO;
+	Executor decoder(diskIO);
+	const auto streamer = std::make_shared<AudioClipStreamer>(stream, &diskIO);
+
+	EXPECT_LT(getDifference(read(*streamer, 0), 0), 0.0001f);
+	decoder.runPending();
+
+	// Jumping past what's been decoded plays silence, rather than waiting for the decoder to get there
+	constexpr size_t seekPos = 60000;
+	EXPECT_LT(getDifference(read(*streamer, seekPos), std::nullopt), 0.0001f);
+	EXPECT_LT(getDifference(read(*streamer, seekPos + bufferSize), std::nullopt), 0.0001f);
+	EXPECT_EQ(streamer->getUnderruns(), 2u);
+
+	// Once it has, playback carries on from where it's got to
+	decoder.runPending();
+	for (size_t pos = seekPos + 2 * bufferSize; pos < seekPos + 100 * bufferSize; pos += bufferSize) {
+		ASSERT_LT(getDifference(read(*streamer, pos), pos), 0.0001f) << pos;
+		decoder.runPending();
+	}
+	EXPECT_EQ(streamer->getUnderruns(), 2u);
+	EXPECT_EQ(stream->getUnderruns(), 2u);
+}
+
+TEST_F(HalleyAudioClipStream, DecodesOnTheReadingThreadWithoutExecutors)
+{
+	ASSERT_FALSE(Executors::hasInstance());
+	auto clip = std::make_shared<AudioClip>(uint8_t(numChannels));
+	clip->loadFromStream(data, Metadata());
+
+	// Each voice gets its own reader, which decodes whatever it's missing straight away
+	AudioSourceClip first(clip, false, 0);
+	AudioSourceClip second(clip, false, 0);
+	EXPECT_LT(getDifference(read(first), 0), 0.0001f);
+
+	constexpr size_t skip = 60000;
+	first.skipAudioData(skip);
+	for (size_t i = 0; i < 100; ++i) {
+		const size_t pos = (i + 1) * bufferSize + skip;
+		ASSERT_LT(getDifference(read(first), pos), 0.0001f) << pos;
+		ASSERT_LT(getDifference(read(second), i * bufferSize), 0.0001f) << pos;
+	}
+	EXPECT_EQ(clip->getStreamUnderruns(), 0u);
+}
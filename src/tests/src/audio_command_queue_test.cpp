@@ -0,0 +1,263 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include <array>
+#include "audio_command_queue.h"
+#include "audio_engine.h"
+#include "audio_event.h"
+#include "audio_facade.h"
+#include "audio_handle_impl.h"
+#include "audio_offline_renderer.h"
+#include "heap_allocation_counter.h"
+using namespace Halley;
+
+namespace {
+	class SilentClip final : public IAudioClip {
+	public:
+		size_t copyChannelData(size_t channelN, size_t pos, size_t len, gsl::span<AudioConfig::SampleFormat> dst) const override
+		{
+			for (size_t i = 0; i < len; ++i) {
+				dst[i] = 0.0f;
+			}
+			return len;
+		}
+
+		uint8_t getNumberOfChannels() const override { return 1; }
+		size_t getLength() const override { return 48000; }
+	};
+
+	class TestAudioDevice final : public AudioDevice {
+	public:
+		String getName() const override { return "Test"; }
+	};
+
+	// A device which only asks for audio when the test says so
+	class TestAudioOutput final : public AudioOutputAPI {
+	public:
+		Vector<std::unique_ptr<const AudioDevice>> getAudioDevices() override
+		{
+			Vector<std::unique_ptr<const AudioDevice>> result;
+			result.push_back(std::make_unique<TestAudioDevice>());
+			return result;
+		}
+
+		AudioSpec openAudioDevice(const AudioSpec& requestedFormat, const AudioDevice* device, AudioCallback prepareAudioCallback) override
+		{
+			callback = std::move(prepareAudioCallback);
+			return requestedFormat;
+		}
+
+		void closeAudioDevice() override { callback = {}; }
+		void startPlayback() override {}
+		void stopPlayback() override {}
+		bool needsMoreAudio() override { return true; }
+		bool needsAudioThread() const override { return false; }
+
+		void onAudioAvailable() override
+		{
+			auto& src = getAudioOutputInterface();
+			buffer.resize(src.getAvailable());
+			src.output(gsl::span<gsl::byte>(buffer.data(), buffer.size()), false);
+		}
+
+		void step()
+		{
+			callback();
+		}
+
+	private:
+		AudioCallback callback;
+		std::vector<gsl::byte> buffer;
+	};
+
+	class TestSystemAPI final : public SystemAPI {
+	public:
+		Path getAssetsPath(const Path& gamePath) const override { return {}; }
+		Path getUnpackedAssetsPath(const Path& gamePath) const override { return {}; }
+		std::unique_ptr<ResourceDataReader> getDataReader(String path, int64_t start, int64_t end) override { return {}; }
+		std::unique_ptr<GLContext> createGLContext() override { return {}; }
+		std::shared_ptr<Window> createWindow(const WindowDefinition& window) override { return {}; }
+		void destroyWindow(std::shared_ptr<Window> window) override {}
+		Vector2i getScreenSize(int n) const override { return {}; }
+		Rect4i getDisplayRect(int screen) const override { return {}; }
+		void showCursor(bool show) override {}
+		std::shared_ptr<ISaveData> getStorageContainer(SaveDataType type, const String& containerName) override { return {}; }
+
+	private:
+		bool generateEvents(VideoAPI* video, InputAPI* input) override { return true; }
+	};
+
+	class HalleyAudioFacade : public ::testing::Test {
+	protected:
+		TestAudioOutput output;
+		TestSystemAPI system;
+		HalleyAPI api {};
+		Resources resources { std::unique_ptr<ResourceLocator>(), api, {} };
+		std::shared_ptr<AudioEvent> event = std::make_shared<AudioEvent>();
+		AudioFacade facade { output, system };
+
+		void SetUp() override
+		{
+			resources.init<AudioEvent>();
+			resources.of<AudioEvent>().setResource(0, "test", event);
+			facade.setResources(resources);
+			facade.startPlayback(0);
+			ASSERT_TRUE(facade.getAudioSpec());
+		}
+
+		// Finished sounds are reported on the step after they run, and picked up when pumped
+		void finishSounds()
+		{
+			output.step();
+			output.step();
+			facade.pump();
+		}
+	};
+}
+
+TEST(HalleyAudioCommandQueue, StressTenThousandPerFrame)
+{
+	constexpr size_t commandsPerFrame = 10000;
+	constexpr size_t numFrames = 8;
+	constexpr uint32_t numVoices = 64;
+
+	AudioOfflineRenderer renderer(AudioSpec(AudioConfig::sampleRate, 2, 512, AudioSampleFormat::Float));
+	auto& engine = renderer.getEngine();
+	AudioCommandQueue queue;
+	const std::shared_ptr<const IAudioClip> clip = std::make_shared<SilentClip>();
+
+	for (uint32_t id = 0; id < numVoices; ++id) {
+		auto command = AudioCommand(AudioCommand::Type::Play, id, 1.0f);
+		command.clip = clip;
+		command.position = AudioPosition::makeUI();
+		command.loop = true;
+		ASSERT_TRUE(queue.push(std::move(command)));
+	}
+	queue.execute(engine);
+	renderer.render(1);
+
+	std::array<float, numVoices> lastGains;
+	for (size_t frame = 0; frame < numFrames; ++frame) {
+		bool allQueued = true;
+		const HeapAllocationCounter allocationCounter;
+		for (size_t i = 0; i < commandsPerFrame; ++i) {
+			const auto id = uint32_t(i / 4 % numVoices);
+			const float value = float(frame * commandsPerFrame + i) / float(numFrames * commandsPerFrame);
+			switch (i % 4) {
+			case 0:
+				allQueued &= queue.push(AudioCommand(AudioCommand::Type::SetVoiceGain, id, value));
+				lastGains[id] = value;
+				break;
+			case 1:
+				{
+					auto command = AudioCommand(AudioCommand::Type::SetVoicePosition, id);
+					command.vector = Vector3f(value * 100.0f, 0.0f, 0.0f);
+					allQueued &= queue.push(std::move(command));
+				}
+				break;
+			case 2:
+				allQueued &= queue.push(AudioCommand(AudioCommand::Type::SetVoicePan, id, value * 2.0f - 1.0f));
+				break;
+			case 3:
+				{
+					auto command = AudioCommand(AudioCommand::Type::SetListener, 0, 100.0f);
+					command.vector = Vector3f(value, value, 0.0f);
+					allQueued &= queue.push(std::move(command));
+				}
+				break;
+			}
+		}
+		const size_t allocations = allocationCounter.getAllocations();
+
+		EXPECT_TRUE(allQueued);
+		EXPECT_EQ(allocations, 0u) << "frame " << frame;
+
+		EXPECT_EQ(queue.execute(engine), commandsPerFrame);
+		renderer.render(1);
+	}
+
+	// The last gain written for each voice is the one in effect
+	for (uint32_t id = 0; id < numVoices; ++id) {
+		const auto& voices = engine.getSources(id);
+		ASSERT_EQ(voices.size(), 1u);
+		EXPECT_EQ(voices[0]->getUserGain(), lastGains[id]);
+	}
+}
+
+TEST(HalleyAudioCommandQueue, RunsInOrderAndDropsWhenFull)
+{
+	AudioOfflineRenderer renderer(AudioSpec(AudioConfig::sampleRate, 2, 512, AudioSampleFormat::Float));
+	AudioCommandQueue queue(4);
+	std::vector<int> order;
+
+	for (int i = 0; i < 6; ++i) {
+		auto command = AudioCommand(AudioCommand::Type::Action);
+		command.action = std::make_unique<std::function<void()>>([&order, i] () { order.push_back(i); });
+		EXPECT_EQ(queue.push(std::move(command)), i < 4);
+	}
+	EXPECT_EQ(queue.getNumPending(), 4u);
+
+	EXPECT_EQ(queue.execute(renderer.getEngine()), 4u);
+	EXPECT_EQ(order, std::vector<int>({ 0, 1, 2, 3 }));
+	EXPECT_EQ(queue.getNumPending(), 0u);
+}
+
+TEST(HalleyAudioCommandQueue, HandlePoolRecyclesBlocks)
+{
+	auto pool = std::make_shared<AudioHandlePool>();
+	auto a = std::allocate_shared<int>(AudioHandleAllocator<int>(pool), 1);
+	const void* first = a.get();
+	a.reset();
+
+	const HeapAllocationCounter allocationCounter;
+	auto b = std::allocate_shared<int>(AudioHandleAllocator<int>(pool), 2);
+	EXPECT_EQ(allocationCounter.getAllocations(), 0u);
+	EXPECT_EQ(b.get(), first);
+}
+
+TEST_F(HalleyAudioFacade, PostingDoesNotAllocate)
+{
+	const std::shared_ptr<const IAudioClip> clip = std::make_shared<SilentClip>();
+	constexpr size_t numSounds = 128;
+
+	// Warm up the handle pool and the list of playing sounds
+	for (size_t i = 0; i < numSounds; ++i) {
+		facade.postEvent("test", AudioPosition::makeUI());
+	}
+	finishSounds();
+
+	std::vector<AudioHandle> handles;
+	handles.reserve(numSounds);
+	handles.push_back(facade.postEvent("test", AudioPosition::makeUI()));
+
+	const HeapAllocationCounter allocationCounter;
+	for (size_t i = 1; i < numSounds; ++i) {
+		if (i % 2 == 0) {
+			handles.push_back(facade.postEvent("test", AudioPosition::makeUI()));
+		} else {
+			auto clipRef = clip;
+			handles.push_back(facade.play(std::move(clipRef), AudioPosition::makeUI(), 1.0f, false));
+		}
+	}
+	EXPECT_EQ(allocationCounter.getAllocations(), 0u);
+
+	for (const auto& handle: handles) {
+		EXPECT_TRUE(handle->isPlaying());
+	}
+}
+
+TEST_F(HalleyAudioFacade, ReleasesEventsOnceFinished)
+{
+	const auto unused = event.use_count();
+
+	// The event has no actions, so its sounds finish as soon as they run
+	auto a = facade.postEvent("test", AudioPosition::makeUI());
+	auto b = facade.postEvent("test", AudioPosition::makeUI());
+	EXPECT_TRUE(a->isPlaying());
+	EXPECT_TRUE(b->isPlaying());
+	EXPECT_GT(event.use_count(), unused);
+
+	finishSounds();
+	EXPECT_FALSE(a->isPlaying());
+	EXPECT_FALSE(b->isPlaying());
+	EXPECT_EQ(event.use_count(), unused);
+}
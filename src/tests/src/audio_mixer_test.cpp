@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include "audio_mixer.h"
+#include "audio_mixer_sse.h"
+#include "audio_mixer_avx.h"
+using namespace Halley;
+
+namespace {
+	constexpr size_t numPacks = 32;
+
+	std::vector<std::unique_ptr<AudioMixer>> makeSIMDMixers()
+	{
+		std::vector<std::unique_ptr<AudioMixer>> result;
+#ifdef HAS_SSE
+		result.push_back(std::make_unique<AudioMixerSSE>());
+#endif
+#ifdef HAS_AVX
+		if (AudioMixer::hasAVX2()) {
+			result.push_back(std::make_unique<AudioMixerAVX>());
+		}
+#endif
+		return result;
+	}
+
+	AudioBuffer makeBuffer(size_t nPacks, uint32_t seed)
+	{
+		Random rng(seed);
+		AudioBuffer buffer;
+		buffer.packs.resize(nPacks);
+		for (auto& pack: buffer.packs) {
+			for (auto& sample: pack.samples) {
+				sample = rng.getFloat(-1.2f, 1.2f);
+			}
+		}
+		return buffer;
+	}
+
+	void expectNear(const AudioBuffer& a, const AudioBuffer& b, float tolerance)
+	{
+		ASSERT_EQ(a.packs.size(), b.packs.size());
+		for (size_t i = 0; i < a.packs.size(); ++i) {
+			for (size_t j = 0; j < AudioSamplePack::NumSamples; ++j) {
+				EXPECT_NEAR(a.packs[i].samples[j], b.packs[i].samples[j], tolerance) << "sample " << (i * AudioSamplePack::NumSamples + j);
+			}
+		}
+	}
+}
+
+TEST(HalleyAudioMixer, MixAudio)
+{
+	AudioMixer scalar;
+	const auto src = makeBuffer(numPacks, 1);
+
+	for (auto& mixer: makeSIMDMixers()) {
+		for (auto gains: { std::pair<float, float>(0.7f, 0.7f), std::pair<float, float>(0.2f, 0.9f) }) {
+			auto expected = makeBuffer(numPacks, 2);
+			auto result = makeBuffer(numPacks, 2);
+			scalar.mixAudio(src.packs, expected.packs, gains.first, gains.second);
+			mixer->mixAudio(src.packs, result.packs, gains.first, gains.second);
+			expectNear(expected, result, 1e-5f);
+		}
+	}
+}
+
+TEST(HalleyAudioMixer, SumAudio)
+{
+	AudioMixer scalar;
+	const auto src = makeBuffer(numPacks, 3);
+
+	for (auto& mixer: makeSIMDMixers()) {
+		auto expected = makeBuffer(numPacks, 4);
+		auto result = makeBuffer(numPacks, 4);
+		scalar.sumAudio(src.packs, expected.packs);
+		mixer->sumAudio(src.packs, result.packs);
+		expectNear(expected, result, 0.0f);
+	}
+}
+
+TEST(HalleyAudioMixer, InterleaveChannels)
+{
+	AudioMixer scalar;
+	auto left = makeBuffer(numPacks, 5);
+	auto right = makeBuffer(numPacks, 6);
+	std::array<AudioBuffer*, 2> srcs = { &left, &right };
+
+	AudioBuffer expected;
+	expected.packs.resize(numPacks * 2);
+	scalar.interleaveChannels(expected.packs, srcs);
+	EXPECT_EQ(expected.packs[0].samples[0], left.packs[0].samples[0]);
+	EXPECT_EQ(expected.packs[0].samples[1], right.packs[0].samples[0]);
+
+	for (auto& mixer: makeSIMDMixers()) {
+		AudioBuffer result;
+		result.packs.resize(numPacks * 2);
+		mixer->interleaveChannels(result.packs, srcs);
+		expectNear(expected, result, 0.0f);
+	}
+}
+
+TEST(HalleyAudioMixer, CompressRange)
+{
+	AudioMixer scalar;
+	auto expected = makeBuffer(numPacks, 7);
+	scalar.compressRange(expected.packs);
+
+	for (auto& mixer: makeSIMDMixers()) {
+		auto result = makeBuffer(numPacks, 7);
+		mixer->compressRange(result.packs);
+		expectNear(expected, result, 0.0f);
+	}
+}
+
+TEST(HalleyAudioMixer, ConvertToInt)
+{
+	AudioMixer scalar;
+	auto buffer = makeBuffer(numPacks, 8);
+	scalar.compressRange(buffer.packs);
+
+	// Odd length, to go through the scalar tail of the vector paths
+	const auto src = gsl::span<const float>(buffer.packs.data()->samples.data(), numPacks * AudioSamplePack::NumSamples).subspan(0, numPacks * AudioSamplePack::NumSamples - 3);
+
+	std::vector<short> expected16(src.size());
+	std::vector<int> expected32(src.size());
+	scalar.convertToInt16(src, expected16);
+	scalar.convertToInt32(src, expected32);
+
+	for (auto& mixer: makeSIMDMixers()) {
+		std::vector<short> result16(src.size());
+		std::vector<int> result32(src.size());
+		mixer->convertToInt16(src, result16);
+		mixer->convertToInt32(src, result32);
+		EXPECT_EQ(expected16, result16);
+		EXPECT_EQ(expected32, result32);
+	}
+}
@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include "audio_engine.h"
+#include "audio_filter_resample.h"
+#include "audio_offline_renderer.h"
+#include "audio_source_clip.h"
+using namespace Halley;
+
+namespace {
+	class ToneClip final : public IAudioClip {
+	public:
+		ToneClip(uint8_t numChannels, size_t length, float frequency)
+			: numChannels(numChannels)
+		{
+			samples.resize(length);
+			for (size_t i = 0; i < length; ++i) {
+				samples[i] = 0.25f * std::sin(2.0f * 3.14159265f * frequency * float(i) / AudioConfig::sampleRate);
+			}
+		}
+
+		size_t copyChannelData(size_t channelN, size_t pos, size_t len, gsl::span<AudioConfig::SampleFormat> dst) const override
+		{
+			const size_t n = std::min(len, samples.size() - std::min(pos, samples.size()));
+			for (size_t i = 0; i < n; ++i) {
+				dst[i] = samples[pos + i];
+			}
+			return n;
+		}
+
+		uint8_t getNumberOfChannels() const override { return numChannels; }
+		size_t getLength() const override { return samples.size(); }
+
+	private:
+		uint8_t numChannels;
+		std::vector<AudioConfig::SampleFormat> samples;
+	};
+
+	Bytes renderTone(AudioSpec spec)
+	{
+		AudioOfflineRenderer renderer(spec);
+		renderer.setRecording(true);
+		renderer.getEngine().play(1, std::make_shared<ToneClip>(1, 4800, 440.0f), AudioPosition::makeUI(), 1.0f, false);
+		renderer.renderSeconds(0.2f);
+		return renderer.makeWAV();
+	}
+
+	// Renders a mix of plain and resampled voices, spread over the given number of mix workers
+	std::vector<float> renderVoices(size_t numWorkers)
+	{
+		AudioOfflineRenderer renderer(AudioSpec(AudioConfig::sampleRate, 2, 512, AudioSampleFormat::Float));
+		renderer.setRecording(true);
+		auto& engine = renderer.getEngine();
+		engine.setMixWorkers(numWorkers, [] (String name, std::function<void()> f) { return std::thread(std::move(f)); });
+
+		for (size_t i = 0; i < 64; ++i) {
+			const auto clip = std::make_shared<ToneClip>(uint8_t(1 + i % 2), 12000, 110.0f + float(i) * 10.0f);
+			std::shared_ptr<AudioSource> source = std::make_shared<AudioSourceClip>(clip, true, 0);
+			if (i % 3 == 0) {
+				source = std::make_shared<AudioFilterResample>(source, 44100 + int(i) * 100, AudioConfig::sampleRate);
+			}
+			const auto position = AudioPosition::makePositional(Vector2f(float(i % 8) * 50.0f - 200.0f, 0.0f));
+			engine.addEmitter(uint32_t(i), std::make_unique<AudioVoice>(source, position, 0.1f, uint8_t(engine.getGroupId(""))));
+		}
+		renderer.render(16);
+
+		const auto recording = renderer.getRecording();
+		const auto* samples = reinterpret_cast<const float*>(recording.data());
+		return std::vector<float>(samples, samples + recording.size() / sizeof(float));
+	}
+}
+
+TEST(HalleyAudioOfflineRender, RendersWAV)
+{
+	const auto spec = AudioSpec(AudioConfig::sampleRate, 2, 512, AudioSampleFormat::Int16);
+	const auto wav = renderTone(spec);
+	ASSERT_GT(wav.size(), 44u);
+	EXPECT_EQ(String(reinterpret_cast<const char*>(wav.data()), 4), "RIFF");
+	EXPECT_EQ(String(reinterpret_cast<const char*>(wav.data() + 8), 4), "WAVE");
+
+	// The tone is 0.1s long, so the first half of the render is loud and the end is silent
+	const auto* samples = reinterpret_cast<const int16_t*>(wav.data() + 44);
+	const size_t numSamples = (wav.size() - 44) / 2;
+	EXPECT_GE(numSamples, size_t(0.2f * spec.sampleRate * spec.numChannels));
+	int16_t peakStart = 0;
+	int16_t peakEnd = 0;
+	for (size_t i = 0; i < numSamples; ++i) {
+		const auto level = int16_t(std::abs(samples[i]));
+		if (i < numSamples / 4) {
+			peakStart = std::max(peakStart, level);
+		} else if (i > numSamples * 3 / 4) {
+			peakEnd = std::max(peakEnd, level);
+		}
+	}
+	EXPECT_GT(peakStart, 1000);
+	EXPECT_EQ(peakEnd, 0);
+
+	// Nothing in the mix depends on timing, so rendering again gives the exact same output
+	EXPECT_EQ(renderTone(spec), wav);
+}
+
+TEST(HalleyAudioOfflineRender, MixWorkersMatchSerialMix)
+{
+	const auto serial = renderVoices(1);
+	const auto parallel = renderVoices(4);
+	ASSERT_EQ(serial.size(), parallel.size());
+	ASSERT_FALSE(serial.empty());
+
+	// Workers sum their voices separately before adding them to the output, so only the rounding differs
+	float maxDifference = 0.0f;
+	for (size_t i = 0; i < serial.size(); ++i) {
+		maxDifference = std::max(maxDifference, std::abs(serial[i] - parallel[i]));
+	}
+	EXPECT_LT(maxDifference, 1e-5f);
+
+	// The reduction always happens in the same order, so the parallel mix is exactly reproducible
+	EXPECT_EQ(parallel, renderVoices(4));
+}
+
+TEST(HalleyAudioOfflineRender, Benchmark)
+{
+	// Throughput of the mixer, as the number of voices a single core could keep up with in real time
+	// Covers mono and stereo clips, streamed clips, pitch resampling, and resampling the output to 44.1 kHz
+	constexpr size_t numVoices = 64;
+	constexpr float seconds = 1.0f;
+
+	AudioOfflineRenderer renderer(AudioSpec(44100, 2, 512, AudioSampleFormat::Int16));
+	auto& engine = renderer.getEngine();
+	const auto clips = std::array<std::shared_ptr<const IAudioClip>, 3>{
+		std::make_shared<ToneClip>(1, 12000, 220.0f),
+		std::make_shared<ToneClip>(2, 24000, 330.0f),
+		std::make_shared<ToneClip>(1, 48000, 440.0f)
+	};
+
+	std::vector<float> streamData(size_t(2 * (seconds + 0.5f) * AudioConfig::sampleRate), 0.1f);
+	for (size_t i = 0; i < numVoices; ++i) {
+		const auto id = uint32_t(i);
+		const auto position = AudioPosition::makePositional(Vector2f(float(i % 8) * 50.0f - 200.0f, 0.0f));
+		std::shared_ptr<AudioSource> source;
+		switch (i % 4) {
+		case 0:
+		case 1:
+			source = std::make_shared<AudioSourceClip>(clips[i % 3], true, 0);
+			break;
+		case 2:
+			source = std::make_shared<AudioFilterResample>(std::make_shared<AudioSourceClip>(clips[i % 3], true, 0), 52000, AudioConfig::sampleRate);
+			break;
+		case 3:
+			{
+				auto stream = std::make_shared<StreamingAudioClip>(2);
+				stream->addInterleavedSamples(streamData);
+				source = std::make_shared<AudioSourceClip>(stream, false, 0);
+			}
+			break;
+		}
+		engine.addEmitter(id, std::make_unique<AudioVoice>(source, position, 0.1f, uint8_t(engine.getGroupId(""))));
+	}
+
+	renderer.render(4); // Warm up the buffer pool
+	renderer.resetStats();
+	renderer.renderSeconds(seconds);
+
+	const auto stats = renderer.getStats();
+	EXPECT_GT(stats.numBuffers, 0u);
+
+	// Loose enough to hold on a slow or busy machine, but a mixer that can't keep up with real time is broken
+	EXPECT_GT(stats.getRealtimeFactor(), 1.0);
+
+	// Reported in the test results, rather than printed
+	const double voicesPerCore = numVoices * stats.getRealtimeFactor() / engine.getNumMixWorkers();
+	RecordProperty("meanBufferMicroseconds", int(stats.meanTime * 1000000.0));
+	RecordProperty("p99BufferMicroseconds", int(stats.p99Time * 1000000.0));
+	RecordProperty("voicesPerCore", int(voicesPerCore));
+}
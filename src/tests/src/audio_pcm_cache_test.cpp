@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+using namespace Halley;
+
+namespace {
+	AudioPCMCache::Decoder makeDecoder(size_t numSamples, int& numDecodes)
+	{
+		return [numSamples, &numDecodes] ()
+		{
+			++numDecodes;
+			AudioPCMData data;
+			data.samples.resize(1);
+			data.samples[0].resize(numSamples, 0.5f);
+			return data;
+		};
+	}
+}
+
+TEST(HalleyAudioPCMCache, DecodesOnce)
+{
+	AudioPCMCache cache(1024 * 1024);
+	int numDecodes = 0;
+
+	auto a = cache.getOrDecode({ "footstep", 1 }, makeDecoder(100, numDecodes));
+	auto b = cache.getOrDecode({ "footstep", 1 }, makeDecoder(100, numDecodes));
+	EXPECT_EQ(numDecodes, 1);
+	EXPECT_EQ(a, b);
+	EXPECT_EQ(cache.getNumHits(), 1u);
+	EXPECT_EQ(cache.getNumMisses(), 1u);
+	EXPECT_EQ(cache.getSizeBytes(), 100 * sizeof(float));
+
+	// A new version of the asset is a different entry
+	auto c = cache.getOrDecode({ "footstep", 2 }, makeDecoder(100, numDecodes));
+	EXPECT_EQ(numDecodes, 2);
+	EXPECT_NE(a, c);
+	EXPECT_EQ(cache.getNumEntries(), 2u);
+}
+
+TEST(HalleyAudioPCMCache, EvictsLeastRecentlyUsed)
+{
+	constexpr size_t clipSamples = 256;
+	AudioPCMCache cache(3 * clipSamples * sizeof(float));
+	int numDecodes = 0;
+
+	for (const auto* name: { "a", "b", "c" }) {
+		cache.getOrDecode({ name, 0 }, makeDecoder(clipSamples, numDecodes));
+	}
+	cache.getOrDecode({ "a", 0 }, makeDecoder(clipSamples, numDecodes)); // Touch "a", so "b" is now the oldest
+	EXPECT_EQ(numDecodes, 3);
+
+	cache.getOrDecode({ "d", 0 }, makeDecoder(clipSamples, numDecodes));
+	EXPECT_EQ(cache.getNumEntries(), 3u);
+	EXPECT_LE(cache.getSizeBytes(), cache.getBudget());
+
+	cache.getOrDecode({ "a", 0 }, makeDecoder(clipSamples, numDecodes));
+	EXPECT_EQ(numDecodes, 4);
+	cache.getOrDecode({ "b", 0 }, makeDecoder(clipSamples, numDecodes));
+	EXPECT_EQ(numDecodes, 5);
+}
+
+TEST(HalleyAudioPCMCache, KeepsEntriesInUse)
+{
+	constexpr size_t clipSamples = 256;
+	AudioPCMCache cache(clipSamples * sizeof(float));
+	int numDecodes = 0;
+
+	const auto held = cache.getOrDecode({ "held", 0 }, makeDecoder(clipSamples, numDecodes));
+	cache.getOrDecode({ "other", 0 }, makeDecoder(clipSamples, numDecodes));
+
+	// Over budget, but the only entry which can go is the one nobody holds
+	EXPECT_EQ(cache.getOrDecode({ "held", 0 }, makeDecoder(clipSamples, numDecodes)), held);
+	EXPECT_EQ(cache.getNumEntries(), 1u);
+	EXPECT_EQ(numDecodes, 2);
+
+	cache.clear();
+	EXPECT_EQ(cache.getNumEntries(), 1u);
+	EXPECT_FALSE(cache.canCache(2 * clipSamples * sizeof(float)));
+}
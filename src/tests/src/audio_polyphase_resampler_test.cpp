@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include "audio_polyphase_resampler.h"
+using namespace Halley;
+
+namespace {
+	constexpr double pi = 3.14159265358979323846;
+
+	// Pulls blocks of output the way AudioFilterResample does, feeding a sine of the given frequency in
+	std::vector<float> resampleSine(int from, int to, double frequency, AudioResamplerQuality quality)
+	{
+		AudioPolyphaseResampler resampler(from, to, 1, quality);
+		std::vector<float> result;
+		size_t inputPos = 0;
+		for (size_t block = 0; block < 40; ++block) {
+			const size_t numOutput = 480 + block % 7;
+			std::vector<float> input(resampler.getInputSamplesNeeded(numOutput));
+			for (size_t i = 0; i < input.size(); ++i) {
+				input[i] = float(std::sin(2.0 * pi * frequency * double(inputPos + i) / from));
+			}
+			inputPos += input.size();
+
+			std::vector<float> output(numOutput);
+			const auto written = resampler.resample(input, output, 0);
+			EXPECT_EQ(written.nRead, input.size());
+			EXPECT_EQ(written.nWritten, numOutput);
+			result.insert(result.end(), output.begin(), output.end());
+		}
+		return result;
+	}
+
+	// The resampler has no delay, so the output should match the same sine sampled at the new rate, once past the initial ramp
+	double getMaxError(const std::vector<float>& samples, int rate, double frequency)
+	{
+		double maxError = 0;
+		for (size_t i = 64; i < samples.size(); ++i) {
+			maxError = std::max(maxError, std::abs(samples[i] - std::sin(2.0 * pi * frequency * double(i) / rate)));
+		}
+		return maxError;
+	}
+}
+
+TEST(HalleyAudioPolyphaseResampler, PreservesSignal)
+{
+	for (const auto ratio: { std::pair<int, int>(48000, 48000), std::pair<int, int>(24000, 48000), std::pair<int, int>(44100, 48000), std::pair<int, int>(48000, 44100), std::pair<int, int>(48123, 48000), std::pair<int, int>(4800, 48000) }) {
+		const auto samples = resampleSine(ratio.first, ratio.second, 440.0, AudioResamplerQuality::Medium);
+		EXPECT_LT(getMaxError(samples, ratio.second, 440.0), 0.002) << ratio.first << " -> " << ratio.second;
+	}
+
+	const auto highQuality = resampleSine(24000, 48000, 1000.0, AudioResamplerQuality::High);
+	EXPECT_LT(getMaxError(highQuality, 48000, 1000.0), 0.0001);
+}
+
+TEST(HalleyAudioPolyphaseResampler, RejectsAliasing)
+{
+	// A 30 kHz tone can't be represented at 48 kHz, and would otherwise fold back down to 18 kHz
+	const auto samples = resampleSine(96000, 48000, 30000.0, AudioResamplerQuality::High);
+	double sum = 0;
+	for (size_t i = 64; i < samples.size(); ++i) {
+		sum += samples[i] * samples[i];
+	}
+	EXPECT_LT(std::sqrt(sum / (samples.size() - 64)), 0.01);
+}
+
+TEST(HalleyAudioPolyphaseResampler, Interleaved)
+{
+	constexpr size_t numFrames = 256;
+	AudioPolyphaseResampler interleaved(48000, 44100, 2, AudioResamplerQuality::Fast);
+	AudioPolyphaseResampler separate(48000, 44100, 2, AudioResamplerQuality::Fast);
+
+	std::vector<float> src(numFrames * 2);
+	std::array<std::vector<float>, 2> channels;
+	for (size_t i = 0; i < numFrames; ++i) {
+		src[2 * i] = float(std::sin(double(i) * 0.05));
+		src[2 * i + 1] = float(std::cos(double(i) * 0.07));
+		channels[0].push_back(src[2 * i]);
+		channels[1].push_back(src[2 * i + 1]);
+	}
+
+	std::vector<float> dst(numFrames * 2);
+	const auto result = interleaved.resampleInterleaved(src, dst);
+	EXPECT_EQ(result.nRead, numFrames);
+	for (size_t ch = 0; ch < 2; ++ch) {
+		std::vector<float> expected(numFrames);
+		const auto channelResult = separate.resample(channels[ch], expected, ch);
+		ASSERT_EQ(channelResult.nWritten, result.nWritten);
+		for (size_t i = 0; i < result.nWritten; ++i) {
+			EXPECT_EQ(dst[2 * i + ch], expected[i]);
+		}
+	}
+}
@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include <thread>
+#include "audio_variable_table.h"
+using namespace Halley;
+
+TEST(HalleyAudioVariableTable, InternsNames)
+{
+	const int speed = AudioVariableTable::getId("test_speed");
+	const int rpm = AudioVariableTable::getId("test_rpm");
+	EXPECT_NE(speed, rpm);
+	EXPECT_EQ(AudioVariableTable::getId("test_speed"), speed);
+
+	AudioVariableTable table;
+	EXPECT_EQ(table.get(speed), 0.0f);
+	table.set(speed, 0.5f);
+	table.set("test_rpm", 3000.0f);
+	EXPECT_EQ(table.get("test_speed"), 0.5f);
+	EXPECT_EQ(table.get(rpm), 3000.0f);
+	EXPECT_EQ(table.get(AudioVariableTable::invalidId), 0.0f);
+
+	// Ids are shared by every table, values are not
+	AudioVariableTable other;
+	EXPECT_EQ(other.get(speed), 0.0f);
+}
+
+TEST(HalleyAudioVariableTable, ConcurrentAccess)
+{
+	AudioVariableTable table;
+	const int id = AudioVariableTable::getId("test_concurrent");
+	constexpr int numWrites = 100000;
+
+	// Every value written is a whole number, so a torn read would show up as anything else
+	std::thread writer([&] ()
+	{
+		for (int i = 1; i <= numWrites; ++i) {
+			table.set(id, float(i));
+		}
+	});
+
+	float last = 0;
+	bool consistent = true;
+	while (last < numWrites) {
+		const float value = table.get(id);
+		if (value != std::floor(value) || value < last) {
+			consistent = false;
+			break;
+		}
+		last = value;
+	}
+	writer.join();
+	EXPECT_TRUE(consistent);
+}
@@ -0,0 +1,207 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include "audio_engine.h"
+#include "audio_event.h"
+#include "audio_filter_resample.h"
+#include "audio_offline_renderer.h"
+#include "audio_source_clip.h"
+using namespace Halley;
+
+namespace {
+	class ConstantClip final : public IAudioClip {
+	public:
+		explicit ConstantClip(size_t length)
+			: length(length)
+		{}
+
+		size_t copyChannelData(size_t channelN, size_t pos, size_t len, gsl::span<AudioConfig::SampleFormat> dst) const override
+		{
+			const size_t n = std::min(len, length - std::min(pos, length));
+			for (size_t i = 0; i < n; ++i) {
+				dst[i] = 0.1f;
+			}
+			return n;
+		}
+
+		uint8_t getNumberOfChannels() const override { return 1; }
+		size_t getLength() const override { return length; }
+
+	private:
+		size_t length;
+	};
+
+	class SkipCounter final : public AudioSource {
+	public:
+		size_t skipped = 0;
+
+		uint8_t getNumberOfChannels() const override { return 1; }
+		bool getAudioData(size_t numSamples, AudioSourceData& dst) override { return true; }
+		bool canSkip() const override { return true; }
+
+		bool skipAudioData(size_t numSamples) override
+		{
+			skipped += numSamples;
+			return true;
+		}
+	};
+
+	class HalleyAudioVoiceLimits : public ::testing::Test {
+	protected:
+		AudioOfflineRenderer renderer;
+		AudioEngine& engine = renderer.getEngine();
+
+		AudioVoice& addVoice(uint32_t id, const AudioEvent& event, float gain = 1.0f, int priority = 0, const String& group = "", size_t length = AudioConfig::sampleRate)
+		{
+			auto source = std::make_shared<AudioSourceClip>(std::make_shared<ConstantClip>(length), false, 0);
+			auto voice = std::make_unique<AudioVoice>(source, AudioPosition::makeUI(), gain, uint8_t(engine.getGroupId(group)));
+			voice->setEventId(event.getEventId());
+			voice->setPriority(priority);
+			engine.addEmitter(id, std::move(voice));
+			return getVoice(id);
+		}
+
+		uint8_t getDefaultGroup()
+		{
+			return uint8_t(engine.getGroupId(""));
+		}
+
+		AudioVoice& getVoice(uint32_t id)
+		{
+			const auto& voices = engine.getSources(id);
+			Expects(voices.size() == 1);
+			return *voices[0];
+		}
+
+		static AudioEvent makeEvent(const String& yaml)
+		{
+			return AudioEvent(YAMLConvert::parseConfig(yaml));
+		}
+	};
+}
+
+TEST_F(HalleyAudioVoiceLimits, StealsOldest)
+{
+	const auto event = makeEvent("maxInstances: 2\nstealPolicy: oldest\n");
+	addVoice(1, event);
+	addVoice(2, event);
+	renderer.render(1);
+
+	EXPECT_TRUE(engine.reserveVoice(event, getDefaultGroup(), 0));
+	EXPECT_TRUE(getVoice(1).isStolen());
+	EXPECT_FALSE(getVoice(2).isStolen());
+}
+
+TEST_F(HalleyAudioVoiceLimits, StealsQuietest)
+{
+	const auto event = makeEvent("maxInstances: 3\nstealPolicy: quietest\n");
+	addVoice(1, event, 0.5f);
+	addVoice(2, event, 0.1f);
+	addVoice(3, event, 1.0f);
+	renderer.render(1);
+
+	EXPECT_TRUE(engine.reserveVoice(event, getDefaultGroup(), 0));
+	EXPECT_FALSE(getVoice(1).isStolen());
+	EXPECT_TRUE(getVoice(2).isStolen());
+	EXPECT_FALSE(getVoice(3).isStolen());
+}
+
+TEST_F(HalleyAudioVoiceLimits, StealsLowestPriorityOnlyIfNotHigher)
+{
+	const auto event = makeEvent("maxInstances: 2\nstealPolicy: lowestPriority\n");
+	addVoice(1, event, 1.0f, 5);
+	addVoice(2, event, 1.0f, 3);
+	renderer.render(1);
+
+	// Every voice playing matters more than the new one
+	EXPECT_FALSE(engine.reserveVoice(event, getDefaultGroup(), 2));
+	EXPECT_FALSE(getVoice(1).isStolen());
+	EXPECT_FALSE(getVoice(2).isStolen());
+
+	EXPECT_TRUE(engine.reserveVoice(event, getDefaultGroup(), 4));
+	EXPECT_FALSE(getVoice(1).isStolen());
+	EXPECT_TRUE(getVoice(2).isStolen());
+}
+
+TEST_F(HalleyAudioVoiceLimits, InstanceLimits)
+{
+	// With no steal policy, the new voice is refused once the limit is reached
+	const auto limited = makeEvent("maxInstances: 1\nstealPolicy: none\n");
+	EXPECT_TRUE(engine.reserveVoice(limited, getDefaultGroup(), 0));
+	addVoice(1, limited);
+	EXPECT_FALSE(engine.reserveVoice(limited, getDefaultGroup(), 0));
+
+	// Voices from other events don't count towards the event's own limit, but do count towards the group's
+	const auto other = makeEvent("maxInstances: 1\nstealPolicy: none\n");
+	EXPECT_TRUE(engine.reserveVoice(other, getDefaultGroup(), 0));
+	const auto groupLimited = makeEvent("maxGroupInstances: 2\nstealPolicy: none\n");
+	const auto group = uint8_t(engine.getGroupId("sfx"));
+	addVoice(2, other, 1.0f, 0, "sfx");
+	EXPECT_TRUE(engine.reserveVoice(groupLimited, group, 0));
+	addVoice(3, limited, 1.0f, 0, "sfx");
+	EXPECT_FALSE(engine.reserveVoice(groupLimited, group, 0));
+	EXPECT_TRUE(engine.reserveVoice(groupLimited, getDefaultGroup(), 0));
+
+	// Stolen voices no longer count
+	const auto stealing = makeEvent("maxGroupInstances: 2\nstealPolicy: oldest\n");
+	EXPECT_TRUE(engine.reserveVoice(stealing, group, 0));
+	EXPECT_TRUE(getVoice(2).isStolen());
+	EXPECT_TRUE(engine.reserveVoice(groupLimited, group, 0));
+}
+
+TEST_F(HalleyAudioVoiceLimits, VirtualisesAndRestoresVoices)
+{
+	const auto event = makeEvent("priority: 0\n");
+	engine.setMaxRealVoices(2);
+	addVoice(1, event, 0.2f);
+	addVoice(2, event, 1.0f);
+	addVoice(3, event, 0.5f);
+	renderer.render(2);
+
+	// Only the two loudest voices are real
+	EXPECT_TRUE(getVoice(1).isVirtual());
+	EXPECT_FALSE(getVoice(2).isVirtual());
+	EXPECT_FALSE(getVoice(3).isVirtual());
+
+	// Once there's room again, the virtual voice becomes real
+	getVoice(2).stop();
+	renderer.render(2);
+	EXPECT_TRUE(engine.getSources(2).empty());
+	EXPECT_FALSE(getVoice(1).isVirtual());
+	EXPECT_FALSE(getVoice(3).isVirtual());
+}
+
+TEST_F(HalleyAudioVoiceLimits, VirtualVoicesKeepTime)
+{
+	// A virtual voice keeps advancing, so it ends at the same time as a real one started alongside it
+	const auto event = makeEvent("priority: 0\n");
+	const size_t length = renderer.getSpec().bufferSize * 10;
+	engine.setMaxRealVoices(1);
+	addVoice(1, event, 1.0f, 0, "", length);
+	addVoice(2, event, 0.1f, 0, "", length);
+
+	renderer.render(2);
+	EXPECT_TRUE(getVoice(2).isVirtual());
+
+	renderer.render(7);
+	EXPECT_FALSE(engine.getSources(1).empty());
+	EXPECT_FALSE(engine.getSources(2).empty());
+
+	renderer.render(2);
+	EXPECT_TRUE(engine.getSources(1).empty());
+	EXPECT_TRUE(engine.getSources(2).empty());
+}
+
+TEST(HalleyAudioFilterResample, SkipDoesNotDrift)
+{
+	// 44.1 kHz into 48 kHz doesn't divide evenly for a 512 sample buffer, so the remainder has to carry over
+	auto counter = std::make_shared<SkipCounter>();
+	AudioFilterResample resample(counter, 44100, 48000);
+
+	constexpr size_t numSkips = 1000;
+	constexpr size_t numSamples = 512;
+	for (size_t i = 0; i < numSkips; ++i) {
+		resample.skipAudioData(numSamples);
+	}
+
+	EXPECT_EQ(counter->skipped, numSkips * numSamples * 44100 / 48000);
+}
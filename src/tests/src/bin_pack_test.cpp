@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+using namespace Halley;
+
+TEST(HalleyBinPackShelfAllocator, PlacesAlongShelves)
+{
+	BinPackShelfAllocator allocator(Vector2i(64, 64));
+
+	// The first entry opens a shelf, and entries of a similar height follow it along
+	EXPECT_EQ(allocator.allocate(Vector2i(16, 16)), Rect4i(0, 0, 16, 16));
+	EXPECT_EQ(allocator.allocate(Vector2i(16, 12)), Rect4i(16, 0, 16, 12));
+
+	// Too tall for the shelf, so a new one opens below it
+	EXPECT_EQ(allocator.allocate(Vector2i(8, 20)), Rect4i(0, 16, 8, 20));
+
+	// Would waste more than half of either shelf, so it gets its own
+	EXPECT_EQ(allocator.allocate(Vector2i(8, 4)), Rect4i(0, 36, 8, 4));
+}
+
+TEST(HalleyBinPackShelfAllocator, NeverOverlaps)
+{
+	const auto binSize = Vector2i(128, 128);
+	BinPackShelfAllocator allocator(binSize);
+
+	Vector<Rect4i> rects;
+	for (int i = 0; i < 200; ++i) {
+		const auto size = Vector2i(4 + (i * 7) % 13, 4 + (i * 5) % 11);
+		if (const auto rect = allocator.allocate(size)) {
+			EXPECT_EQ(rect->getSize(), size);
+			EXPECT_GE(rect->getLeft(), 0);
+			EXPECT_GE(rect->getTop(), 0);
+			EXPECT_LE(rect->getRight(), binSize.x);
+			EXPECT_LE(rect->getBottom(), binSize.y);
+			rects.push_back(*rect);
+		}
+	}
+
+	ASSERT_FALSE(rects.empty());
+	for (size_t a = 0; a < rects.size(); ++a) {
+		for (size_t b = a + 1; b < rects.size(); ++b) {
+			EXPECT_FALSE(rects[a].overlaps(rects[b])) << a << " and " << b;
+		}
+	}
+}
+
+TEST(HalleyBinPackShelfAllocator, FillsUpAndOverflows)
+{
+	BinPackShelfAllocator allocator(Vector2i(32, 32));
+
+	// Entries which don't fit the bin at all are always rejected
+	EXPECT_FALSE(allocator.allocate(Vector2i(33, 8)));
+	EXPECT_FALSE(allocator.allocate(Vector2i(8, 33)));
+	EXPECT_FALSE(allocator.allocate(Vector2i(0, 8)));
+
+	// Exactly sixteen 8x8 entries fit
+	for (int i = 0; i < 16; ++i) {
+		EXPECT_TRUE(allocator.allocate(Vector2i(8, 8))) << i;
+	}
+	EXPECT_FALSE(allocator.allocate(Vector2i(8, 8)));
+	EXPECT_FALSE(allocator.allocate(Vector2i(1, 1)));
+
+	// Resetting makes the whole bin available again
+	allocator.reset();
+	EXPECT_EQ(allocator.allocate(Vector2i(32, 32)), Rect4i(0, 0, 32, 32));
+}
+
+TEST(HalleyBinPackShelfAllocator, FallsBackToAnyShelfWhenOutOfRows)
+{
+	BinPackShelfAllocator allocator(Vector2i(64, 32));
+
+	// Two shelves of incompatible heights leave too little room for a third
+	EXPECT_EQ(allocator.allocate(Vector2i(8, 20)), Rect4i(0, 0, 8, 20));
+	EXPECT_EQ(allocator.allocate(Vector2i(8, 9)), Rect4i(0, 20, 8, 9));
+
+	// A short entry would normally get its own shelf, but with no rows left it goes into the first one that fits
+	EXPECT_EQ(allocator.allocate(Vector2i(8, 4)), Rect4i(8, 0, 8, 4));
+}
@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include <filesystem>
+#include "painter_test_access.h"
+#include "test_render_resources.h"
+using namespace Halley;
+
+namespace {
+	DrawCallRecord makeDraw(const String& material, const String& texture, size_t numQuads, const String& target = "screen")
+	{
+		DrawCallRecord draw;
+		draw.material = material;
+		draw.textures.push_back(texture);
+		draw.numVertices = numQuads * 4;
+		draw.numIndices = numQuads * 6;
+		draw.renderTarget = target;
+		return draw;
+	}
+
+	void recordFrame(DrawCallAnalytics& analytics)
+	{
+		analytics.startFrame();
+
+		auto first = makeDraw("Halley/Sprite", "atlas0", 10);
+		first.shaderChanged = true;
+		analytics.recordDraw(first);
+		analytics.recordDraw(makeDraw("Halley/Sprite", "atlas1", 5));
+
+		auto clipped = makeDraw("Halley/Sprite", "atlas1", 2);
+		clipped.clip = Rect4i(0, 0, 32, 32);
+		analytics.recordDraw(clipped);
+
+		auto text = makeDraw("Halley/Text", "font", 20, "target#0");
+		text.shaderChanged = true;
+		analytics.recordDraw(text);
+
+		analytics.endFrame();
+	}
+
+	std::shared_ptr<Texture> makeTexture(const String& name, Vector2i size)
+	{
+		auto texture = std::make_shared<DummyTexture>(size);
+		texture->setAssetId(name);
+		return texture;
+	}
+
+	Sprite makeSprite(const std::shared_ptr<Material>& material, Vector2f pos)
+	{
+		return Sprite()
+			.setMaterial(material, false)
+			.setPivot(Vector2f())
+			.setSize(Vector2f(8, 8))
+			.setPosition(pos);
+	}
+}
+
+TEST(HalleyDrawCallAnalytics, Summary)
+{
+	DrawCallAnalytics analytics;
+	recordFrame(analytics);
+
+	const auto summary = analytics.getSummary();
+	EXPECT_EQ(analytics.getNumFramesRecorded(), 1u);
+	EXPECT_EQ(summary.drawCalls, 4u);
+	EXPECT_EQ(summary.vertices, 37u * 4);
+	EXPECT_EQ(summary.triangles, 37u * 2);
+	EXPECT_EQ(summary.materialSwitches, 2u);
+	EXPECT_EQ(summary.shaderSwitches, 2u);
+	EXPECT_EQ(summary.textureSwitches, 3u);
+	EXPECT_EQ(summary.renderTargetSwitches, 2u);
+	EXPECT_EQ(summary.clipChanges, 2u);
+}
+
+TEST(HalleyDrawCallAnalytics, OnlyCompletedFramesAreReported)
+{
+	DrawCallAnalytics analytics;
+	recordFrame(analytics);
+
+	analytics.startFrame();
+	analytics.recordDraw(makeDraw("Halley/Sprite", "atlas0", 1));
+
+	EXPECT_EQ(analytics.getDrawCalls().size(), 4u);
+	analytics.endFrame();
+	EXPECT_EQ(analytics.getDrawCalls().size(), 1u);
+	EXPECT_EQ(analytics.getNumFramesRecorded(), 2u);
+}
+
+TEST(HalleyDrawCallAnalytics, GoldenRoundTrip)
+{
+	DrawCallAnalytics analytics;
+	recordFrame(analytics);
+
+	const auto yaml = YAMLConvert::generateYAML(analytics.toConfigNode(), {});
+	const auto golden = YAMLConvert::parseConfig(yaml);
+	EXPECT_TRUE(analytics.compareWithGolden(golden).matches);
+
+	DrawCallAnalytics other;
+	other.startFrame();
+	other.recordDraw(makeDraw("Halley/Sprite", "atlas0", 10));
+	other.endFrame();
+
+	const auto result = other.compareWithGolden(golden);
+	EXPECT_FALSE(result.matches);
+	EXPECT_FALSE(result.differences.empty());
+}
+
+TEST(HalleyDrawCallAnalytics, SummaryOnlyGolden)
+{
+	DrawCallAnalytics analytics;
+	recordFrame(analytics);
+
+	ConfigNode::MapType golden;
+	golden["summary"] = analytics.getSummary().toConfigNode();
+	EXPECT_TRUE(analytics.compareWithGolden(ConfigNode(std::move(golden))).matches);
+}
+
+TEST(HalleyDrawCallAnalytics, GoldenFile)
+{
+	// Writing goes through the OS, which is normally set up by Core
+	OS os;
+	OS::setInstance(&os);
+
+	DrawCallAnalytics analytics;
+	recordFrame(analytics);
+
+	const auto path = Path(std::filesystem::temp_directory_path().string()) / "halley_draw_call_golden.yaml";
+	Path::removeFile(path);
+	EXPECT_FALSE(analytics.checkGoldenFile(path, DrawCallAnalytics::GoldenMode::Compare).matches);
+	EXPECT_TRUE(analytics.checkGoldenFile(path, DrawCallAnalytics::GoldenMode::Update).matches);
+	EXPECT_TRUE(analytics.checkGoldenFile(path, DrawCallAnalytics::GoldenMode::Compare).matches);
+	Path::removeFile(path);
+
+	OS::setInstance(nullptr);
+}
+
+TEST(HalleyDrawCallAnalytics, PainterScene)
+{
+	TestRenderResources resources({ makeSpriteMaterialYAML("Test/Sprite"), makeSpriteMaterialYAML("Test/Other") });
+	DrawCallAnalytics analytics;
+	AnalyticsPainter painter(resources.getResources(), analytics);
+
+	const auto atlas0 = makeTexture("atlas0", Vector2i(64, 64));
+	const auto atlas1 = makeTexture("atlas1", Vector2i(64, 64));
+	const auto sprite0 = resources.makeMaterial("Test/Sprite");
+	sprite0->set(0, atlas0);
+	const auto sprite1 = resources.makeMaterial("Test/Sprite");
+	sprite1->set(0, atlas1);
+	const auto other = resources.makeMaterial("Test/Other");
+	other->set(0, atlas1);
+
+	ScreenRenderTarget screen(Rect4i(0, 0, 64, 64));
+	TextureRenderTarget offscreen;
+	offscreen.setTarget(0, makeTexture("offscreen", Vector2i(32, 32)));
+	Camera camera;
+	auto screenContext = PainterTestAccess::makeRenderContext(painter, camera, screen);
+	auto offscreenContext = PainterTestAccess::makeRenderContext(painter, camera, offscreen);
+
+	PainterTestAccess::startRender(painter);
+	screenContext.bind([&] (Painter& p)
+	{
+		// Same shader throughout, but the texture changes, and then the clip
+		makeSprite(sprite0, Vector2f(0, 0)).draw(p);
+		makeSprite(sprite1, Vector2f(10, 0)).draw(p);
+		p.setClip(Rect4i(0, 0, 32, 32));
+		makeSprite(sprite1, Vector2f(20, 0)).draw(p);
+		p.setClip();
+
+		// Another material with the same texture, so only the shader changes
+		makeSprite(other, Vector2f(30, 0)).draw(p);
+	});
+	offscreenContext.bind([&] (Painter& p)
+	{
+		makeSprite(sprite0, Vector2f(0, 0)).draw(p);
+	});
+	PainterTestAccess::endRender(painter);
+
+	const auto& draws = analytics.getDrawCalls();
+	ASSERT_EQ(draws.size(), 5u);
+	EXPECT_EQ(draws[0].textures, Vector<String>{ "atlas0" });
+	EXPECT_EQ(draws[1].textures, Vector<String>{ "atlas1" });
+	EXPECT_FALSE(draws[1].clip.has_value());
+	EXPECT_TRUE(draws[2].clip.has_value());
+	EXPECT_FALSE(draws[3].clip.has_value());
+	EXPECT_EQ(draws[3].material, "Test/Other");
+	EXPECT_EQ(draws[4].renderTarget, "target#0");
+	for (size_t i = 0; i < 4; ++i) {
+		EXPECT_EQ(draws[i].renderTarget, "screen");
+		EXPECT_EQ(draws[i].numVertices, 4u);
+		EXPECT_EQ(draws[i].numIndices, 6u);
+	}
+
+	const auto summary = analytics.getSummary();
+	EXPECT_EQ(summary.drawCalls, 5u);
+	EXPECT_EQ(summary.vertices, 20u);
+	EXPECT_EQ(summary.triangles, 10u);
+	EXPECT_EQ(summary.materialSwitches, 3u); // Test/Sprite, Test/Other, Test/Sprite
+	EXPECT_EQ(summary.shaderSwitches, 3u);
+	EXPECT_EQ(summary.textureSwitches, 3u); // atlas0, atlas1, atlas0
+	EXPECT_EQ(summary.clipChanges, 2u);
+	EXPECT_EQ(summary.renderTargetSwitches, 2u);
+}
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include "dummy/dummy_system.h"
+#include "dummy/dummy_video.h"
+using namespace Halley;
+
+namespace {
+	std::unique_ptr<Image> makeImage(Vector2i size)
+	{
+		auto image = std::make_unique<Image>(Image::Format::RGBA, size);
+		image->clear(0xFFFFFFFF);
+		return image;
+	}
+
+	class HalleyDynamicAtlas : public ::testing::Test {
+	protected:
+		DummySystemAPI system;
+		DummyVideoAPI video { system };
+
+		// Room for exactly four 32x32 images
+		DynamicAtlas atlas { video, Vector2i(64, 64), 1, 0 };
+	};
+}
+
+TEST_F(HalleyDynamicAtlas, Add)
+{
+	const auto sprite = atlas.add("a", *makeImage(Vector2i(32, 16)));
+	ASSERT_NE(sprite, nullptr);
+	EXPECT_TRUE(atlas.has("a"));
+	EXPECT_FALSE(atlas.has("b"));
+	EXPECT_EQ(atlas.getNumPages(), 1u);
+	EXPECT_EQ(atlas.getNumEntries(), 1u);
+
+	const auto& entry = sprite->getSprite();
+	EXPECT_EQ(entry.size, Vector2f(32, 16));
+	EXPECT_EQ(entry.coords.getSize(), Vector2f(0.5f, 0.25f));
+	EXPECT_EQ(sprite->getSpriteSheet()->getTexture(), atlas.getPageTexture(0));
+
+	// Adding the same key again, or getting it, returns the same sprite
+	EXPECT_EQ(atlas.add("a", *makeImage(Vector2i(8, 8))), sprite);
+	EXPECT_EQ(atlas.get("a"), sprite);
+	EXPECT_EQ(atlas.get("b"), nullptr);
+	EXPECT_EQ(atlas.getNumEntries(), 1u);
+
+	// Too large for a page
+	EXPECT_EQ(atlas.add("huge", *makeImage(Vector2i(65, 8))), nullptr);
+	EXPECT_FALSE(atlas.has("huge"));
+}
+
+TEST_F(HalleyDynamicAtlas, EvictsLeastRecentlyUsedAndReusesItsSlot)
+{
+	Rect4f coordsC;
+	size_t idxC = 0;
+	std::shared_ptr<const SpriteResource> b;
+	for (const auto* key: { "a", "b", "c", "d" }) {
+		auto sprite = atlas.add(key, *makeImage(Vector2i(32, 32)));
+		ASSERT_NE(sprite, nullptr) << key;
+		if (String(key) == "b") {
+			b = sprite;
+		} else if (String(key) == "c") {
+			coordsC = sprite->getSprite().coords;
+			idxC = sprite->getIdx();
+		}
+	}
+	EXPECT_EQ(atlas.getNumEntries(), 4u);
+
+	// "a" is the oldest, but has been used since, and "b" is still held, so "c" goes
+	atlas.get("a");
+	const auto e = atlas.add("e", *makeImage(Vector2i(32, 32)));
+	ASSERT_NE(e, nullptr);
+	EXPECT_FALSE(atlas.has("c"));
+	EXPECT_TRUE(atlas.has("a"));
+	EXPECT_TRUE(atlas.has("b"));
+	EXPECT_TRUE(atlas.has("d"));
+	EXPECT_EQ(atlas.getNumPages(), 1u);
+	EXPECT_EQ(atlas.getNumEntries(), 4u);
+
+	// Both the space on the page and the sprite sheet entry are reused
+	EXPECT_EQ(e->getSprite().coords, coordsC);
+	EXPECT_EQ(e->getIdx(), idxC);
+	EXPECT_EQ(e->getSpriteSheet()->getSpriteCount(), 4u);
+}
+
+TEST_F(HalleyDynamicAtlas, HeldImagesAreNotEvicted)
+{
+	Vector<std::shared_ptr<const SpriteResource>> held;
+	for (const auto* key: { "a", "b", "c", "d" }) {
+		held.push_back(atlas.add(key, *makeImage(Vector2i(32, 32))));
+	}
+
+	EXPECT_EQ(atlas.add("e", *makeImage(Vector2i(32, 32))), nullptr);
+	EXPECT_EQ(atlas.getNumEntries(), 4u);
+
+	// Dropping the handle is what lets an image go, even if a sprite still shows it
+	Sprite sprite;
+	sprite.setSprite(*held[1]);
+	held[1].reset();
+	EXPECT_NE(atlas.add("e", *makeImage(Vector2i(32, 32))), nullptr);
+	EXPECT_FALSE(atlas.has("b"));
+}
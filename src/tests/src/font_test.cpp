@@ -0,0 +1,37 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+using namespace Halley;
+
+namespace {
+	Font::Glyph makeGlyph(int code)
+	{
+		const float x = float(code % 1000);
+		return Font::Glyph(code, Rect4f(x, 0, 1, 1), Vector2f(x, 2), Vector2f(), Vector2f(), Vector2f(x + 1, 0));
+	}
+}
+
+TEST(HalleyFont, GlyphLookup)
+{
+	Font font("test", "test.png", 10, 12, 12, 1, Vector2i(64, 64));
+	for (const int code: { 0, 65, 66, 0x4E2D, 0x1F600 }) {
+		font.addGlyph(makeGlyph(code));
+	}
+
+	// Replacing a glyph doesn't add another one
+	auto replacement = makeGlyph(66);
+	replacement.advance = Vector2f(100, 0);
+	font.addGlyph(replacement);
+
+	auto font2 = Deserializer::fromBytes<Font>(Serializer::toBytes(font));
+	for (const Font* f: { &font, &font2 }) {
+		EXPECT_EQ(f->getGlyphHere(65).advance, Vector2f(66, 0));
+		EXPECT_EQ(f->getGlyphHere(66).advance, Vector2f(100, 0));
+		EXPECT_EQ(f->getGlyphHere(0x4E2D).charcode, 0x4E2D);
+		EXPECT_EQ(f->getGlyphHere(0x1F600).charcode, 0x1F600); // Outside the BMP
+
+		// Missing glyphs fall back to 0, both in a page that has glyphs and in one that doesn't
+		EXPECT_EQ(f->getGlyphHere(67).charcode, 0);
+		EXPECT_EQ(f->getGlyphHere(0x3000).charcode, 0);
+		EXPECT_EQ(f->getGlyphHere(0x1F601).charcode, 0);
+	}
+}
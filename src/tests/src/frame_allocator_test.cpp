@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include "heap_allocation_counter.h"
+#include "painter_test_access.h"
+#include "test_render_resources.h"
+using namespace Halley;
+
+namespace {
+	class TestRenderTarget final : public RenderTarget {
+	public:
+		Rect4i getViewPort() const override { return Rect4i(0, 0, 64, 64); }
+		bool hasColourBuffer(int attachmentNumber) const override { return true; }
+		bool hasDepthBuffer() const override { return false; }
+	};
+
+	void simulateFrame(FrameAllocator& allocator)
+	{
+		FrameVector<RenderGraphNode*> queue(allocator);
+		queue.reserve(64);
+		for (size_t i = 0; i < 64; ++i) {
+			queue.push_back(nullptr);
+		}
+
+		FrameVector<Vector2f> points(allocator);
+		for (int i = 0; i < 5000; ++i) {
+			points.push_back(Vector2f(float(i), float(i)));
+		}
+
+		FrameVector<uint16_t> indices(allocator);
+		indices.resize(30000);
+
+		allocator.reset();
+	}
+}
+
+TEST(HalleyFrameAllocator, Alignment)
+{
+	FrameAllocator allocator(256);
+
+	for (size_t alignment = 1; alignment <= 64; alignment *= 2) {
+		auto* p = allocator.allocate(3, alignment);
+		EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % alignment, 0u);
+	}
+
+	// Larger than the block size
+	auto* big = static_cast<char*>(allocator.allocate(1000, 16));
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(big) % 16, 0u);
+	big[999] = 1;
+	EXPECT_GE(allocator.getBytesUsed(), 1000u);
+
+	allocator.reset();
+	EXPECT_EQ(allocator.getBytesUsed(), 0u);
+	EXPECT_EQ(allocator.getNumBlocks(), 1u);
+}
+
+TEST(HalleyFrameAllocator, SteadyStateFrameDoesNotAllocate)
+{
+	FrameAllocator allocator(1024);
+
+	// First frame grows the allocator, reset merges it into a single block
+	simulateFrame(allocator);
+	simulateFrame(allocator);
+	EXPECT_EQ(allocator.getNumBlocks(), 1u);
+
+	const HeapAllocationCounter allocationCounter;
+	for (int i = 0; i < 10; ++i) {
+		simulateFrame(allocator);
+	}
+	EXPECT_EQ(allocationCounter.getAllocations(), 0u);
+}
+
+TEST(HalleyFrameAllocator, ResetByPainterAtEndOfFrame)
+{
+	TestRenderResources resources;
+	DummyPainter painter(resources.getResources());
+	auto& allocator = painter.getFrameAllocator();
+
+	// Triangulating a concave polygon takes its scratch space from the frame allocator
+	const auto polygon = Polygon(VertexList{ Vector2f(0, 0), Vector2f(10, 0), Vector2f(10, 10), Vector2f(5, 3), Vector2f(0, 10) });
+	ASSERT_FALSE(polygon.isConvex());
+
+	TestRenderTarget target;
+	Camera camera;
+	auto rc = PainterTestAccess::makeRenderContext(painter, camera, target);
+
+	PainterTestAccess::startRender(painter);
+	rc.bind([&] (Painter& p)
+	{
+		p.drawPolygon(polygon, Colour4f(1, 1, 1, 1));
+	});
+	EXPECT_GT(allocator.getBytesUsed(), 0u);
+	PainterTestAccess::endRender(painter);
+
+	EXPECT_EQ(allocator.getBytesUsed(), 0u);
+}
+
+TEST(HalleyFrameAllocator, SteadyStatePainterFrameDoesNotAllocate)
+{
+	TestRenderResources resources({ makeSpriteMaterialYAML("Test/Sprite") });
+	DummyPainter painter(resources.getResources());
+	const auto material = resources.makeMaterial("Test/Sprite");
+	material->set(0, std::shared_ptr<const Texture>(std::make_shared<DummyTexture>(Vector2i(64, 64))));
+
+	// Enough sprites to overflow the stack buffer that Sprite::draw used to have, some of them off screen
+	Vector<Sprite> sprites;
+	for (int i = 0; i < 64; ++i) {
+		sprites.push_back(Sprite()
+			.setMaterial(material)
+			.setPivot(Vector2f())
+			.setSize(Vector2f(4, 4))
+			.setPosition(Vector2f(float(i % 8) * 12.0f, float(i / 8) * 12.0f)));
+	}
+	const auto polygon = Polygon(VertexList{ Vector2f(0, 0), Vector2f(10, 0), Vector2f(10, 10), Vector2f(5, 3), Vector2f(0, 10) });
+	const std::array<Vector2f, 3> line = { Vector2f(0, 0), Vector2f(20, 5), Vector2f(30, 30) };
+
+	SpritePainter spritePainter;
+	const std::function<void(Painter&)> drawScene = [&] (Painter& p)
+	{
+		spritePainter.start();
+		spritePainter.add(sprites, 1, 0, 0);
+		spritePainter.draw(1, p);
+
+		// The same path that text takes, after laying out its glyphs
+		Sprite::drawMixedMaterials(sprites.data(), sprites.size(), p);
+
+		p.drawCircle(Vector2f(32, 32), 10, 1, Colour4f(1, 1, 1, 1));
+		p.drawCircleArc(Vector2f(32, 32), 10, 1, Angle1f::fromDegrees(0), Angle1f::fromDegrees(90), Colour4f(1, 1, 1, 1));
+		p.drawEllipse(Vector2f(32, 32), Vector2f(10, 5), 1, Colour4f(1, 1, 1, 1));
+		p.drawRect(Rect4f(4, 4, 20, 20), 1, Colour4f(1, 1, 1, 1));
+		p.drawLine(line, 1, Colour4f(1, 1, 1, 1));
+		p.drawPolygon(polygon, Colour4f(1, 1, 1, 1));
+	};
+
+	TestRenderTarget target;
+	Camera camera;
+	auto rc = PainterTestAccess::makeRenderContext(painter, camera, target);
+	auto drawFrame = [&] ()
+	{
+		PainterTestAccess::startRender(painter);
+		rc.bind(drawScene);
+		PainterTestAccess::endRender(painter);
+	};
+
+	// The first frames size the painter's buffers and the frame allocator
+	drawFrame();
+	drawFrame();
+	ASSERT_GT(painter.getPrevDrawCalls(), 0u);
+
+	const HeapAllocationCounter allocationCounter;
+	for (int i = 0; i < 10; ++i) {
+		drawFrame();
+	}
+	EXPECT_EQ(allocationCounter.getAllocations(), 0u);
+}
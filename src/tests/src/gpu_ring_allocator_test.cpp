@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+using namespace Halley;
+
+namespace {
+	class FakeFence final : public GPUFence {
+	public:
+		FakeFence(bool& signalled, int& waits)
+			: signalled(signalled)
+			, waits(waits)
+		{}
+
+		bool isSignalled() override { return signalled; }
+
+		void wait() override
+		{
+			++waits;
+			signalled = true;
+		}
+
+	private:
+		bool& signalled;
+		int& waits;
+	};
+}
+
+TEST(HalleyGPURingAllocator, AllocatesWithinSegment)
+{
+	GPURingAllocator ring(1024, 3);
+	EXPECT_EQ(ring.getCapacity(), 3072u);
+
+	ring.beginFrame();
+	const auto segmentStart = ring.getCurrentSegment() * ring.getSegmentSize();
+
+	const auto a = ring.allocate(10, 16);
+	const auto b = ring.allocate(10, 16);
+	ASSERT_TRUE(a && b);
+	EXPECT_EQ(a.value(), segmentStart);
+	EXPECT_EQ(b.value(), segmentStart + 16);
+
+	EXPECT_FALSE(ring.allocate(1024, 16));
+	EXPECT_TRUE(ring.hasOverflowed());
+
+	const auto c = ring.allocate(1024 - 32, 16);
+	ASSERT_TRUE(c);
+	EXPECT_EQ(c.value() + 1024 - 32, segmentStart + 1024);
+	ring.endFrame({});
+
+	ring.reset(2048);
+	EXPECT_FALSE(ring.hasOverflowed());
+	EXPECT_EQ(ring.getSegmentSize(), 2048u);
+}
+
+TEST(HalleyGPURingAllocator, WaitsForFenceBeforeReusingSegment)
+{
+	GPURingAllocator ring(256, 3);
+
+	bool signalled[3] = { false, false, false };
+	int waits[3] = { 0, 0, 0 };
+	size_t segments[3];
+
+	for (int i = 0; i < 3; ++i) {
+		ring.beginFrame();
+		segments[i] = ring.getCurrentSegment();
+		ring.allocate(100);
+		ring.endFrame(std::make_unique<FakeFence>(signalled[i], waits[i]));
+	}
+	EXPECT_NE(segments[0], segments[1]);
+	EXPECT_NE(segments[1], segments[2]);
+	EXPECT_NE(segments[0], segments[2]);
+	EXPECT_EQ(ring.getNumStalls(), 0u);
+
+	// GPU is still on the first frame: must block
+	ring.beginFrame();
+	EXPECT_EQ(ring.getCurrentSegment(), segments[0]);
+	EXPECT_EQ(waits[0], 1);
+	EXPECT_EQ(ring.getNumStalls(), 1u);
+	ring.endFrame({});
+
+	// GPU already finished the second frame: no blocking
+	signalled[1] = true;
+	ring.beginFrame();
+	EXPECT_EQ(ring.getCurrentSegment(), segments[1]);
+	EXPECT_EQ(waits[1], 0);
+	EXPECT_EQ(ring.getNumStalls(), 1u);
+	ring.endFrame({});
+
+	ring.waitAll();
+	EXPECT_EQ(waits[2], 1);
+}
@@ -0,0 +1,43 @@
+#include "heap_allocation_counter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+using namespace Halley;
+
+namespace {
+	std::atomic<size_t> heapAllocations { 0 };
+}
+
+void* operator new(size_t size)
+{
+	++heapAllocations;
+	if (auto* p = std::malloc(size == 0 ? 1 : size)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+HeapAllocationCounter::HeapAllocationCounter()
+	: start(getTotalAllocations())
+{
+}
+
+size_t HeapAllocationCounter::getAllocations() const
+{
+	return getTotalAllocations() - start;
+}
+
+size_t HeapAllocationCounter::getTotalAllocations()
+{
+	return heapAllocations.load();
+}
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+using namespace Halley;
+
+namespace {
+	class HalleyParticles : public ::testing::Test {
+	protected:
+		HalleyAPI api {};
+		Resources resources { std::unique_ptr<ResourceLocator>(), api, {} };
+		std::shared_ptr<Material> material = std::make_shared<Material>(std::make_shared<MaterialDefinition>());
+
+		Particles makeParticles(ConfigNode::MapType node)
+		{
+			Particles particles(ConfigNode(std::move(node)), resources);
+			particles.setSprites({ Sprite().setMaterial(material) });
+			return particles;
+		}
+
+		// Runs the update over the cpuAux threads, which only happens for large systems
+		template <typename F>
+		void withAuxThreads(F f)
+		{
+			Executors executors;
+			Executors::setInstance(executors);
+			ThreadPool pool("cpuAux", Executors::getCPUAux(), 3, [] (String name, std::function<void()> run) { return std::thread(std::move(run)); });
+			f();
+		}
+	};
+
+	struct ParticleState {
+		Vector2f position;
+		Angle1f rotation;
+		Vector2f scale;
+		Colour4f colour;
+
+		bool operator==(const ParticleState& other) const
+		{
+			return position == other.position && rotation == other.rotation && scale == other.scale && colour == other.colour;
+		}
+	};
+
+	std::vector<std::vector<ParticleState>> simulate(Particles& particles, size_t nFrames)
+	{
+		Random::getGlobal().setSeed(uint32_t(1234));
+
+		std::vector<std::vector<ParticleState>> frames;
+		for (size_t i = 0; i < nFrames; ++i) {
+			particles.update(1.0 / 30.0);
+			auto& frame = frames.emplace_back();
+			for (const auto& sprite: particles.getSprites()) {
+				frame.push_back({ sprite.getPosition(), sprite.getRotation(), sprite.getScale(), sprite.getColour() });
+			}
+		}
+		return frames;
+	}
+}
+
+TEST_F(HalleyParticles, SlicedUpdateMatchesSerial)
+{
+	// Enough particles to be split across threads, exercising every part of the update
+	ConfigNode::MapType node;
+	node["burst"] = 20000;
+	node["ttl"] = 1.0f;
+	node["ttlScatter"] = 0.5f;
+	node["speed"] = 100.0f;
+	node["speedScatter"] = 50.0f;
+	node["speedDamp"] = 0.5f;
+	node["acceleration"] = Vector2f(0, 10);
+	node["angleScatter"] = 180.0f;
+	node["directionScatter"] = 30.0f;
+	node["rotateTowardsMovement"] = true;
+	node["endScale"] = 2.0f;
+	node["fadeInTime"] = 0.1f;
+	node["fadeOutTime"] = 0.2f;
+	node["stopTime"] = 0.3f;
+	constexpr size_t nFrames = 50;
+
+	ASSERT_FALSE(Executors::hasInstance());
+	auto serialParticles = makeParticles(node);
+	const auto serial = simulate(serialParticles, nFrames);
+
+	std::vector<std::vector<ParticleState>> sliced;
+	withAuxThreads([&] ()
+	{
+		auto slicedParticles = makeParticles(node);
+		sliced = simulate(slicedParticles, nFrames);
+	});
+	EXPECT_FALSE(Executors::hasInstance());
+
+	ASSERT_EQ(serial.size(), sliced.size());
+	EXPECT_EQ(serial[0].size(), 20000u);
+	EXPECT_TRUE(serial.back().empty());
+	for (size_t i = 0; i < nFrames; ++i) {
+		ASSERT_EQ(serial[i].size(), sliced[i].size()) << "frame " << i;
+		EXPECT_TRUE(serial[i] == sliced[i]) << "frame " << i;
+	}
+}
+
+TEST_F(HalleyParticles, CompactionKeepsOnlyLiveParticles)
+{
+	// Each frame spawns a batch which moves 25 units a frame, and dies once it's been alive for four frames
+	// If a dead particle was kept, its sprite would be left at 100 units
+	ConfigNode::MapType node;
+	node["spawnRate"] = 20000.0f;
+	node["ttl"] = 1.0f;
+	node["speed"] = 100.0f;
+	constexpr size_t perFrame = 5000;
+
+	withAuxThreads([&] ()
+	{
+		auto particles = makeParticles(node);
+		for (size_t frame = 1; frame <= 10; ++frame) {
+			particles.update(0.25);
+
+			std::map<float, size_t> countAtX;
+			for (const auto& sprite: particles.getSprites()) {
+				EXPECT_EQ(sprite.getPosition().y, 0.0f);
+				++countAtX[sprite.getPosition().x];
+			}
+
+			std::map<float, size_t> expected;
+			for (size_t age = 1; age <= std::min(frame, size_t(3)); ++age) {
+				expected[float(age) * 25.0f] = perFrame;
+			}
+			EXPECT_EQ(countAtX, expected) << "frame " << frame;
+		}
+	});
+}
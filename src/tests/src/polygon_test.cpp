@@ -18,3 +18,22 @@ TEST(HalleyPolygon, Subtraction)
 		EXPECT_TRUE(result.value()[i].isConvex());
 	}
 }
+
+TEST(HalleyPolygon, Revision)
+{
+	Polygon poly(VertexList{ { 0, 0 }, { 10, 0 }, { 5, 5 }, { 10, 10 }, { 0, 10 } });
+	const auto revision = poly.getRevision();
+
+	// Moving it around keeps the same vertex list, so whatever was derived from it still applies
+	poly.translate(Vector2f(3, 4));
+	poly.rotate(Angle1f::fromDegrees(30));
+	poly.scale(Vector2f(2, 2));
+	EXPECT_EQ(poly.getRevision(), revision);
+
+	const Polygon copy = poly;
+	EXPECT_EQ(copy.getRevision(), revision);
+
+	poly.setVertices(VertexList{ { 0, 0 }, { 10, 0 }, { 10, 10 } });
+	EXPECT_NE(poly.getRevision(), revision);
+	EXPECT_NE(Polygon(VertexList{ { 0, 0 }, { 10, 0 }, { 10, 10 } }).getRevision(), poly.getRevision());
+}
@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include <cstring>
+#include "painter_test_access.h"
+#include "test_render_resources.h"
+using namespace Halley;
+
+namespace {
+	const String spriteMaterial = makeSpriteMaterialYAML("Test/InstancedSprite", true);
+
+	MaterialDefinition makeMaterial(const String& yaml)
+	{
+		MaterialDefinition material;
+		material.load(YAMLConvert::parseConfig(yaml));
+		return material;
+	}
+
+	Vector<SpriteVertexAttrib> makeSprites(size_t n)
+	{
+		Vector<SpriteVertexAttrib> sprites(n);
+		for (size_t i = 0; i < n; ++i) {
+			const float f = float(i + 1);
+			auto& s = sprites[i];
+			std::memset(&s, 0, sizeof(s));
+			s.vertPos = Vector4f(-1, -1, -1, -1);
+			s.pos = Vector2f(10 * f, 20 * f);
+			s.pivot = Vector2f(0.5f, 1.0f);
+			s.size = Vector2f(16 * f, 32 * f);
+			s.scale = Vector2f(1, f);
+			s.colour = Colour4f(0.1f * f, 0.2f, 0.3f, 1.0f);
+			s.texRect0 = Rect4f(0.1f, 0.2f, 0.3f * f, 0.4f);
+			s.texRect1 = Rect4f(0.5f, 0.6f, 0.7f, 0.8f * f);
+			s.custom0 = Vector4f(f, 2 * f, 3 * f, 4 * f);
+			s.custom1 = Vector4f(5 * f, 6 * f, 7 * f, 8 * f);
+			s.custom2 = Vector4f(9 * f, 10 * f, 11 * f, 12 * f);
+			s.rotation = 0.25f * f;
+			s.textureRotation = 1.0f;
+		}
+		return sprites;
+	}
+
+	// Keeps the vertices that the instances were expanded into
+	class CapturingPainter final : public AnalyticsPainter {
+	public:
+		using AnalyticsPainter::AnalyticsPainter;
+
+		Vector<char> vertices;
+
+		void setVertices(const MaterialDefinition& material, size_t numVertices, void* vertexData, size_t numIndices, unsigned short* indices, bool standardQuadsOnly) override
+		{
+			const auto* bytes = static_cast<const char*>(vertexData);
+			vertices.assign(bytes, bytes + numVertices * material.getVertexStride());
+			AnalyticsPainter::setVertices(material, numVertices, vertexData, numIndices, indices, standardQuadsOnly);
+		}
+	};
+}
+
+TEST(HalleySpriteInstancing, RecordLayout)
+{
+	const auto material = makeMaterial(spriteMaterial);
+	EXPECT_TRUE(material.isInstanced());
+	EXPECT_EQ(material.getVertexStride(), sizeof(SpriteVertexAttrib));
+	EXPECT_EQ(material.getInstanceSize(), material.getVertexSize() - sizeof(Vector4f));
+	EXPECT_EQ(material.getInstanceStride() % 16, 0u);
+	EXPECT_LT(material.getInstanceStride(), material.getVertexStride());
+
+	// Attributes after vertPos move back by its size
+	const auto& attributes = material.getAttributes();
+	EXPECT_EQ(material.getInstanceAttributeOffset(attributes.at(1)), 0u);
+	EXPECT_EQ(material.getInstanceAttributeOffset(attributes.back()), size_t(attributes.back().offset) - sizeof(Vector4f));
+}
+
+TEST(HalleySpriteInstancing, RecordHoldsSpriteData)
+{
+	const auto material = makeMaterial(spriteMaterial);
+	const auto sprites = makeSprites(3);
+
+	Vector<char> instances(sprites.size() * material.getInstanceStride());
+	Painter::writeSpriteInstances(material, sprites.size(), sprites.data(), instances.data());
+
+	for (size_t i = 0; i < sprites.size(); ++i) {
+		const char* record = instances.data() + i * material.getInstanceStride();
+		const char* vertex = reinterpret_cast<const char*>(&sprites[i]);
+		for (const auto& attribute: material.getAttributes()) {
+			if (size_t(attribute.offset) == material.getVertexPosOffset()) {
+				continue;
+			}
+			const auto size = MaterialAttribute::getAttributeSize(attribute.type);
+			EXPECT_EQ(std::memcmp(record + material.getInstanceAttributeOffset(attribute), vertex + attribute.offset, size), 0) << "sprite " << i << ", attribute " << attribute.name;
+		}
+	}
+}
+
+TEST(HalleySpriteInstancing, ExpandedInstancesMatchSpriteVertices)
+{
+	const auto material = makeMaterial(spriteMaterial);
+	const auto sprites = makeSprites(5);
+	const size_t stride = material.getVertexStride();
+
+	Vector<char> expected(sprites.size() * 4 * stride);
+	Painter::expandSpriteVertices(material, sprites.size(), sprites.data(), expected.data());
+
+	Vector<char> instances(sprites.size() * material.getInstanceStride());
+	Painter::writeSpriteInstances(material, sprites.size(), sprites.data(), instances.data());
+	Vector<char> expanded(sprites.size() * 4 * stride);
+	Painter::expandSpriteInstances(material, sprites.size(), instances.data(), expanded.data());
+
+	for (size_t i = 0; i < sprites.size() * 4; ++i) {
+		EXPECT_EQ(std::memcmp(expected.data() + i * stride, expanded.data() + i * stride, material.getVertexSize()), 0) << "vertex " << i;
+
+		const auto& vertPos = *reinterpret_cast<const Vector4f*>(expanded.data() + i * stride + material.getVertexPosOffset());
+		EXPECT_EQ(vertPos, Painter::getSpriteCorners()[i % 4]);
+	}
+}
+
+TEST(HalleySpriteInstancing, RequiresVertPos)
+{
+	EXPECT_THROW(makeMaterial("name: Test/Broken\ninstanced: true\nattributes:\n  - name: position\n    type: vec2\n    semantic: POSITION\n"), Exception);
+
+	// A vec4 in the first slot is not enough, it has to be marked as vertPos
+	EXPECT_THROW(makeMaterial("name: Test/Unmarked\ninstanced: true\nattributes:\n  - name: colour\n    type: vec4\n    semantic: COLOR\n"), Exception);
+	EXPECT_FALSE(makeMaterial("name: Test/NotInstanced\nattributes:\n  - name: position\n    type: vec2\n    semantic: POSITION\n").isInstanced());
+}
+
+TEST(HalleySpriteInstancing, DrawSprites)
+{
+	TestRenderResources resources({ spriteMaterial });
+	DrawCallAnalytics analytics;
+	CapturingPainter painter(resources.getResources(), analytics);
+	const auto material = resources.makeMaterial("Test/InstancedSprite");
+	material->set(0, std::shared_ptr<const Texture>(std::make_shared<DummyTexture>(Vector2i(64, 64))));
+	const auto& definition = material->getDefinition();
+	ASSERT_TRUE(definition.isInstanced());
+
+	const auto sprites = makeSprites(5);
+	ScreenRenderTarget screen(Rect4i(0, 0, 64, 64));
+	Camera camera;
+	auto rc = PainterTestAccess::makeRenderContext(painter, camera, screen);
+
+	PainterTestAccess::startRender(painter);
+	rc.bind([&] (Painter& p)
+	{
+		// Consecutive calls with the same material go into one batch
+		p.drawSprites(material, 3, sprites.data());
+		p.drawSprites(material, 2, sprites.data() + 3);
+	});
+	PainterTestAccess::endRender(painter);
+
+	const auto& draws = analytics.getDrawCalls();
+	ASSERT_EQ(draws.size(), 1u);
+	EXPECT_EQ(draws[0].numInstances, 5u);
+	EXPECT_EQ(draws[0].numVertices, 20u);
+	EXPECT_EQ(draws[0].numIndices, 30u);
+
+	// Without instancing in the backend, the instances are expanded into the same vertices drawSprites would have made
+	const size_t stride = definition.getVertexStride();
+	Vector<char> expected(sprites.size() * 4 * stride);
+	Painter::expandSpriteVertices(definition, sprites.size(), sprites.data(), expected.data());
+	ASSERT_EQ(painter.vertices.size(), expected.size());
+	for (size_t i = 0; i < sprites.size() * 4; ++i) {
+		EXPECT_EQ(std::memcmp(expected.data() + i * stride, painter.vertices.data() + i * stride, definition.getVertexSize()), 0) << "vertex " << i;
+	}
+}
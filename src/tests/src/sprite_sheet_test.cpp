@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+using namespace Halley;
+
+namespace {
+	SpriteSheetEntry makeEntry(float size)
+	{
+		SpriteSheetEntry entry;
+		entry.size = Vector2f(size, size);
+		entry.coords = Rect4f(0, 0, size / 100.0f, size / 100.0f);
+		return entry;
+	}
+
+	std::unique_ptr<SpriteSheet> makeSheet(std::initializer_list<std::pair<const char*, float>> sprites)
+	{
+		auto sheet = std::make_unique<SpriteSheet>();
+		for (const auto& [name, size]: sprites) {
+			sheet->addSprite(name, makeEntry(size));
+		}
+		return sheet;
+	}
+}
+
+TEST(HalleySpriteSheet, HandleLookup)
+{
+	const auto sheet = makeSheet({ { "a", 1 }, { "b", 2 } });
+
+	const auto a = sheet->getHandle("a");
+	const auto b = sheet->getHandle("b");
+	ASSERT_TRUE(a.isValid());
+	ASSERT_TRUE(b.isValid());
+	EXPECT_NE(a, b);
+	EXPECT_EQ(&sheet->getSprite(a), &sheet->getSprite("a"));
+	EXPECT_EQ(&sheet->getSprite(b), &sheet->getSprite("b"));
+}
+
+TEST(HalleySpriteSheet, InvalidHandleResolvesToDummy)
+{
+	const auto sheet = makeSheet({ { "a", 1 } });
+
+	const auto missing = sheet->getHandle("missing");
+	EXPECT_FALSE(missing.isValid());
+	EXPECT_EQ(&sheet->getSprite(missing), &sheet->getDummySprite());
+	EXPECT_EQ(&sheet->getSprite(SpriteHandle()), &sheet->getDummySprite());
+
+	// A handle past the end, e.g. one from a different sheet
+	EXPECT_EQ(&sheet->getSprite(SpriteHandle(5)), &sheet->getDummySprite());
+}
+
+TEST(HalleySpriteSheet, HandlesSurviveReload)
+{
+	const auto sheet = std::shared_ptr<SpriteSheet>(makeSheet({ { "a", 1 }, { "b", 2 }, { "c", 3 } }));
+	const auto a = sheet->getHandle("a");
+	const auto b = sheet->getHandle("b");
+	const auto c = sheet->getHandle("c");
+	const SpriteResource resourceC(sheet, c.getIndex());
+
+	// "b" is removed, "a" and "c" change, and "d" is new. The new sheet also lists them in a different order.
+	sheet->reload(std::move(*makeSheet({ { "d", 40 }, { "c", 30 }, { "a", 10 } })));
+
+	// Handles resolved before the reload still point to the same sprite, with its new data
+	EXPECT_EQ(sheet->getHandle("a"), a);
+	EXPECT_EQ(sheet->getHandle("c"), c);
+	EXPECT_EQ(sheet->getSprite(a).size, Vector2f(10, 10));
+	EXPECT_EQ(sheet->getSprite(c).size, Vector2f(30, 30));
+	EXPECT_EQ(&resourceC.getSprite(), &sheet->getSprite(c));
+
+	// The removed sprite's slot now holds the dummy
+	EXPECT_FALSE(sheet->hasSprite("b"));
+	EXPECT_FALSE(sheet->getHandle("b").isValid());
+	EXPECT_EQ(sheet->getSprite(b).size, sheet->getDummySprite().size);
+	EXPECT_EQ(sheet->getSprite(b).coords, sheet->getDummySprite().coords);
+
+	// New sprites are appended after every existing slot
+	const auto d = sheet->getHandle("d");
+	ASSERT_TRUE(d.isValid());
+	EXPECT_EQ(d.getIndex(), 3u);
+	EXPECT_EQ(sheet->getSprite(d).size, Vector2f(40, 40));
+}
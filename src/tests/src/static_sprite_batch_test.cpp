@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+using namespace Halley;
+
+namespace {
+	const char* spriteMaterial = R"(
+name: Test/Sprite
+attributes:
+  - name: vertPos
+    type: vec4
+    semantic: VERTPOS
+    special: vertPos
+  - name: position
+    type: vec2
+    semantic: POSITION
+  - name: pivot
+    type: vec2
+    semantic: PIVOT
+  - name: size
+    type: vec2
+    semantic: SIZE
+  - name: scale
+    type: vec2
+    semantic: SCALE
+  - name: colour
+    type: vec4
+    semantic: COLOR
+  - name: texCoord0
+    type: vec4
+    semantic: TEXCOORD0
+  - name: texCoord1
+    type: vec4
+    semantic: TEXCOORD1
+  - name: custom0
+    type: vec4
+    semantic: CUSTOM0
+  - name: custom1
+    type: vec4
+    semantic: CUSTOM1
+  - name: custom2
+    type: vec4
+    semantic: CUSTOM2
+  - name: rotation
+    type: float
+    semantic: ROTATION
+  - name: textureRotation
+    type: float
+    semantic: TEXTUREROTATION
+)";
+
+	std::shared_ptr<Material> makeMaterial()
+	{
+		auto definition = std::make_shared<MaterialDefinition>();
+		definition->load(YAMLConvert::parseConfig(spriteMaterial));
+		return std::make_shared<Material>(definition);
+	}
+
+	Sprite makeSprite(const std::shared_ptr<Material>& material, Rect4f rect)
+	{
+		Sprite sprite;
+		sprite.setMaterial(material);
+		sprite.setPivot(Vector2f());
+		sprite.setSize(rect.getSize());
+		sprite.setPosition(rect.getTopLeft());
+		return sprite;
+	}
+}
+
+TEST(HalleyStaticSpriteBatch, KeepsOrderOfOverlappingSprites)
+{
+	const auto material = makeMaterial();
+	StaticSpriteBatch batch(100.0f);
+
+	// The middle sprite's centre is in the next chunk over, but it covers both of its neighbours
+	Vector<Sprite> sprites;
+	sprites.push_back(makeSprite(material, Rect4f(10, 10, 20, 20)));
+	sprites.push_back(makeSprite(material, Rect4f(20, 10, 160, 20)));
+	sprites.push_back(makeSprite(material, Rect4f(30, 10, 20, 20)));
+	sprites.push_back(makeSprite(material, Rect4f(150, 50, 20, 20)));
+	batch.setSprites(sprites);
+
+	const auto order = batch.getDrawOrder();
+	ASSERT_EQ(order.size(), sprites.size());
+
+	Vector<size_t> drawPos(sprites.size());
+	for (size_t i = 0; i < order.size(); ++i) {
+		drawPos[order[i]] = i;
+	}
+	for (size_t a = 0; a < sprites.size(); ++a) {
+		for (size_t b = a + 1; b < sprites.size(); ++b) {
+			if (sprites[a].getAABB().overlaps(sprites[b].getAABB())) {
+				EXPECT_LT(drawPos[a], drawPos[b]) << "sprites " << a << " and " << b;
+			}
+		}
+	}
+}
+
+TEST(HalleyStaticSpriteBatch, GroupsTilesByChunk)
+{
+	const auto material = makeMaterial();
+	StaticSpriteBatch batch(64.0f);
+
+	// Tiles added a row at a time still end up one chunk per cell, since none of them overlap
+	Vector<Sprite> sprites;
+	for (int y = 0; y < 8; ++y) {
+		for (int x = 0; x < 8; ++x) {
+			sprites.push_back(makeSprite(material, Rect4f(float(x * 16), float(y * 16), 16, 16)));
+		}
+	}
+	batch.setSprites(sprites);
+
+	EXPECT_EQ(batch.getNumChunks(), 4u);
+	EXPECT_EQ(batch.getDrawOrder().size(), sprites.size());
+}
@@ -0,0 +1,200 @@
+#include "test_render_resources.h"
+#include <cstring>
+using namespace Halley;
+
+namespace {
+	const char* painterMaterials[] = {
+		R"(
+name: Halley/MaterialBase
+uniforms:
+  - HalleyBlock:
+    - name: u_mvp
+      type: mat4
+    - name: u_viewPortSize
+      type: vec2
+)",
+		R"(
+name: Halley/SolidLine
+attributes:
+  - name: colour
+    type: vec4
+    semantic: COLOR
+  - name: position
+    type: vec2
+    semantic: POSITION
+  - name: normal
+    type: vec2
+    semantic: NORMAL
+  - name: width
+    type: vec2
+    semantic: WIDTH
+)",
+		R"(
+name: Halley/SolidPolygon
+attributes:
+  - name: colour
+    type: vec4
+    semantic: COLOR
+  - name: position
+    type: vec2
+    semantic: POSITION
+  - name: normal
+    type: vec2
+    semantic: NORMAL
+  - name: width
+    type: vec2
+    semantic: WIDTH
+)",
+		R"(
+name: Halley/Blit
+attributes:
+  - name: position
+    type: vec4
+    semantic: POSITION
+)"
+	};
+
+	const char* basePath = "test_assets";
+	const char* shaderName = "Test/Shader";
+
+	class MemoryDataReader final : public ResourceDataReader {
+	public:
+		explicit MemoryDataReader(std::shared_ptr<const Bytes> data)
+			: data(std::move(data))
+		{}
+
+		size_t size() const override { return data->size(); }
+		size_t tell() const override { return pos; }
+		void close() override {}
+
+		int read(gsl::span<gsl::byte> dst) override
+		{
+			const size_t n = std::min(size_t(dst.size()), data->size() - std::min(pos, data->size()));
+			memcpy(dst.data(), data->data() + pos, n);
+			pos += n;
+			return int(n);
+		}
+
+		void seek(int64_t offset, int whence) override
+		{
+			if (whence == SEEK_SET) {
+				pos = size_t(offset);
+			} else if (whence == SEEK_CUR) {
+				pos = size_t(int64_t(pos) + offset);
+			} else {
+				pos = size_t(int64_t(data->size()) + offset);
+			}
+		}
+
+	private:
+		std::shared_ptr<const Bytes> data;
+		size_t pos = 0;
+	};
+}
+
+String Halley::makeSpriteMaterialYAML(const String& name, bool instanced)
+{
+	return "name: " + name + "\ninstanced: " + (instanced ? "true" : "false") + R"(
+attributes:
+  - name: vertPos
+    type: vec4
+    semantic: VERTPOS
+    special: vertPos
+  - name: position
+    type: vec2
+    semantic: POSITION
+  - name: pivot
+    type: vec2
+    semantic: PIVOT
+  - name: size
+    type: vec2
+    semantic: SIZE
+  - name: scale
+    type: vec2
+    semantic: SCALE
+  - name: colour
+    type: vec4
+    semantic: COLOR
+  - name: texCoord0
+    type: vec4
+    semantic: TEXCOORD0
+  - name: texCoord1
+    type: vec4
+    semantic: TEXCOORD1
+  - name: custom0
+    type: vec4
+    semantic: CUSTOM0
+  - name: custom1
+    type: vec4
+    semantic: CUSTOM1
+  - name: custom2
+    type: vec4
+    semantic: CUSTOM2
+  - name: rotation
+    type: float
+    semantic: ROTATION
+  - name: textureRotation
+    type: float
+    semantic: TEXTUREROTATION
+textures:
+  - tex0: sampler2D
+)";
+}
+
+// Serves the asset database and assets from memory
+class TestRenderResources::MemorySystemAPI final : public DummySystemAPI {
+public:
+	HashMap<String, std::shared_ptr<const Bytes>> files;
+
+	std::unique_ptr<ResourceDataReader> getDataReader(String path, int64_t start, int64_t end) override
+	{
+		const auto iter = files.find(path);
+		if (iter == files.end()) {
+			return {};
+		}
+		return std::make_unique<MemoryDataReader>(iter->second);
+	}
+};
+
+TestRenderResources::TestRenderResources(std::initializer_list<String> materials)
+	: system(std::make_unique<MemorySystemAPI>())
+	, video(std::make_unique<DummyVideoAPI>(*system))
+{
+	AssetDatabase assetDb;
+	auto addMaterial = [&] (const String& yaml)
+	{
+		MaterialDefinition definition;
+		definition.load(YAMLConvert::parseConfig(yaml));
+		definition.addPass(MaterialPass(shaderName, ConfigNode(ConfigNode::MapType())));
+
+		const auto path = "material/" + definition.getName();
+		system->files[(Path(basePath) / path).string()] = std::make_shared<const Bytes>(Serializer::toBytes(definition));
+		assetDb.addAsset(definition.getName(), AssetType::MaterialDefinition, AssetDatabase::Entry(path, Metadata()));
+	};
+	for (const auto* yaml: painterMaterials) {
+		addMaterial(yaml);
+	}
+	for (const auto& yaml: materials) {
+		addMaterial(yaml);
+	}
+	system->files[(Path(basePath) / "assets.db").string()] = std::make_shared<const Bytes>(Serializer::toBytes(assetDb));
+
+	api.system = system.get();
+	api.video = video.get();
+	auto locator = std::make_unique<ResourceLocator>(*system);
+	locator->addFileSystem(basePath);
+	resources = std::make_unique<Resources>(std::move(locator), api, Resources::Options());
+
+	resources->init<MaterialDefinition>();
+	resources->init<ShaderFile>();
+	resources->init<Texture>();
+	resources->of<ShaderFile>().setResource(0, String(shaderName) + ":" + video->getShaderLanguage(), std::make_shared<ShaderFile>());
+	resources->of<Texture>().setResource(0, "whitebox.png", std::make_shared<DummyTexture>(Vector2i(1, 1)));
+}
+
+TestRenderResources::~TestRenderResources() = default;
+
+std::shared_ptr<Material> TestRenderResources::makeMaterial(const String& name)
+{
+	return std::make_shared<Material>(resources->get<MaterialDefinition>(name));
+}